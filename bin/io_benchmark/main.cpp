@@ -0,0 +1,650 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/*
+ * Offline microbenchmarks of the IO building blocks of the library, one mode at a time.
+ *
+ * With --coroutines, it compares the per-operation cost of co_await on the wrappers of aws/crt/coro against the raw
+ * callback they wrap. It needs a build configured with ENABLE_COROUTINE_TESTS.
+ *
+ * With --handlers, it sends frames through stacks of the channel handlers of aws/crt/io over a loopback channel,
+ * with no socket, and reports the frame rate and the number of messages that reached the bottom of the channel.
+ *
+ * With --tasks, it measures ChannelHandler::ScheduleTask() on a chain of tasks that each schedule the next one,
+ * with a std::function and with a lambda stored in place.
+ *
+ * With --tls-contexts, it builds client TLS contexts for one configuration directly and through a TlsContextCache,
+ * and reports the build time and the bytes held through the allocator while the contexts are alive.
+ */
+
+#include <aws/crt/Api.h>
+#include <aws/crt/auth/Credentials.h>
+#include <aws/crt/Compression.h>
+#include <aws/crt/coro/Awaitables.h>
+#include <aws/crt/io/CompressionHandler.h>
+#include <aws/crt/io/EventLoopGroup.h>
+#include <aws/crt/io/FramingHandler.h>
+#include <aws/crt/io/MetricsHandler.h>
+#include <aws/crt/io/TlsContextCache.h>
+#include <aws/crt/io/WriteCoalescingHandler.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/command_line_parser.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <string>
+
+using namespace Aws::Crt;
+
+struct BenchmarkOptions
+{
+    size_t coroutineIterations = 0;
+    size_t handlerFrames = 0;
+    size_t taskCount = 0;
+    size_t tlsContextCount = 0;
+    const char *caFile = nullptr;
+    size_t frameSize = 1024;
+};
+
+static void s_Usage(int exit_code)
+{
+    fprintf(stderr, "usage: io_benchmark [options]\n");
+    fprintf(stderr, "\n Options:\n\n");
+    fprintf(stderr, "  -c, --coroutines INT: get credentials from a static provider INT times, through callbacks\n");
+    fprintf(stderr, "            and through co_await, and report the cost of each operation. Needs a build with\n");
+    fprintf(stderr, "            ENABLE_COROUTINE_TESTS.\n");
+    fprintf(stderr, "  -f, --handlers INT: send INT frames through framing, compression and write coalescing\n");
+    fprintf(stderr, "            handlers over a loopback channel and report the frame rate of each stack.\n");
+    fprintf(stderr, "  -t, --tasks INT: reschedule a channel task INT times, as a std::function and as a lambda\n");
+    fprintf(stderr, "            stored in place, and report the cost of each task.\n");
+    fprintf(stderr, "  -l, --tls-contexts INT: build INT client TLS contexts for one configuration, directly and\n");
+    fprintf(stderr, "            through a TlsContextCache, and report build time and allocator bytes.\n");
+    fprintf(stderr, "  -r, --ca-file FILE: trust store loaded by the --tls-contexts contexts, instead of the\n");
+    fprintf(stderr, "            system default.\n");
+    fprintf(stderr, "  -s, --frame-size INT: payload size of the --handlers frames, 1024 by default.\n");
+    fprintf(stderr, "  -h, --help\n");
+    fprintf(stderr, "            Display this message and quit.\n");
+    exit(exit_code);
+}
+
+static struct aws_cli_option s_long_options[] = {
+    {"coroutines", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'c'},
+    {"handlers", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'f'},
+    {"frame-size", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 's'},
+    {"tasks", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 't'},
+    {"tls-contexts", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'l'},
+    {"ca-file", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'r'},
+    {"help", AWS_CLI_OPTIONS_NO_ARGUMENT, NULL, 'h'},
+    /* Per getopt(3) the last element of the array has to be filled with all zeros */
+    {NULL, AWS_CLI_OPTIONS_NO_ARGUMENT, NULL, 0},
+};
+
+static void s_ParseOptions(int argc, char **argv, BenchmarkOptions &options)
+{
+    while (true)
+    {
+        int option_index = 0;
+        int c = aws_cli_getopt_long(argc, argv, "c:f:s:t:l:r:h", s_long_options, &option_index);
+        if (c == -1)
+        {
+            /* finished parsing */
+            break;
+        }
+
+        switch (c)
+        {
+            case 0:
+                /* getopt_long() returns 0 if an option.flag is non-null */
+                break;
+            case 'c':
+                options.coroutineIterations = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 'f':
+                options.handlerFrames = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 's':
+                options.frameSize = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 't':
+                options.taskCount = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 'l':
+                options.tlsContextCount = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 'r':
+                options.caFile = aws_cli_optarg;
+                break;
+            case 'h':
+                s_Usage(0);
+                break;
+            default:
+                fprintf(stderr, "Unknown option\n");
+                s_Usage(1);
+        }
+    }
+}
+
+static uint64_t s_Now()
+{
+    uint64_t now = 0;
+    aws_high_res_clock_get_ticks(&now);
+    return now;
+}
+
+/*
+ * Left-most handler that turns every write message back into a read message, so a channel runs without a socket.
+ */
+class LoopbackHandler : public Io::ChannelHandler
+{
+  public:
+    LoopbackHandler(Allocator *allocator) : Io::ChannelHandler(allocator) {}
+
+    int ProcessReadMessage(struct aws_io_message *) override { return AWS_OP_ERR; }
+
+    int ProcessWriteMessage(struct aws_io_message *message) override
+    {
+        if (!SendData(aws_byte_cursor_from_buf(&message->message_data), Io::ChannelDirection::Read))
+        {
+            return AWS_OP_ERR;
+        }
+
+        if (message->on_completion != nullptr)
+        {
+            message->on_completion(GetSlot()->channel, message, AWS_ERROR_SUCCESS, message->user_data);
+        }
+        aws_mem_release(message->allocator, message);
+        return AWS_OP_SUCCESS;
+    }
+
+    int IncrementReadWindow(size_t) override { return AWS_OP_SUCCESS; }
+
+    void ProcessShutdown(Io::ChannelDirection dir, int errorCode, bool freeScarceResourcesImmediately) override
+    {
+        OnShutdownComplete(dir, errorCode, freeScarceResourcesImmediately);
+    }
+
+    size_t InitialWindowSize() override { return SIZE_MAX; }
+
+    size_t MessageOverhead() override { return 0; }
+};
+
+struct LoopbackChannel
+{
+    Vector<std::shared_ptr<Io::ChannelHandler>> handlers;
+    std::promise<int> setupPromise;
+    std::promise<void> shutdownPromise;
+    struct aws_channel *channel = nullptr;
+};
+
+static void s_OnLoopbackChannelSetup(struct aws_channel *channel, int errorCode, void *userData)
+{
+    auto *loopback = static_cast<LoopbackChannel *>(userData);
+    if (errorCode == AWS_ERROR_SUCCESS)
+    {
+        for (const auto &handler : loopback->handlers)
+        {
+            struct aws_channel_slot *slot = aws_channel_slot_new(channel);
+            aws_channel_slot_insert_end(channel, slot);
+            aws_channel_slot_set_handler(slot, handler->SeatForCInterop(handler));
+        }
+    }
+    loopback->setupPromise.set_value(errorCode);
+}
+
+static void s_OnLoopbackChannelShutdown(struct aws_channel *, int, void *userData)
+{
+    static_cast<LoopbackChannel *>(userData)->shutdownPromise.set_value();
+}
+
+static bool s_StartLoopbackChannel(Allocator *allocator, Io::EventLoopGroup &eventLoopGroup, LoopbackChannel &loopback)
+{
+    struct aws_channel_options channelOptions;
+    AWS_ZERO_STRUCT(channelOptions);
+    channelOptions.event_loop = aws_event_loop_group_get_next_loop(eventLoopGroup.GetUnderlyingHandle());
+    channelOptions.on_setup_completed = s_OnLoopbackChannelSetup;
+    channelOptions.on_shutdown_completed = s_OnLoopbackChannelShutdown;
+    channelOptions.setup_user_data = &loopback;
+    channelOptions.shutdown_user_data = &loopback;
+    loopback.channel = aws_channel_new(allocator, &channelOptions);
+    if (loopback.channel == nullptr)
+    {
+        return false;
+    }
+
+    if (loopback.setupPromise.get_future().get() != AWS_ERROR_SUCCESS)
+    {
+        aws_channel_destroy(loopback.channel);
+        return false;
+    }
+
+    return true;
+}
+
+static void s_StopLoopbackChannel(LoopbackChannel &loopback)
+{
+    aws_channel_shutdown(loopback.channel, AWS_ERROR_SUCCESS);
+    loopback.shutdownPromise.get_future().wait();
+    loopback.handlers.clear();
+    aws_channel_destroy(loopback.channel);
+}
+
+/*
+ * Loopback handler that reschedules a task from the channel's thread until a number of tasks have run.
+ */
+class TaskChainHandler : public LoopbackHandler
+{
+  public:
+    TaskChainHandler(Allocator *allocator) : LoopbackHandler(allocator) {}
+
+    void RescheduleUntilDone(size_t remaining, std::promise<size_t> &done, bool useStdFunction)
+    {
+        if (remaining == 0)
+        {
+            done.set_value(m_tasksRun);
+            return;
+        }
+
+        auto task = [this, remaining, &done, useStdFunction](Io::TaskStatus status)
+        {
+            if (status == Io::TaskStatus::RunReady)
+            {
+                ++m_tasksRun;
+                RescheduleUntilDone(remaining - 1, done, useStdFunction);
+            }
+        };
+
+        if (useStdFunction)
+        {
+            ScheduleTask(std::function<void(Io::TaskStatus)>(task));
+        }
+        else
+        {
+            ScheduleTask(task);
+        }
+    }
+
+    void Reset() { m_tasksRun = 0; }
+
+  private:
+    size_t m_tasksRun = 0;
+};
+
+static int s_RunTaskBenchmarks(const BenchmarkOptions &options, Allocator *allocator)
+{
+    Io::EventLoopGroup eventLoopGroup(1, allocator);
+    if (!eventLoopGroup)
+    {
+        fprintf(
+            stderr, "Failed to create an event loop group with error %s\n", aws_error_debug_str(aws_last_error()));
+        return 1;
+    }
+
+    auto handler = MakeShared<TaskChainHandler>(allocator, allocator);
+    LoopbackChannel loopback;
+    loopback.handlers.push_back(handler);
+    if (!s_StartLoopbackChannel(allocator, eventLoopGroup, loopback))
+    {
+        fprintf(stderr, "Failed to set up a channel with error %s\n", aws_error_debug_str(aws_last_error()));
+        return 1;
+    }
+
+    /* Each task schedules the next one, so this is the cost of a schedule and a run on the channel's thread */
+    size_t taskCount = options.taskCount;
+    int exitCode = 0;
+    printf("%-16s %10s %12s\n", "ScheduleTask", "tasks", "ns/task");
+    for (bool useStdFunction : {true, false})
+    {
+        std::promise<size_t> done;
+        auto tasksRun = done.get_future();
+        uint64_t startNs = s_Now();
+        handler->ScheduleTask(
+            [&handler, &done, taskCount, useStdFunction](Io::TaskStatus)
+            {
+                handler->Reset();
+                handler->RescheduleUntilDone(taskCount, done, useStdFunction);
+            });
+        size_t completed = tasksRun.get();
+        uint64_t elapsedNs = s_Now() - startNs;
+
+        printf(
+            "%-16s %10zu %12.1f\n",
+            useStdFunction ? "std::function" : "inplace",
+            completed,
+            static_cast<double>(elapsedNs) / taskCount);
+        if (completed != taskCount)
+        {
+            exitCode = 1;
+        }
+    }
+
+    s_StopLoopbackChannel(loopback);
+    return exitCode;
+}
+
+enum class HandlerStack
+{
+    Framing,
+    FramingDeflate,
+    FramingCoalescing,
+};
+
+/*
+ * Sends frameCount frames through loopback | metrics | stack | framing and back. Returns the frames received.
+ */
+static size_t s_RunHandlerStack(
+    Allocator *allocator,
+    Io::EventLoopGroup &eventLoopGroup,
+    HandlerStack stack,
+    size_t frameCount,
+    size_t frameSize,
+    uint64_t &elapsedNs,
+    uint64_t &wireMessages)
+{
+    std::atomic<size_t> framesReceived(0);
+    std::promise<void> allReceived;
+    Io::FramingHandlerOptions framingOptions;
+    framingOptions.MaxFrameSize = std::max(framingOptions.MaxFrameSize, frameSize);
+    framingOptions.MaxBufferedSize =
+        std::max(framingOptions.MaxBufferedSize, frameSize + framingOptions.LengthPrefixSize);
+    framingOptions.OnFrameReceivedCallback = [&](const ByteCursor &)
+    {
+        if (++framesReceived == frameCount)
+        {
+            allReceived.set_value();
+        }
+    };
+
+    auto framing = MakeShared<Io::FramingHandler>(allocator, framingOptions, allocator);
+    auto metrics = MakeShared<Io::MetricsHandler>(allocator, allocator);
+
+    LoopbackChannel loopback;
+    loopback.handlers.push_back(MakeShared<LoopbackHandler>(allocator, allocator));
+    loopback.handlers.push_back(metrics);
+    if (stack == HandlerStack::FramingDeflate)
+    {
+        loopback.handlers.push_back(MakeShared<Io::CompressionHandler>(
+            allocator,
+            StreamCodec::CreateCompressor(CompressionAlgorithm::Deflate, -1, allocator),
+            StreamCodec::CreateDecompressor(CompressionAlgorithm::Deflate, allocator),
+            SIZE_MAX,
+            std::max<size_t>(16 * 1024 * 1024, frameSize * 2),
+            allocator));
+    }
+    else if (stack == HandlerStack::FramingCoalescing)
+    {
+        loopback.handlers.push_back(
+            MakeShared<Io::WriteCoalescingHandler>(allocator, Io::WriteCoalescingOptions(), allocator));
+    }
+    loopback.handlers.push_back(framing);
+
+    if (!s_StartLoopbackChannel(allocator, eventLoopGroup, loopback))
+    {
+        return 0;
+    }
+
+    /* Text rather than a single repeated byte, so that deflate has some work to do */
+    String payload;
+    for (size_t i = 0; payload.size() < frameSize; ++i)
+    {
+        payload += "frame payload " + String(std::to_string(i).c_str()) + " of the io benchmark; ";
+    }
+    payload.resize(frameSize);
+    uint64_t startNs = s_Now();
+    framing->ScheduleTask(
+        [&](Io::TaskStatus)
+        {
+            for (size_t i = 0; i < frameCount; ++i)
+            {
+                if (!framing->SendFrame(ByteCursorFromString(payload)))
+                {
+                    break;
+                }
+            }
+        });
+
+    /* A frame that fails to send shuts the channel down rather than arriving */
+    auto received = allReceived.get_future();
+    received.wait_for(std::chrono::seconds(60));
+    elapsedNs = s_Now() - startNs;
+    wireMessages = metrics->GetMetrics().messagesWritten;
+
+    s_StopLoopbackChannel(loopback);
+    return framesReceived.load();
+}
+
+static int s_RunHandlerBenchmarks(const BenchmarkOptions &options, Allocator *allocator)
+{
+    Io::EventLoopGroup eventLoopGroup(1, allocator);
+    if (!eventLoopGroup)
+    {
+        fprintf(
+            stderr, "Failed to create an event loop group with error %s\n", aws_error_debug_str(aws_last_error()));
+        return 1;
+    }
+
+    struct
+    {
+        const char *name;
+        HandlerStack stack;
+    } stacks[] = {
+        {"framing", HandlerStack::Framing},
+        {"framing+deflate", HandlerStack::FramingDeflate},
+        {"framing+coalesce", HandlerStack::FramingCoalescing},
+    };
+
+    size_t frameCount = options.handlerFrames;
+    size_t frameSize = options.frameSize;
+    int exitCode = 0;
+    printf("%-18s %10s %12s %12s %14s\n", "stack", "frames", "ns/frame", "MB/s", "wire messages");
+    for (const auto &entry : stacks)
+    {
+        if (entry.stack == HandlerStack::FramingDeflate && !StreamCodec::IsSupported(CompressionAlgorithm::Deflate))
+        {
+            printf("%-18s skipped, built without zlib\n", entry.name);
+            continue;
+        }
+
+        uint64_t elapsedNs = 0;
+        uint64_t wireMessages = 0;
+        size_t received =
+            s_RunHandlerStack(allocator, eventLoopGroup, entry.stack, frameCount, frameSize, elapsedNs, wireMessages);
+        double seconds = static_cast<double>(elapsedNs) / 1e9;
+        printf(
+            "%-18s %10zu %12.1f %12.1f %14llu\n",
+            entry.name,
+            received,
+            static_cast<double>(elapsedNs) / frameCount,
+            seconds > 0 ? received * frameSize / seconds / (1024 * 1024) : 0.0,
+            static_cast<unsigned long long>(wireMessages));
+        if (received != frameCount)
+        {
+            exitCode = 1;
+        }
+    }
+
+    return exitCode;
+}
+
+#if !BYO_CRYPTO
+
+static int s_RunTlsContextBenchmarks(const BenchmarkOptions &options, Allocator *allocator)
+{
+    Io::TlsContextOptions tlsOptions = Io::TlsContextOptions::InitDefaultClient(allocator);
+    if (!tlsOptions || (options.caFile != nullptr && !tlsOptions.OverrideDefaultTrustStore(nullptr, options.caFile)))
+    {
+        fprintf(stderr, "Failed to set up TLS options with error %s\n", aws_error_debug_str(aws_last_error()));
+        return 1;
+    }
+
+    /* A cache of its own, so that nothing is shared with earlier contexts of the process */
+    Io::TlsContextCache cache(allocator);
+    size_t contextCount = options.tlsContextCount;
+    int exitCode = 0;
+    printf("%-10s %10s %12s %14s\n", "TlsContext", "contexts", "us/context", "bytes held");
+    for (bool cached : {false, true})
+    {
+        Vector<Io::TlsContext> contexts;
+        contexts.reserve(contextCount);
+        size_t bytesBefore = aws_mem_tracer_bytes(allocator);
+        uint64_t startNs = s_Now();
+        for (size_t i = 0; i < contextCount; ++i)
+        {
+            if (cached)
+            {
+                contexts.push_back(cache.GetOrCreate(tlsOptions, Io::TlsMode::CLIENT));
+            }
+            else
+            {
+                contexts.emplace_back(tlsOptions, Io::TlsMode::CLIENT, allocator);
+            }
+        }
+        uint64_t elapsedNs = s_Now() - startNs;
+        size_t bytesHeld = aws_mem_tracer_bytes(allocator) - bytesBefore;
+
+        size_t valid = 0;
+        for (const Io::TlsContext &context : contexts)
+        {
+            valid += context ? 1 : 0;
+        }
+
+        /* Only what the TLS library allocates through the CRT allocator shows up in bytes held */
+        printf(
+            "%-10s %10zu %12.1f %14zu\n",
+            cached ? "cached" : "direct",
+            valid,
+            static_cast<double>(elapsedNs) / 1000 / contextCount,
+            bytesHeld);
+        if (valid != contextCount)
+        {
+            exitCode = 1;
+        }
+    }
+
+    return exitCode;
+}
+
+#else
+
+static int s_RunTlsContextBenchmarks(const BenchmarkOptions &, Allocator *)
+{
+    fprintf(stderr, "--tls-contexts is not available in a build with BYO_CRYPTO\n");
+    return 1;
+}
+
+#endif
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+static Coro::DetachedTask s_AwaitCredentialsRepeatedly(
+    const Auth::ICredentialsProvider &provider,
+    size_t iterations,
+    std::promise<size_t> &done)
+{
+    size_t successCount = 0;
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        Coro::CredentialsResult result = co_await Coro::GetCredentials(provider);
+        if (result.errorCode == AWS_ERROR_SUCCESS && result.credentials)
+        {
+            ++successCount;
+        }
+    }
+    done.set_value(successCount);
+}
+
+static int s_RunCoroutineBenchmarks(const BenchmarkOptions &options, Allocator *allocator)
+{
+    /* The static provider completes inline, so this is the overhead of the wrapper and the coroutine frame */
+    Auth::CredentialsProviderStaticConfig config;
+    config.AccessKeyId = aws_byte_cursor_from_c_str("AccessKey");
+    config.SecretAccessKey = aws_byte_cursor_from_c_str("Sekrit");
+    auto provider = Auth::CredentialsProvider::CreateCredentialsProviderStatic(config, allocator);
+    if (!provider)
+    {
+        fprintf(
+            stderr, "Failed to create a credentials provider with error %s\n", aws_error_debug_str(aws_last_error()));
+        return 1;
+    }
+
+    size_t iterations = options.coroutineIterations;
+    size_t callbackSuccessCount = 0;
+    uint64_t startNs = s_Now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        provider->GetCredentials(
+            [&callbackSuccessCount](std::shared_ptr<Auth::Credentials> credentials, int errorCode)
+            {
+                if (errorCode == AWS_ERROR_SUCCESS && credentials)
+                {
+                    ++callbackSuccessCount;
+                }
+            });
+    }
+    uint64_t callbackNs = s_Now() - startNs;
+
+    std::promise<size_t> coroutineDone;
+    auto coroutineSuccessCount = coroutineDone.get_future();
+    startNs = s_Now();
+    s_AwaitCredentialsRepeatedly(*provider, iterations, coroutineDone);
+    size_t coroutineSuccesses = coroutineSuccessCount.get();
+    uint64_t coroutineNs = s_Now() - startNs;
+
+    printf("%-16s %10s %12s\n", "GetCredentials", "ops", "ns/op");
+    printf("%-16s %10zu %12.1f\n", "callback", callbackSuccessCount, static_cast<double>(callbackNs) / iterations);
+    printf("%-16s %10zu %12.1f\n", "co_await", coroutineSuccesses, static_cast<double>(coroutineNs) / iterations);
+
+    return callbackSuccessCount == iterations && coroutineSuccesses == iterations ? 0 : 1;
+}
+
+#else
+
+static int s_RunCoroutineBenchmarks(const BenchmarkOptions &, Allocator *)
+{
+    fprintf(stderr, "--coroutines needs a C++20 build, configure with -DENABLE_COROUTINE_TESTS=ON\n");
+    return 1;
+}
+
+#endif
+
+int main(int argc, char **argv)
+{
+    struct aws_allocator *allocator = aws_mem_tracer_new(aws_default_allocator(), NULL, AWS_MEMTRACE_BYTES, 0);
+    int exitCode = 0;
+
+    {
+        ApiHandle apiHandle(allocator);
+        BenchmarkOptions options;
+        s_ParseOptions(argc, argv, options);
+
+        if (options.coroutineIterations > 0)
+        {
+            exitCode = s_RunCoroutineBenchmarks(options, allocator);
+        }
+        else if (options.handlerFrames > 0)
+        {
+            exitCode = s_RunHandlerBenchmarks(options, allocator);
+        }
+        else if (options.taskCount > 0)
+        {
+            exitCode = s_RunTaskBenchmarks(options, allocator);
+        }
+        else if (options.tlsContextCount > 0)
+        {
+            exitCode = s_RunTlsContextBenchmarks(options, allocator);
+        }
+        else
+        {
+            s_Usage(1);
+        }
+    }
+
+    aws_mem_tracer_destroy(allocator);
+
+    return exitCode;
+}
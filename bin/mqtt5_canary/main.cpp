@@ -4,6 +4,8 @@
  */
 
 #include <aws/crt/Api.h>
+#include <aws/crt/JsonObject.h>
+#include <aws/crt/LatencyHistogram.h>
 #include <aws/crt/StlAllocator.h>
 #include <aws/crt/UUID.h>
 #include <aws/crt/crypto/Hash.h>
@@ -16,6 +18,7 @@
 
 #include <aws/common/clock.h>
 #include <aws/common/command_line_parser.h>
+#include <aws/common/file.h>
 #include <aws/common/mutex.h>
 #include <condition_variable>
 #include <inttypes.h>
@@ -67,6 +70,12 @@ enum AwsMqtt5CanaryOperations
     AWS_MQTT5_CANARY_OPERATION_COUNT = 13,
 };
 
+enum AwsMqtt5CanaryOutputFormat
+{
+    AWS_MQTT5_CANARY_OUTPUT_JSON = 0,
+    AWS_MQTT5_CANARY_OUTPUT_CSV = 1,
+};
+
 struct AwsMqtt5CanaryTesterOptions
 {
     uint16_t elgMaxThreads;
@@ -77,6 +86,8 @@ struct AwsMqtt5CanaryTesterOptions
     enum AwsMqtt5CanaryOperations *operations;
     size_t testRunSeconds;
     size_t memoryCheckIntervalSec; // Print memory usage every monitorSecond
+    const char *outputFile;        // Results are written there at the end of the run, "-" for stdout
+    enum AwsMqtt5CanaryOutputFormat outputFormat;
 };
 
 static void s_Usage(int exit_code)
@@ -98,6 +109,8 @@ static void s_Usage(int exit_code)
     fprintf(stderr, "  -C, --clients: number of mqtt5 clients to use\n");
     fprintf(stderr, "  -T, --tps: operations to run per second\n");
     fprintf(stderr, "  -s, --seconds: seconds to run canary test\n");
+    fprintf(stderr, "  -o, --output FILE: write the run's results and latency percentiles to FILE, - for stdout\n");
+    fprintf(stderr, "  -F, --format json|csv: format of --output. Default is json.\n");
     fprintf(stderr, "  -h, --help\n");
     fprintf(stderr, "            Display this message and quit.\n");
     exit(exit_code);
@@ -117,6 +130,8 @@ static struct aws_cli_option s_long_options[] = {
     {"clients", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'C'},
     {"tps", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'T'},
     {"seconds", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 's'},
+    {"output", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'o'},
+    {"format", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'F'},
     /* Per getopt(3) the last element of the array has to be filled with all zeros */
     {NULL, AWS_CLI_OPTIONS_NO_ARGUMENT, NULL, 0},
 };
@@ -127,7 +142,7 @@ static void s_ParseOptions(int argc, char **argv, struct AppCtx &ctx, struct Aws
     while (true)
     {
         int option_index = 0;
-        int c = aws_cli_getopt_long(argc, argv, "a:c:e:f:l:v:wht:C:T:s:", s_long_options, &option_index);
+        int c = aws_cli_getopt_long(argc, argv, "a:c:e:f:l:v:wht:C:T:s:o:F:", s_long_options, &option_index);
         if (c == -1)
         {
             /* finished parsing */
@@ -202,6 +217,24 @@ static void s_ParseOptions(int argc, char **argv, struct AppCtx &ctx, struct Aws
             case 's':
                 testerOptions->testRunSeconds = atoi(aws_cli_optarg);
                 break;
+            case 'o':
+                testerOptions->outputFile = aws_cli_optarg;
+                break;
+            case 'F':
+                if (!strcmp(aws_cli_optarg, "json"))
+                {
+                    testerOptions->outputFormat = AWS_MQTT5_CANARY_OUTPUT_JSON;
+                }
+                else if (!strcmp(aws_cli_optarg, "csv"))
+                {
+                    testerOptions->outputFormat = AWS_MQTT5_CANARY_OUTPUT_CSV;
+                }
+                else
+                {
+                    fprintf(stderr, "unsupported output format %s\n", aws_cli_optarg);
+                    s_Usage(1);
+                }
+                break;
             case 0x02:
                 /* getopt_long() returns 0x02 (START_OF_TEXT) if a positional arg was encountered */
                 ctx.uri = Io::Uri(aws_byte_cursor_from_c_str(aws_cli_positional_arg), ctx.allocator);
@@ -257,6 +290,9 @@ static void s_AwsMqtt5CanaryInitTesterOptions(struct AwsMqtt5CanaryTesterOptions
     testerOptions->testRunSeconds = 60;
     /* Time interval for printing memory usage info in seconds. Default to 10 mins */
     testerOptions->memoryCheckIntervalSec = 600;
+    /* No results file unless requested, JSON by default */
+    testerOptions->outputFile = NULL;
+    testerOptions->outputFormat = AWS_MQTT5_CANARY_OUTPUT_JSON;
 }
 
 struct AwsMqtt5CanaryStatistic
@@ -276,6 +312,48 @@ struct AwsMqtt5CanaryStatistic
     uint64_t unsub_failed;
 } g_statistic;
 
+/**********************************************************
+ * LATENCY
+ **********************************************************/
+
+enum AwsMqtt5CanaryLatencyKind
+{
+    AWS_MQTT5_CANARY_LATENCY_PUBLISH_QOS0 = 0,
+    AWS_MQTT5_CANARY_LATENCY_PUBLISH_QOS1 = 1,
+    AWS_MQTT5_CANARY_LATENCY_SUBSCRIBE = 2,
+    AWS_MQTT5_CANARY_LATENCY_UNSUBSCRIBE = 3,
+    AWS_MQTT5_CANARY_LATENCY_COUNT = 4,
+};
+
+static const char *s_AwsMqtt5CanaryLatencyNames[AWS_MQTT5_CANARY_LATENCY_COUNT] = {
+    "publish_qos0",
+    "publish_qos1",
+    "subscribe",
+    "unsubscribe",
+};
+
+/* Time from when an operation was due to its successful completion, per kind of operation */
+static LatencyHistogram g_latencies[AWS_MQTT5_CANARY_LATENCY_COUNT];
+
+/*
+ * When the operation the main loop is issuing was due. The load is generated open loop, on a fixed schedule, and
+ * latencies are measured from the schedule rather than from when the operation could actually be issued, so a
+ * stalled client shows up as latency instead of silently lowering the request rate.
+ */
+static uint64_t g_operationDueNs = 0;
+
+static void s_AwsMqtt5CanaryRecordLatency(AwsMqtt5CanaryLatencyKind kind, uint64_t dueNs)
+{
+    if (dueNs == 0)
+    {
+        return;
+    }
+
+    uint64_t now = 0;
+    aws_high_res_clock_get_ticks(&now);
+    g_latencies[kind].Record(now > dueNs ? now - dueNs : 0);
+}
+
 struct AwsMqtt5CanaryTestClient
 {
     std::shared_ptr<Mqtt5::Mqtt5Client> client;
@@ -445,7 +523,8 @@ static int s_AwsMqtt5CanaryOperationSubscribe(struct AwsMqtt5CanaryTestClient *t
     ++g_statistic.subscribe_attempt;
     AWS_LOGF_INFO(AWS_LS_MQTT5_CANARY, "ID:%s Subscribe to topic: %s", testClient->clientId.c_str(), topicArray);
 
-    if (testClient->client->Subscribe(packet, [](int errorcode, std::shared_ptr<SubAckPacket>) {
+    uint64_t dueNs = g_operationDueNs;
+    if (testClient->client->Subscribe(packet, [dueNs](int errorcode, std::shared_ptr<SubAckPacket>) {
             if (errorcode != 0)
             {
                 ++g_statistic.subscribe_failed;
@@ -457,6 +536,7 @@ static int s_AwsMqtt5CanaryOperationSubscribe(struct AwsMqtt5CanaryTestClient *t
                 return;
             }
             ++g_statistic.subscribe_succeed;
+            s_AwsMqtt5CanaryRecordLatency(AWS_MQTT5_CANARY_LATENCY_SUBSCRIBE, dueNs);
         }))
     {
         return AWS_OP_SUCCESS;
@@ -484,10 +564,12 @@ static int s_AwsMqtt5CanaryOperationUnsubscribeBad(struct AwsMqtt5CanaryTestClie
 
     ++g_statistic.totalOperations;
     ++g_statistic.unsub_attempt;
+    uint64_t dueNs = g_operationDueNs;
     if (testClient->client->Unsubscribe(
-            unsubscription, [testClient](int, std::shared_ptr<Mqtt5::UnSubAckPacket> packet) {
+            unsubscription, [testClient, dueNs](int, std::shared_ptr<Mqtt5::UnSubAckPacket> packet) {
                 if (packet == nullptr)
                     return;
+                s_AwsMqtt5CanaryRecordLatency(AWS_MQTT5_CANARY_LATENCY_UNSUBSCRIBE, dueNs);
                 if (packet->getReasonCodes()[0] == AWS_MQTT5_UARC_SUCCESS)
                 {
                     ++g_statistic.unsub_succeed;
@@ -532,7 +614,13 @@ static int s_AwsMqtt5CanaryOperationUnsubscribe(struct AwsMqtt5CanaryTestClient
 
     ++g_statistic.totalOperations;
     ++g_statistic.unsub_attempt;
-    if (testClient->client->Unsubscribe(unsubscription))
+    uint64_t dueNs = g_operationDueNs;
+    if (testClient->client->Unsubscribe(unsubscription, [dueNs](int errorcode, std::shared_ptr<Mqtt5::UnSubAckPacket>) {
+            if (errorcode == AWS_ERROR_SUCCESS)
+            {
+                s_AwsMqtt5CanaryRecordLatency(AWS_MQTT5_CANARY_LATENCY_UNSUBSCRIBE, dueNs);
+            }
+        }))
     {
         ++g_statistic.unsub_succeed;
         AWS_LOGF_INFO(
@@ -586,20 +674,26 @@ static int s_AwsMqtt5CanaryOperationPublish(
     ++g_statistic.totalOperations;
     ++g_statistic.publish_attempt;
 
-    if (testClient->client->Publish(packetPublish, [testClient](int errorcode, std::shared_ptr<PublishResult> packet) {
-            if (errorcode != 0)
-            {
-                ++g_statistic.publish_failed;
-                AWS_LOGF_ERROR(
-                    AWS_LS_MQTT5_CANARY,
-                    "ID: %s Publish failed with error code: %d, %s\n",
-                    testClient->clientId.c_str(),
-                    errorcode,
-                    aws_error_str(errorcode));
-                return;
-            }
-            ++g_statistic.publish_succeed;
-        }))
+    uint64_t dueNs = g_operationDueNs;
+    AwsMqtt5CanaryLatencyKind latencyKind = qos == AWS_MQTT5_QOS_AT_MOST_ONCE ? AWS_MQTT5_CANARY_LATENCY_PUBLISH_QOS0
+                                                                              : AWS_MQTT5_CANARY_LATENCY_PUBLISH_QOS1;
+    if (testClient->client->Publish(
+            packetPublish,
+            [testClient, dueNs, latencyKind](int errorcode, std::shared_ptr<PublishResult> packet) {
+                if (errorcode != 0)
+                {
+                    ++g_statistic.publish_failed;
+                    AWS_LOGF_ERROR(
+                        AWS_LS_MQTT5_CANARY,
+                        "ID: %s Publish failed with error code: %d, %s\n",
+                        testClient->clientId.c_str(),
+                        errorcode,
+                        aws_error_str(errorcode));
+                    return;
+                }
+                ++g_statistic.publish_succeed;
+                s_AwsMqtt5CanaryRecordLatency(latencyKind, dueNs);
+            }))
     {
         AWS_LOGF_INFO(
             AWS_LS_MQTT5_CANARY, "ID:%s Publish to topic %s", testClient->clientId.c_str(), topicFilter.c_str());
@@ -727,6 +821,155 @@ static struct AwsMqtt5CanaryOperationsFunctionTable s_AwsMqtt5CanaryOperationTab
     &s_AwsMqtt5CanaryOperationPublishToSharedTopicQos1,     /* publish_to_shared_topic_qos1 */
 }};
 
+/**********************************************************
+ * RESULTS
+ **********************************************************/
+
+struct AwsMqtt5CanaryRunSummary
+{
+    ApiHandle::Version crtVersion;
+    size_t clientCount;
+    size_t operationsExecuted;
+    uint64_t durationNs;
+    uint64_t maxScheduleLagNs;
+    size_t outstandingBytes;
+};
+
+static double s_NanosToMicros(double nanos)
+{
+    return nanos / 1000.0;
+}
+
+static void s_AwsMqtt5CanaryWriteJsonResults(
+    FILE *output,
+    const struct AwsMqtt5CanaryTesterOptions *testerOptions,
+    const struct AwsMqtt5CanaryRunSummary *summary,
+    const LatencyHistogramSnapshot *snapshots)
+{
+    char versionString[64];
+    snprintf(
+        versionString,
+        sizeof(versionString),
+        "%u.%u.%u",
+        (unsigned)summary->crtVersion.major,
+        (unsigned)summary->crtVersion.minor,
+        (unsigned)summary->crtVersion.patch);
+
+    double durationSeconds = (double)summary->durationNs / AWS_TIMESTAMP_NANOS;
+
+    JsonObject counters;
+    counters.WithInt64("totalOperations", (int64_t)g_statistic.totalOperations)
+        .WithInt64("subscribeAttempt", (int64_t)g_statistic.subscribe_attempt)
+        .WithInt64("subscribeSucceed", (int64_t)g_statistic.subscribe_succeed)
+        .WithInt64("subscribeFailed", (int64_t)g_statistic.subscribe_failed)
+        .WithInt64("publishAttempt", (int64_t)g_statistic.publish_attempt)
+        .WithInt64("publishSucceed", (int64_t)g_statistic.publish_succeed)
+        .WithInt64("publishFailed", (int64_t)g_statistic.publish_failed)
+        .WithInt64("unsubAttempt", (int64_t)g_statistic.unsub_attempt)
+        .WithInt64("unsubSucceed", (int64_t)g_statistic.unsub_succeed)
+        .WithInt64("unsubFailed", (int64_t)g_statistic.unsub_failed);
+
+    Vector<JsonObject> latencies;
+    for (size_t i = 0; i < AWS_MQTT5_CANARY_LATENCY_COUNT; ++i)
+    {
+        const LatencyHistogramSnapshot &snapshot = snapshots[i];
+        JsonObject latency;
+        latency.WithString("operation", s_AwsMqtt5CanaryLatencyNames[i])
+            .WithInt64("count", (int64_t)snapshot.count)
+            .WithDouble("meanUs", s_NanosToMicros(snapshot.GetMeanNanos()))
+            .WithDouble("p50Us", s_NanosToMicros((double)snapshot.GetPercentileNanos(50.0)))
+            .WithDouble("p90Us", s_NanosToMicros((double)snapshot.GetPercentileNanos(90.0)))
+            .WithDouble("p99Us", s_NanosToMicros((double)snapshot.GetPercentileNanos(99.0)))
+            .WithDouble("p999Us", s_NanosToMicros((double)snapshot.GetPercentileNanos(99.9)))
+            .WithDouble("maxUs", s_NanosToMicros((double)snapshot.maxNanos));
+        latencies.push_back(std::move(latency));
+    }
+
+    JsonObject results;
+    results.WithString("crtVersion", versionString)
+        .WithInt64("clients", (int64_t)summary->clientCount)
+        .WithInt64("targetTps", (int64_t)testerOptions->tps)
+        .WithDouble("achievedTps", durationSeconds > 0 ? summary->operationsExecuted / durationSeconds : 0)
+        .WithDouble("durationSeconds", durationSeconds)
+        .WithDouble("maxScheduleLagUs", s_NanosToMicros((double)summary->maxScheduleLagNs))
+        .WithInt64("outstandingBytes", (int64_t)summary->outstandingBytes)
+        .WithObject("counters", std::move(counters))
+        .WithArray("latencies", std::move(latencies));
+
+    fprintf(output, "%s\n", results.View().WriteReadable().c_str());
+}
+
+static void s_AwsMqtt5CanaryWriteCsvResults(
+    FILE *output,
+    const struct AwsMqtt5CanaryTesterOptions *testerOptions,
+    const struct AwsMqtt5CanaryRunSummary *summary,
+    const LatencyHistogramSnapshot *snapshots)
+{
+    double durationSeconds = (double)summary->durationNs / AWS_TIMESTAMP_NANOS;
+    double achievedTps = durationSeconds > 0 ? summary->operationsExecuted / durationSeconds : 0;
+
+    fprintf(
+        output,
+        "operation,clients,target_tps,achieved_tps,count,mean_us,p50_us,p90_us,p99_us,p999_us,max_us,"
+        "max_schedule_lag_us\n");
+    for (size_t i = 0; i < AWS_MQTT5_CANARY_LATENCY_COUNT; ++i)
+    {
+        const LatencyHistogramSnapshot &snapshot = snapshots[i];
+        fprintf(
+            output,
+            "%s,%zu,%zu,%.2f,%" PRIu64 ",%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+            s_AwsMqtt5CanaryLatencyNames[i],
+            summary->clientCount,
+            testerOptions->tps,
+            achievedTps,
+            snapshot.count,
+            s_NanosToMicros(snapshot.GetMeanNanos()),
+            s_NanosToMicros((double)snapshot.GetPercentileNanos(50.0)),
+            s_NanosToMicros((double)snapshot.GetPercentileNanos(90.0)),
+            s_NanosToMicros((double)snapshot.GetPercentileNanos(99.0)),
+            s_NanosToMicros((double)snapshot.GetPercentileNanos(99.9)),
+            s_NanosToMicros((double)snapshot.maxNanos),
+            s_NanosToMicros((double)summary->maxScheduleLagNs));
+    }
+}
+
+static void s_AwsMqtt5CanaryWriteResults(
+    const struct AwsMqtt5CanaryTesterOptions *testerOptions,
+    const struct AwsMqtt5CanaryRunSummary *summary)
+{
+    bool toStdout = strcmp(testerOptions->outputFile, "-") == 0;
+    FILE *output = toStdout ? stdout : aws_fopen(testerOptions->outputFile, "w");
+    if (output == NULL)
+    {
+        fprintf(stderr, "Failed to open %s for writing results\n", testerOptions->outputFile);
+        return;
+    }
+
+    LatencyHistogramSnapshot snapshots[AWS_MQTT5_CANARY_LATENCY_COUNT];
+    for (size_t i = 0; i < AWS_MQTT5_CANARY_LATENCY_COUNT; ++i)
+    {
+        snapshots[i] = g_latencies[i].GetSnapshot();
+    }
+
+    if (testerOptions->outputFormat == AWS_MQTT5_CANARY_OUTPUT_CSV)
+    {
+        s_AwsMqtt5CanaryWriteCsvResults(output, testerOptions, summary, snapshots);
+    }
+    else
+    {
+        s_AwsMqtt5CanaryWriteJsonResults(output, testerOptions, summary, snapshots);
+    }
+
+    if (toStdout)
+    {
+        fflush(output);
+    }
+    else
+    {
+        fclose(output);
+    }
+}
+
 /**********************************************************
  * MAIN
  **********************************************************/
@@ -987,8 +1230,10 @@ int main(int argc, char **argv)
          **********************************************************/
         bool done = false;
         size_t operationsExecuted = 0;
-        uint64_t timeTestFinish = 0;
-        aws_high_res_clock_get_ticks(&timeTestFinish);
+        uint64_t maxScheduleLagNs = 0;
+        uint64_t timeTestStart = 0;
+        aws_high_res_clock_get_ticks(&timeTestStart);
+        uint64_t timeTestFinish = timeTestStart;
         timeTestFinish +=
             aws_timestamp_convert(testerOptions.testRunSeconds, AWS_TIMESTAMP_SECS, AWS_TIMESTAMP_NANOS, NULL);
         uint64_t timeInterval =
@@ -999,15 +1244,35 @@ int main(int argc, char **argv)
 
         while (!done)
         {
+            /*
+             * Operations are issued on a fixed schedule rather than a fixed pause after each one, so a slow
+             * operation does not lower the offered load. When behind schedule, the next operation is issued at once.
+             */
             uint64_t now = 0;
             aws_high_res_clock_get_ticks(&now);
+            uint64_t dueTime = now;
+            if (testerOptions.tpsSleepTime != 0)
+            {
+                dueTime = timeTestStart + operationsExecuted * testerOptions.tpsSleepTime;
+                if (now < dueTime)
+                {
+                    aws_thread_current_sleep(dueTime - now);
+                    aws_high_res_clock_get_ticks(&now);
+                }
+                else if (now - dueTime > maxScheduleLagNs)
+                {
+                    maxScheduleLagNs = now - dueTime;
+                }
+            }
             operationsExecuted++;
 
             AwsMqtt5CanaryOperations nextOperation = s_AwsMqtt5CanaryGetRandomOperation(&testerOptions);
             awsMqtt5CanaryOperationFn *operation_fn =
                 s_AwsMqtt5CanaryOperationTable.operationByOperationType[nextOperation];
 
+            g_operationDueNs = dueTime;
             (*operation_fn)(&clients[rand() % clients.size()], appCtx.allocator);
+            g_operationDueNs = 0;
 
             if (now > timeTestFinish)
             {
@@ -1026,9 +1291,10 @@ int main(int argc, char **argv)
                 fprintf(stderr, "   Operations executed: %zu\n", operationsExecuted);
                 memoryCheckPoint = now + timeInterval;
             }
-
-            aws_thread_current_sleep(testerOptions.tpsSleepTime);
         }
+
+        uint64_t timeTestEnd = 0;
+        aws_high_res_clock_get_ticks(&timeTestEnd);
         /**********************************************************
          * CLEAN UP
          **********************************************************/
@@ -1068,6 +1334,18 @@ int main(int argc, char **argv)
             g_statistic.unsub_attempt,
             g_statistic.unsub_succeed,
             g_statistic.unsub_failed);
+
+        if (testerOptions.outputFile != NULL)
+        {
+            struct AwsMqtt5CanaryRunSummary summary;
+            summary.crtVersion = apiHandle.GetCrtVersion();
+            summary.clientCount = clients.size();
+            summary.operationsExecuted = operationsExecuted;
+            summary.durationNs = timeTestEnd - timeTestStart;
+            summary.maxScheduleLagNs = maxScheduleLagNs;
+            summary.outstandingBytes = aws_mem_tracer_bytes(allocator);
+            s_AwsMqtt5CanaryWriteResults(&testerOptions, &summary);
+        }
     }
 
     aws_mem_tracer_destroy(allocator);
@@ -0,0 +1,1664 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/*
+ * Offline throughput/latency benchmark of Mqtt5Client and MqttConnection against the in-process loopback broker
+ * of the test suite. Every client subscribes to its own topic and keeps a window of QoS 1 publishes to it in
+ * flight, so each message measures both the PUBACK round trip and the delivery back to the client. The
+ * adapter-nocb protocol publishes through the adapter's cursor path without a completion callback: the delivery
+ * back to the client paces the next publish instead, and its ack columns stay empty.
+ *
+ * With --memory, it instead connects many idle clients at once, as individual Mqtt5Clients and as one
+ * Mqtt5ClientFleet, and reports the memory held per connection.
+ *
+ * With --durable-queue, it instead measures the disk-backed offline queue of Mqtt5Client: how fast publishes are
+ * spilled to the segment file while offline, and replayed from it once connected.
+ *
+ * With --compression, it instead measures payload compression of Mqtt5Client on telemetry-like JSON: the ratio,
+ * codec throughput with and without reusing codecs, and the bytes and rate of publishes on the loopback broker.
+ *
+ * With --request-response, it instead keeps that many requests outstanding at once on a RequestResponseClient,
+ * answered by an echoing client, and reports the request and response rates and the round trip latency.
+ */
+
+#include <aws/crt/Api.h>
+#include <aws/crt/Compression.h>
+#include <aws/crt/LatencyHistogram.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5ClientFleet.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/crt/mqtt/Mqtt5RequestResponseClient.h>
+#include <aws/crt/mqtt/MqttClient.h>
+#include <aws/crt/mqtt/private/Mqtt5CallbackGate.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/command_line_parser.h>
+
+#include "MqttLoopbackBroker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <inttypes.h>
+#include <mutex>
+#include <thread>
+
+using namespace Aws::Crt;
+
+#define AWS_MQTT_BENCHMARK_TIMEOUT_SEC 10
+#define AWS_MQTT_BENCHMARK_RUN_TIMEOUT_SEC 120
+
+struct BenchmarkOptions
+{
+    Vector<size_t> clientCounts;
+    Vector<size_t> payloadSizes;
+    Vector<size_t> memoryClientCounts;
+    size_t durableQueueMessages = 0;
+    const char *compression = nullptr;
+    CompressionAlgorithm compressionAlgorithm = CompressionAlgorithm::Deflate;
+    size_t callbackDispatches = 0;
+    size_t outstandingRequests = 0;
+    size_t messagesPerClient = 1000;
+    size_t window = 32;
+    uint16_t threads = 0;
+    bool mqtt5 = true;
+    bool mqtt311 = true;
+    bool adapter = true;
+};
+
+static void s_Usage(int exit_code)
+{
+    fprintf(stderr, "usage: mqtt_benchmark [options]\n");
+    fprintf(stderr, "\n Options:\n\n");
+    fprintf(stderr, "  -p, --protocol 5|311|adapter|all: client implementation(s) to benchmark, adapter being the\n");
+    fprintf(stderr, "            MQTT 3.1.1 API over an MQTT5 client, with and without its cursor data path, and\n");
+    fprintf(stderr, "            on the cursor data path without completion callbacks.\n");
+    fprintf(stderr, "            Default is all.\n");
+    fprintf(stderr, "  -C, --clients LIST: comma separated numbers of concurrent clients. Default is 1,10,50.\n");
+    fprintf(stderr, "  -s, --sizes LIST: comma separated payload sizes in bytes. Default is 16,256,4096,65536.\n");
+    fprintf(stderr, "  -n, --messages INT: QoS 1 messages published by each client per run. Default is 1000.\n");
+    fprintf(stderr, "  -w, --window INT: publishes each client keeps in flight. Default is 32.\n");
+    fprintf(stderr, "  -t, --threads INT: event loop threads of the clients and of the broker. Default: all cores.\n");
+    fprintf(stderr, "  -m, --memory LIST: instead of throughput, measure memory per idle MQTT5 connection for the\n");
+    fprintf(stderr, "            comma separated numbers of clients, e.g. 10000. Each connection takes two file\n");
+    fprintf(stderr, "            descriptors: raise ulimit -n accordingly.\n");
+    fprintf(stderr, "  -d, --durable-queue INT: instead of throughput, spill INT QoS 1 publishes of each of the\n");
+    fprintf(stderr, "            --sizes to a durable offline queue while offline, then replay them.\n");
+    fprintf(stderr, "  -z, --compression deflate|zstd: instead of throughput, compress --messages telemetry JSON\n");
+    fprintf(stderr, "            payloads of about each of the --sizes, and publish them with and without\n");
+    fprintf(stderr, "            payload compression.\n");
+    fprintf(stderr, "  -g, --callback-dispatch INT: instead of throughput, time INT callback dispatches per thread\n");
+    fprintf(stderr, "            through the callback gate of a client and through the recursive lock it replaced,\n");
+    fprintf(stderr, "            on 1 to --threads concurrent threads.\n");
+    fprintf(stderr, "  -r, --request-response INT: instead of throughput, issue INT requests of each of the --sizes\n");
+    fprintf(stderr, "            at once through a request/response client, e.g. 10000, and wait for all responses.\n");
+    fprintf(stderr, "  -h, --help\n");
+    fprintf(stderr, "            Display this message and quit.\n");
+    exit(exit_code);
+}
+
+static struct aws_cli_option s_long_options[] = {
+    {"protocol", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'p'},
+    {"clients", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'C'},
+    {"sizes", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 's'},
+    {"messages", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'n'},
+    {"window", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'w'},
+    {"threads", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 't'},
+    {"memory", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'm'},
+    {"durable-queue", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'd'},
+    {"compression", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'z'},
+    {"callback-dispatch", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'g'},
+    {"request-response", AWS_CLI_OPTIONS_REQUIRED_ARGUMENT, NULL, 'r'},
+    {"help", AWS_CLI_OPTIONS_NO_ARGUMENT, NULL, 'h'},
+    /* Per getopt(3) the last element of the array has to be filled with all zeros */
+    {NULL, AWS_CLI_OPTIONS_NO_ARGUMENT, NULL, 0},
+};
+
+static Vector<size_t> s_ParseList(const char *list)
+{
+    Vector<size_t> values;
+    const char *position = list;
+    while (*position != '\0')
+    {
+        char *end = nullptr;
+        unsigned long value = strtoul(position, &end, 10);
+        if (end == position || value == 0)
+        {
+            fprintf(stderr, "invalid list %s\n", list);
+            s_Usage(1);
+        }
+
+        values.push_back(static_cast<size_t>(value));
+        position = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+static void s_ParseOptions(int argc, char **argv, BenchmarkOptions &options)
+{
+    while (true)
+    {
+        int option_index = 0;
+        int c = aws_cli_getopt_long(argc, argv, "p:C:s:n:w:t:m:d:z:g:r:h", s_long_options, &option_index);
+        if (c == -1)
+        {
+            /* finished parsing */
+            break;
+        }
+
+        switch (c)
+        {
+            case 0:
+                /* getopt_long() returns 0 if an option.flag is non-null */
+                break;
+            case 'p':
+                options.mqtt5 = !strcmp(aws_cli_optarg, "5") || !strcmp(aws_cli_optarg, "all");
+                options.mqtt311 = !strcmp(aws_cli_optarg, "311") || !strcmp(aws_cli_optarg, "all");
+                options.adapter = !strcmp(aws_cli_optarg, "adapter") || !strcmp(aws_cli_optarg, "all");
+                if (!options.mqtt5 && !options.mqtt311 && !options.adapter)
+                {
+                    fprintf(stderr, "unsupported protocol %s\n", aws_cli_optarg);
+                    s_Usage(1);
+                }
+                break;
+            case 'C':
+                options.clientCounts = s_ParseList(aws_cli_optarg);
+                break;
+            case 's':
+                options.payloadSizes = s_ParseList(aws_cli_optarg);
+                break;
+            case 'n':
+                options.messagesPerClient = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 'w':
+                options.window = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 't':
+                options.threads = static_cast<uint16_t>(atoi(aws_cli_optarg));
+                break;
+            case 'm':
+                options.memoryClientCounts = s_ParseList(aws_cli_optarg);
+                break;
+            case 'd':
+                options.durableQueueMessages = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 'z':
+                options.compression = aws_cli_optarg;
+                if (!strcmp(aws_cli_optarg, "zstd"))
+                {
+                    options.compressionAlgorithm = CompressionAlgorithm::Zstd;
+                }
+                else if (strcmp(aws_cli_optarg, "deflate"))
+                {
+                    fprintf(stderr, "unsupported compression %s\n", aws_cli_optarg);
+                    s_Usage(1);
+                }
+                break;
+            case 'g':
+                options.callbackDispatches = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 'r':
+                options.outstandingRequests = static_cast<size_t>(atoi(aws_cli_optarg));
+                break;
+            case 'h':
+                s_Usage(0);
+                break;
+            default:
+                fprintf(stderr, "Unknown option\n");
+                s_Usage(1);
+        }
+    }
+
+    if (options.clientCounts.empty())
+    {
+        options.clientCounts = {1, 10, 50};
+    }
+    if (options.payloadSizes.empty())
+    {
+        options.payloadSizes = {16, 256, 4096, 65536};
+    }
+    if (options.messagesPerClient == 0 || options.window == 0)
+    {
+        fprintf(stderr, "--messages and --window must be positive\n");
+        s_Usage(1);
+    }
+}
+
+static uint64_t s_Now()
+{
+    uint64_t now = 0;
+    aws_high_res_clock_get_ticks(&now);
+    return now;
+}
+
+template <typename T> static bool s_Wait(std::future<T> &future)
+{
+    return future.wait_for(std::chrono::seconds(AWS_MQTT_BENCHMARK_TIMEOUT_SEC)) == std::future_status::ready;
+}
+
+/*
+ * What the benchmark needs from a client, implemented over Mqtt5Client and MqttConnection. Connect(),
+ * Subscribe() and Disconnect() block until the operation completes.
+ */
+class BenchmarkClient
+{
+  public:
+    using OnMessage = std::function<void(ByteCursor payload)>;
+    using OnPublishComplete = std::function<void(int errorCode)>;
+
+    virtual ~BenchmarkClient() = default;
+
+    virtual bool Connect() = 0;
+    virtual bool Subscribe(const String &topic) = 0;
+    /* onComplete may only be empty for a Mqtt311BenchmarkClient on the cursor data path */
+    virtual bool Publish(const String &topic, ByteCursor payload, OnPublishComplete &&onComplete) = 0;
+    virtual void Disconnect() = 0;
+};
+
+class Mqtt5BenchmarkClient : public BenchmarkClient
+{
+  public:
+    Mqtt5BenchmarkClient(
+        const String &clientId,
+        uint32_t port,
+        Io::ClientBootstrap &bootstrap,
+        OnMessage &&onMessage,
+        Allocator *allocator)
+        : m_allocator(allocator)
+    {
+        auto connectPacket = MakeShared<Mqtt5::ConnectPacket>(allocator, allocator);
+        connectPacket->WithClientId(clientId);
+
+        Mqtt5::Mqtt5ClientOptions options(allocator);
+        options.WithHostName("127.0.0.1")
+            .WithPort(port)
+            .WithBootstrap(&bootstrap)
+            .WithConnectOptions(connectPacket)
+            .WithClientConnectionSuccessCallback([this](const Mqtt5::OnConnectionSuccessEventData &)
+                                                 { ReportConnection(true); })
+            .WithClientConnectionFailureCallback([this](const Mqtt5::OnConnectionFailureEventData &)
+                                                 { ReportConnection(false); })
+            .WithClientStoppedCallback([this](const Mqtt5::OnStoppedEventData &) { m_stoppedPromise.set_value(); })
+            .WithPublishReceivedCallback([onMessage](const Mqtt5::PublishReceivedEventData &eventData)
+                                         { onMessage(eventData.publishPacket->getPayload()); });
+
+        m_client = Mqtt5::Mqtt5Client::NewMqtt5Client(options, allocator);
+    }
+
+    bool Connect() override
+    {
+        auto connected = m_connectionPromise.get_future();
+        return m_client && m_client->Start() && s_Wait(connected) && connected.get();
+    }
+
+    bool Subscribe(const String &topic) override
+    {
+        std::promise<int> subscribed;
+        auto subscribePacket = MakeShared<Mqtt5::SubscribePacket>(m_allocator, m_allocator);
+        subscribePacket->WithSubscription(
+            Mqtt5::Subscription(topic, Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, m_allocator));
+
+        auto result = subscribed.get_future();
+        return m_client->Subscribe(
+                   subscribePacket,
+                   [&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+                   { subscribed.set_value(errorCode); }) &&
+               s_Wait(result) && result.get() == AWS_ERROR_SUCCESS;
+    }
+
+    bool Publish(const String &topic, ByteCursor payload, OnPublishComplete &&onComplete) override
+    {
+        auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+            m_allocator, topic, payload, Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, m_allocator);
+        return m_client->Publish(
+            publishPacket,
+            [onComplete](int errorCode, std::shared_ptr<Mqtt5::PublishResult>) { onComplete(errorCode); });
+    }
+
+    void Disconnect() override
+    {
+        if (m_client && m_client->Stop())
+        {
+            auto stopped = m_stoppedPromise.get_future();
+            s_Wait(stopped);
+        }
+    }
+
+  private:
+    /* the client keeps retrying after a failure: only the first attempt is reported */
+    void ReportConnection(bool connected)
+    {
+        if (!m_connectionReported.exchange(true))
+        {
+            m_connectionPromise.set_value(connected);
+        }
+    }
+
+    Allocator *m_allocator;
+    std::atomic<bool> m_connectionReported{false};
+    std::promise<bool> m_connectionPromise;
+    std::promise<void> m_stoppedPromise;
+    std::shared_ptr<Mqtt5::Mqtt5Client> m_client;
+};
+
+/*
+ * Over an MqttClient, or over an Mqtt5Client through the adapter when mqtt5Client is set. cursors selects the data
+ * path that passes topics and payloads as cursors.
+ */
+class Mqtt311BenchmarkClient : public BenchmarkClient
+{
+  public:
+    Mqtt311BenchmarkClient(
+        const String &clientId,
+        std::shared_ptr<Mqtt::MqttConnection> connection,
+        std::shared_ptr<Mqtt5::Mqtt5Client> mqtt5Client,
+        bool cursors,
+        OnMessage &&onMessage,
+        Allocator *allocator)
+        : m_clientId(clientId, StlAllocator<char>(allocator)), m_cursors(cursors), m_onMessage(std::move(onMessage)),
+          m_mqtt5Client(std::move(mqtt5Client)), m_connection(std::move(connection))
+    {
+        if (m_connection)
+        {
+            m_connection->OnConnectionCompleted =
+                [this](Mqtt::MqttConnection &, int errorCode, Mqtt::ReturnCode returnCode, bool)
+            {
+                bool accepted = errorCode == AWS_ERROR_SUCCESS && returnCode == AWS_MQTT_CONNECT_ACCEPTED;
+                m_connectionPromise.set_value(accepted);
+            };
+            m_connection->OnDisconnect = [this](Mqtt::MqttConnection &) { m_disconnectPromise.set_value(); };
+        }
+    }
+
+    bool Connect() override
+    {
+        auto connected = m_connectionPromise.get_future();
+        return m_connection && m_connection->Connect(m_clientId.c_str(), true) && s_Wait(connected) &&
+               connected.get();
+    }
+
+    bool Subscribe(const String &topic) override
+    {
+        std::promise<int> subscribed;
+        auto result = subscribed.get_future();
+        auto onSubAck = [&subscribed](Mqtt::MqttConnection &, uint16_t, const String &, Mqtt::QOS, int errorCode)
+        { subscribed.set_value(errorCode); };
+        uint16_t packetId = 0;
+        if (m_cursors)
+        {
+            packetId = m_connection->SubscribeWithCursorHandler(
+                topic.c_str(),
+                AWS_MQTT_QOS_AT_LEAST_ONCE,
+                [this](Mqtt::MqttConnection &, ByteCursor, ByteCursor payload, bool, Mqtt::QOS, bool)
+                { m_onMessage(payload); },
+                onSubAck);
+        }
+        else
+        {
+            packetId = m_connection->Subscribe(
+                topic.c_str(),
+                AWS_MQTT_QOS_AT_LEAST_ONCE,
+                [this](Mqtt::MqttConnection &, const String &, const ByteBuf &payload, bool, Mqtt::QOS, bool)
+                { m_onMessage(aws_byte_cursor_from_buf(&payload)); },
+                onSubAck);
+        }
+        return packetId != 0 && s_Wait(result) && result.get() == AWS_ERROR_SUCCESS;
+    }
+
+    bool Publish(const String &topic, ByteCursor payload, OnPublishComplete &&onComplete) override
+    {
+        if (m_cursors && !onComplete)
+        {
+            return m_connection->Publish(ByteCursorFromString(topic), AWS_MQTT_QOS_AT_LEAST_ONCE, false, payload) != 0;
+        }
+
+        if (m_cursors)
+        {
+            return m_connection->Publish(
+                       ByteCursorFromString(topic),
+                       AWS_MQTT_QOS_AT_LEAST_ONCE,
+                       false,
+                       payload,
+                       [onComplete](Mqtt::MqttConnection &, uint16_t, int errorCode) { onComplete(errorCode); }) != 0;
+        }
+
+        ByteBuf payloadBuf = aws_byte_buf_from_array(payload.ptr, payload.len);
+        return m_connection->Publish(
+                   topic.c_str(),
+                   AWS_MQTT_QOS_AT_LEAST_ONCE,
+                   false,
+                   payloadBuf,
+                   [onComplete](Mqtt::MqttConnection &, uint16_t, int errorCode) { onComplete(errorCode); }) != 0;
+    }
+
+    void Disconnect() override
+    {
+        if (m_connection && m_connection->Disconnect())
+        {
+            auto disconnected = m_disconnectPromise.get_future();
+            s_Wait(disconnected);
+        }
+    }
+
+  private:
+    String m_clientId;
+    bool m_cursors;
+    OnMessage m_onMessage;
+    std::promise<bool> m_connectionPromise;
+    std::promise<void> m_disconnectPromise;
+    std::shared_ptr<Mqtt5::Mqtt5Client> m_mqtt5Client;
+    std::shared_ptr<Mqtt::MqttConnection> m_connection;
+};
+
+/* An Mqtt5Client for the MQTT 3.1.1 adapter, which connects and disconnects it */
+static std::shared_ptr<Mqtt5::Mqtt5Client> s_NewAdapterClient(
+    const String &clientId,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    auto connectPacket = MakeShared<Mqtt5::ConnectPacket>(allocator, allocator);
+    connectPacket->WithClientId(clientId);
+
+    Mqtt5::Mqtt5ClientOptions options(allocator);
+    options.WithHostName("127.0.0.1").WithPort(port).WithBootstrap(&bootstrap).WithConnectOptions(connectPacket);
+    return Mqtt5::Mqtt5Client::NewMqtt5Client(options, allocator);
+}
+
+struct BenchmarkRun
+{
+    const char *protocol;
+    size_t clientCount;
+    size_t payloadSize;
+    /* publishes without a completion callback, each delivery counting as the completion */
+    bool fireAndForget = false;
+
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> received{0};
+    std::atomic<size_t> failed{0};
+    LatencyHistogram pubackLatency;
+    LatencyHistogram deliveryLatency;
+
+    size_t bytesPerClient = 0;
+    double seconds = 0;
+};
+
+struct BenchmarkClientState
+{
+    std::unique_ptr<BenchmarkClient> client;
+    String topic;
+    std::atomic<size_t> issued{0};
+};
+
+/*
+ * Publishes the next message of a client, stamped with its send time. Called once per window slot to start, then
+ * from each completion.
+ */
+static void s_PublishNext(BenchmarkRun &run, BenchmarkClientState &state, size_t messagesPerClient)
+{
+    if (state.issued.fetch_add(1) >= messagesPerClient)
+    {
+        return;
+    }
+
+    Vector<uint8_t> payload(std::max(run.payloadSize, sizeof(uint64_t)), 'x');
+    uint64_t sentNs = s_Now();
+    memcpy(payload.data(), &sentNs, sizeof(sentNs));
+
+    BenchmarkClient::OnPublishComplete onComplete;
+    if (!run.fireAndForget)
+    {
+        onComplete = [&run, &state, sentNs, messagesPerClient](int errorCode)
+        {
+            run.pubackLatency.Record(s_Now() - sentNs);
+            if (errorCode != AWS_ERROR_SUCCESS)
+            {
+                run.failed.fetch_add(1);
+            }
+            run.completed.fetch_add(1);
+            s_PublishNext(run, state, messagesPerClient);
+        };
+    }
+
+    bool started = state.client->Publish(
+        state.topic, aws_byte_cursor_from_array(payload.data(), payload.size()), std::move(onComplete));
+
+    if (!started)
+    {
+        run.failed.fetch_add(1);
+        run.completed.fetch_add(1);
+    }
+}
+
+static bool s_Run(
+    BenchmarkRun &run,
+    const BenchmarkOptions &options,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    Mqtt::MqttClient mqttClient(bootstrap, allocator);
+    auto onMessage = [&run](ByteCursor payload)
+    {
+        uint64_t sentNs = 0;
+        if (payload.len >= sizeof(sentNs))
+        {
+            memcpy(&sentNs, payload.ptr, sizeof(sentNs));
+            run.deliveryLatency.Record(s_Now() - sentNs);
+        }
+        run.received.fetch_add(1);
+    };
+
+    run.fireAndForget = !strcmp(run.protocol, "adapter-nocb");
+    size_t messagesPerClient = options.messagesPerClient;
+
+    size_t bytesBefore = aws_mem_tracer_bytes(allocator);
+    Vector<std::unique_ptr<BenchmarkClientState>> clients;
+    bool ok = true;
+    for (size_t i = 0; i < run.clientCount && ok; ++i)
+    {
+        std::unique_ptr<BenchmarkClientState> state(new BenchmarkClientState());
+        /* Without a completion callback, the delivery back to the client completes the publish */
+        BenchmarkClientState *statePointer = state.get();
+        auto onClientMessage = [&run, &onMessage, statePointer, messagesPerClient](ByteCursor payload)
+        {
+            onMessage(payload);
+            if (run.fireAndForget)
+            {
+                run.completed.fetch_add(1);
+                s_PublishNext(run, *statePointer, messagesPerClient);
+            }
+        };
+        String clientId = String("bench-") + run.protocol + "-" + std::to_string(i).c_str();
+        state->topic = String("bench/") + std::to_string(i).c_str() + "/data";
+        if (!strcmp(run.protocol, "mqtt5"))
+        {
+            state->client.reset(new Mqtt5BenchmarkClient(clientId, port, bootstrap, onClientMessage, allocator));
+        }
+        else if (!strcmp(run.protocol, "mqtt311"))
+        {
+            auto connection = mqttClient.NewConnection("127.0.0.1", port, Io::SocketOptions());
+            state->client.reset(
+                new Mqtt311BenchmarkClient(clientId, connection, nullptr, false, onClientMessage, allocator));
+        }
+        else
+        {
+            auto mqtt5Client = s_NewAdapterClient(clientId, port, bootstrap, allocator);
+            std::shared_ptr<Mqtt::MqttConnection> connection;
+            if (mqtt5Client)
+            {
+                connection = Mqtt::MqttConnection::NewConnectionFromMqtt5Client(mqtt5Client);
+            }
+            bool cursors = !strcmp(run.protocol, "adapter-fast") || run.fireAndForget;
+            state->client.reset(
+                new Mqtt311BenchmarkClient(clientId, connection, mqtt5Client, cursors, onClientMessage, allocator));
+        }
+
+        ok = state->client->Connect() && state->client->Subscribe(state->topic);
+        clients.push_back(std::move(state));
+    }
+
+    if (ok)
+    {
+        run.bytesPerClient = (aws_mem_tracer_bytes(allocator) - bytesBefore) / run.clientCount;
+
+        size_t target = run.clientCount * options.messagesPerClient;
+        uint64_t startNs = s_Now();
+        for (auto &state : clients)
+        {
+            for (size_t slot = 0; slot < options.window; ++slot)
+            {
+                s_PublishNext(run, *state, options.messagesPerClient);
+            }
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(AWS_MQTT_BENCHMARK_RUN_TIMEOUT_SEC);
+        while ((run.completed.load() < target || run.received.load() + run.failed.load() < target) &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        run.seconds = static_cast<double>(s_Now() - startNs) / AWS_TIMESTAMP_NANOS;
+        ok = run.completed.load() == target;
+    }
+
+    for (auto &state : clients)
+    {
+        state->client->Disconnect();
+    }
+    clients.clear();
+
+    return ok;
+}
+
+struct MemoryRun
+{
+    const char *mode;
+    size_t clientCount;
+
+    size_t connected = 0;
+    double connectSeconds = 0;
+    size_t bytesPerClient = 0;
+};
+
+/*
+ * Connects run.clientCount idle clients at once, either as individual Mqtt5Clients or as one Mqtt5ClientFleet, and
+ * measures the client side memory held per connection.
+ */
+static bool s_RunMemory(MemoryRun &run, uint32_t port, Io::ClientBootstrap &bootstrap, Allocator *allocator)
+{
+    std::atomic<size_t> connected(0);
+    std::atomic<size_t> stopped(0);
+    Vector<std::shared_ptr<Mqtt5::Mqtt5Client>> clients;
+    std::shared_ptr<Mqtt5::Mqtt5ClientFleet> fleet;
+    bool started = true;
+
+    size_t bytesBefore = aws_mem_tracer_bytes(allocator);
+    uint64_t startNs = s_Now();
+    if (!strcmp(run.mode, "fleet"))
+    {
+        Mqtt5::Mqtt5ClientOptions options(allocator);
+        options.WithHostName("127.0.0.1").WithPort(port).WithBootstrap(&bootstrap);
+
+        Mqtt5::Mqtt5ClientFleetOptions fleetOptions(allocator);
+        fleetOptions.WithClientCount(run.clientCount)
+            .WithClientIdPrefix("memory-fleet-")
+            .WithConnectionSuccessCallback([&connected](size_t, const Mqtt5::OnConnectionSuccessEventData &)
+                                           { connected.fetch_add(1); })
+            .WithStoppedCallback([&stopped](size_t, const Mqtt5::OnStoppedEventData &) { stopped.fetch_add(1); });
+
+        fleet = Mqtt5::Mqtt5ClientFleet::NewMqtt5ClientFleet(options, fleetOptions, allocator);
+        started = fleet && fleet->Start();
+    }
+    else
+    {
+        clients.reserve(run.clientCount);
+        for (size_t i = 0; i < run.clientCount && started; ++i)
+        {
+            auto connectPacket = MakeShared<Mqtt5::ConnectPacket>(allocator, allocator);
+            connectPacket->WithClientId(String("memory-mqtt5-") + std::to_string(i).c_str());
+
+            Mqtt5::Mqtt5ClientOptions options(allocator);
+            options.WithHostName("127.0.0.1")
+                .WithPort(port)
+                .WithBootstrap(&bootstrap)
+                .WithConnectOptions(connectPacket)
+                .WithClientConnectionSuccessCallback([&connected](const Mqtt5::OnConnectionSuccessEventData &)
+                                                     { connected.fetch_add(1); })
+                .WithClientStoppedCallback([&stopped](const Mqtt5::OnStoppedEventData &) { stopped.fetch_add(1); });
+
+            auto client = Mqtt5::Mqtt5Client::NewMqtt5Client(options, allocator);
+            started = client && client->Start();
+            clients.push_back(std::move(client));
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(AWS_MQTT_BENCHMARK_RUN_TIMEOUT_SEC);
+    while (started && connected.load() < run.clientCount && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    run.connectSeconds = static_cast<double>(s_Now() - startNs) / AWS_TIMESTAMP_NANOS;
+    run.connected = connected.load();
+    run.bytesPerClient = (aws_mem_tracer_bytes(allocator) - bytesBefore) / run.clientCount;
+
+    size_t stopping = 0;
+    if (fleet)
+    {
+        fleet->Stop();
+        stopping = fleet->GetClientCount();
+    }
+    for (auto &client : clients)
+    {
+        if (client && client->Stop())
+        {
+            ++stopping;
+        }
+    }
+
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(AWS_MQTT_BENCHMARK_RUN_TIMEOUT_SEC);
+    while (stopped.load() < stopping && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    fleet = nullptr;
+    clients.clear();
+
+    return started && run.connected == run.clientCount;
+}
+
+static void s_PrintMemoryRun(const MemoryRun &run)
+{
+    printf(
+        "%-8s %8zu %10zu %10.2f %12zu\n",
+        run.mode,
+        run.clientCount,
+        run.connected,
+        run.connectSeconds,
+        run.bytesPerClient);
+}
+
+struct DurableQueueRun
+{
+    size_t messages;
+    size_t payloadSize;
+
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> failed{0};
+    double spillSeconds = 0;
+    double replaySeconds = 0;
+};
+
+static const char *s_durableQueueSegmentPath = "mqtt_benchmark.segment";
+
+/*
+ * Publishes run.messages QoS 1 messages with a client that has not connected yet, so that they all go to the
+ * segment file, then connects it and waits for all of them to be replayed and acknowledged.
+ */
+static bool s_RunDurableQueue(DurableQueueRun &run, uint32_t port, Io::ClientBootstrap &bootstrap, Allocator *allocator)
+{
+    remove(s_durableQueueSegmentPath);
+
+    Mqtt5::DurableOfflineQueueOptions queueOptions;
+    queueOptions.m_segmentFilePath = s_durableQueueSegmentPath;
+    queueOptions.m_memoryWatermarkBytes = 1024 * 1024;
+
+    std::promise<void> stopped;
+    auto connectPacket = MakeShared<Mqtt5::ConnectPacket>(allocator, allocator);
+    connectPacket->WithClientId("bench-durable-queue");
+
+    Mqtt5::Mqtt5ClientOptions options(allocator);
+    options.WithHostName("127.0.0.1")
+        .WithPort(port)
+        .WithBootstrap(&bootstrap)
+        .WithConnectOptions(connectPacket)
+        .WithDurableOfflineQueue(queueOptions)
+        .WithClientStoppedCallback([&stopped](const Mqtt5::OnStoppedEventData &) { stopped.set_value(); });
+
+    auto client = Mqtt5::Mqtt5Client::NewMqtt5Client(options, allocator);
+    if (!client)
+    {
+        return false;
+    }
+
+    Vector<uint8_t> payload(run.payloadSize, 'x');
+    String topic("bench/durable/data");
+    bool ok = true;
+
+    uint64_t startNs = s_Now();
+    for (size_t i = 0; i < run.messages && ok; ++i)
+    {
+        auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+            allocator,
+            topic,
+            aws_byte_cursor_from_array(payload.data(), payload.size()),
+            Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+            allocator);
+        ok = client->Publish(
+            publishPacket,
+            [&run](int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+            {
+                if (errorCode != AWS_ERROR_SUCCESS)
+                {
+                    run.failed.fetch_add(1);
+                }
+                run.completed.fetch_add(1);
+            });
+    }
+    run.spillSeconds = static_cast<double>(s_Now() - startNs) / AWS_TIMESTAMP_NANOS;
+
+    if (ok)
+    {
+        startNs = s_Now();
+        ok = client->Start();
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(AWS_MQTT_BENCHMARK_RUN_TIMEOUT_SEC);
+        while (ok && run.completed.load() < run.messages && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        run.replaySeconds = static_cast<double>(s_Now() - startNs) / AWS_TIMESTAMP_NANOS;
+        ok = ok && run.completed.load() == run.messages;
+
+        if (client->Stop())
+        {
+            auto stoppedFuture = stopped.get_future();
+            s_Wait(stoppedFuture);
+        }
+    }
+
+    client = nullptr;
+    remove(s_durableQueueSegmentPath);
+    return ok;
+}
+
+static void s_PrintDurableQueueRun(const DurableQueueRun &run)
+{
+    double spillRate = run.spillSeconds > 0 ? run.messages / run.spillSeconds : 0;
+    double replayRate = run.replaySeconds > 0 ? run.completed.load() / run.replaySeconds : 0;
+    double mebibytes = run.payloadSize / (1024.0 * 1024.0);
+    printf(
+        "%10zu %8zu %12.0f %10.2f %12.0f %10.2f %8zu\n",
+        run.messages,
+        run.payloadSize,
+        spillRate,
+        spillRate * mebibytes,
+        replayRate,
+        replayRate * mebibytes,
+        run.failed.load());
+}
+
+struct CompressionRun
+{
+    size_t messages;
+    size_t payloadSize;
+
+    double compressedRatio = 0;
+    double pooledCompressSeconds = 0;
+    double freshCompressSeconds = 0;
+    double decompressSeconds = 0;
+
+    uint64_t plainWireBytes = 0;
+    uint64_t compressedWireBytes = 0;
+    double plainPublishSeconds = 0;
+    double compressedPublishSeconds = 0;
+};
+
+/* Telemetry readings as a device would batch them, at least size bytes long */
+static String s_TelemetryJson(size_t size)
+{
+    String json = "{\"deviceId\":\"sensor-0042\",\"readings\":[";
+    for (size_t i = 0; json.size() + 2 < size; ++i)
+    {
+        json += i > 0 ? "," : "";
+        json += "{\"ts\":";
+        json += std::to_string(1700000000000ULL + i * 250).c_str();
+        json += ",\"temperature\":";
+        json += std::to_string(2000 + (i * 7) % 150).c_str();
+        json += ",\"humidity\":";
+        json += std::to_string(4000 + (i * 13) % 300).c_str();
+        json += ",\"status\":\"ok\"}";
+    }
+    json += "]}";
+    return json;
+}
+
+/*
+ * Compresses json run.messages times, either through one codec reused across messages as Mqtt5Client pools
+ * them, or through a codec created per message.
+ */
+static bool s_TimeCompression(
+    CompressionRun &run,
+    CompressionAlgorithm algorithm,
+    const String &json,
+    bool pooled,
+    ByteBuf &compressed,
+    Allocator *allocator)
+{
+    StreamCodec codec = StreamCodec::CreateCompressor(algorithm, -1, allocator);
+    bool ok = static_cast<bool>(codec);
+
+    uint64_t startNs = s_Now();
+    for (size_t i = 0; i < run.messages && ok; ++i)
+    {
+        if (!pooled && i > 0)
+        {
+            codec = StreamCodec::CreateCompressor(algorithm, -1, allocator);
+        }
+        compressed.len = 0;
+        ByteCursor input = ByteCursorFromString(json);
+        ok = codec && codec.Update(input, compressed) && codec.Finish(compressed);
+    }
+    double seconds = static_cast<double>(s_Now() - startNs) / AWS_TIMESTAMP_NANOS;
+    (pooled ? run.pooledCompressSeconds : run.freshCompressSeconds) = seconds;
+    return ok;
+}
+
+/*
+ * Publishes run.messages QoS 1 messages of json with one client, compressing them or not, and waits for all of
+ * them to be acknowledged. Nobody subscribes, so only the publishing side is measured.
+ */
+static bool s_RunCompressedPublishes(
+    CompressionRun &run,
+    const Mqtt5::PayloadCompressionOptions *compressionOptions,
+    const String &json,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    std::promise<void> connected;
+    std::promise<void> stopped;
+    auto client = MqttLoopbackBroker::NewMqtt5Client(
+        compressionOptions != nullptr ? "bench-compressed" : "bench-uncompressed",
+        port,
+        connected,
+        stopped,
+        nullptr,
+        allocator,
+        [&bootstrap, compressionOptions](Mqtt5::Mqtt5ClientOptions &options)
+        {
+            options.WithBootstrap(&bootstrap);
+            if (compressionOptions != nullptr)
+            {
+                options.WithPayloadCompression(*compressionOptions);
+            }
+        });
+    auto connectedFuture = connected.get_future();
+    if (!client || !client->Start() || !s_Wait(connectedFuture))
+    {
+        return false;
+    }
+
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> failed{0};
+    bool ok = true;
+    uint64_t startNs = s_Now();
+    for (size_t i = 0; i < run.messages && ok; ++i)
+    {
+        auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+            allocator,
+            "bench/compression/data",
+            ByteCursorFromString(json),
+            Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+            allocator);
+        publishPacket->WithPayloadFormatIndicator(Mqtt5::PayloadFormatIndicator::AWS_MQTT5_PFI_UTF8);
+        ok = client->Publish(
+            publishPacket,
+            [&completed, &failed](int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+            {
+                if (errorCode != AWS_ERROR_SUCCESS)
+                {
+                    failed.fetch_add(1);
+                }
+                completed.fetch_add(1);
+            });
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(AWS_MQTT_BENCHMARK_RUN_TIMEOUT_SEC);
+    while (ok && completed.load() < run.messages && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double seconds = static_cast<double>(s_Now() - startNs) / AWS_TIMESTAMP_NANOS;
+    ok = ok && completed.load() == run.messages && failed.load() == 0;
+
+    uint64_t wireBytes = client->GetMetrics().publishBytesSent;
+    if (compressionOptions != nullptr)
+    {
+        run.compressedPublishSeconds = seconds;
+        run.compressedWireBytes = wireBytes;
+    }
+    else
+    {
+        run.plainPublishSeconds = seconds;
+        run.plainWireBytes = wireBytes;
+    }
+
+    if (client->Stop())
+    {
+        auto stoppedFuture = stopped.get_future();
+        s_Wait(stoppedFuture);
+    }
+    return ok;
+}
+
+static bool s_RunCompression(
+    CompressionRun &run,
+    CompressionAlgorithm algorithm,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    String json = s_TelemetryJson(run.payloadSize);
+    run.payloadSize = json.size();
+
+    ByteBuf compressed;
+    aws_byte_buf_init(&compressed, allocator, json.size());
+    ByteBuf decompressed;
+    aws_byte_buf_init(&decompressed, allocator, json.size());
+
+    bool ok = s_TimeCompression(run, algorithm, json, false, compressed, allocator) &&
+              s_TimeCompression(run, algorithm, json, true, compressed, allocator);
+    run.compressedRatio = static_cast<double>(compressed.len) / json.size();
+
+    StreamCodec decompressor = StreamCodec::CreateDecompressor(algorithm, allocator);
+    ok = ok && decompressor;
+    uint64_t startNs = s_Now();
+    for (size_t i = 0; i < run.messages && ok; ++i)
+    {
+        decompressed.len = 0;
+        ByteCursor input = ByteCursorFromByteBuf(compressed);
+        ok = decompressor.Update(input, decompressed) && decompressor.Finish(decompressed);
+    }
+    run.decompressSeconds = static_cast<double>(s_Now() - startNs) / AWS_TIMESTAMP_NANOS;
+
+    aws_byte_buf_clean_up(&decompressed);
+    aws_byte_buf_clean_up(&compressed);
+
+    Mqtt5::PayloadCompressionOptions compressionOptions;
+    compressionOptions.m_algorithm = algorithm;
+    return ok && s_RunCompressedPublishes(run, nullptr, json, port, bootstrap, allocator) &&
+           s_RunCompressedPublishes(run, &compressionOptions, json, port, bootstrap, allocator);
+}
+
+static void s_PrintCompressionRun(const CompressionRun &run)
+{
+    double mebibytes = run.messages * run.payloadSize / (1024.0 * 1024.0);
+    auto rate = [](double amount, double seconds) { return seconds > 0 ? amount / seconds : 0; };
+    printf(
+        "%8zu %7.3f %12.2f %12.2f %12.2f %10.0f %10" PRIu64 " %10.0f %10" PRIu64 "\n",
+        run.payloadSize,
+        run.compressedRatio,
+        rate(mebibytes, run.freshCompressSeconds),
+        rate(mebibytes, run.pooledCompressSeconds),
+        rate(mebibytes, run.decompressSeconds),
+        rate(static_cast<double>(run.messages), run.plainPublishSeconds),
+        run.plainWireBytes / run.messages,
+        rate(static_cast<double>(run.messages), run.compressedPublishSeconds),
+        run.compressedWireBytes / run.messages);
+}
+
+struct RequestResponseRun
+{
+    size_t requests;
+    size_t payloadSize;
+
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> failed{0};
+    LatencyHistogram roundTripLatency;
+    double issueSeconds = 0;
+    double totalSeconds = 0;
+};
+
+/*
+ * Creates and connects a client of the loopback broker on bootstrap. Returns nullptr on failure.
+ */
+static std::shared_ptr<Mqtt5::Mqtt5Client> s_NewRequestResponseParty(
+    const char *clientId,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    std::promise<void> &connected,
+    std::promise<void> &stopped,
+    Mqtt5::OnPublishReceivedHandler &&onPublishReceived,
+    Allocator *allocator)
+{
+    auto client = MqttLoopbackBroker::NewMqtt5Client(
+        clientId,
+        port,
+        connected,
+        stopped,
+        std::move(onPublishReceived),
+        allocator,
+        [&bootstrap](Mqtt5::Mqtt5ClientOptions &options) { options.WithBootstrap(&bootstrap); });
+    if (!client || !client->Start())
+    {
+        return nullptr;
+    }
+
+    auto connectedFuture = connected.get_future();
+    return s_Wait(connectedFuture) ? client : nullptr;
+}
+
+static bool s_SubscribeAndWait(Mqtt5::Mqtt5Client &client, const char *topic, Allocator *allocator)
+{
+    std::promise<int> subscribed;
+    auto subscribePacket = MakeShared<Mqtt5::SubscribePacket>(allocator, allocator);
+    subscribePacket->WithSubscription(Mqtt5::Subscription(topic, Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator));
+    if (!client.Subscribe(
+            subscribePacket,
+            [&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>) { subscribed.set_value(errorCode); }))
+    {
+        return false;
+    }
+
+    auto subscribedFuture = subscribed.get_future();
+    return s_Wait(subscribedFuture) && subscribedFuture.get() == AWS_ERROR_SUCCESS;
+}
+
+/*
+ * Issues run.requests QoS 1 requests back to back through a RequestResponseClient allowing all of them in flight,
+ * answered by a second client echoing them to their response topic, and waits for all the responses.
+ */
+static bool s_RunRequestResponse(
+    RequestResponseRun &run,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    std::shared_ptr<Mqtt5::Mqtt5Client> responder;
+    std::promise<void> responderConnected;
+    std::promise<void> responderStopped;
+    responder = s_NewRequestResponseParty(
+        "bench-rpc-responder",
+        port,
+        bootstrap,
+        responderConnected,
+        responderStopped,
+        MqttLoopbackBroker::EchoResponder(responder, allocator),
+        allocator);
+
+    std::shared_ptr<Mqtt5::RequestResponseClient> requestResponse;
+    std::promise<void> requesterConnected;
+    std::promise<void> requesterStopped;
+    auto requester = s_NewRequestResponseParty(
+        "bench-rpc-requester",
+        port,
+        bootstrap,
+        requesterConnected,
+        requesterStopped,
+        [&requestResponse](const Mqtt5::PublishReceivedEventData &eventData)
+        {
+            if (requestResponse)
+            {
+                requestResponse->OnPublishReceived(eventData);
+            }
+        },
+        allocator);
+
+    bool ok = responder && requester && s_SubscribeAndWait(*responder, "bench/rpc/request", allocator);
+    if (ok)
+    {
+        Mqtt5::RequestResponseClientOptions options(allocator);
+        options.WithResponseTopic("bench/rpc/response")
+            .WithRequestTimeoutMs(AWS_MQTT_BENCHMARK_RUN_TIMEOUT_SEC * 1000)
+            .WithMaxInFlightRequests(run.requests);
+        requestResponse = Mqtt5::RequestResponseClient::NewRequestResponseClient(requester, options, allocator);
+        std::promise<int> subscribed;
+        ok = requestResponse &&
+             requestResponse->Subscribe([&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+                                        { subscribed.set_value(errorCode); });
+        auto subscribedFuture = subscribed.get_future();
+        ok = ok && s_Wait(subscribedFuture) && subscribedFuture.get() == AWS_ERROR_SUCCESS;
+    }
+
+    if (ok)
+    {
+        Vector<uint8_t> payload(run.payloadSize, 'x');
+        uint64_t startNs = s_Now();
+        for (size_t i = 0; i < run.requests && ok; ++i)
+        {
+            auto request = MakeShared<Mqtt5::PublishPacket>(
+                allocator,
+                "bench/rpc/request",
+                aws_byte_cursor_from_array(payload.data(), payload.size()),
+                Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+                allocator);
+            uint64_t sentNs = s_Now();
+            ok = requestResponse->Request(
+                request,
+                [&run, sentNs](int errorCode, std::shared_ptr<Mqtt5::PublishPacket>)
+                {
+                    if (errorCode != AWS_ERROR_SUCCESS)
+                    {
+                        run.failed.fetch_add(1);
+                    }
+                    run.roundTripLatency.Record(s_Now() - sentNs);
+                    run.completed.fetch_add(1);
+                });
+        }
+        run.issueSeconds = static_cast<double>(s_Now() - startNs) / AWS_TIMESTAMP_NANOS;
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(AWS_MQTT_BENCHMARK_RUN_TIMEOUT_SEC);
+        while (ok && run.completed.load() < run.requests && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        run.totalSeconds = static_cast<double>(s_Now() - startNs) / AWS_TIMESTAMP_NANOS;
+        ok = ok && run.completed.load() == run.requests;
+    }
+
+    if (requestResponse)
+    {
+        requestResponse->Close();
+    }
+    if (requester && requester->Stop())
+    {
+        auto stoppedFuture = requesterStopped.get_future();
+        s_Wait(stoppedFuture);
+    }
+    if (responder && responder->Stop())
+    {
+        auto stoppedFuture = responderStopped.get_future();
+        s_Wait(stoppedFuture);
+    }
+    requestResponse = nullptr;
+    requester = nullptr;
+    responder = nullptr;
+
+    return ok;
+}
+
+static void s_PrintRequestResponseRun(const RequestResponseRun &run)
+{
+    LatencyHistogramSnapshot roundTrip = run.roundTripLatency.GetSnapshot();
+    printf(
+        "%10zu %8zu %12.0f %12.0f %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %8zu\n",
+        run.requests,
+        run.payloadSize,
+        run.issueSeconds > 0 ? run.requests / run.issueSeconds : 0,
+        run.totalSeconds > 0 ? run.completed.load() / run.totalSeconds : 0,
+        roundTrip.GetPercentileNanos(50) / 1000,
+        roundTrip.GetPercentileNanos(99) / 1000,
+        roundTrip.GetPercentileNanos(99.9) / 1000,
+        run.failed.load());
+}
+
+static void s_PrintHeader()
+{
+    printf(
+        "%-12s %8s %8s %12s %10s %10s %10s %10s %10s %10s %10s %12s %8s\n",
+        "protocol",
+        "clients",
+        "payload",
+        "msgs/s",
+        "MiB/s",
+        "ack p50",
+        "ack p99",
+        "ack p99.9",
+        "dlv p50",
+        "dlv p99",
+        "dlv p99.9",
+        "bytes/client",
+        "failed");
+}
+
+static void s_PrintRun(const BenchmarkRun &run)
+{
+    LatencyHistogramSnapshot ack = run.pubackLatency.GetSnapshot();
+    LatencyHistogramSnapshot delivery = run.deliveryLatency.GetSnapshot();
+    double messagesPerSecond = run.seconds > 0 ? run.received.load() / run.seconds : 0;
+
+    /* latencies in microseconds, as bucket upper bounds */
+    printf(
+        "%-12s %8zu %8zu %12.0f %10.2f %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+        " %10" PRIu64 " %12zu %8zu\n",
+        run.protocol,
+        run.clientCount,
+        run.payloadSize,
+        messagesPerSecond,
+        messagesPerSecond * run.payloadSize / (1024.0 * 1024.0),
+        ack.GetPercentileNanos(50) / 1000,
+        ack.GetPercentileNanos(99) / 1000,
+        ack.GetPercentileNanos(99.9) / 1000,
+        delivery.GetPercentileNanos(50) / 1000,
+        delivery.GetPercentileNanos(99) / 1000,
+        delivery.GetPercentileNanos(99.9) / 1000,
+        run.bytesPerClient,
+        run.failed.load());
+}
+
+static int s_RunMemoryBenchmarks(
+    const BenchmarkOptions &options,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    int exitCode = 0;
+    printf("loopback broker on port %" PRIu32 ", idle MQTT5 connections\n\n", port);
+    printf("%-8s %8s %10s %10s %12s\n", "mode", "clients", "connected", "connect s", "bytes/client");
+    for (size_t clientCount : options.memoryClientCounts)
+    {
+        for (const char *mode : {"mqtt5", "fleet"})
+        {
+            MemoryRun run;
+            run.mode = mode;
+            run.clientCount = clientCount;
+            if (!s_RunMemory(run, port, bootstrap, allocator))
+            {
+                fprintf(stderr, "%s memory run with %zu clients did not complete\n", mode, clientCount);
+                exitCode = 1;
+            }
+            s_PrintMemoryRun(run);
+        }
+    }
+
+    return exitCode;
+}
+
+static int s_RunDurableQueueBenchmarks(
+    const BenchmarkOptions &options,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    int exitCode = 0;
+    printf(
+        "loopback broker on port %" PRIu32 ", MQTT5 durable offline queue, segment file %s\n"
+        "spill: publishes appended while offline, replay: connect to last PUBACK\n\n",
+        port,
+        s_durableQueueSegmentPath);
+    printf(
+        "%10s %8s %12s %10s %12s %10s %8s\n",
+        "messages",
+        "payload",
+        "spill msg/s",
+        "spill MiB/s",
+        "replay msg/s",
+        "replay MiB/s",
+        "failed");
+    for (size_t payloadSize : options.payloadSizes)
+    {
+        DurableQueueRun run;
+        run.messages = options.durableQueueMessages;
+        run.payloadSize = payloadSize;
+        if (!s_RunDurableQueue(run, port, bootstrap, allocator))
+        {
+            fprintf(stderr, "durable queue run with %zu byte payloads did not complete\n", payloadSize);
+            exitCode = 1;
+        }
+        s_PrintDurableQueueRun(run);
+    }
+
+    return exitCode;
+}
+
+static int s_RunCompressionBenchmarks(
+    const BenchmarkOptions &options,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    if (!StreamCodec::IsSupported(options.compressionAlgorithm))
+    {
+        fprintf(stderr, "%s is not supported by this build\n", options.compression);
+        return 1;
+    }
+
+    int exitCode = 0;
+    printf(
+        "loopback broker on port %" PRIu32 ", %s over %zu telemetry JSON messages per size\n"
+        "fresh: codec per message, pooled: codec reused, B/msg: payload bytes sent per publish\n\n",
+        port,
+        options.compression,
+        options.messagesPerClient);
+    printf(
+        "%8s %7s %12s %12s %12s %10s %10s %10s %10s\n",
+        "payload",
+        "ratio",
+        "fresh MiB/s",
+        "pooled MiB/s",
+        "decomp MiB/s",
+        "plain msg/s",
+        "plain B/msg",
+        "comp msg/s",
+        "comp B/msg");
+    for (size_t payloadSize : options.payloadSizes)
+    {
+        CompressionRun run;
+        run.messages = options.messagesPerClient;
+        run.payloadSize = payloadSize;
+        if (!s_RunCompression(run, options.compressionAlgorithm, port, bootstrap, allocator))
+        {
+            fprintf(stderr, "compression run with %zu byte payloads did not complete\n", payloadSize);
+            exitCode = 1;
+        }
+        s_PrintCompressionRun(run);
+    }
+
+    return exitCode;
+}
+
+/* How the callbacks of a client were gated before Mqtt5CallbackGate: a flag under a recursive lock */
+struct LockedCallbackFlag
+{
+    std::recursive_mutex lock;
+    bool invoke = true;
+};
+
+/* Nanoseconds for each of threadCount threads to run dispatches dispatches at the same time */
+template <typename Dispatch> static uint64_t s_TimeDispatch(size_t threadCount, size_t dispatches, Dispatch dispatch)
+{
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<size_t> invoked(0);
+    Vector<std::thread> threads;
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(std::thread(
+            [&]()
+            {
+                ready.fetch_add(1);
+                while (!go.load())
+                {
+                    std::this_thread::yield();
+                }
+
+                size_t count = 0;
+                for (size_t j = 0; j < dispatches; ++j)
+                {
+                    count += dispatch() ? 1 : 0;
+                }
+                invoked.fetch_add(count);
+            }));
+    }
+
+    while (ready.load() < threadCount)
+    {
+        std::this_thread::yield();
+    }
+    uint64_t startNs = s_Now();
+    go.store(true);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    uint64_t elapsedNs = s_Now() - startNs;
+
+    AWS_FATAL_ASSERT(invoked.load() == threadCount * dispatches);
+    return elapsedNs;
+}
+
+static int s_RunCallbackDispatchBenchmarks(const BenchmarkOptions &options)
+{
+    size_t maxThreads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    printf(
+        "%zu callback dispatches per thread, all threads dispatching callbacks of one client
+"
+        "ns: wall time per dispatch of a thread, M/s: dispatches per second of all threads
+
+",
+        options.callbackDispatches);
+    printf("%8s %10s %10s %10s %10s
+", "threads", "lock ns", "gate ns", "lock M/s", "gate M/s");
+    for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        LockedCallbackFlag locked;
+        uint64_t lockNs = s_TimeDispatch(
+            threadCount,
+            options.callbackDispatches,
+            [&locked]()
+            {
+                std::lock_guard<std::recursive_mutex> lock(locked.lock);
+                return locked.invoke;
+            });
+
+        Mqtt5::Mqtt5CallbackGate gate;
+        uint64_t gateNs = s_TimeDispatch(
+            threadCount,
+            options.callbackDispatches,
+            [&gate]()
+            {
+                Mqtt5::Mqtt5CallbackGate::Scope scope(gate);
+                return static_cast<bool>(scope);
+            });
+
+        double dispatches = static_cast<double>(options.callbackDispatches);
+        double total = dispatches * threadCount;
+        printf(
+            "%8zu %10.1f %10.1f %10.1f %10.1f\n",
+            threadCount,
+            lockNs / dispatches,
+            gateNs / dispatches,
+            total * 1000.0 / std::max<uint64_t>(lockNs, 1),
+            total * 1000.0 / std::max<uint64_t>(gateNs, 1));
+    }
+
+    return 0;
+}
+
+static int s_RunRequestResponseBenchmarks(
+    const BenchmarkOptions &options,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    int exitCode = 0;
+    printf(
+        "loopback broker on port %" PRIu32 ", MQTT5 request/response, all requests outstanding at once\n"
+        "req/s: requests issued, rsp/s: responses matched, rtt: request to response, in microseconds\n\n",
+        port);
+    printf(
+        "%10s %8s %12s %12s %10s %10s %10s %8s\n",
+        "requests",
+        "payload",
+        "req/s",
+        "rsp/s",
+        "rtt p50",
+        "rtt p99",
+        "rtt p99.9",
+        "failed");
+    for (size_t payloadSize : options.payloadSizes)
+    {
+        RequestResponseRun run;
+        run.requests = options.outstandingRequests;
+        run.payloadSize = payloadSize;
+        if (!s_RunRequestResponse(run, port, bootstrap, allocator))
+        {
+            fprintf(stderr, "request/response run with %zu byte payloads did not complete\n", payloadSize);
+            exitCode = 1;
+        }
+        s_PrintRequestResponseRun(run);
+    }
+
+    return exitCode;
+}
+
+static int s_RunThroughputBenchmarks(
+    const BenchmarkOptions &options,
+    uint32_t port,
+    Io::ClientBootstrap &bootstrap,
+    Allocator *allocator)
+{
+    int exitCode = 0;
+    printf(
+        "loopback broker on port %" PRIu32 ", %zu QoS 1 messages per client, window %zu\n"
+        "ack: publish to PUBACK, dlv: publish to delivery, in microseconds\n\n",
+        port,
+        options.messagesPerClient,
+        options.window);
+    s_PrintHeader();
+
+    Vector<const char *> protocols;
+    if (options.mqtt5)
+    {
+        protocols.push_back("mqtt5");
+    }
+    if (options.mqtt311)
+    {
+        protocols.push_back("mqtt311");
+    }
+    if (options.adapter)
+    {
+        protocols.push_back("adapter");
+        protocols.push_back("adapter-fast");
+        protocols.push_back("adapter-nocb");
+    }
+
+    for (const char *protocol : protocols)
+    {
+        for (size_t clientCount : options.clientCounts)
+        {
+            for (size_t payloadSize : options.payloadSizes)
+            {
+                BenchmarkRun run;
+                run.protocol = protocol;
+                run.clientCount = clientCount;
+                run.payloadSize = payloadSize;
+                if (!s_Run(run, options, port, bootstrap, allocator))
+                {
+                    fprintf(
+                        stderr,
+                        "%s run with %zu clients and %zu byte payloads did not complete\n",
+                        protocol,
+                        clientCount,
+                        payloadSize);
+                    exitCode = 1;
+                }
+                s_PrintRun(run);
+            }
+        }
+    }
+
+    return exitCode;
+}
+
+int main(int argc, char **argv)
+{
+    struct aws_allocator *allocator = aws_mem_tracer_new(aws_default_allocator(), NULL, AWS_MEMTRACE_BYTES, 0);
+    int exitCode = 0;
+
+    {
+        ApiHandle apiHandle(allocator);
+        BenchmarkOptions options;
+        s_ParseOptions(argc, argv, options);
+
+        /* the broker allocates from the untracked allocator, so bytes/client only counts the client side */
+        Io::EventLoopGroup brokerEventLoopGroup(options.threads, aws_default_allocator());
+        MqttLoopbackBroker broker(brokerEventLoopGroup, aws_default_allocator());
+        if (!broker.Start())
+        {
+            fprintf(
+                stderr, "Failed to start the loopback broker with error %s\n", aws_error_debug_str(aws_last_error()));
+            exit(1);
+        }
+
+        Io::EventLoopGroup eventLoopGroup(options.threads, allocator);
+        Io::DefaultHostResolver hostResolver(eventLoopGroup, 8, 30, allocator);
+        Io::ClientBootstrap bootstrap(eventLoopGroup, hostResolver, allocator);
+        if (!bootstrap)
+        {
+            fprintf(
+                stderr,
+                "Failed to create client bootstrap with error %s\n",
+                aws_error_debug_str(bootstrap.LastError()));
+            exit(1);
+        }
+
+        if (!options.memoryClientCounts.empty())
+        {
+            exitCode = s_RunMemoryBenchmarks(options, broker.GetPort(), bootstrap, allocator);
+        }
+        else if (options.durableQueueMessages > 0)
+        {
+            exitCode = s_RunDurableQueueBenchmarks(options, broker.GetPort(), bootstrap, allocator);
+        }
+        else if (options.compression != nullptr)
+        {
+            exitCode = s_RunCompressionBenchmarks(options, broker.GetPort(), bootstrap, allocator);
+        }
+        else if (options.callbackDispatches > 0)
+        {
+            exitCode = s_RunCallbackDispatchBenchmarks(options);
+        }
+        else if (options.outstandingRequests > 0)
+        {
+            exitCode = s_RunRequestResponseBenchmarks(options, broker.GetPort(), bootstrap, allocator);
+        }
+        else
+        {
+            exitCode = s_RunThroughputBenchmarks(options, broker.GetPort(), bootstrap, allocator);
+        }
+
+        broker.Stop();
+    }
+
+    aws_mem_tracer_destroy(allocator);
+
+    return exitCode;
+}
@@ -7,6 +7,15 @@ find_dependency(aws-c-auth)
 find_dependency(aws-c-event-stream)
 find_dependency(aws-c-s3)
 
+if (@USE_ZLIB@)
+    find_dependency(ZLIB)
+endif()
+
+if (@USE_ZSTD@)
+    list(APPEND CMAKE_MODULE_PATH "${CMAKE_CURRENT_LIST_DIR}")
+    find_dependency(zstd)
+endif()
+
 macro(aws_load_targets type)
     include(${CMAKE_CURRENT_LIST_DIR}/${type}/@PROJECT_NAME@-targets.cmake)
 endmacro()
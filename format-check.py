@@ -8,7 +8,7 @@ from tempfile import NamedTemporaryFile
 
 CLANG_FORMAT_VERSION = '18.1.6'
 
-INCLUDE_REGEX = re.compile(r'^(include|source|tests)/.*\.(cpp|h)$')
+INCLUDE_REGEX = re.compile(r'^(include|source|testing|tests)/.*\.(cpp|h)$')
 EXCLUDE_REGEX = re.compile(r'^$')
 
 arg_parser = argparse.ArgumentParser(description="Check with clang-format")
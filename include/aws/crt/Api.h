@@ -6,6 +6,7 @@
 #include <aws/crt/Types.h>
 #include <aws/crt/crypto/HMAC.h>
 #include <aws/crt/crypto/Hash.h>
+#include <aws/crt/io/TlsContextCache.h>
 #include <aws/crt/mqtt/Mqtt5Client.h>
 #include <aws/crt/mqtt/MqttClient.h>
 
@@ -182,6 +183,19 @@ namespace Aws
              */
             static Io::HostResolver *GetOrCreateStaticDefaultHostResolver();
 
+            /**
+             * Gets the static default TlsContextCache, creating it if necessary.
+             *
+             * Clients building TlsContexts from the same TlsContextOptions in many places can get them through this
+             * cache to share a single context, and load their certificates and trust store once.
+             *
+             * The default TlsContextCache will be automatically managed and released by the API handle when it's
+             * resources are being freed. Contexts obtained from it remain valid after that.
+             *
+             * @return TlsContextCache* A pointer to the static default TlsContextCache
+             */
+            static Io::TlsContextCache *GetOrCreateStaticDefaultTlsContextCache();
+
 #pragma pack(push, 1)
             struct Version
             {
@@ -216,6 +230,10 @@ namespace Aws
             static std::mutex s_lock_default_host_resolver;
             static void ReleaseStaticDefaultHostResolver();
 
+            static Io::TlsContextCache *s_static_tls_context_cache;
+            static std::mutex s_lock_tls_context_cache;
+            static void ReleaseStaticDefaultTlsContextCache();
+
             Version m_version = {0, 0, 0};
         };
 
@@ -0,0 +1,148 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Exports.h>
+#include <aws/crt/Types.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        /**
+         * Compression formats supported by StreamCodec.
+         *
+         * Support for each format is optional and selected when the library is built (USE_ZLIB and USE_ZSTD cmake
+         * options). Use StreamCodec::IsSupported() to check at runtime.
+         */
+        enum class CompressionAlgorithm
+        {
+            /**
+             * Deflate with a zlib header and checksum (RFC 1950), provided by zlib.
+             */
+            Deflate,
+
+            /**
+             * Zstandard (RFC 8878), provided by libzstd.
+             */
+            Zstd,
+        };
+
+        /// @private
+        class StreamCodecImpl;
+
+        /**
+         * Streaming compressor or decompressor.
+         *
+         * Data can be fed in any number of Update() calls. A compressor only guarantees that the peer can decode
+         * everything fed so far after Flush() or Finish().
+         *
+         * Output is appended to the output buffer, which is grown with its own allocator as needed.
+         */
+        class AWS_CRT_CPP_API StreamCodec final
+        {
+          public:
+            ~StreamCodec();
+            StreamCodec(const StreamCodec &) = delete;
+            StreamCodec &operator=(const StreamCodec &) = delete;
+            StreamCodec(StreamCodec &&toMove) noexcept;
+            StreamCodec &operator=(StreamCodec &&toMove) noexcept;
+
+            /**
+             * @return true if the instance is in a valid state, false otherwise.
+             */
+            operator bool() const noexcept;
+
+            /**
+             * @return the value of the last aws error encountered by operations on this instance.
+             */
+            inline int LastError() const noexcept { return m_lastError; }
+
+            /**
+             * @return true if this build of the library supports the given algorithm.
+             */
+            static bool IsSupported(CompressionAlgorithm algorithm) noexcept;
+
+            /**
+             * Creates a compressor.
+             *
+             * @param algorithm compression format to produce
+             * @param level compression level, algorithm specific. A negative value selects the algorithm's default.
+             * @param allocator memory allocator to use
+             */
+            static StreamCodec CreateCompressor(
+                CompressionAlgorithm algorithm,
+                int level = -1,
+                Allocator *allocator = ApiAllocator()) noexcept;
+
+            /**
+             * Creates a decompressor.
+             *
+             * @param algorithm compression format to consume
+             * @param allocator memory allocator to use
+             */
+            static StreamCodec CreateDecompressor(
+                CompressionAlgorithm algorithm,
+                Allocator *allocator = ApiAllocator()) noexcept;
+
+            /**
+             * Consumes all of input and appends whatever output is ready to output.
+             * On success, input is advanced to its end.
+             *
+             * @param input data to consume
+             * @param output buffer the output is appended to
+             * @param maxOutputSize most bytes this call may append. Decompressing untrusted data should always set
+             * it: a few kilobytes of input can expand to gigabytes. If the output would be larger, the call fails
+             * with AWS_ERROR_SHORT_BUFFER, with part of the output appended, and the codec must not be used again.
+             *
+             * @return true on success, false otherwise (e.g. the compressed data is corrupt).
+             */
+            bool Update(ByteCursor &input, ByteBuf &output, size_t maxOutputSize = SIZE_MAX) noexcept;
+
+            /**
+             * For a compressor, appends output such that everything fed so far can be decoded by the peer, without
+             * ending the stream. Has no effect on a decompressor.
+             *
+             * @return true on success, false otherwise.
+             */
+            bool Flush(ByteBuf &output) noexcept;
+
+            /**
+             * For a compressor, ends the stream and appends the remaining output. For a decompressor, checks that a
+             * complete stream was consumed. Either way the codec is then ready for a new, independent stream.
+             *
+             * @return true on success, false otherwise.
+             */
+            bool Finish(ByteBuf &output) noexcept;
+
+            /**
+             * Compresses input as a single, complete stream and appends it to output.
+             */
+            static bool CompressOneShot(
+                CompressionAlgorithm algorithm,
+                const ByteCursor &input,
+                ByteBuf &output,
+                int level = -1,
+                Allocator *allocator = ApiAllocator()) noexcept;
+
+            /**
+             * Decompresses a single, complete stream and appends the result to output. Fails with
+             * AWS_ERROR_SHORT_BUFFER if the result would be larger than maxOutputSize.
+             */
+            static bool DecompressOneShot(
+                CompressionAlgorithm algorithm,
+                const ByteCursor &input,
+                ByteBuf &output,
+                size_t maxOutputSize,
+                Allocator *allocator = ApiAllocator()) noexcept;
+
+          private:
+            StreamCodec(StreamCodecImpl *impl, Allocator *allocator, int lastError) noexcept;
+
+            StreamCodecImpl *m_impl;
+            Allocator *m_allocator;
+            int m_lastError;
+        };
+    } // namespace Crt
+} // namespace Aws
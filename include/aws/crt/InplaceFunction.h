@@ -0,0 +1,211 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Types.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        template <typename Signature, size_t Capacity = 64> class InplaceFunction;
+
+        /**
+         * Move-only, small-buffer-optimized alternative to std::function.
+         *
+         * Callables whose size fits in Capacity bytes (and which are nothrow move constructible) are stored
+         * inline, so constructing and invoking an InplaceFunction does not touch the heap. Larger callables fall
+         * back to a single allocation from the supplied allocator.
+         *
+         * @tparam R return type of the call operator
+         * @tparam Args argument types of the call operator
+         * @tparam Capacity size in bytes of the inline storage
+         */
+        template <typename R, typename... Args, size_t Capacity> class InplaceFunction<R(Args...), Capacity>
+        {
+          public:
+            InplaceFunction() noexcept : m_invoke(nullptr), m_manage(nullptr), m_allocator(nullptr) {}
+            InplaceFunction(std::nullptr_t) noexcept : m_invoke(nullptr), m_manage(nullptr), m_allocator(nullptr) {}
+
+            /**
+             * @param fn callable to wrap
+             * @param allocator allocator used if fn does not fit in the inline storage
+             */
+            template <
+                typename F,
+                typename = typename std::enable_if<
+                    !std::is_same<typename std::decay<F>::type, InplaceFunction>::value>::type>
+            InplaceFunction(F &&fn, Allocator *allocator = ApiAllocator())
+                : m_invoke(nullptr), m_manage(nullptr), m_allocator(allocator)
+            {
+                using Callable = typename std::decay<F>::type;
+                Emplace<Callable>(std::forward<F>(fn), std::integral_constant<bool, StoresInline<Callable>::value>());
+            }
+
+            InplaceFunction(InplaceFunction &&toMove) noexcept
+                : m_invoke(toMove.m_invoke), m_manage(toMove.m_manage), m_allocator(toMove.m_allocator)
+            {
+                if (m_manage != nullptr)
+                {
+                    m_manage(Operation::Move, &m_storage, &toMove.m_storage, m_allocator);
+                    toMove.m_invoke = nullptr;
+                    toMove.m_manage = nullptr;
+                }
+            }
+
+            InplaceFunction &operator=(InplaceFunction &&toMove) noexcept
+            {
+                if (this != &toMove)
+                {
+                    Reset();
+                    m_invoke = toMove.m_invoke;
+                    m_manage = toMove.m_manage;
+                    m_allocator = toMove.m_allocator;
+                    if (m_manage != nullptr)
+                    {
+                        m_manage(Operation::Move, &m_storage, &toMove.m_storage, m_allocator);
+                        toMove.m_invoke = nullptr;
+                        toMove.m_manage = nullptr;
+                    }
+                }
+
+                return *this;
+            }
+
+            InplaceFunction &operator=(std::nullptr_t) noexcept
+            {
+                Reset();
+                return *this;
+            }
+
+            InplaceFunction(const InplaceFunction &) = delete;
+            InplaceFunction &operator=(const InplaceFunction &) = delete;
+
+            ~InplaceFunction() { Reset(); }
+
+            /**
+             * Invokes the wrapped callable. Must not be called on an empty InplaceFunction.
+             */
+            R operator()(Args... args)
+            {
+                AWS_FATAL_ASSERT(m_invoke != nullptr);
+                return m_invoke(&m_storage, std::forward<Args>(args)...);
+            }
+
+            /**
+             * @return true if a callable is wrapped, false otherwise.
+             */
+            explicit operator bool() const noexcept { return m_invoke != nullptr; }
+
+            /**
+             * @return true if a callable of type F would be stored without a heap allocation.
+             */
+            template <typename F> static constexpr bool FitsInline() noexcept
+            {
+                return StoresInline<typename std::decay<F>::type>::value;
+            }
+
+          private:
+            using Storage = typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type;
+
+            enum class Operation
+            {
+                Move,
+                Destroy,
+            };
+
+            using InvokeFn = R (*)(void *storage, Args &&...args);
+            using ManageFn = void (*)(Operation operation, void *dest, void *source, Allocator *allocator);
+
+            template <typename F> struct StoresInline
+            {
+                static constexpr bool value = sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) &&
+                                              std::is_nothrow_move_constructible<F>::value;
+            };
+
+            template <typename Ret, typename Dummy = void> struct Invoker
+            {
+                template <typename F> static Ret Invoke(F &fn, Args &&...args)
+                {
+                    return fn(std::forward<Args>(args)...);
+                }
+            };
+
+            template <typename Dummy> struct Invoker<void, Dummy>
+            {
+                template <typename F> static void Invoke(F &fn, Args &&...args) { fn(std::forward<Args>(args)...); }
+            };
+
+            template <typename F> static R s_InvokeInline(void *storage, Args &&...args)
+            {
+                return Invoker<R>::Invoke(*static_cast<F *>(storage), std::forward<Args>(args)...);
+            }
+
+            template <typename F>
+            static void s_ManageInline(Operation operation, void *dest, void *source, Allocator *)
+            {
+                F *sourceFn = static_cast<F *>(source);
+                if (operation == Operation::Move)
+                {
+                    new (dest) F(std::move(*sourceFn));
+                }
+                sourceFn->~F();
+            }
+
+            template <typename F> static R s_InvokeHeap(void *storage, Args &&...args)
+            {
+                return Invoker<R>::Invoke(**static_cast<F **>(storage), std::forward<Args>(args)...);
+            }
+
+            template <typename F>
+            static void s_ManageHeap(Operation operation, void *dest, void *source, Allocator *allocator)
+            {
+                F *sourceFn = *static_cast<F **>(source);
+                if (operation == Operation::Move)
+                {
+                    new (dest) F *(sourceFn);
+                }
+                else
+                {
+                    Delete(sourceFn, allocator);
+                }
+            }
+
+            template <typename F, typename Arg> void Emplace(Arg &&fn, std::true_type /* inline */)
+            {
+                new (&m_storage) F(std::forward<Arg>(fn));
+                m_invoke = &s_InvokeInline<F>;
+                m_manage = &s_ManageInline<F>;
+            }
+
+            template <typename F, typename Arg> void Emplace(Arg &&fn, std::false_type /* inline */)
+            {
+                F *heapFn = New<F>(m_allocator, std::forward<Arg>(fn));
+                AWS_FATAL_ASSERT(heapFn != nullptr);
+                new (&m_storage) F *(heapFn);
+                m_invoke = &s_InvokeHeap<F>;
+                m_manage = &s_ManageHeap<F>;
+            }
+
+            void Reset() noexcept
+            {
+                if (m_manage != nullptr)
+                {
+                    m_manage(Operation::Destroy, nullptr, &m_storage, m_allocator);
+                    m_invoke = nullptr;
+                    m_manage = nullptr;
+                }
+            }
+
+            Storage m_storage;
+            InvokeFn m_invoke;
+            ManageFn m_manage;
+            Allocator *m_allocator;
+        };
+    } // namespace Crt
+} // namespace Aws
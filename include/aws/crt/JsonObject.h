@@ -31,6 +31,12 @@ namespace Aws
              */
             JsonObject(const String &stringToParse);
 
+            /**
+             * Constructs a JSON DOM by parsing the input cursor, without copying it into a String first.
+             * Call WasParseSuccessful() on new object to determine if parse was successful.
+             */
+            JsonObject(ByteCursor stringToParse);
+
             /**
              * Construct a deep copy.
              * Prefer using a @ref JsonView if copying is not needed.
@@ -177,6 +183,19 @@ namespace Aws
              */
             JsonObject &AsObject(JsonObject &&value);
 
+            /**
+             * Applies patch to this node in place as a JSON Merge Patch (RFC 7386): members of patch replace the
+             * ones of this node with the same key, except objects, which are merged recursively, and nulls, which
+             * remove the key. Converts this node to an empty JSON object first if necessary. A patch that is not
+             * an object replaces this node. Only the members of patch are visited, so the cost does not depend on
+             * the size of this node.
+             *
+             * @param patch the changes to apply, deep-copied
+             * @param keepNulls if true, null members of patch are set as null values rather than removing their
+             * key, for accumulating several patches into one
+             */
+            JsonObject &MergePatch(const JsonView &patch, bool keepNulls = false);
+
             /**
              * Returns true if the last parse request was successful.
              */
@@ -445,6 +464,8 @@ namespace Aws
           private:
             JsonView(const aws_json_value *val);
 
+            friend class JsonObject;
+
             String Write(bool treatAsObject, bool readable) const;
 
             const aws_json_value *m_value;
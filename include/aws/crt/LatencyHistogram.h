@@ -0,0 +1,111 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Exports.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        /**
+         * Point-in-time copy of a LatencyHistogram.
+         *
+         * Bucket 0 counts samples below 2 nanoseconds. Bucket i (i > 0) counts samples in
+         * [2^i, 2^(i+1)) nanoseconds. The last bucket also absorbs everything larger than its lower bound.
+         */
+        struct AWS_CRT_CPP_API LatencyHistogramSnapshot
+        {
+            static const size_t BucketCount = 40;
+
+            LatencyHistogramSnapshot() noexcept;
+
+            /**
+             * number of samples in each bucket
+             */
+            uint64_t buckets[BucketCount];
+
+            /**
+             * total number of samples recorded
+             */
+            uint64_t count;
+
+            /**
+             * sum of all samples, in nanoseconds
+             */
+            uint64_t sumNanos;
+
+            /**
+             * largest sample recorded, in nanoseconds
+             */
+            uint64_t maxNanos;
+
+            /**
+             * @return the mean of all samples in nanoseconds, or 0 if there are none.
+             */
+            double GetMeanNanos() const noexcept;
+
+            /**
+             * @param percentile value in [0, 100]
+             * @return an upper bound (the end of the containing bucket, capped at maxNanos) of the given
+             * percentile in nanoseconds, or 0 if there are no samples.
+             */
+            uint64_t GetPercentileNanos(double percentile) const noexcept;
+
+            /**
+             * Adds all samples of another snapshot into this one.
+             */
+            void Merge(const LatencyHistogramSnapshot &other) noexcept;
+
+            /**
+             * @return the exclusive upper bound of a bucket in nanoseconds.
+             */
+            static uint64_t GetBucketUpperBoundNanos(size_t bucket) noexcept;
+        };
+
+        /**
+         * Lock-free, fixed-size histogram of durations with power-of-two buckets.
+         *
+         * Record() may be called concurrently from any number of threads. Snapshots taken while samples are being
+         * recorded are not atomic as a whole, but every counter is individually consistent.
+         */
+        class AWS_CRT_CPP_API LatencyHistogram
+        {
+          public:
+            LatencyHistogram() noexcept;
+            LatencyHistogram(const LatencyHistogram &) = delete;
+            LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+            /**
+             * Records a sample.
+             */
+            void Record(uint64_t nanos) noexcept;
+
+            /**
+             * @return a copy of the current state of the histogram.
+             */
+            LatencyHistogramSnapshot GetSnapshot() const noexcept;
+
+            /**
+             * Clears all samples.
+             */
+            void Reset() noexcept;
+
+            /**
+             * @return the bucket a sample falls into.
+             */
+            static size_t GetBucketIndex(uint64_t nanos) noexcept;
+
+          private:
+            std::atomic<uint64_t> m_buckets[LatencyHistogramSnapshot::BucketCount];
+            std::atomic<uint64_t> m_count;
+            std::atomic<uint64_t> m_sumNanos;
+            std::atomic<uint64_t> m_maxNanos;
+        };
+    } // namespace Crt
+} // namespace Aws
@@ -0,0 +1,293 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/*
+ * co_await-able wrappers for the callback based CRT APIs.
+ *
+ * This header is optional and only has content when compiled as C++20 (or later) with coroutine support. The rest
+ * of the library continues to build as C++11.
+ */
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#    include <aws/crt/InplaceFunction.h>
+#    include <aws/crt/Types.h>
+#    include <aws/crt/auth/Credentials.h>
+#    include <aws/crt/auth/Signing.h>
+#    include <aws/crt/http/HttpConnectionManager.h>
+#    include <aws/crt/io/EventLoopGroup.h>
+#    include <aws/crt/io/HostResolver.h>
+#    include <aws/crt/mqtt/Mqtt5Client.h>
+#    include <aws/crt/mqtt/Mqtt5Packets.h>
+
+#    include <atomic>
+#    include <coroutine>
+#    include <exception>
+#    include <utility>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Coro
+        {
+            /**
+             * Awaitable wrapper around a single callback based CRT operation.
+             *
+             * The operation is started when the awaiting coroutine suspends. When the CRT completion callback
+             * fires, the coroutine is resumed:
+             *  - on resumeOn, if one is given and the callback arrived on a different thread.
+             *  - inline on the callback's thread otherwise.
+             * To come back to the event loop a coroutine runs on, look it up once, e.g. with
+             * EventLoopGroup::GetCallersLoop() on the group that started the coroutine, and pass it to each co_await.
+             * If the operation fails to start, or completes before the coroutine actually suspends, the coroutine
+             * simply continues on its current thread.
+             *
+             * The wrapper lives in the coroutine frame, so completion callbacks only capture a single pointer and
+             * fit in std::function's small buffer.
+             *
+             * @tparam T result type. Must be default constructible, movable and have an `int errorCode` member.
+             */
+            template <typename T> class Awaitable
+            {
+              public:
+                /**
+                 * Starts the operation. Must arrange for Complete() to be called exactly once if it returns true.
+                 */
+                using Launcher = InplaceFunction<bool(Awaitable &)>;
+
+                Awaitable(Launcher &&launch, Io::EventLoop resumeOn) noexcept
+                    : m_launch(std::move(launch)), m_resumeOn(resumeOn), m_completed(false)
+                {
+                }
+
+                Awaitable(const Awaitable &) = delete;
+                Awaitable(Awaitable &&) = delete;
+                Awaitable &operator=(const Awaitable &) = delete;
+                Awaitable &operator=(Awaitable &&) = delete;
+
+                bool await_ready() const noexcept { return false; }
+
+                bool await_suspend(std::coroutine_handle<> handle)
+                {
+                    m_handle = handle;
+                    if (!m_launch(*this))
+                    {
+                        int lastError = aws_last_error();
+                        m_result.errorCode = lastError != AWS_ERROR_SUCCESS ? lastError : AWS_ERROR_UNKNOWN;
+                        return false;
+                    }
+
+                    /* If the completion already happened, don't suspend at all. */
+                    return !m_completed.exchange(true, std::memory_order_acq_rel);
+                }
+
+                T await_resume() noexcept { return std::move(m_result); }
+
+                /**
+                 * Stores the operation's result and resumes the awaiting coroutine.
+                 */
+                void Complete(T &&result)
+                {
+                    m_result = std::move(result);
+
+                    /* Whoever gets here second (await_suspend or the callback) is responsible for resuming. */
+                    if (!m_completed.exchange(true, std::memory_order_acq_rel))
+                    {
+                        return;
+                    }
+
+                    std::coroutine_handle<> handle = m_handle;
+                    if (m_resumeOn && !m_resumeOn.IsCallersThread())
+                    {
+                        if (m_resumeOn.Schedule([handle](Io::TaskStatus) { handle.resume(); }))
+                        {
+                            return;
+                        }
+                    }
+
+                    handle.resume();
+                }
+
+              private:
+                Launcher m_launch;
+                Io::EventLoop m_resumeOn;
+                std::coroutine_handle<> m_handle;
+                std::atomic<bool> m_completed;
+                T m_result;
+            };
+
+            /**
+             * Minimal eagerly-started coroutine type with no result. The coroutine frame frees itself when the
+             * body finishes. Exceptions escaping the body terminate the process.
+             */
+            struct DetachedTask
+            {
+                struct promise_type
+                {
+                    DetachedTask get_return_object() noexcept { return {}; }
+                    std::suspend_never initial_suspend() noexcept { return {}; }
+                    std::suspend_never final_suspend() noexcept { return {}; }
+                    void return_void() noexcept {}
+                    void unhandled_exception() noexcept { std::terminate(); }
+                };
+            };
+
+            /**
+             * Result of AcquireConnection()
+             */
+            struct ConnectionAcquisitionResult
+            {
+                std::shared_ptr<Http::HttpClientConnection> connection;
+                int errorCode = AWS_ERROR_SUCCESS;
+            };
+
+            /**
+             * Result of Publish()
+             */
+            struct PublishCompletionResult
+            {
+                std::shared_ptr<Mqtt5::PublishResult> result;
+                int errorCode = AWS_ERROR_SUCCESS;
+            };
+
+            /**
+             * Result of GetCredentials()
+             */
+            struct CredentialsResult
+            {
+                std::shared_ptr<Auth::Credentials> credentials;
+                int errorCode = AWS_ERROR_SUCCESS;
+            };
+
+            /**
+             * Result of SignRequest()
+             */
+            struct SigningResult
+            {
+                std::shared_ptr<Http::HttpRequest> request;
+                int errorCode = AWS_ERROR_SUCCESS;
+            };
+
+            /**
+             * Result of ResolveHost(). The resolver does not let callers keep its address records, so the
+             * addresses are copied out as strings.
+             */
+            struct HostResolutionResult
+            {
+                Vector<String> addresses;
+                int errorCode = AWS_ERROR_SUCCESS;
+            };
+
+            /**
+             * co_await-able form of HttpClientConnectionManager::AcquireConnection().
+             */
+            inline Awaitable<ConnectionAcquisitionResult> AcquireConnection(
+                Http::HttpClientConnectionManager &manager,
+                Io::EventLoop resumeOn = Io::EventLoop())
+            {
+                return Awaitable<ConnectionAcquisitionResult>(
+                    [&manager](Awaitable<ConnectionAcquisitionResult> &awaitable)
+                    {
+                        return manager.AcquireConnection(
+                            [&awaitable](std::shared_ptr<Http::HttpClientConnection> connection, int errorCode)
+                            { awaitable.Complete({std::move(connection), errorCode}); });
+                    },
+                    resumeOn);
+            }
+
+            /**
+             * co_await-able form of Mqtt5Client::Publish(). The coroutine resumes when the publish completes
+             * (for QoS 1, when the PUBACK arrives).
+             */
+            inline Awaitable<PublishCompletionResult> Publish(
+                Mqtt5::Mqtt5Client &client,
+                std::shared_ptr<Mqtt5::PublishPacket> publishPacket,
+                Io::EventLoop resumeOn = Io::EventLoop())
+            {
+                return Awaitable<PublishCompletionResult>(
+                    [&client, publishPacket](Awaitable<PublishCompletionResult> &awaitable)
+                    {
+                        return client.Publish(
+                            publishPacket,
+                            [&awaitable](int errorCode, std::shared_ptr<Mqtt5::PublishResult> result)
+                            { awaitable.Complete({std::move(result), errorCode}); });
+                    },
+                    resumeOn);
+            }
+
+            /**
+             * co_await-able form of ICredentialsProvider::GetCredentials().
+             */
+            inline Awaitable<CredentialsResult> GetCredentials(
+                const Auth::ICredentialsProvider &provider,
+                Io::EventLoop resumeOn = Io::EventLoop())
+            {
+                return Awaitable<CredentialsResult>(
+                    [&provider](Awaitable<CredentialsResult> &awaitable)
+                    {
+                        return provider.GetCredentials(
+                            [&awaitable](std::shared_ptr<Auth::Credentials> credentials, int errorCode)
+                            { awaitable.Complete({std::move(credentials), errorCode}); });
+                    },
+                    resumeOn);
+            }
+
+            /**
+             * co_await-able form of IHttpRequestSigner::SignRequest(), e.g. for Sigv4HttpRequestSigner.
+             * config must outlive the co_await expression.
+             */
+            inline Awaitable<SigningResult> SignRequest(
+                Auth::IHttpRequestSigner &signer,
+                const std::shared_ptr<Http::HttpRequest> &request,
+                const Auth::ISigningConfig &config,
+                Io::EventLoop resumeOn = Io::EventLoop())
+            {
+                return Awaitable<SigningResult>(
+                    [&signer, &request, &config](Awaitable<SigningResult> &awaitable)
+                    {
+                        return signer.SignRequest(
+                            request,
+                            config,
+                            [&awaitable](const std::shared_ptr<Http::HttpRequest> &signedRequest, int errorCode)
+                            { awaitable.Complete({signedRequest, errorCode}); });
+                    },
+                    resumeOn);
+            }
+
+            /**
+             * co_await-able form of HostResolver::ResolveHost().
+             */
+            inline Awaitable<HostResolutionResult> ResolveHost(
+                Io::HostResolver &resolver,
+                const String &host,
+                Io::EventLoop resumeOn = Io::EventLoop())
+            {
+                return Awaitable<HostResolutionResult>(
+                    [&resolver, &host](Awaitable<HostResolutionResult> &awaitable)
+                    {
+                        return resolver.ResolveHost(
+                            host,
+                            [&awaitable](
+                                Io::HostResolver &, const Vector<Io::HostAddress> &addresses, int errorCode)
+                            {
+                                HostResolutionResult result;
+                                result.errorCode = errorCode;
+                                result.addresses.reserve(addresses.size());
+                                for (const Io::HostAddress &address : addresses)
+                                {
+                                    result.addresses.emplace_back(
+                                        aws_string_c_str(address.address), address.address->len);
+                                }
+                                awaitable.Complete(std::move(result));
+                            });
+                    },
+                    resumeOn);
+            }
+        } // namespace Coro
+    } // namespace Crt
+} // namespace Aws
+
+#endif /* __cpp_impl_coroutine */
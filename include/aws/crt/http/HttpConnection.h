@@ -9,6 +9,7 @@
 
 #include <aws/crt/Types.h>
 #include <aws/crt/io/Bootstrap.h>
+#include <aws/crt/io/ConnectionSetupMetrics.h>
 #include <aws/crt/io/SocketOptions.h>
 #include <aws/crt/io/TlsOptions.h>
 
@@ -419,6 +420,21 @@ namespace Aws
                  * byte read from the OnIncomingBody callback.
                  */
                 bool ManualWindowManagement;
+
+                /**
+                 * The event loop the connection should run on. It must belong to the bootstrap's event loop group.
+                 * Use EventLoopGroup::GetLoopNearCaller() to keep the connection on the caller's CPU group.
+                 * Optional. If empty, the bootstrap picks the loop.
+                 */
+                Io::EventLoop RequestedEventLoop;
+
+                /**
+                 * Invoked once the connection's TLS handshake completes or fails, with the time spent resolving and
+                 * connecting and in the handshake. Not invoked for plain text connections, nor by
+                 * HttpClientConnectionManager.
+                 * Optional.
+                 */
+                Io::OnConnectionSetupMetrics OnConnectionSetupMetricsCallback;
             };
 
             enum class HttpVersion
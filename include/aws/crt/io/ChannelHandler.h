@@ -5,7 +5,9 @@
  */
 
 #include <aws/crt/Exports.h>
+#include <aws/crt/InplaceFunction.h>
 #include <aws/crt/Types.h>
+#include <aws/crt/io/EventLoopGroup.h>
 #include <aws/io/channel.h>
 
 #include <chrono>
@@ -31,11 +33,11 @@ namespace Aws
                 ApplicationData,
             };
 
-            enum class TaskStatus
-            {
-                RunReady,
-                Canceled,
-            };
+            /**
+             * Callable type used for tasks scheduled through ChannelHandler::ScheduleTask(). Lambdas with up to 64
+             * bytes of captured state are stored inline without a heap allocation.
+             */
+            using ChannelTask = InplaceFunction<void(TaskStatus), 64>;
 
             /**
              * Wrapper for aws-c-io channel handlers. The semantics are identical as the functions on
@@ -46,7 +48,7 @@ namespace Aws
             class AWS_CRT_CPP_API ChannelHandler
             {
               public:
-                virtual ~ChannelHandler() = default;
+                virtual ~ChannelHandler();
 
                 ChannelHandler(const ChannelHandler &) = delete;
                 ChannelHandler &operator=(const ChannelHandler &) = delete;
@@ -156,6 +158,31 @@ namespace Aws
                  */
                 void ScheduleTask(std::function<void(TaskStatus)> &&task, std::chrono::nanoseconds run_in);
 
+                /**
+                 * Schedule a callable to run on the next "tick" of the event loop.
+                 * If the channel is completely shut down, the task will run with the 'Canceled' status.
+                 *
+                 * Unlike the std::function overload, small callables are stored inline and the task bookkeeping is
+                 * recycled through a per-handler free list, so rescheduling from the channel's thread does not
+                 * allocate.
+                 */
+                template <typename TaskFn> void ScheduleTask(TaskFn &&task)
+                {
+                    ScheduleChannelTask(ChannelTask(std::forward<TaskFn>(task), m_allocator), nullptr);
+                }
+
+                /**
+                 * Schedule a callable to run after a desired length of time has passed.
+                 * The task will run with the 'Canceled' status if the channel completes shutdown
+                 * before that length of time elapses.
+                 *
+                 * See the single argument overload for allocation behavior.
+                 */
+                template <typename TaskFn> void ScheduleTask(TaskFn &&task, std::chrono::nanoseconds run_in)
+                {
+                    ScheduleChannelTask(ChannelTask(std::forward<TaskFn>(task), m_allocator), &run_in);
+                }
+
               protected:
                 ChannelHandler(Allocator *allocator = ApiAllocator());
 
@@ -178,6 +205,20 @@ namespace Aws
                  */
                 bool SendMessage(struct aws_io_message *message, ChannelDirection direction);
 
+                /**
+                 * Copies data into as many messages from the channel's pool as needed and sends them in the given
+                 * direction. If onCompletion is set, it is attached to the last message, so it fires once all of
+                 * data has been written. Nothing is sent if data is empty.
+                 *
+                 * In the read direction, the caller is responsible for honoring DownstreamReadWindow().
+                 * Returns true if all of data was sent.
+                 */
+                bool SendData(
+                    const ByteCursor &data,
+                    ChannelDirection direction,
+                    aws_channel_on_message_write_completed_fn *onCompletion = nullptr,
+                    void *userData = nullptr);
+
                 /**
                  * Issue a window update notification upstream.
                  * Returns true if successful.
@@ -209,9 +250,19 @@ namespace Aws
                 Allocator *m_allocator;
 
               private:
+                struct TaskWrapper;
+
+                void ScheduleChannelTask(ChannelTask &&task, const std::chrono::nanoseconds *runIn);
+                TaskWrapper *AcquireTaskWrapper();
+                void ReleaseTaskWrapper(TaskWrapper *wrapper);
+
                 std::shared_ptr<ChannelHandler> m_selfReference;
+                TaskWrapper *m_freeTaskWrappers;
+                size_t m_freeTaskWrapperCount;
                 static struct aws_channel_handler_vtable s_vtable;
 
+                static void s_ChannelTaskCallback(struct aws_channel_task *, void *arg, enum aws_task_status status);
+
                 static void s_Destroy(struct aws_channel_handler *handler);
                 static int s_ProcessReadMessage(
                     struct aws_channel_handler *,
@@ -0,0 +1,73 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Compression.h>
+#include <aws/crt/Types.h>
+#include <aws/crt/io/ChannelHandler.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            /**
+             * Channel handler that compresses the data written through it and decompresses the data read through
+             * it, as a continuous stream in each direction.
+             *
+             * Every write message is flushed by the compressor, so the peer can decode each message as soon as it
+             * arrives. Decompressed data is forwarded downstream within the downstream read window; upstream is only
+             * credited once the data it sent has been forwarded, so back pressure carries through the handler.
+             *
+             * Decompressed data waiting for the downstream window is bounded: a read that would decompress past the
+             * bound shuts the channel down with AWS_ERROR_SHORT_BUFFER, so a small message expanding to gigabytes
+             * cannot exhaust memory.
+             */
+            class AWS_CRT_CPP_API CompressionHandler : public ChannelHandler
+            {
+              public:
+                /**
+                 * @param compressor codec applied in the write direction. If it is not valid, writes pass through
+                 * unchanged.
+                 * @param decompressor codec applied in the read direction. If it is not valid, reads pass through
+                 * unchanged.
+                 * @param initialWindowSize read window the handler advertises upstream
+                 * @param maxPendingReadSize most bytes of read data held until downstream has window for them
+                 * @param allocator memory allocator to use
+                 */
+                CompressionHandler(
+                    StreamCodec &&compressor,
+                    StreamCodec &&decompressor,
+                    size_t initialWindowSize = SIZE_MAX,
+                    size_t maxPendingReadSize = 16 * 1024 * 1024,
+                    Allocator *allocator = ApiAllocator());
+                ~CompressionHandler() override;
+
+              protected:
+                int ProcessReadMessage(struct aws_io_message *message) override;
+                int ProcessWriteMessage(struct aws_io_message *message) override;
+                int IncrementReadWindow(size_t size) override;
+                void ProcessShutdown(ChannelDirection dir, int errorCode, bool freeScarceResourcesImmediately)
+                    override;
+                size_t InitialWindowSize() override;
+                size_t MessageOverhead() override;
+
+              private:
+                void ForwardPendingReads();
+
+                StreamCodec m_compressor;
+                StreamCodec m_decompressor;
+                size_t m_initialWindowSize;
+                size_t m_maxPendingReadSize;
+                ByteBuf m_writeBuffer;
+                ByteBuf m_pendingRead;
+                size_t m_pendingReadOffset;
+                /* Bytes received from upstream whose output has not been forwarded downstream yet. */
+                size_t m_pendingUpstreamCredit;
+                bool m_readFailed;
+            };
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
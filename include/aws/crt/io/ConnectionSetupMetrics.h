@@ -0,0 +1,124 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Types.h>
+
+#include <aws/io/tls_channel_handler.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            /**
+             * Timings of a TLS connection's setup. Timestamps are in nanoseconds on the high resolution clock
+             * (aws_high_res_clock_get_ticks()), the clock event loops run on.
+             */
+            struct AWS_CRT_CPP_API ConnectionSetupMetrics
+            {
+                ConnectionSetupMetrics() noexcept;
+
+                /**
+                 * When the connection attempt started, or 0 if the client cannot tell (e.g. MQTT 3 reconnects).
+                 */
+                uint64_t attemptStartNs;
+
+                /**
+                 * When the TLS handshake started: host resolution and the socket connect are done by then. 0 if
+                 * the TLS implementation does not report it.
+                 */
+                uint64_t tlsHandshakeStartNs;
+
+                /**
+                 * When the TLS handshake completed or failed.
+                 */
+                uint64_t tlsHandshakeEndNs;
+
+                /**
+                 * AWS_ERROR_SUCCESS if the handshake succeeded, the error it failed with otherwise.
+                 */
+                int tlsErrorCode;
+
+                /**
+                 * Protocol agreed on through ALPN, empty if none was (or the handshake failed).
+                 */
+                String negotiatedProtocol;
+
+                /**
+                 * @return time spent resolving the host and connecting the socket, or zero if unknown.
+                 */
+                std::chrono::nanoseconds ResolveAndConnectDuration() const noexcept;
+
+                /**
+                 * @return duration of the TLS handshake, or zero if unknown.
+                 */
+                std::chrono::nanoseconds TlsHandshakeDuration() const noexcept;
+            };
+
+            /**
+             * Invoked on an event loop thread when a connection's TLS handshake completes or fails.
+             */
+            using OnConnectionSetupMetrics = std::function<void(const ConnectionSetupMetrics &metrics)>;
+
+            /**
+             * @private
+             * Collects ConnectionSetupMetrics for the connections made with a set of TLS connection options, by
+             * hooking their negotiation result callback. Must outlive every connection made with Instrument()'s
+             * result.
+             */
+            class AWS_CRT_CPP_API ConnectionSetupObserver final
+            {
+              public:
+                ConnectionSetupObserver() noexcept;
+                ~ConnectionSetupObserver();
+                ConnectionSetupObserver(const ConnectionSetupObserver &) = delete;
+                ConnectionSetupObserver &operator=(const ConnectionSetupObserver &) = delete;
+
+                /**
+                 * Sets the callback metrics are reported to. Must not be changed while connections are set up.
+                 */
+                void SetCallback(OnConnectionSetupMetrics &&callback) noexcept { m_callback = std::move(callback); }
+
+                /**
+                 * @return true if a callback is set.
+                 */
+                explicit operator bool() const noexcept { return static_cast<bool>(m_callback); }
+
+                /**
+                 * Copies tlsOptions and hooks the copy's negotiation result callback. A callback already set on
+                 * tlsOptions is still invoked.
+                 *
+                 * @return the hooked copy, valid until the next call or the observer's destruction, or nullptr if
+                 * the copy failed.
+                 */
+                aws_tls_connection_options *Instrument(const aws_tls_connection_options &tlsOptions) noexcept;
+
+                /**
+                 * Records the start of a connection attempt. The next reported metrics carry it.
+                 */
+                void OnAttemptStarted() noexcept;
+
+              private:
+                static void s_OnNegotiationResult(
+                    struct aws_channel_handler *handler,
+                    struct aws_channel_slot *slot,
+                    int errorCode,
+                    void *userData);
+
+                OnConnectionSetupMetrics m_callback;
+                aws_tls_connection_options m_tlsOptions;
+                bool m_hasTlsOptions;
+                aws_tls_on_negotiation_result_fn *m_chainedOnNegotiationResult;
+                void *m_chainedUserData;
+                std::atomic<uint64_t> m_attemptStartNs;
+            };
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
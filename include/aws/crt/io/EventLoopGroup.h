@@ -3,16 +3,200 @@
  * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
  * SPDX-License-Identifier: Apache-2.0.
  */
+#include <aws/crt/InplaceFunction.h>
+#include <aws/crt/LatencyHistogram.h>
 #include <aws/crt/Types.h>
 
 #include <aws/io/event_loop.h>
 
+#include <atomic>
+#include <chrono>
+
 namespace Aws
 {
     namespace Crt
     {
         namespace Io
         {
+            enum class TaskStatus
+            {
+                RunReady,
+                Canceled,
+            };
+
+            /**
+             * Callable type for work scheduled directly on an event loop. The task runs with the 'Canceled' status
+             * if the event loop is destroyed before the task gets a chance to run.
+             */
+            using EventLoopTask = InplaceFunction<void(TaskStatus), 64>;
+
+            /**
+             * Strategy used by an EventLoopGroup to pick the event loop that runs a piece of work.
+             */
+            enum class LoopSelection
+            {
+                /**
+                 * Prefer the less busy of a couple of candidate loops, based on each loop's load factor.
+                 * This is the same policy the CRT uses when assigning connections to event loops.
+                 */
+                LeastLoaded,
+
+                /**
+                 * Cycle through the loops of the group in order.
+                 */
+                RoundRobin,
+            };
+
+            /**
+             * How an EventLoopGroup places its event-loop threads on the machine's cores.
+             */
+            enum class EventLoopPlacement
+            {
+                /**
+                 * Threads are not pinned; the OS may run them on any core.
+                 */
+                Unpinned,
+
+                /**
+                 * Each thread is pinned to its own physical core. Cores are taken from every CPU group (e.g. NUMA
+                 * node) in turn, so the loops are spread evenly across the groups. Combine with
+                 * EventLoopGroup::GetLoopNearCaller() to keep a connection's I/O on the caller's node.
+                 */
+                SpreadAcrossCpuGroups,
+            };
+
+            /**
+             * Snapshot of the utilization and task latency of a single event loop.
+             */
+            struct AWS_CRT_CPP_API EventLoopStatistics
+            {
+                EventLoopStatistics() noexcept;
+
+                /**
+                 * Load factor reported by the event loop: the time, in nanoseconds, the loop spent processing
+                 * I/O events and tasks during its most recent one second measurement window.
+                 */
+                size_t loadFactor;
+
+                /**
+                 * Fraction of the most recent measurement window the loop was busy, in [0, 1]. Derived from
+                 * loadFactor. The remainder of the window was spent idle, waiting for I/O or timers.
+                 */
+                double busyRatio;
+
+                /**
+                 * Number of tasks scheduled through EventLoop/EventLoopGroup on this loop.
+                 */
+                uint64_t tasksScheduled;
+
+                /**
+                 * Number of those tasks that have run.
+                 */
+                uint64_t tasksRun;
+
+                /**
+                 * Number of those tasks that were canceled because the loop shut down.
+                 */
+                uint64_t tasksCanceled;
+
+                /**
+                 * Time between the moment a task was due (scheduled time plus requested delay) and the moment it
+                 * started running, for tasks scheduled through EventLoop/EventLoopGroup.
+                 */
+                LatencyHistogramSnapshot taskLatency;
+
+                /**
+                 * Same measurement for the periodic probe task enabled by EventLoopGroup::EnableLatencyProbe().
+                 * Because the probe runs regardless of application traffic, this is the best indicator of handler
+                 * code that blocks the loop.
+                 */
+                LatencyHistogramSnapshot probeLatency;
+            };
+
+            /// @private
+            struct EventLoopInstrumentation;
+
+            /// @private
+            struct EventLoopGroupInstrumentation;
+
+            /**
+             * Non-owning handle to a single event loop of an EventLoopGroup.
+             *
+             * An EventLoop is only valid as long as the EventLoopGroup it came from is alive.
+             */
+            class AWS_CRT_CPP_API EventLoop final
+            {
+              public:
+                EventLoop() noexcept;
+                /**
+                 * @param eventLoop native event loop to wrap
+                 * @param allocator memory allocator to use for scheduled task bookkeeping
+                 */
+                explicit EventLoop(aws_event_loop *eventLoop, Allocator *allocator = ApiAllocator()) noexcept;
+
+                /**
+                 * @return true if this handle refers to an event loop, false otherwise.
+                 */
+                operator bool() const noexcept;
+
+                /**
+                 * Schedule a task to run on this event loop as soon as possible.
+                 * This may be called from any thread.
+                 *
+                 * @return true if the task was scheduled, false otherwise.
+                 */
+                bool Schedule(EventLoopTask &&task);
+
+                /**
+                 * Schedule a task to run on this event loop after a desired length of time has passed.
+                 * This may be called from any thread.
+                 *
+                 * @return true if the task was scheduled, false otherwise.
+                 */
+                bool ScheduleAfter(EventLoopTask &&task, std::chrono::nanoseconds delay);
+
+                /**
+                 * @return true if the calling thread is this event loop's thread.
+                 */
+                bool IsCallersThread() const noexcept;
+
+                /**
+                 * @return the load factor the event loop reports for itself. Higher means busier.
+                 */
+                size_t GetLoadFactor() const noexcept;
+
+                /**
+                 * @return the CPU group (e.g. NUMA node) this loop's thread is pinned to, or -1 if unknown.
+                 */
+                int32_t GetCpuGroup() const noexcept;
+
+                /**
+                 * @return the core this loop's thread is pinned to, or -1 if it is not pinned to a single core.
+                 */
+                int32_t GetCpuId() const noexcept;
+
+                /**
+                 * @return utilization and task latency statistics for this event loop. Task counters and latencies
+                 * are only available for handles obtained from an EventLoopGroup.
+                 */
+                EventLoopStatistics GetStatistics() const noexcept;
+
+                /// @private
+                aws_event_loop *GetUnderlyingHandle() const noexcept;
+
+              private:
+                friend class EventLoopGroup;
+
+                EventLoop(
+                    aws_event_loop *eventLoop,
+                    Allocator *allocator,
+                    EventLoopInstrumentation *instrumentation) noexcept;
+
+                aws_event_loop *m_eventLoop;
+                Allocator *m_allocator;
+                EventLoopInstrumentation *m_instrumentation;
+            };
+
             /**
              * A collection of event loops.
              *
@@ -45,6 +229,16 @@ namespace Aws
                  * @param allocator memory allocator to use.
                  */
                 EventLoopGroup(uint16_t cpuGroup, uint16_t threadCount, Allocator *allocator = ApiAllocator()) noexcept;
+                /**
+                 * @param placement: how to place the event-loop threads on the machine's cores.
+                 * @param threadCount: The number of event-loops to create, default will be 0, which will create one for
+                 * each physical core available to the placement policy.
+                 * @param allocator memory allocator to use.
+                 */
+                EventLoopGroup(
+                    EventLoopPlacement placement,
+                    uint16_t threadCount = 0,
+                    Allocator *allocator = ApiAllocator()) noexcept;
                 ~EventLoopGroup();
                 EventLoopGroup(const EventLoopGroup &) = delete;
                 EventLoopGroup(EventLoopGroup &&) noexcept;
@@ -61,11 +255,99 @@ namespace Aws
                  */
                 int LastError() const;
 
+                /**
+                 * @return the number of event loops in this group.
+                 */
+                size_t GetLoopCount() const noexcept;
+
+                /**
+                 * @return a handle to the event loop at index, or an empty handle if index is out of range.
+                 */
+                EventLoop GetLoopAt(size_t index) const noexcept;
+
+                /**
+                 * @return a handle to an event loop of this group, picked using the given selection strategy.
+                 */
+                EventLoop GetNextLoop(LoopSelection selection = LoopSelection::LeastLoaded) noexcept;
+
+                /**
+                 * @return a handle to the event loop the calling thread belongs to, or an empty handle if the caller
+                 * is not running on one of this group's event loops.
+                 */
+                EventLoop GetCallersLoop() const noexcept;
+
+                /**
+                 * @return the least loaded event loop pinned to the same CPU group (e.g. NUMA node) as the core the
+                 * caller is currently running on. Falls back to GetNextLoop() if the caller's core cannot be
+                 * determined or no loop is local to it.
+                 *
+                 * Pass the result as the requested event loop when creating a connection to keep its I/O local.
+                 */
+                EventLoop GetLoopNearCaller() noexcept;
+
+                /**
+                 * Schedule a task to run as soon as possible on an event loop of this group.
+                 * This may be called from any thread.
+                 *
+                 * @return true if the task was scheduled, false otherwise.
+                 */
+                bool Schedule(EventLoopTask &&task, LoopSelection selection = LoopSelection::LeastLoaded);
+
+                /**
+                 * Schedule a task to run on an event loop of this group after a desired length of time has passed.
+                 * This may be called from any thread.
+                 *
+                 * @return true if the task was scheduled, false otherwise.
+                 */
+                bool ScheduleAfter(
+                    EventLoopTask &&task,
+                    std::chrono::nanoseconds delay,
+                    LoopSelection selection = LoopSelection::LeastLoaded);
+
+                /**
+                 * Schedule a continuation. If the caller is running on one of this group's event loops (for example
+                 * from inside a CRT callback), the task is queued on that same loop so the work stays on the thread
+                 * that produced its input. Otherwise this behaves like Schedule().
+                 *
+                 * @return true if the task was scheduled, false otherwise.
+                 */
+                bool Post(EventLoopTask &&task);
+
+                /**
+                 * @return a snapshot of the statistics of every event loop in this group, indexed like GetLoopAt().
+                 */
+                Vector<EventLoopStatistics> GetStatistics() const;
+
+                /**
+                 * Clears the task counters and latency histograms of every event loop in this group.
+                 */
+                void ResetStatistics() noexcept;
+
+                /**
+                 * Starts running a tiny task on every event loop of this group each interval and records how late
+                 * it runs in EventLoopStatistics::probeLatency. Calling this again changes the interval.
+                 *
+                 * @return true if the probe was started, false otherwise.
+                 */
+                bool EnableLatencyProbe(std::chrono::milliseconds interval) noexcept;
+
+                /**
+                 * Stops the probe started by EnableLatencyProbe(). Samples already recorded are kept.
+                 */
+                void DisableLatencyProbe() noexcept;
+
                 /// @private
                 aws_event_loop_group *GetUnderlyingHandle() noexcept;
 
               private:
+                void InitInstrumentation() noexcept;
+                EventLoopInstrumentation *GetInstrumentation(aws_event_loop *eventLoop) const noexcept;
+
                 aws_event_loop_group *m_eventLoopGroup;
+                /* Owned by the native group: freed by its shutdown callback, once every loop has stopped. */
+                EventLoopGroupInstrumentation *m_instrumentation;
+                Allocator *m_allocator;
+                std::atomic<size_t> m_nextLoopIndex;
                 int m_lastError;
             };
         } // namespace Io
@@ -0,0 +1,141 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Types.h>
+#include <aws/crt/io/ChannelHandler.h>
+
+#include <functional>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            enum class FramingMode
+            {
+                /**
+                 * Each frame is preceded by its length, as a big-endian unsigned integer of LengthPrefixSize bytes.
+                 */
+                LengthPrefix,
+
+                /**
+                 * Each frame is followed by Delimiter. Payloads must not contain the delimiter, it is not escaped.
+                 */
+                Delimiter,
+            };
+
+            /**
+             * Invoked with the payload of each complete frame. The cursor is only valid for the duration of the call.
+             */
+            using OnFrameReceived = std::function<void(const ByteCursor &frame)>;
+
+            /**
+             * Configuration for a FramingHandler.
+             */
+            class AWS_CRT_CPP_API FramingHandlerOptions
+            {
+              public:
+                FramingHandlerOptions();
+                FramingHandlerOptions(const FramingHandlerOptions &rhs) = default;
+                FramingHandlerOptions(FramingHandlerOptions &&rhs) = default;
+                FramingHandlerOptions &operator=(const FramingHandlerOptions &rhs) = default;
+                FramingHandlerOptions &operator=(FramingHandlerOptions &&rhs) = default;
+
+                /**
+                 * How frames are delimited on the wire. Defaults to FramingMode::LengthPrefix.
+                 */
+                FramingMode Mode;
+
+                /**
+                 * Size in bytes of the length prefix, from 1 to 8. Defaults to 4.
+                 */
+                size_t LengthPrefixSize;
+
+                /**
+                 * Byte sequence that terminates each frame in FramingMode::Delimiter. Defaults to "\n".
+                 */
+                String Delimiter;
+
+                /**
+                 * Largest frame payload accepted in the read direction. A peer sending a larger frame causes the
+                 * channel to shut down with AWS_IO_CHANNEL_ERROR_ERROR_CANT_ACCEPT_INPUT. Defaults to 1 MiB.
+                 */
+                size_t MaxFrameSize;
+
+                /**
+                 * Most bytes of read data held while downstream has no window for them, complete frames included.
+                 * A read that would exceed it shuts the channel down with AWS_IO_CHANNEL_ERROR_ERROR_CANT_ACCEPT_INPUT.
+                 * Must be at least MaxFrameSize plus the framing overhead. Defaults to 16 MiB.
+                 */
+                size_t MaxBufferedSize;
+
+                /**
+                 * Read window the handler advertises upstream. Must be larger than MaxFrameSize plus the framing
+                 * overhead, or a maximum size frame can never arrive. Upstream is credited as frames are delivered,
+                 * so a window no larger than MaxBufferedSize applies back pressure instead of failing the channel
+                 * when downstream stops reading. Defaults to SIZE_MAX.
+                 */
+                size_t InitialWindowSize;
+
+                /**
+                 * If set, received frames are handed to this callback and nothing is sent further down the channel
+                 * in the read direction: the handler is meant to be the last one of the channel.
+                 *
+                 * Otherwise each frame is forwarded downstream as a single message, when it fits in one. Frames
+                 * larger than the channel's maximum message size are forwarded as several consecutive messages.
+                 */
+                OnFrameReceived OnFrameReceivedCallback;
+            };
+
+            /**
+             * Channel handler that splits the incoming byte stream into frames and frames outgoing data.
+             *
+             * Read direction: bytes are accumulated until a complete frame is available, so downstream handlers see
+             * whole frames regardless of how the data was segmented on the wire.
+             *
+             * Write direction: each message written by the downstream handler becomes one frame. SendFrame() writes
+             * a frame from the handler's own side, e.g. when the handler is the last one of the channel.
+             */
+            class AWS_CRT_CPP_API FramingHandler : public ChannelHandler
+            {
+              public:
+                FramingHandler(const FramingHandlerOptions &options, Allocator *allocator = ApiAllocator());
+                ~FramingHandler() override;
+
+                /**
+                 * Frames payload and sends it in the write direction. Must be called from the channel's thread.
+                 *
+                 * @return true if the frame was sent, false otherwise.
+                 */
+                bool SendFrame(const ByteCursor &payload);
+
+              protected:
+                int ProcessReadMessage(struct aws_io_message *message) override;
+                int ProcessWriteMessage(struct aws_io_message *message) override;
+                int IncrementReadWindow(size_t size) override;
+                void ProcessShutdown(ChannelDirection dir, int errorCode, bool freeScarceResourcesImmediately)
+                    override;
+                size_t InitialWindowSize() override;
+                size_t MessageOverhead() override;
+
+              private:
+                bool EncodeFrame(
+                    const ByteCursor &payload,
+                    aws_channel_on_message_write_completed_fn *onCompletion,
+                    void *userData);
+                bool NextFrame(const ByteCursor &buffered, size_t scanFrom, ByteCursor &frame, size_t &frameSize);
+                void DeliverFrames();
+
+                FramingHandlerOptions m_options;
+                ByteBuf m_readBuffer;
+                /* Delimiter mode: number of buffered bytes already known not to contain the start of a delimiter. */
+                size_t m_scannedBytes;
+                bool m_delivering;
+                bool m_readFailed;
+            };
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
@@ -0,0 +1,117 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/LatencyHistogram.h>
+#include <aws/crt/Types.h>
+#include <aws/crt/io/ChannelHandler.h>
+
+#include <aws/common/statistics.h>
+
+#include <atomic>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            /**
+             * Statistics category under which MetricsHandler reports through the channel's statistics gathering
+             * (aws_crt_statistics_handler). Taken from the range following the aws-c-* libraries' own.
+             */
+            static const aws_crt_statistics_category_t ChannelMetricsStatisticsCategory =
+                AWS_CRT_STATISTICS_CATEGORY_BEGIN_RANGE(16);
+
+            /**
+             * Per-interval counters reported by MetricsHandler::GatherStatistics(). Laid out like the aws-c-io
+             * statistics structures: the category comes first.
+             */
+            struct ChannelMetricsStatistics
+            {
+                aws_crt_statistics_category_t category;
+                uint64_t bytesRead;
+                uint64_t bytesWritten;
+                uint64_t messagesRead;
+                uint64_t messagesWritten;
+            };
+
+            /**
+             * Cumulative metrics of a MetricsHandler.
+             */
+            struct AWS_CRT_CPP_API ChannelMetrics
+            {
+                ChannelMetrics() noexcept;
+
+                uint64_t bytesRead;
+                uint64_t bytesWritten;
+                uint64_t messagesRead;
+                uint64_t messagesWritten;
+
+                /**
+                 * Time from a message entering the handler in the write direction to its write completing, for
+                 * messages whose completion is reported by the channel (e.g. written to a socket).
+                 */
+                LatencyHistogramSnapshot writeCompletionLatency;
+
+                /**
+                 * Time the handlers downstream of this one spent processing each message in the read direction.
+                 */
+                LatencyHistogramSnapshot readProcessingLatency;
+            };
+
+            /**
+             * Pass-through channel handler that counts the bytes and messages flowing through it and records write
+             * completion and read processing latency.
+             *
+             * Per-interval counters are published through GatherStatistics(), so they show up in the channel's
+             * statistics handler. Cumulative values can be read from any thread with GetMetrics().
+             */
+            class AWS_CRT_CPP_API MetricsHandler : public ChannelHandler
+            {
+              public:
+                MetricsHandler(Allocator *allocator = ApiAllocator());
+                ~MetricsHandler() override;
+
+                /**
+                 * @return the cumulative metrics of this handler. May be called from any thread.
+                 */
+                ChannelMetrics GetMetrics() const noexcept;
+
+              protected:
+                int ProcessReadMessage(struct aws_io_message *message) override;
+                int ProcessWriteMessage(struct aws_io_message *message) override;
+                int IncrementReadWindow(size_t size) override;
+                void ProcessShutdown(ChannelDirection dir, int errorCode, bool freeScarceResourcesImmediately)
+                    override;
+                size_t InitialWindowSize() override;
+                size_t MessageOverhead() override;
+                void ResetStatistics() override;
+                void GatherStatistics(struct aws_array_list *statsList) override;
+
+              private:
+                struct WriteCompletion;
+
+                WriteCompletion *AcquireWriteCompletion();
+                void ReleaseWriteCompletion(WriteCompletion *completion);
+
+                static void s_OnWriteCompleted(
+                    struct aws_channel *channel,
+                    struct aws_io_message *message,
+                    int errorCode,
+                    void *userData);
+
+                ChannelMetricsStatistics m_intervalStatistics;
+                std::atomic<uint64_t> m_bytesRead;
+                std::atomic<uint64_t> m_bytesWritten;
+                std::atomic<uint64_t> m_messagesRead;
+                std::atomic<uint64_t> m_messagesWritten;
+                LatencyHistogram m_writeCompletionLatency;
+                LatencyHistogram m_readProcessingLatency;
+                WriteCompletion *m_freeWriteCompletions;
+                size_t m_freeWriteCompletionCount;
+            };
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
@@ -0,0 +1,95 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Types.h>
+#include <aws/crt/io/TlsOptions.h>
+
+#include <memory>
+#include <mutex>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            /**
+             * Counters of a TlsContextCache.
+             */
+            struct AWS_CRT_CPP_API TlsContextCacheStatistics
+            {
+                TlsContextCacheStatistics() noexcept;
+
+                /**
+                 * Requests served with an existing context.
+                 */
+                uint64_t hits;
+
+                /**
+                 * Requests that had to build a context.
+                 */
+                uint64_t misses;
+
+                /**
+                 * Requests whose options cannot be shared (e.g. PKCS#11), served with a context of their own.
+                 */
+                uint64_t uncacheable;
+            };
+
+            /**
+             * Shares TlsContexts between equivalent TlsContextOptions, so that identical configurations load their
+             * certificates, keys and trust store once.
+             *
+             * Options are compared by a SHA-256 hash over the inputs they were built from (credentials, trust store,
+             * ALPN list, peer verification, TLS version, cipher preference) and the TlsMode.
+             * Files are identified by path: a cached context keeps using what was loaded when it was built. Options
+             * using PKCS#11 are never shared.
+             *
+             * The cache only holds weak references: a context is shared while any TlsContext returned for it (or
+             * a copy of it) is alive, and built anew once they are all gone.
+             *
+             * All functions are thread safe. ApiHandle::GetOrCreateStaticDefaultTlsContextCache() provides a
+             * process-wide instance.
+             */
+            class AWS_CRT_CPP_API TlsContextCache final
+            {
+              public:
+                TlsContextCache(Allocator *allocator = ApiAllocator()) noexcept;
+                ~TlsContextCache();
+                TlsContextCache(const TlsContextCache &) = delete;
+                TlsContextCache &operator=(const TlsContextCache &) = delete;
+
+                /**
+                 * Returns a context for options and mode, shared with every other caller passing equivalent options.
+                 * Contexts that fail to initialize are returned but not cached; check them as usual.
+                 *
+                 * @param options: configuration of the context.
+                 * @param mode: client or server.
+                 * @return the context.
+                 */
+                TlsContext GetOrCreate(TlsContextOptions &options, TlsMode mode) noexcept;
+
+                /**
+                 * @return the number of distinct contexts currently shared through this cache.
+                 */
+                size_t Size() const noexcept;
+
+                /**
+                 * @return the counters of this cache.
+                 */
+                TlsContextCacheStatistics GetStatistics() const noexcept;
+
+              private:
+                static bool s_ComputeKey(const TlsContextOptions &options, TlsMode mode, String &key) noexcept;
+                void PurgeExpired() noexcept;
+
+                Allocator *m_allocator;
+                mutable std::mutex m_lock;
+                Map<String, std::weak_ptr<aws_tls_ctx>> m_entries;
+                TlsContextCacheStatistics m_statistics;
+            };
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
@@ -9,6 +9,7 @@
 #include <aws/io/tls_channel_handler.h>
 
 #include <functional>
+#include <initializer_list>
 #include <memory>
 
 struct aws_tls_ctx_options;
@@ -35,6 +36,7 @@ namespace Aws
             class AWS_CRT_CPP_API TlsContextOptions
             {
                 friend class TlsContext;
+                friend class TlsContextCache;
 
               public:
                 TlsContextOptions() noexcept;
@@ -204,7 +206,16 @@ namespace Aws
                 const aws_tls_ctx_options *GetUnderlyingHandle() const noexcept { return &m_options; }
 
               private:
+                /**
+                 * Records an input of these options under name, for TlsContextCache to tell equivalent options
+                 * apart. With digest set, only a SHA-256 digest of the parts is kept, so key material and passwords
+                 * are not copied; if it cannot be computed, the options are marked as not cacheable.
+                 */
+                void RecordFingerprint(const char *name, std::initializer_list<ByteCursor> parts, bool digest) noexcept;
+
                 aws_tls_ctx_options m_options;
+                Map<String, String> m_fingerprint;
+                bool m_cacheable;
                 bool m_isInit;
             };
 
@@ -377,6 +388,10 @@ namespace Aws
                 aws_tls_ctx *GetUnderlyingHandle() const noexcept { return m_ctx.get(); }
 
               private:
+                friend class TlsContextCache;
+
+                TlsContext(std::shared_ptr<aws_tls_ctx> ctx) noexcept;
+
                 bool isValid() const noexcept { return m_ctx && m_initializationError == AWS_ERROR_SUCCESS; }
 
                 std::shared_ptr<aws_tls_ctx> m_ctx;
@@ -0,0 +1,135 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Types.h>
+#include <aws/crt/io/ChannelHandler.h>
+
+#include <atomic>
+#include <chrono>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            /**
+             * Configuration for a WriteCoalescingHandler.
+             */
+            class AWS_CRT_CPP_API WriteCoalescingOptions
+            {
+              public:
+                WriteCoalescingOptions();
+                WriteCoalescingOptions(const WriteCoalescingOptions &rhs) = default;
+                WriteCoalescingOptions &operator=(const WriteCoalescingOptions &rhs) = default;
+
+                /**
+                 * Longest time a write may be held back waiting for more data to batch with. Zero (the default)
+                 * holds writes until the end of the current event loop tick, so everything written in response to
+                 * the same event goes out together without adding latency.
+                 */
+                std::chrono::nanoseconds MaxDelay;
+
+                /**
+                 * A batch is sent as soon as it holds this many bytes. Writes at least this large bypass batching.
+                 * Zero (the default) means the largest message the channel allows, see AcquireMaxSizeMessageForWrite().
+                 */
+                size_t MaxBytes;
+            };
+
+            /**
+             * Counters of a WriteCoalescingHandler. Comparing messagesIn to messagesOut gives the coalescing ratio.
+             */
+            struct AWS_CRT_CPP_API WriteCoalescingStatistics
+            {
+                WriteCoalescingStatistics() noexcept;
+
+                /**
+                 * Messages received in the write direction.
+                 */
+                uint64_t messagesIn;
+
+                /**
+                 * Messages sent on in the write direction.
+                 */
+                uint64_t messagesOut;
+
+                /**
+                 * Bytes sent on in the write direction.
+                 */
+                uint64_t bytesOut;
+            };
+
+            /**
+             * Channel handler that packs small writes into full size messages (Nagle-style batching), so a burst of
+             * small writes costs a few TLS records and syscalls rather than one each.
+             *
+             * Write completion callbacks of the batched messages fire when the batch they were packed into has been
+             * written, each with the message it was given for. Reads pass through untouched.
+             *
+             * Place it right after the TLS handler (or the socket handler, without TLS).
+             */
+            class AWS_CRT_CPP_API WriteCoalescingHandler : public ChannelHandler
+            {
+              public:
+                WriteCoalescingHandler(
+                    const WriteCoalescingOptions &options = WriteCoalescingOptions(),
+                    Allocator *allocator = ApiAllocator());
+                ~WriteCoalescingHandler() override;
+
+                /**
+                 * Sends the current batch immediately. Must be called from the channel's thread.
+                 *
+                 * @return true if nothing was pending or the batch was sent, false otherwise.
+                 */
+                bool Flush();
+
+                /**
+                 * @return the counters of this handler. May be called from any thread.
+                 */
+                WriteCoalescingStatistics GetStatistics() const noexcept;
+
+              protected:
+                int ProcessReadMessage(struct aws_io_message *message) override;
+                int ProcessWriteMessage(struct aws_io_message *message) override;
+                int IncrementReadWindow(size_t size) override;
+                void ProcessShutdown(ChannelDirection dir, int errorCode, bool freeScarceResourcesImmediately)
+                    override;
+                size_t InitialWindowSize() override;
+                size_t MessageOverhead() override;
+
+              private:
+                struct Batch;
+
+                Batch *AcquireBatch();
+                void ReleaseBatch(Batch *batch);
+                size_t BatchLimit() const;
+                bool StartBatch();
+                void ScheduleFlush(uint64_t delayNanos);
+                void OnFlushTimer();
+                bool SendPassthrough(struct aws_io_message *message);
+
+                static void s_OnBatchWritten(
+                    struct aws_channel *channel,
+                    struct aws_io_message *message,
+                    int errorCode,
+                    void *userData);
+
+                WriteCoalescingOptions m_options;
+                struct aws_io_message *m_pending;
+                Batch *m_pendingBatch;
+                size_t m_pendingLimit;
+                uint64_t m_batchStartNanos;
+                bool m_flushScheduled;
+                Batch *m_freeBatches;
+                size_t m_freeBatchCount;
+
+                std::atomic<uint64_t> m_messagesIn;
+                std::atomic<uint64_t> m_messagesOut;
+                std::atomic<uint64_t> m_bytesOut;
+            };
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
@@ -3,6 +3,8 @@
  * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
  * SPDX-License-Identifier: Apache-2.0.
  */
+#include <aws/crt/Compression.h>
+#include <aws/crt/LatencyHistogram.h>
 #include <aws/crt/http/HttpConnection.h>
 #include <aws/crt/mqtt/Mqtt5Types.h>
 #include <aws/crt/mqtt/MqttClient.h>
@@ -21,6 +23,7 @@ namespace Aws
             class NegotiatedSettings;
             class PublishResult;
             class PublishPacket;
+            class PublishTemplate;
             class PubAckPacket;
             class SubscribePacket;
             class SubAckPacket;
@@ -169,6 +172,97 @@ namespace Aws
                 uint64_t m_minConnectedTimeToResetReconnectDelayMs;
             };
 
+            /**
+             * Configures the disk-backed offline queue of a client, see Mqtt5ClientOptions::WithDurableOfflineQueue
+             */
+            struct AWS_CRT_CPP_API DurableOfflineQueueOptions
+            {
+                /**
+                 * Path of the append-only segment file holding the spilled publishes. It is created if it does not
+                 * exist; publishes it holds from a previous run are replayed first. Two clients must not share a
+                 * segment file.
+                 */
+                Crt::String m_segmentFilePath;
+
+                /**
+                 * Topic and payload bytes of the publishes the client may hold in memory, queued or waiting for an
+                 * ack, before further publishes are spilled to the segment file.
+                 */
+                uint64_t m_memoryWatermarkBytes;
+            };
+
+            /**
+             * Configures payload compression of a client, see Mqtt5ClientOptions::WithPayloadCompression
+             */
+            struct AWS_CRT_CPP_API PayloadCompressionOptions
+            {
+                PayloadCompressionOptions() noexcept;
+
+                /**
+                 * Algorithm of the publishes the client compresses. Defaults to Deflate. Received publishes are
+                 * decompressed with whichever algorithm they name, if the build supports it.
+                 */
+                CompressionAlgorithm m_algorithm;
+
+                /**
+                 * Payloads smaller than this are sent as they are, as compression would not pay off for them.
+                 * Defaults to 256 bytes.
+                 */
+                size_t m_thresholdBytes;
+
+                /**
+                 * Compression level, algorithm specific. A negative value selects the algorithm's default, which is
+                 * the default.
+                 */
+                int m_level;
+
+                /**
+                 * Largest payload a received publish may decompress to. Publishes decompressing to more are dropped
+                 * with an error logged, so that a peer cannot exhaust memory with a small message inflating to a huge
+                 * one. 0, the default, uses the maximum packet size the client sets in its CONNECT, or 256 MiB, the
+                 * largest packet MQTT5 allows, if it sets none.
+                 */
+                size_t m_maxDecompressedBytes;
+            };
+
+            /**
+             * Token bucket limits of one QoS of publishes, see PublishRateLimitOptions. A limit of 0 is unlimited.
+             */
+            struct AWS_CRT_CPP_API PublishRateLimit
+            {
+                PublishRateLimit() noexcept;
+
+                /**
+                 * Publishes per second
+                 */
+                uint64_t m_messagesPerSecond;
+
+                /**
+                 * Topic and payload bytes per second, counted before payload compression
+                 */
+                uint64_t m_bytesPerSecond;
+            };
+
+            /**
+             * Configures client-side publish rate limiting, see Mqtt5ClientOptions::WithPublishRateLimit
+             *
+             * Each limit is a token bucket holding up to one second worth of its rate, so a client that was idle may
+             * send a burst of that size at once. AWS IoT Core for instance allows 100 publishes and 512 KiB per
+             * second and connection.
+             */
+            struct AWS_CRT_CPP_API PublishRateLimitOptions
+            {
+                /**
+                 * Limits of the QoS 0 publishes
+                 */
+                PublishRateLimit m_qos0;
+
+                /**
+                 * Limits of the QoS 1 publishes
+                 */
+                PublishRateLimit m_qos1;
+            };
+
             /**
              * Simple statistics about the current state of the client's queue of operations
              */
@@ -199,6 +293,72 @@ namespace Aws
                 uint64_t unackedOperationSize;
             };
 
+            /**
+             * Traffic, latency and backpressure counters of a client, accumulated since it was created. They cover
+             * the operations submitted through the Mqtt5Client and the PUBLISH packets it receives.
+             */
+            struct AWS_CRT_CPP_API Mqtt5ClientMetrics
+            {
+                Mqtt5ClientMetrics() noexcept;
+
+                /**
+                 * PUBLISH packets sent successfully, by QoS. QoS 0 publishes count once written to the socket, QoS 1
+                 * publishes once acknowledged.
+                 */
+                uint64_t publishesSentQos0;
+                uint64_t publishesSentQos1;
+
+                /**
+                 * PUBLISH packets received, by QoS
+                 */
+                uint64_t publishesReceivedQos0;
+                uint64_t publishesReceivedQos1;
+
+                /**
+                 * Topic and payload bytes of the PUBLISH packets sent successfully and received, after compression
+                 * when payload compression is set. Packet headers, properties, other packet types and TLS overhead
+                 * are not included.
+                 */
+                uint64_t publishBytesSent;
+                uint64_t publishBytesReceived;
+
+                /**
+                 * Time from submitting a QoS 1 publish to receiving its PUBACK, including the time it spent queued in
+                 * the client.
+                 */
+                LatencyHistogramSnapshot pubAckLatency;
+
+                /**
+                 * Connections successfully established, and how many of them were reconnects
+                 */
+                uint64_t connectionSuccesses;
+                uint64_t reconnects;
+
+                /**
+                 * Publish, subscribe and unsubscribe operations submitted and not completed yet: queued while offline,
+                 * waiting to be sent or waiting for an ack.
+                 */
+                uint64_t incompleteOperationCount;
+
+                /**
+                 * Largest incompleteOperationCount since the previous call to GetMetrics(), so that polling the
+                 * metrics periodically tracks the depth of the queue over time without missing bursts.
+                 */
+                uint64_t incompleteOperationPeak;
+
+                /**
+                 * Time spent connected with as many QoS 1 publishes outstanding as the receive maximum of the server
+                 * allows, during which further QoS 1 publishes wait in the queue.
+                 */
+                uint64_t flowControlBlockedNanos;
+
+                /**
+                 * Publishes held back by the publish rate limit, and the total time they waited for it
+                 */
+                uint64_t publishesRateLimited;
+                uint64_t rateLimitDelayNanos;
+            };
+
             /**
              * The data returned when AttemptingConnect is invoked in the LifecycleEvents callback.
              * Currently empty, but may be used in the future for passing additional data.
@@ -281,6 +441,12 @@ namespace Aws
              */
             using OnAttemptingConnectHandler = std::function<void(const OnAttemptingConnectEventData &)>;
 
+            /**
+             * Type signature of the callback invoked when the TLS handshake of a connection attempt completes or
+             * fails
+             */
+            using OnConnectionSetupMetricsHandler = std::function<void(const Io::ConnectionSetupMetrics &)>;
+
             /**
              * Type signature of the callback invoked when client connection stopped
              * Mandatory event fields: client
@@ -402,6 +568,25 @@ namespace Aws
                     std::shared_ptr<PublishPacket> publishPacket,
                     OnPublishCompletionHandler onPublishCompletionCallback = NULL) noexcept;
 
+                /**
+                 * Tells the client to attempt to send a PUBLISH packet made of a template and a payload. The
+                 * topic, properties and user properties of the template are shared by every publish made from it
+                 * rather than copied into a PublishPacket each time.
+                 *
+                 * The payload is only read during the call: the client copies what it keeps, so the caller may
+                 * reuse its buffer as soon as Publish() returns.
+                 *
+                 * @param publishTemplate: fields of the PUBLISH packet to send to the server
+                 * @param payload: payload of the PUBLISH packet
+                 * @param onPublishCompletionCallback: callback on publish complete, default to NULL
+                 *
+                 * @return true if the publish operation succeed otherwise false
+                 */
+                bool Publish(
+                    std::shared_ptr<const PublishTemplate> publishTemplate,
+                    ByteCursor payload,
+                    OnPublishCompletionHandler onPublishCompletionCallback = NULL) noexcept;
+
                 /**
                  * Tells the client to attempt to subscribe to one or more topic filters.
                  *
@@ -433,6 +618,13 @@ namespace Aws
                  */
                 const Mqtt5ClientOperationStatistics &GetOperationStatistics() noexcept;
 
+                /**
+                 * Get the traffic, latency and backpressure counters of the client
+                 *
+                 * @return Mqtt5ClientMetrics
+                 */
+                Mqtt5ClientMetrics GetMetrics() noexcept;
+
                 virtual ~Mqtt5Client();
 
               private:
@@ -450,6 +642,7 @@ namespace Aws
             class AWS_CRT_CPP_API Mqtt5ClientOptions final
             {
                 friend class Mqtt5ClientCore;
+                friend class Mqtt5ClientFleet;
                 friend class Mqtt5to3AdapterOptions;
 
               public:
@@ -567,6 +760,63 @@ namespace Aws
                  */
                 Mqtt5ClientOptions &WithReconnectOptions(ReconnectOptions reconnectOptions) noexcept;
 
+                /**
+                 * Sets a disk-backed offline queue for publishes. While the client is disconnected, or holds more
+                 * publishes than the memory watermark, Publish() appends publishes to a segment file instead of
+                 * queueing them in memory. They are replayed in order once the client is connected and back under the
+                 * watermark, including after a restart of the process. Publish() then keeps the order of submission.
+                 *
+                 * Only the topic, payload, QoS and retain flag of a spilled publish are kept. Its completion callback
+                 * is invoked once it is replayed and completes, unless the process restarted in between. A replayed
+                 * publish leaves the file once it completes, successfully or not; publishes replayed but not completed
+                 * when the client is destroyed are replayed again by the next one. The file is flushed to the
+                 * operating system on every write, not synced to the storage device.
+                 *
+                 * Subscribes, unsubscribes and the publishes of a MqttConnection created from the client do not go
+                 * through the queue.
+                 *
+                 * @param durableOfflineQueueOptions segment file and memory watermark
+                 *
+                 * @return this option object
+                 */
+                Mqtt5ClientOptions &WithDurableOfflineQueue(
+                    const DurableOfflineQueueOptions &durableOfflineQueueOptions) noexcept;
+
+                /**
+                 * Sets payload compression. Payloads of outgoing publishes at least as large as the threshold are
+                 * compressed, and sent compressed if that makes them smaller, with a "content-encoding" user property
+                 * naming the algorithm ("deflate" or "zstd") and no payload format indicator. Received publishes with
+                 * such a property are decompressed before reaching the publish received callback, which sees neither
+                 * the property nor the compressed payload. A received payload that fails to decompress is delivered
+                 * as it is.
+                 *
+                 * Both ends must use this option, or otherwise understand the content-encoding user property.
+                 * Client creation fails if the build does not support the algorithm.
+                 *
+                 * @param payloadCompressionOptions algorithm, size threshold and level
+                 *
+                 * @return this option object
+                 */
+                Mqtt5ClientOptions &WithPayloadCompression(
+                    const PayloadCompressionOptions &payloadCompressionOptions) noexcept;
+
+                /**
+                 * Sets client-side rate limits on publishes, to stay under the per-connection limits of the server
+                 * rather than be throttled or disconnected by it. A publish exceeding the limits of its QoS is held
+                 * by the client and submitted as soon as the limits allow. Publishes of a QoS are submitted in the
+                 * order Publish() accepted them; one that does not exceed the limits and has nothing queued before it
+                 * is submitted right away.
+                 *
+                 * Publishes held by the limiter when the client is destroyed are dropped without invoking their
+                 * completion callback. Publishes of a MqttConnection created from the client are not limited.
+                 *
+                 * @param publishRateLimitOptions message and byte rates, per QoS
+                 *
+                 * @return this option object
+                 */
+                Mqtt5ClientOptions &WithPublishRateLimit(
+                    const PublishRateLimitOptions &publishRateLimitOptions) noexcept;
+
                 /**
                  * Sets the topic aliasing behavior for the client.
                  *
@@ -676,6 +926,17 @@ namespace Aws
                  */
                 Mqtt5ClientOptions &WithClientAttemptingConnectCallback(OnAttemptingConnectHandler callback) noexcept;
 
+                /**
+                 * Sets callback trigged when the TLS handshake of a connection attempt completes or fails, with the
+                 * time the attempt spent resolving, connecting and in the handshake. Only used with TLS.
+                 *
+                 * @param callback
+                 *
+                 * @return this option object
+                 */
+                Mqtt5ClientOptions &WithConnectionSetupMetricsCallback(
+                    OnConnectionSetupMetricsHandler callback) noexcept;
+
                 /**
                  * Sets callback trigged when a PUBLISH packet is received by the client
                  *
@@ -738,6 +999,11 @@ namespace Aws
                  */
                 OnAttemptingConnectHandler onAttemptingConnect;
 
+                /**
+                 * Callback handler trigged when the TLS handshake of a connection attempt completes or fails.
+                 */
+                OnConnectionSetupMetricsHandler onConnectionSetupMetrics;
+
                 /**
                  * Callback handler trigged when an MQTT PUBLISH packet is received by the client
                  *
@@ -808,6 +1074,21 @@ namespace Aws
                  */
                 ReconnectOptions m_reconnectionOptions;
 
+                /**
+                 * Disk-backed offline queue for publishes, disabled if undefined
+                 */
+                Crt::Optional<DurableOfflineQueueOptions> m_durableOfflineQueueOptions;
+
+                /**
+                 * Compression of publish payloads, disabled if undefined
+                 */
+                Crt::Optional<PayloadCompressionOptions> m_payloadCompressionOptions;
+
+                /**
+                 * Rate limits of publishes, disabled if undefined
+                 */
+                Crt::Optional<PublishRateLimitOptions> m_publishRateLimitOptions;
+
                 /**
                  * Controls client topic aliasing behavior
                  */
@@ -0,0 +1,302 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/mqtt/Mqtt5Client.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            /**
+             * Type signature of the callback invoked when a member of a fleet successfully establishes an MQTT
+             * connection
+             */
+            using OnFleetConnectionSuccessHandler =
+                std::function<void(size_t clientIndex, const OnConnectionSuccessEventData &)>;
+
+            /**
+             * Type signature of the callback invoked when a member of a fleet fails to establish an MQTT connection
+             */
+            using OnFleetConnectionFailureHandler =
+                std::function<void(size_t clientIndex, const OnConnectionFailureEventData &)>;
+
+            /**
+             * Type signature of the callback invoked when the MQTT connection of a member of a fleet is closed
+             */
+            using OnFleetDisconnectionHandler =
+                std::function<void(size_t clientIndex, const OnDisconnectionEventData &)>;
+
+            /**
+             * Type signature of the callback invoked when a member of a fleet reaches the "Stopped" state
+             */
+            using OnFleetStoppedHandler = std::function<void(size_t clientIndex, const OnStoppedEventData &)>;
+
+            /**
+             * Type signature of the callback invoked when a member of a fleet receives a PUBLISH packet
+             */
+            using OnFleetPublishReceivedHandler =
+                std::function<void(size_t clientIndex, const PublishReceivedEventData &)>;
+
+            /* Internal state of a Mqtt5ClientFleet and of its clients, defined in Mqtt5ClientFleet.cpp */
+            struct Mqtt5ClientFleetShared;
+            struct Mqtt5ClientFleetMember;
+
+            /**
+             * Configuration of a Mqtt5ClientFleet, on top of the Mqtt5ClientOptions shared by all of its members.
+             */
+            class AWS_CRT_CPP_API Mqtt5ClientFleetOptions final
+            {
+                friend class Mqtt5ClientFleet;
+
+              public:
+                Mqtt5ClientFleetOptions(Allocator *allocator = ApiAllocator()) noexcept;
+
+                /**
+                 * Sets the number of clients of the fleet.
+                 *
+                 * @param clientCount number of clients, must be at least 1
+                 *
+                 * @return this options object
+                 */
+                Mqtt5ClientFleetOptions &WithClientCount(size_t clientCount) noexcept;
+
+                /**
+                 * Sets the prefix of the client ids. Client i of the fleet connects with the client id
+                 * "<prefix><i>". If the prefix is empty, the client id of the shared connect options is used as the
+                 * prefix; if that is empty too, the clients connect without a client id and let the server assign one.
+                 *
+                 * @param clientIdPrefix prefix of the client ids
+                 *
+                 * @return this options object
+                 */
+                Mqtt5ClientFleetOptions &WithClientIdPrefix(const String &clientIdPrefix) noexcept;
+
+                /**
+                 * Sets how many bytes each client may hold before new operations are rejected with AWS_ERROR_OOM.
+                 * Memory held by a client includes its connection, queued operations and in-flight packets. The
+                 * budget is checked when an operation is submitted: a client can go over it by the size of the
+                 * operations it already accepted, but not by more.
+                 *
+                 * @param bytes budget in bytes, 0 for no limit. Defaults to 0.
+                 *
+                 * @return this options object
+                 */
+                Mqtt5ClientFleetOptions &WithMemoryBudgetPerClient(size_t bytes) noexcept;
+
+                /**
+                 * Sets the callback invoked when a client successfully establishes an MQTT connection
+                 *
+                 * @param callback
+                 *
+                 * @return this options object
+                 */
+                Mqtt5ClientFleetOptions &WithConnectionSuccessCallback(
+                    OnFleetConnectionSuccessHandler callback) noexcept;
+
+                /**
+                 * Sets the callback invoked when a client fails to establish an MQTT connection
+                 *
+                 * @param callback
+                 *
+                 * @return this options object
+                 */
+                Mqtt5ClientFleetOptions &WithConnectionFailureCallback(
+                    OnFleetConnectionFailureHandler callback) noexcept;
+
+                /**
+                 * Sets the callback invoked when the MQTT connection of a client is closed
+                 *
+                 * @param callback
+                 *
+                 * @return this options object
+                 */
+                Mqtt5ClientFleetOptions &WithDisconnectionCallback(OnFleetDisconnectionHandler callback) noexcept;
+
+                /**
+                 * Sets the callback invoked when a client reaches the "Stopped" state
+                 *
+                 * @param callback
+                 *
+                 * @return this options object
+                 */
+                Mqtt5ClientFleetOptions &WithStoppedCallback(OnFleetStoppedHandler callback) noexcept;
+
+                /**
+                 * Sets the callback invoked when a client receives a PUBLISH packet
+                 *
+                 * @param callback
+                 *
+                 * @return this options object
+                 */
+                Mqtt5ClientFleetOptions &WithPublishReceivedCallback(OnFleetPublishReceivedHandler callback) noexcept;
+
+              private:
+                size_t m_clientCount;
+                String m_clientIdPrefix;
+                size_t m_memoryBudgetPerClient;
+
+                OnFleetConnectionSuccessHandler m_onConnectionSuccess;
+                OnFleetConnectionFailureHandler m_onConnectionFailure;
+                OnFleetDisconnectionHandler m_onDisconnection;
+                OnFleetStoppedHandler m_onStopped;
+                OnFleetPublishReceivedHandler m_onPublishReceived;
+            };
+
+            /**
+             * A fleet of MQTT5 clients sharing one configuration and one set of callbacks, for processes running
+             * thousands of clients such as device simulators.
+             *
+             * Every Mqtt5Client carries its own copy of the options, callbacks, adapter options and callback gate.
+             * A fleet keeps those once, and per client only the native client, a memory accounting allocator and
+             * its index, which callbacks receive to tell clients apart. Clients are addressed by index, from 0 to
+             * GetClientCount() - 1.
+             *
+             * The callbacks of the Mqtt5ClientOptions given to the fleet are not used: set them on the
+             * Mqtt5ClientFleetOptions instead. Connection setup metrics are not supported.
+             *
+             * Destroying the fleet stops delivering callbacks and releases the clients. Once the destructor returns no
+             * callback is running, except the one the fleet is destroyed from, if any.
+             */
+            class AWS_CRT_CPP_API Mqtt5ClientFleet final
+            {
+              public:
+                /**
+                 * Factory function for mqtt5 client fleets
+                 *
+                 * @param options options shared by all clients of the fleet
+                 * @param fleetOptions number of clients, client ids, memory budget and callbacks of the fleet
+                 * @param allocator allocator to use
+                 * @return a new fleet, or nullptr if a client could not be created
+                 */
+                static std::shared_ptr<Mqtt5ClientFleet> NewMqtt5ClientFleet(
+                    const Mqtt5ClientOptions &options,
+                    const Mqtt5ClientFleetOptions &fleetOptions,
+                    Allocator *allocator = ApiAllocator()) noexcept;
+
+                ~Mqtt5ClientFleet();
+                Mqtt5ClientFleet(const Mqtt5ClientFleet &) = delete;
+                Mqtt5ClientFleet(Mqtt5ClientFleet &&) = delete;
+                Mqtt5ClientFleet &operator=(const Mqtt5ClientFleet &) = delete;
+                Mqtt5ClientFleet &operator=(Mqtt5ClientFleet &&) = delete;
+
+                /**
+                 * @return the value of the last aws error encountered by operations on this instance.
+                 */
+                int LastError() const noexcept;
+
+                /**
+                 * @return the number of clients of the fleet
+                 */
+                size_t GetClientCount() const noexcept { return m_clientCount; }
+
+                /**
+                 * Starts every client of the fleet.
+                 *
+                 * @return true if all clients started, otherwise false
+                 */
+                bool Start() noexcept;
+
+                /**
+                 * Stops every client of the fleet.
+                 *
+                 * @return true if all clients stopped, otherwise false
+                 */
+                bool Stop() noexcept;
+
+                /**
+                 * Notifies a client that you want it to attempt to connect to the configured endpoint.
+                 *
+                 * @param clientIndex index of the client
+                 *
+                 * @return true if operation succeed, otherwise false
+                 */
+                bool Start(size_t clientIndex) noexcept;
+
+                /**
+                 * Notifies a client that you want it to transition to the stopped state.
+                 *
+                 * @param clientIndex index of the client
+                 * @param disconnectPacket (optional) properties of a DISCONNECT packet to send as part of the shutdown
+                 * process
+                 *
+                 * @return true if operation succeed, otherwise false
+                 */
+                bool Stop(size_t clientIndex, std::shared_ptr<DisconnectPacket> disconnectPacket = nullptr) noexcept;
+
+                /**
+                 * Tells a client to attempt to send a PUBLISH packet
+                 *
+                 * @param clientIndex index of the client
+                 * @param publishPacket: packet PUBLISH to send to the server
+                 * @param onPublishCompletionCallback: callback on publish complete, default to NULL
+                 *
+                 * @return true if the publish operation succeed otherwise false
+                 */
+                bool Publish(
+                    size_t clientIndex,
+                    std::shared_ptr<PublishPacket> publishPacket,
+                    OnPublishCompletionHandler onPublishCompletionCallback = NULL) noexcept;
+
+                /**
+                 * Tells a client to attempt to subscribe to one or more topic filters.
+                 *
+                 * @param clientIndex index of the client
+                 * @param subscribePacket: SUBSCRIBE packet to send to the server
+                 * @param onSubscribeCompletionCallback: callback on subscribe complete, default to NULL
+                 *
+                 * @return true if the subscription operation succeed otherwise false
+                 */
+                bool Subscribe(
+                    size_t clientIndex,
+                    std::shared_ptr<SubscribePacket> subscribePacket,
+                    OnSubscribeCompletionHandler onSubscribeCompletionCallback = NULL) noexcept;
+
+                /**
+                 * Tells a client to attempt to unsubscribe to one or more topic filters.
+                 *
+                 * @param clientIndex index of the client
+                 * @param unsubscribePacket: UNSUBSCRIBE packet to send to the server
+                 * @param onUnsubscribeCompletionCallback: callback on unsubscribe complete, default to NULL
+                 *
+                 * @return true if the unsubscription operation succeed otherwise false
+                 */
+                bool Unsubscribe(
+                    size_t clientIndex,
+                    std::shared_ptr<UnsubscribePacket> unsubscribePacket,
+                    OnUnsubscribeCompletionHandler onUnsubscribeCompletionCallback = NULL) noexcept;
+
+                /**
+                 * @param clientIndex index of the client
+                 *
+                 * @return the bytes currently allocated by a client
+                 */
+                size_t GetClientMemoryUsage(size_t clientIndex) const noexcept;
+
+                /**
+                 * @param clientIndex index of the client
+                 *
+                 * @return statistics about the current state of the client's queue of operations
+                 */
+                Mqtt5ClientOperationStatistics GetOperationStatistics(size_t clientIndex) const noexcept;
+
+              private:
+                Mqtt5ClientFleet(
+                    const Mqtt5ClientOptions &options,
+                    const Mqtt5ClientFleetOptions &fleetOptions,
+                    Allocator *allocator) noexcept;
+
+                Mqtt5ClientFleetMember *GetMember(size_t clientIndex) const noexcept;
+
+                Allocator *m_allocator;
+                size_t m_clientCount;
+
+                /* Outlives the fleet until every client has terminated, as late callbacks still reach it */
+                Mqtt5ClientFleetShared *m_shared;
+            };
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
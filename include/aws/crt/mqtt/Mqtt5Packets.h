@@ -39,6 +39,48 @@ namespace Aws
                 Crt::String m_value;
             };
 
+            /**
+             * Immutable list of MQTT5 user properties, encoded once into a single allocation holding both the native
+             * property array and the names and values it points to. A PublishPacket refers to it without copying
+             * or encoding it again, so one list can be shared by every packet carrying the same properties, such as
+             * tracing headers.
+             */
+            class AWS_CRT_CPP_API UserPropertyList final
+            {
+              public:
+                /**
+                 * Encodes userProperties.
+                 *
+                 * @return a new list, or nullptr with the error raised
+                 */
+                static std::shared_ptr<const UserPropertyList> NewUserPropertyList(
+                    const Vector<UserProperty> &userProperties,
+                    Allocator *allocator = ApiAllocator()) noexcept;
+
+                ~UserPropertyList();
+                UserPropertyList(const UserPropertyList &) = delete;
+                UserPropertyList(UserPropertyList &&) = delete;
+                UserPropertyList &operator=(const UserPropertyList &) = delete;
+                UserPropertyList &operator=(UserPropertyList &&) = delete;
+
+                /**
+                 * @return the number of properties
+                 */
+                size_t GetCount() const noexcept { return m_count; }
+
+                /**
+                 * @return the native properties, valid as long as the list
+                 */
+                const aws_mqtt5_user_property *GetNativeProperties() const noexcept { return m_properties; }
+
+              private:
+                UserPropertyList(aws_mqtt5_user_property *properties, size_t count, Allocator *allocator) noexcept;
+
+                aws_mqtt5_user_property *m_properties;
+                size_t m_count;
+                Allocator *m_allocator;
+            };
+
             class AWS_CRT_CPP_API IPacket
             {
               public:
@@ -74,6 +116,33 @@ namespace Aws
                  */
                 PublishPacket &WithPayload(ByteCursor payload) noexcept;
 
+                /**
+                 * Sets the payload for the publish message, taking over the buffer instead of copying it. payload
+                 * is left zeroed; the packet cleans the buffer up with the allocator it was created with.
+                 *
+                 * See [MQTT5 Publish
+                 * Payload](https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901119)
+                 *
+                 * @param payload The buffer holding the payload for the publish message.
+                 * @return The PublishPacket Object after setting the payload.
+                 */
+                PublishPacket &WithPayload(ByteBuf &&payload) noexcept;
+
+                /**
+                 * Sets the payload for the publish message without copying it. The packet holds a reference to
+                 * payloadOwner for as long as it points into payload, which payloadOwner must keep valid: a
+                 * shared_ptr with a custom deleter releases a frame or a pooled buffer once the packet is done
+                 * with it.
+                 *
+                 * See [MQTT5 Publish
+                 * Payload](https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901119)
+                 *
+                 * @param payload The payload for the publish message.
+                 * @param payloadOwner Keeps the memory of payload valid.
+                 * @return The PublishPacket Object after setting the payload.
+                 */
+                PublishPacket &WithPayload(ByteCursor payload, std::shared_ptr<const void> payloadOwner) noexcept;
+
                 /**
                  * Sets the MQTT quality of service level the message should be delivered with.
                  *
@@ -159,6 +228,16 @@ namespace Aws
                  */
                 PublishPacket &WithCorrelationData(ByteCursor correlationData) noexcept;
 
+                /**
+                 * Sets the property specifying the content type of the payload.  Not internally meaningful to MQTT5.
+                 *
+                 * See [MQTT5 Content Type](https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901118)
+                 *
+                 * @param contentType Opaque binary data naming the content type of the payload, e.g. a MIME type
+                 * @return The PublishPacket Object after setting the content type.
+                 */
+                PublishPacket &WithContentType(ByteCursor contentType) noexcept;
+
                 /**
                  * Sets the list of MQTT5 user properties included with the packet.
                  *
@@ -192,6 +271,19 @@ namespace Aws
                  */
                 PublishPacket &WithUserProperty(UserProperty &&property) noexcept;
 
+                /**
+                 * Sets a shared list of MQTT5 user properties included with the packet, ahead of the ones set with
+                 * WithUserProperties() and WithUserProperty(). A packet carrying only a shared list passes it to the
+                 * client as it is, without copying or allocating.
+                 *
+                 * See [MQTT5 User
+                 * Property](https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901116)
+                 *
+                 * @param userPropertyList shared list of MQTT5 user properties, or nullptr to remove it
+                 * @return The PublishPacket Object after setting the user property list
+                 */
+                PublishPacket &WithUserPropertyList(std::shared_ptr<const UserPropertyList> userPropertyList) noexcept;
+
                 bool initializeRawOptions(aws_mqtt5_packet_publish_view &raw_options) noexcept;
 
                 /**
@@ -328,6 +420,14 @@ namespace Aws
                  */
                 const Crt::Vector<UserProperty> &getUserProperties() const noexcept;
 
+                /**
+                 * Shared list of MQTT5 user properties included with the packet, ahead of getUserProperties(). Always
+                 * null for a received packet, whose properties are all in getUserProperties().
+                 *
+                 * @return Shared list of MQTT5 user properties, or nullptr if none was set.
+                 */
+                const std::shared_ptr<const UserPropertyList> &getUserPropertyList() const noexcept;
+
                 virtual ~PublishPacket();
                 PublishPacket(const PublishPacket &) = delete;
                 PublishPacket(PublishPacket &&) noexcept = delete;
@@ -431,6 +531,18 @@ namespace Aws
                  */
                 Crt::Vector<UserProperty> m_userProperties;
 
+                /**
+                 * Shared MQTT5 user properties included with the packet, ahead of m_userProperties.
+                 */
+                std::shared_ptr<const UserPropertyList> m_userPropertyList;
+
+                /**
+                 * Property specifying the content type of the payload.  Not internally meaningful to MQTT5.
+                 *
+                 * See [MQTT5 Content Type](https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901118)
+                 */
+                Crt::Optional<ByteCursor> m_contentType;
+
                 ///////////////////////////////////////////////////////////////////////////
                 // The following parameters are ignored when building publish operations */
                 ///////////////////////////////////////////////////////////////////////////
@@ -445,23 +557,76 @@ namespace Aws
                  */
                 Crt::Vector<uint32_t> m_subscriptionIdentifiers;
 
-                /**
-                 * Property specifying the content type of the payload.  Not internally meaningful to MQTT5.
-                 *
-                 * See [MQTT5 Content Type](https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901118)
-                 */
-                Crt::Optional<ByteCursor> m_contentType;
-
                 ///////////////////////////////////////////////////////////////////////////
                 // Underlying data storage for internal use
                 ///////////////////////////////////////////////////////////////////////////
                 ByteBuf m_payloadStorage;
+                std::shared_ptr<const void> m_payloadOwner;
                 ByteBuf m_contentTypeStorage;
                 ByteBuf m_correlationDataStorage;
                 Crt::String m_responseTopicString;
                 struct aws_mqtt5_user_property *m_userPropertiesStorage;
             };
 
+            /**
+             * Immutable fields of a PUBLISH packet sent repeatedly with different payloads, for
+             * Mqtt5Client::Publish(publishTemplate, payload).
+             *
+             * The topic, QoS, retain flag, payload format indicator, message expiry interval, topic alias, response
+             * topic, correlation data, content type and user properties are copied and encoded once, when the
+             * template is created. Publishing with it then neither copies nor allocates them again. A template can
+             * be shared by any number of clients and threads.
+             */
+            class AWS_CRT_CPP_API PublishTemplate final
+            {
+              public:
+                /**
+                 * Captures the fields of a packet, except for its payload, which is given with each publish.
+                 *
+                 * @return a new template, or nullptr with the error raised
+                 */
+                static std::shared_ptr<const PublishTemplate> NewPublishTemplate(
+                    const PublishPacket &fields,
+                    Allocator *allocator = ApiAllocator()) noexcept;
+
+                ~PublishTemplate();
+                PublishTemplate(const PublishTemplate &) = delete;
+                PublishTemplate(PublishTemplate &&) = delete;
+                PublishTemplate &operator=(const PublishTemplate &) = delete;
+                PublishTemplate &operator=(PublishTemplate &&) = delete;
+
+                const Crt::String &getTopic() const noexcept { return m_topic; }
+                Mqtt5::QOS getQOS() const noexcept { return m_view.qos; }
+
+                /**
+                 * Fills raw_options with the fields of the template and payload. raw_options points into both: it
+                 * is valid as long as the template and the memory of payload are.
+                 */
+                void initializeRawOptions(aws_mqtt5_packet_publish_view &raw_options, ByteCursor payload)
+                    const noexcept;
+
+              private:
+                PublishTemplate(
+                    const PublishPacket &fields,
+                    std::shared_ptr<const UserPropertyList> &&userProperties,
+                    Allocator *allocator) noexcept;
+
+                Crt::String m_topic;
+                Crt::Optional<PayloadFormatIndicator> m_payloadFormatIndicator;
+                Crt::Optional<uint32_t> m_messageExpiryIntervalSec;
+                Crt::Optional<uint16_t> m_topicAlias;
+                ByteBuf m_responseTopic;
+                ByteBuf m_correlationData;
+                ByteBuf m_contentType;
+                ByteCursor m_responseTopicCursor;
+                ByteCursor m_correlationDataCursor;
+                ByteCursor m_contentTypeCursor;
+                std::shared_ptr<const UserPropertyList> m_userProperties;
+
+                /* Points into the members above; only the payload changes from one publish to the next */
+                aws_mqtt5_packet_publish_view m_view;
+            };
+
             /**
              * Mqtt behavior settings that are dynamically negotiated as part of the CONNECT/CONNACK exchange.
              *
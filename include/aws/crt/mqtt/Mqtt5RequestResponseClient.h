@@ -0,0 +1,226 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/io/EventLoopGroup.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+
+#include <mutex>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            /**
+             * Invoked once per request: with the response, or with an error and a null response if the request
+             * could not be published (the error of its publish), timed out (AWS_ERROR_MQTT_TIMEOUT) or was still
+             * outstanding when the client was closed (AWS_ERROR_INVALID_STATE).
+             */
+            using OnResponseHandler = std::function<void(int errorCode, std::shared_ptr<PublishPacket> response)>;
+
+            /**
+             * Counters of a RequestResponseClient
+             */
+            struct AWS_CRT_CPP_API RequestResponseClientMetrics
+            {
+                RequestResponseClientMetrics() noexcept;
+
+                /* Requests submitted for publishing */
+                uint64_t requestsSent;
+
+                /* Requests refused because the maximum number of them were outstanding already */
+                uint64_t requestsRejected;
+
+                /* Responses matched with an outstanding request */
+                uint64_t responsesMatched;
+
+                /* Publishes on the response topic matching no outstanding request, such as late responses */
+                uint64_t responsesUnmatched;
+
+                /* Requests which got no response in time */
+                uint64_t requestsTimedOut;
+            };
+
+            /**
+             * Configuration of a RequestResponseClient
+             */
+            class AWS_CRT_CPP_API RequestResponseClientOptions final
+            {
+                friend class RequestResponseClient;
+
+              public:
+                RequestResponseClientOptions(Allocator *allocator = ApiAllocator()) noexcept;
+
+                /**
+                 * Sets the topic responses are expected on, set as the response topic of every request. Required.
+                 *
+                 * @return this options object
+                 */
+                RequestResponseClientOptions &WithResponseTopic(const String &responseTopic) noexcept;
+
+                /**
+                 * Sets how long a request waits for its response. Defaults to 10 seconds.
+                 *
+                 * @return this options object
+                 */
+                RequestResponseClientOptions &WithRequestTimeoutMs(uint32_t timeoutMs) noexcept;
+
+                /**
+                 * Sets the granularity of request timeouts: a request times out within this long after its
+                 * timeout. Defaults to 100 milliseconds.
+                 *
+                 * @return this options object
+                 */
+                RequestResponseClientOptions &WithTimeoutResolutionMs(uint32_t resolutionMs) noexcept;
+
+                /**
+                 * Sets how many requests can be outstanding at once. Request() fails with AWS_ERROR_MQTT_QUEUE_FULL
+                 * beyond that. Defaults to 1024.
+                 *
+                 * @return this options object
+                 */
+                RequestResponseClientOptions &WithMaxInFlightRequests(size_t maxInFlightRequests) noexcept;
+
+                /**
+                 * Sets the event loop group running the timeout timer. Defaults to the static default event loop
+                 * group.
+                 *
+                 * @return this options object
+                 */
+                RequestResponseClientOptions &WithEventLoopGroup(Io::EventLoopGroup *eventLoopGroup) noexcept;
+
+              private:
+                String m_responseTopic;
+                uint32_t m_requestTimeoutMs;
+                uint32_t m_timeoutResolutionMs;
+                size_t m_maxInFlightRequests;
+                Io::EventLoopGroup *m_eventLoopGroup;
+            };
+
+            /**
+             * Correlates MQTT5 requests with their responses over a Mqtt5Client.
+             *
+             * Every request gets the response topic of the client and an 8 byte correlation data, a request id
+             * starting from a random value, so that clients sharing a response topic do not take each other's
+             * responses. The outstanding requests are indexed by that id in a hash table sized for the maximum
+             * number of them, so that matching a response copies nothing.
+             *
+             * Timeouts are tracked by a timer wheel ticking at the timeout resolution while requests are
+             * outstanding: a request goes into the slot of the tick it expires at, and completing it leaves the
+             * slot alone, to be skipped when the wheel gets there. Requests and responses cost O(1) whatever the
+             * number outstanding.
+             *
+             * The client does not receive publishes by itself: call Subscribe() once to subscribe to the response
+             * topic, and forward the publishes the Mqtt5Client receives to OnPublishReceived(), which tells whether
+             * they were responses.
+             */
+            class AWS_CRT_CPP_API RequestResponseClient final
+                : public std::enable_shared_from_this<RequestResponseClient>
+            {
+              public:
+                /**
+                 * Factory function for request/response clients
+                 *
+                 * @param client the client to publish requests and subscribe with
+                 * @param options response topic, timeouts and in-flight limit
+                 * @param allocator allocator to use
+                 * @return a new request/response client, or nullptr with the error raised
+                 */
+                static std::shared_ptr<RequestResponseClient> NewRequestResponseClient(
+                    std::shared_ptr<Mqtt5Client> client,
+                    const RequestResponseClientOptions &options,
+                    Allocator *allocator = ApiAllocator()) noexcept;
+
+                ~RequestResponseClient();
+                RequestResponseClient(const RequestResponseClient &) = delete;
+                RequestResponseClient(RequestResponseClient &&) = delete;
+                RequestResponseClient &operator=(const RequestResponseClient &) = delete;
+                RequestResponseClient &operator=(RequestResponseClient &&) = delete;
+
+                /**
+                 * Subscribes to the response topic.
+                 *
+                 * @return true if the subscribe operation was submitted, otherwise false
+                 */
+                bool Subscribe(OnSubscribeCompletionHandler onSubscribeCompletion = nullptr) noexcept;
+
+                /**
+                 * Publishes request with the response topic and a correlation data of its own, overwriting those
+                 * of the packet, and invokes onResponse once it completes.
+                 *
+                 * @return true if the request was submitted, otherwise false and onResponse is not invoked
+                 */
+                bool Request(std::shared_ptr<PublishPacket> request, OnResponseHandler onResponse) noexcept;
+
+                /**
+                 * Completes the request a publish received by the Mqtt5Client responds to, if it was received on
+                 * the response topic.
+                 *
+                 * @return true if the publish was received on the response topic, otherwise false
+                 */
+                bool OnPublishReceived(const PublishReceivedEventData &eventData) noexcept;
+
+                /**
+                 * @return the number of outstanding requests
+                 */
+                size_t GetInFlightRequestCount() const noexcept;
+
+                RequestResponseClientMetrics GetMetrics() const noexcept;
+
+                /**
+                 * Completes the outstanding requests with AWS_ERROR_INVALID_STATE and refuses further ones. Requests
+                 * still outstanding when the client is destroyed are dropped without completing them.
+                 */
+                void Close() noexcept;
+
+              private:
+                struct PendingRequest
+                {
+                    OnResponseHandler onResponse;
+                    uint64_t deadlineTick;
+                };
+
+                RequestResponseClient(
+                    std::shared_ptr<Mqtt5Client> &&client,
+                    const RequestResponseClientOptions &options,
+                    Allocator *allocator) noexcept;
+
+                /* Ticks of the timer wheel elapsed since the client was created */
+                uint64_t GetTick(uint64_t nowNs) const noexcept;
+
+                /* Removes a request from the index, with m_lock held. Returns false if it was not outstanding. */
+                bool TakeRequest(uint64_t requestId, OnResponseHandler &onResponse) noexcept;
+
+                bool ScheduleTick() noexcept;
+                void OnTick() noexcept;
+
+                Allocator *m_allocator;
+                std::shared_ptr<Mqtt5Client> m_client;
+                String m_responseTopic;
+                size_t m_maxInFlightRequests;
+                Io::EventLoopGroup *m_eventLoopGroup;
+
+                uint64_t m_startNs;
+                uint64_t m_tickNs;
+                uint64_t m_timeoutTicks;
+
+                mutable std::mutex m_lock;
+                UnorderedMap<uint64_t, PendingRequest> m_requests;
+
+                /* Ids of the requests expiring at each tick modulo the number of slots */
+                Vector<Vector<uint64_t>> m_wheel;
+
+                /* The last tick whose slot was visited */
+                uint64_t m_processedTick;
+                bool m_tickScheduled;
+                uint64_t m_nextRequestId;
+                bool m_closed;
+                RequestResponseClientMetrics m_metrics;
+            };
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
@@ -8,6 +8,7 @@
 #include <aws/crt/StlAllocator.h>
 #include <aws/crt/Types.h>
 #include <aws/crt/http/HttpConnection.h>
+#include <aws/crt/io/ConnectionSetupMetrics.h>
 #include <aws/crt/io/SocketOptions.h>
 #include <aws/crt/io/TlsOptions.h>
 #include <aws/crt/mqtt/MqttTypes.h>
@@ -123,6 +124,13 @@ namespace Aws
              */
             using OnDisconnectHandler = std::function<void(MqttConnection &connection)>;
 
+            /**
+             * Invoked when the TLS handshake of a connection attempt (initial connect or reconnect) completes or
+             * fails. attemptStartNs is only known for attempts started by Connect().
+             */
+            using OnConnectionSetupMetricsHandler =
+                std::function<void(MqttConnection &connection, const Io::ConnectionSetupMetrics &metrics)>;
+
             /**
              * @deprecated Use OnMessageReceivedHandler
              */
@@ -292,6 +300,23 @@ namespace Aws
                     OnPublishReceivedHandler &&onPublish,
                     OnSubAckHandler &&onSubAck) noexcept;
 
+                /**
+                 * Subscribes to topicFilter like Subscribe(), handing messages to onMessage without copying their
+                 * topic. The fastest way to receive, especially over an Mqtt5Client.
+                 *
+                 * @param topicFilter topic filter to subscribe to
+                 * @param qos maximum qos client is willing to receive matching messages on
+                 * @param onMessage callback to invoke when a message is received based on matching this filter
+                 * @param onSubAck callback to invoke with the server's response to the subscribe request
+                 *
+                 * @return packet id of the subscribe request, or 0 if the attempt failed synchronously
+                 */
+                uint16_t SubscribeWithCursorHandler(
+                    const char *topicFilter,
+                    QOS qos,
+                    OnMessageReceivedCursorHandler &&onMessage,
+                    OnSubAckHandler &&onSubAck) noexcept;
+
                 /**
                  * Subscribes to multiple topicFilters. OnMessageReceivedHandler will be invoked from an event-loop
                  * thread upon an incoming Publish message. OnMultiSubAckHandler will be invoked
@@ -317,6 +342,25 @@ namespace Aws
                     QOS qos,
                     OnMultiSubAckHandler &&onOpComplete) noexcept;
 
+                /**
+                 * Subscribes to multiple topicFilters that share a single onMessage handler, which learns the
+                 * matching filter from its index in topicFilters rather than from a handler of its own. Meant for
+                 * subscriptions to thousands of filters, such as per-device shadow topics: the filters take one
+                 * allocation between them, a pointer each, rather than a handler each.
+                 *
+                 * @param topicFilters topic filters to subscribe to
+                 * @param qos maximum qos client is willing to receive matching messages on
+                 * @param onMessage callback to invoke when a message is received based on matching any of the filters
+                 * @param onOpComplete callback to invoke with the server's response to the subscribe request
+                 *
+                 * @return packet id of the subscribe request, or 0 if the attempt failed synchronously
+                 */
+                uint16_t SubscribeWithSharedHandler(
+                    const Vector<const char *> &topicFilters,
+                    QOS qos,
+                    OnSharedMessageReceivedHandler &&onMessage,
+                    OnMultiSubAckHandler &&onOpComplete) noexcept;
+
                 /**
                  * Installs a handler for all incoming publish messages, regardless of if Subscribe has been
                  * called on the topic.
@@ -331,6 +375,15 @@ namespace Aws
                  */
                 bool SetOnMessageHandler(OnPublishReceivedHandler &&onPublish) noexcept;
 
+                /**
+                 * Installs a handler for all incoming publish messages like SetOnMessageHandler(), handing them to
+                 * onMessage without copying their topic.
+                 *
+                 * @param onMessage callback to invoke for all received messages
+                 * @return success/failure
+                 */
+                bool SetOnMessageCursorHandler(OnMessageReceivedCursorHandler &&onMessage) noexcept;
+
                 /**
                  * Unsubscribes from topicFilter. OnOperationCompleteHandler will be invoked upon receipt of
                  * an unsuback message.
@@ -362,6 +415,25 @@ namespace Aws
                     const ByteBuf &payload,
                     OnOperationCompleteHandler &&onOpComplete) noexcept;
 
+                /**
+                 * Publishes to a topic given as a cursor, which saves measuring it. Without onOpComplete, the
+                 * publish takes no allocation beyond the ones of the native client.
+                 *
+                 * @param topic topic to publish to
+                 * @param qos QOS to publish the message with
+                 * @param retain should this message replace the current retained message of the topic?
+                 * @param payload payload of the message
+                 * @param onOpComplete completion callback to invoke when the operation is complete, or nullptr
+                 *
+                 * @return packet id of the publish request, or 0 if the attempt failed synchronously
+                 */
+                uint16_t Publish(
+                    ByteCursor topic,
+                    QOS qos,
+                    bool retain,
+                    ByteCursor payload,
+                    OnOperationCompleteHandler &&onOpComplete = nullptr) noexcept;
+
                 /**
                  * Get the statistics about the current state of the connection's queue of operations
                  *
@@ -420,6 +492,13 @@ namespace Aws
                  */
                 OnConnectionFailureHandler OnConnectionFailure;
 
+                /**
+                 * Invoked whenever the TLS handshake of a connection attempt completes or fails, with the time
+                 * spent resolving, connecting and in the handshake. Must be set before Connect(). Not invoked for
+                 * connections without TLS or made through an MQTT5 client.
+                 */
+                OnConnectionSetupMetricsHandler OnConnectionSetupMetrics;
+
               private:
                 /**
                  * Constructor.
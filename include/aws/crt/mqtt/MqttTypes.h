@@ -55,6 +55,49 @@ namespace Aws
                 QOS qos,
                 bool retain)>;
 
+            /**
+             * Invoked upon receipt of a Publish message on a subscribed topic, with the topic and payload as the
+             * client received them rather than copied into a String. Both cursors are only valid during the call.
+             *
+             * @param connection The connection object.
+             * @param topic The information channel to which the payload data was published.
+             * @param payload The payload data.
+             * @param dup DUP flag. If true, this might be re-delivery of an earlier attempt to send the message.
+             * @param qos Quality of Service used to deliver the message.
+             * @param retain Retain flag. If true, the message was sent as a result of a new subscription being made by
+             * the client.
+             */
+            using OnMessageReceivedCursorHandler = std::function<void(
+                MqttConnection &connection,
+                ByteCursor topic,
+                ByteCursor payload,
+                bool dup,
+                QOS qos,
+                bool retain)>;
+
+            /**
+             * Invoked upon receipt of a Publish message on one of the topic filters of a
+             * MqttConnection::SubscribeWithSharedHandler() call. Like OnMessageReceivedCursorHandler, the topic and
+             * payload are only valid during the call.
+             *
+             * @param connection The connection object.
+             * @param filterId Index of the matching topic filter in the list passed to SubscribeWithSharedHandler().
+             * @param topic The information channel to which the payload data was published.
+             * @param payload The payload data.
+             * @param dup DUP flag. If true, this might be re-delivery of an earlier attempt to send the message.
+             * @param qos Quality of Service used to deliver the message.
+             * @param retain Retain flag. If true, the message was sent as a result of a new subscription being made by
+             * the client.
+             */
+            using OnSharedMessageReceivedHandler = std::function<void(
+                MqttConnection &connection,
+                uint32_t filterId,
+                ByteCursor topic,
+                ByteCursor payload,
+                bool dup,
+                QOS qos,
+                bool retain)>;
+
             /**
              * Invoked when a suback message is received.
              *
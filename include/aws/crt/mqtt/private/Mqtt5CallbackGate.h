@@ -0,0 +1,73 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Exports.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            /**
+             * Admits the callbacks of a Mqtt5ClientCore until it closes, without a lock on the way of every event.
+             *
+             * A callback counts itself in before checking whether the gate is closed, and out when it returns.
+             * Close() stops admitting callbacks, then waits for the ones admitted before, so that none runs once
+             * it returns. Scopes of the closing thread itself are not waited for, which lets a callback close
+             * the gate, as it could with the recursive lock this replaces. Only the scopes returning once the gate
+             * is closed take the lock, to wake Close() up.
+             */
+            class AWS_CRT_CPP_API Mqtt5CallbackGate final
+            {
+              public:
+                /**
+                 * Admits a callback for its lifetime: evaluates to false once the gate is closed.
+                 */
+                class AWS_CRT_CPP_API Scope final
+                {
+                  public:
+                    explicit Scope(Mqtt5CallbackGate &gate) noexcept;
+                    ~Scope();
+                    Scope(const Scope &) = delete;
+                    Scope &operator=(const Scope &) = delete;
+
+                    explicit operator bool() const noexcept { return m_admitted; }
+
+                  private:
+                    friend class Mqtt5CallbackGate;
+
+                    Mqtt5CallbackGate &m_gate;
+
+                    /* The scope this one is nested in on the same thread, of any gate */
+                    const Scope *m_outer;
+                    bool m_admitted;
+                };
+
+                Mqtt5CallbackGate() noexcept;
+                Mqtt5CallbackGate(const Mqtt5CallbackGate &) = delete;
+                Mqtt5CallbackGate &operator=(const Mqtt5CallbackGate &) = delete;
+
+                /**
+                 * Stops admitting callbacks and waits for the admitted ones of other threads to return.
+                 */
+                void Close() noexcept;
+
+              private:
+                /* The scopes in flight, with s_closedFlag set once closed, so both change together */
+                std::atomic<size_t> m_state;
+
+                /* Close() waits on m_scopeReturned for the scopes of other threads to return */
+                std::mutex m_closeLock;
+                std::condition_variable m_scopeReturned;
+            };
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
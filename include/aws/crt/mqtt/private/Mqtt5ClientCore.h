@@ -10,7 +10,12 @@
 #include <aws/crt/http/HttpConnection.h>
 #include <aws/crt/mqtt/Mqtt5Client.h>
 #include <aws/crt/mqtt/Mqtt5Types.h>
+#include <aws/crt/mqtt/private/Mqtt5CallbackGate.h>
+#include <aws/crt/mqtt/private/Mqtt5DurableOfflineQueue.h>
+#include <aws/crt/mqtt/private/Mqtt5PayloadCompression.h>
+#include <aws/crt/mqtt/private/Mqtt5PublishRateLimiter.h>
 
+#include <atomic>
 #include <mutex>
 
 namespace Aws
@@ -19,6 +24,61 @@ namespace Aws
     {
         namespace Mqtt5
         {
+            /**
+             * Accumulates the Mqtt5ClientMetrics of a client. Counters are lock-free; the flow control state is
+             * guarded by a lock as it changes with every QoS 1 publish and connection event.
+             */
+            class AWS_CRT_CPP_API Mqtt5ClientMetricsRecorder final
+            {
+              public:
+                Mqtt5ClientMetricsRecorder() noexcept;
+                Mqtt5ClientMetricsRecorder(const Mqtt5ClientMetricsRecorder &) = delete;
+                Mqtt5ClientMetricsRecorder &operator=(const Mqtt5ClientMetricsRecorder &) = delete;
+
+                /**
+                 * Records an operation accepted by the native client. qos1Publish tells whether it counts against
+                 * the receive maximum of the server.
+                 */
+                void OnOperationSubmitted(bool qos1Publish) noexcept;
+                void OnOperationCompleted(bool qos1Publish) noexcept;
+
+                /**
+                 * Records a successful publish. submittedNs is when it was submitted, used for QoS 1 publishes.
+                 */
+                void OnPublishSent(aws_mqtt5_qos qos, size_t bytes, uint64_t submittedNs) noexcept;
+                void OnPublishReceived(aws_mqtt5_qos qos, size_t bytes) noexcept;
+
+                void OnConnectionSuccess(uint16_t receiveMaximum) noexcept;
+                void OnDisconnection() noexcept;
+
+                /**
+                 * @return the metrics, and starts a new interval for incompleteOperationPeak
+                 */
+                Mqtt5ClientMetrics GetMetrics() noexcept;
+
+              private:
+                /* Starts or ends a flow control blocked interval, with m_flowControlLock held */
+                void UpdateFlowControl(uint64_t now) noexcept;
+
+                std::atomic<uint64_t> m_publishesSentQos0;
+                std::atomic<uint64_t> m_publishesSentQos1;
+                std::atomic<uint64_t> m_publishesReceivedQos0;
+                std::atomic<uint64_t> m_publishesReceivedQos1;
+                std::atomic<uint64_t> m_publishBytesSent;
+                std::atomic<uint64_t> m_publishBytesReceived;
+                std::atomic<uint64_t> m_connectionSuccesses;
+                std::atomic<uint64_t> m_incompleteOperations;
+                std::atomic<uint64_t> m_incompleteOperationPeak;
+                LatencyHistogram m_pubAckLatency;
+
+                std::mutex m_flowControlLock;
+                bool m_connected;
+                uint16_t m_receiveMaximum;
+                uint64_t m_incompleteQos1Publishes;
+                uint64_t m_blockedSinceNs;
+                uint64_t m_blockedNanos;
+            };
+
             /**
              * The Mqtt5ClientCore is an internal class for Mqtt5Client. The class is used to handle communication
              * between Mqtt5Client and underlying c mqtt5 client. This class should only be used internally by
@@ -72,6 +132,20 @@ namespace Aws
                     std::shared_ptr<PublishPacket> publishOptions,
                     OnPublishCompletionHandler onPublishCompletionCallback = NULL) noexcept;
 
+                /**
+                 * Tells the client to attempt to send a PUBLISH packet built from a template and a payload
+                 *
+                 * @param publishTemplate: fields of the PUBLISH packet to send to the server
+                 * @param payload: payload of the PUBLISH packet, only read during the call
+                 * @param onPublishCompletionCallback: callback on publish complete, default to NULL
+                 *
+                 * @return true if the publish operation succeed otherwise false
+                 */
+                bool Publish(
+                    const std::shared_ptr<const PublishTemplate> &publishTemplate,
+                    ByteCursor payload,
+                    OnPublishCompletionHandler onPublishCompletionCallback = NULL) noexcept;
+
                 /**
                  * Tells the client to attempt to subscribe to one or more topic filters.
                  *
@@ -123,6 +197,44 @@ namespace Aws
                 std::shared_ptr<Crt::Mqtt::MqttConnection> NewConnection(
                     const Mqtt5::Mqtt5to3AdapterOptions *options) noexcept;
 
+                /**
+                 * Hands a publish to the durable offline queue, if any, then to PacePublish(). packet holds the
+                 * memory publish points into, if any.
+                 */
+                bool OfferPublish(
+                    const aws_mqtt5_packet_publish_view &publish,
+                    const std::shared_ptr<PublishPacket> &packet,
+                    OnPublishCompletionHandler &&onPublishCompletionCallback) noexcept;
+
+                /**
+                 * Submits a publish to the native client.
+                 *
+                 * @param offlineQueueEndOffset identifies the record of a publish replayed by the durable offline
+                 * queue, 0 otherwise
+                 */
+                bool SubmitPublish(
+                    const aws_mqtt5_packet_publish_view &publish,
+                    OnPublishCompletionHandler &&onPublishCompletionCallback,
+                    uint64_t offlineQueueEndOffset) noexcept;
+
+                /**
+                 * Submits a publish to the native client, or hands it to the publish rate limiter if the limits
+                 * hold it back. packet holds the memory publish points into, if any.
+                 */
+                bool PacePublish(
+                    const aws_mqtt5_packet_publish_view &publish,
+                    const std::shared_ptr<PublishPacket> &packet,
+                    OnPublishCompletionHandler &&onPublishCompletionCallback,
+                    uint64_t offlineQueueEndOffset) noexcept;
+
+                /**
+                 * Submits a publish the rate limiter held back, reporting a failure to its completion callback
+                 */
+                void SubmitRateLimitedPublish(
+                    const aws_mqtt5_packet_publish_view &publish,
+                    OnPublishCompletionHandler &&onPublishCompletionCallback,
+                    uint64_t offlineQueueEndOffset) noexcept;
+
                 /* Static Callbacks */
                 static void s_publishCompletionCallback(
                     enum aws_mqtt5_packet_type packet_type,
@@ -179,6 +291,16 @@ namespace Aws
                  */
                 OnAttemptingConnectHandler onAttemptingConnect;
 
+                /**
+                 * Callback handler trigged when the TLS handshake of a connection attempt completes or fails.
+                 */
+                OnConnectionSetupMetricsHandler onConnectionSetupMetrics;
+
+                /**
+                 * Hooks the TLS options given to the client when onConnectionSetupMetrics is set.
+                 */
+                Io::ConnectionSetupObserver m_setupObserver;
+
                 /**
                  * Callback handler trigged when an MQTT PUBLISH packet is received by the client
                  */
@@ -196,18 +318,31 @@ namespace Aws
                 ScopedResource<Mqtt5to3AdapterOptions> m_mqtt5to3AdapterOptions;
 
                 /*
-                 * The callback flag used to indicate if it is safe to invoke the callbacks
+                 * Admits the callbacks, and the publishes the components submit, until Close()
+                 */
+                Mqtt5CallbackGate m_callbackGate;
+
+                /*
+                 * Backs Mqtt5Client::GetMetrics
+                 */
+                Mqtt5ClientMetricsRecorder m_metrics;
+
+                /*
+                 * Routes every publish when the options set a durable offline queue, null otherwise
+                 */
+                ScopedResource<Mqtt5DurableOfflineQueue> m_durableOfflineQueue;
+
+                /*
+                 * Compresses publishes on their way to the native client and decompresses received ones when the
+                 * options set payload compression, null otherwise
                  */
-                enum CallbackFlag
-                {
-                    INVOKE,
-                    IGNORE
-                } m_callbackFlag;
+                ScopedResource<Mqtt5PayloadCompression> m_payloadCompression;
 
                 /*
-                 * Lock for the callbacks. This is used to protect the callback flag and callbacks.
+                 * Paces publishes, after the durable offline queue, when the options set a publish rate limit, null
+                 * otherwise
                  */
-                std::recursive_mutex m_callback_lock;
+                ScopedResource<Mqtt5PublishRateLimiter> m_publishRateLimiter;
 
                 aws_mqtt5_client *m_client;
                 Allocator *m_allocator;
@@ -0,0 +1,198 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Types.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+
+#include <stdio.h>
+
+#include <mutex>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            /**
+             * Disk-backed queue of publishes for a Mqtt5ClientCore configured with a DurableOfflineQueueOptions.
+             *
+             * Publishes go straight to the native client while it is connected, nothing is spilled and the publishes
+             * it holds stay under the memory watermark. Otherwise they are appended to the segment file, and replayed
+             * from it in order once connected, as completions bring the client back under the watermark. A publish
+             * spilled before a restart is replayed by the next client opening the same file.
+             *
+             * Segment file layout, in host byte order:
+             *   header:  magic (4) | version (4) | committed offset (8)
+             *   records: body length (4) | CRC32 of the body (4) | body
+             *   body:    qos (1) | retain (1) | topic length (2) | topic | payload
+             *
+             * Records before the committed offset have completed. A torn record at the end of the file, left by a
+             * crash during an append, fails its CRC and is overwritten by the next append. Once every record has
+             * completed the file is truncated back to its header.
+             *
+             * The committed offset is written every 32 completed records rather than on each of them, and when the
+             * queue is closed, so a crash replays at most that many completed publishes again, which QoS 1 allows for.
+             * File I/O happens under m_fileLock, never under m_lock, so completions on the event loop only wait on the
+             * disk when they have a batch to commit or a record to replay.
+             */
+            class Mqtt5DurableOfflineQueue final
+            {
+              public:
+                /**
+                 * Submits a replayed publish to the native client. endOffset identifies the record when it
+                 * completes. Returns false if the publish was not submitted, leaving onPublishCompletion untouched:
+                 * the record then stays in the file, to be replayed on the next connection.
+                 */
+                using SubmitHandler = std::function<bool(
+                    const aws_mqtt5_packet_publish_view &publish,
+                    OnPublishCompletionHandler &&onPublishCompletion,
+                    uint64_t endOffset)>;
+
+                /**
+                 * How Offer() handled a publish
+                 */
+                enum class OfferResult
+                {
+                    /* Submit the publish to the native client directly, then call OnPublishCompleted(bytes, 0) */
+                    Submit,
+                    /* The publish was appended to the segment file */
+                    Spilled,
+                    /* The publish could not be appended, aws_last_error() tells why */
+                    Failed,
+                };
+
+                /**
+                 * Opens or creates the segment file and recovers the records it holds.
+                 *
+                 * @return a new queue, or nullptr with the error raised
+                 */
+                static ScopedResource<Mqtt5DurableOfflineQueue> NewDurableOfflineQueue(
+                    const DurableOfflineQueueOptions &options,
+                    SubmitHandler &&submit,
+                    Allocator *allocator) noexcept;
+
+                ~Mqtt5DurableOfflineQueue();
+                Mqtt5DurableOfflineQueue(const Mqtt5DurableOfflineQueue &) = delete;
+                Mqtt5DurableOfflineQueue &operator=(const Mqtt5DurableOfflineQueue &) = delete;
+
+                /**
+                 * Decides whether a publish goes to the native client or to the segment file, and appends it in the
+                 * latter case. The completion callback of a spilled publish is kept in memory until it is replayed.
+                 */
+                OfferResult Offer(
+                    const aws_mqtt5_packet_publish_view &publish,
+                    OnPublishCompletionHandler &onPublishCompletion) noexcept;
+
+                /**
+                 * Accounts for the completion of a publish that went through Offer(). endOffset is the one given to
+                 * the SubmitHandler, or 0 for a publish submitted directly.
+                 */
+                void OnPublishCompleted(size_t bytes, uint64_t endOffset) noexcept;
+
+                /**
+                 * Accounts for a replayed publish that the SubmitHandler accepted, but that failed to reach the
+                 * native client later on. Its record stays uncommitted, holding back the committed offset, so the
+                 * next client opening the file replays it. Replaying pauses until the next connection.
+                 */
+                void OnReplayFailed(size_t bytes) noexcept;
+
+                void OnConnectionSuccess() noexcept;
+                void OnDisconnection() noexcept;
+
+                /**
+                 * Stops replaying and committing, and writes the committed offset. Records not completed yet stay in
+                 * the file for the next client.
+                 */
+                void Close() noexcept;
+
+              private:
+                Mqtt5DurableOfflineQueue(
+                    const DurableOfflineQueueOptions &options,
+                    SubmitHandler &&submit,
+                    Allocator *allocator) noexcept;
+
+                bool Open() noexcept;
+
+                /* File I/O, with m_fileLock held unless opening */
+
+                /* Truncates the file to a header committing nothing */
+                bool Truncate() noexcept;
+                bool WriteCommittedOffset(uint64_t committedOffset) noexcept;
+
+                /* Appends a record at offset and returns its total size, 0 on failure */
+                size_t Append(const aws_mqtt5_packet_publish_view &publish, uint64_t offset) noexcept;
+
+                /* Reads the record at offset into m_readBuffer and returns its total size, 0 if it is missing or
+                 * torn. */
+                size_t ReadRecord(uint64_t offset, uint64_t fileLength) noexcept;
+
+                /* Submits spilled records while connected and under the watermark, in order, one caller at a time */
+                void Drain() noexcept;
+
+                /* Truncates the file if every record completed, otherwise writes the committed offset if it moved */
+                void Sync() noexcept;
+
+                /* With m_lock held */
+                bool HasRoom() const noexcept;
+                bool IsDrained() const noexcept;
+                void CompletePublish(size_t bytes, uint64_t endOffset) noexcept;
+
+                struct PendingCallback
+                {
+                    uint64_t offset;
+                    OnPublishCompletionHandler onPublishCompletion;
+                };
+
+                struct InFlightRecord
+                {
+                    uint64_t endOffset;
+                    bool completed;
+                };
+
+                Allocator *m_allocator;
+                String m_path;
+                SubmitHandler m_submit;
+                uint64_t m_memoryWatermarkBytes;
+
+                /* Serializes file I/O and m_file. Taken before m_lock when both are held. */
+                std::mutex m_fileLock;
+                FILE *m_file;
+
+                std::mutex m_lock;
+                bool m_connected;
+                bool m_closed;
+                bool m_draining;
+
+                /* Set when a replayed publish failed to be submitted, replaying resumes on the next connection */
+                bool m_submitFailed;
+
+                /* Publishes being appended, which later publishes may not overtake */
+                uint64_t m_appendingCount;
+
+                /* Bytes of publishes held by the native client that went through the queue */
+                uint64_t m_inMemoryBytes;
+
+                uint64_t m_committedOffset;
+
+                /* The committed offset last written to the file, and the records committed since */
+                uint64_t m_persistedOffset;
+                uint64_t m_unpersistedCount;
+
+                uint64_t m_readOffset;
+                uint64_t m_writeOffset;
+                uint64_t m_pendingCount;
+
+                /* Callbacks of the publishes spilled by this process, in file order */
+                List<PendingCallback> m_pendingCallbacks;
+
+                /* Replayed records not completed yet, in file order */
+                List<InFlightRecord> m_inFlight;
+
+                ByteBuf m_readBuffer;
+            };
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
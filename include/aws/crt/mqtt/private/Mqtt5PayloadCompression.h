@@ -0,0 +1,92 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Compression.h>
+#include <aws/crt/Types.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+
+#include <mutex>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            /**
+             * Payload and user properties of a publish view rewritten by Mqtt5PayloadCompression. The view points
+             * into it, so it must outlive the use of the view.
+             */
+            struct Mqtt5PayloadTransformStorage
+            {
+                Mqtt5PayloadTransformStorage(Allocator *allocator) noexcept;
+                ~Mqtt5PayloadTransformStorage();
+                Mqtt5PayloadTransformStorage(const Mqtt5PayloadTransformStorage &) = delete;
+                Mqtt5PayloadTransformStorage &operator=(const Mqtt5PayloadTransformStorage &) = delete;
+
+                ByteBuf payload;
+                Vector<aws_mqtt5_user_property> userProperties;
+            };
+
+            /**
+             * Compresses outgoing publish payloads and decompresses incoming ones for a Mqtt5ClientCore configured with
+             * a PayloadCompressionOptions.
+             *
+             * A compressed publish carries a "content-encoding" user property naming the algorithm, as HTTP does, so
+             * its content type stays the one the application set. Codecs are pooled across publishes: a StreamCodec
+             * is ready for a new stream after Finish(), which saves setting up zlib or zstd contexts per message.
+             */
+            class Mqtt5PayloadCompression final
+            {
+              public:
+                /**
+                 * @param maxDecompressedBytes largest payload a received publish may decompress to, resolved from
+                 * PayloadCompressionOptions::m_maxDecompressedBytes
+                 */
+                Mqtt5PayloadCompression(
+                    const PayloadCompressionOptions &options,
+                    size_t maxDecompressedBytes,
+                    Allocator *allocator) noexcept;
+                Mqtt5PayloadCompression(const Mqtt5PayloadCompression &) = delete;
+                Mqtt5PayloadCompression &operator=(const Mqtt5PayloadCompression &) = delete;
+
+                /**
+                 * Compresses the payload of publish into storage if it is at least the threshold and compressing
+                 * makes it smaller, and points publish at the result.
+                 *
+                 * @return true unless compression failed, with the error raised
+                 */
+                bool Compress(aws_mqtt5_packet_publish_view &publish, Mqtt5PayloadTransformStorage &storage) noexcept;
+
+                /**
+                 * Decompresses the payload of publish into storage if it carries a content-encoding this build
+                 * supports, and points publish at the result, without the content-encoding user property.
+                 *
+                 * Fails with AWS_ERROR_SHORT_BUFFER once the payload decompresses to more than the maximum, without
+                 * decompressing the rest of it.
+                 *
+                 * @return true unless decompression failed, with the error raised; publish is then left untouched
+                 */
+                bool Decompress(aws_mqtt5_packet_publish_view &publish, Mqtt5PayloadTransformStorage &storage) noexcept;
+
+              private:
+                StreamCodec AcquireCodec(Vector<StreamCodec> &pool, bool compressor, CompressionAlgorithm algorithm);
+                void ReleaseCodec(Vector<StreamCodec> &pool, StreamCodec &&codec) noexcept;
+
+                Allocator *m_allocator;
+                CompressionAlgorithm m_algorithm;
+                size_t m_thresholdBytes;
+                int m_level;
+                size_t m_maxDecompressedBytes;
+
+                /* Idle codecs, at most one per thread that used them at once */
+                std::mutex m_poolLock;
+                Vector<StreamCodec> m_compressors;
+                Vector<StreamCodec> m_deflateDecompressors;
+                Vector<StreamCodec> m_zstdDecompressors;
+            };
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
@@ -0,0 +1,165 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Types.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+
+#include <mutex>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            /**
+             * Token bucket refilled at a fixed rate, holding up to one second worth of tokens. A request larger
+             * than that is let through once the bucket is full, leaving it in debt, so that it cannot block forever.
+             */
+            class Mqtt5TokenBucket final
+            {
+              public:
+                Mqtt5TokenBucket(uint64_t tokensPerSecond, uint64_t nowNs) noexcept;
+
+                /**
+                 * @return nanoseconds until tokens can be taken, 0 if they can be taken now
+                 */
+                uint64_t GetDelayNanos(uint64_t tokens, uint64_t nowNs) noexcept;
+
+                void Take(uint64_t tokens) noexcept;
+
+              private:
+                void Refill(uint64_t nowNs) noexcept;
+
+                uint64_t m_tokensPerSecond;
+                double m_tokens;
+                uint64_t m_refilledAtNs;
+            };
+
+            /**
+             * Paces the publishes of a Mqtt5ClientCore configured with a PublishRateLimitOptions.
+             *
+             * Each QoS has a message and a byte bucket, and a queue of the publishes waiting for them. A publish
+             * goes straight to the native client when its queue is empty and the buckets allow it; otherwise a copy
+             * waits in the queue, and a timer on the event loop submits it once the buckets refill.
+             */
+            class Mqtt5PublishRateLimiter final
+            {
+              public:
+                /**
+                 * Submits a publish the limiter held back to the native client, reporting a failure to its
+                 * completion callback.
+                 */
+                using SubmitHandler = std::function<void(
+                    const aws_mqtt5_packet_publish_view &publish,
+                    OnPublishCompletionHandler &&onPublishCompletion,
+                    uint64_t offlineQueueEndOffset)>;
+
+                /**
+                 * Calls OnTimer() after delayNs. Returns false if the timer could not be scheduled.
+                 */
+                using ScheduleHandler = std::function<bool(uint64_t delayNs)>;
+
+                /**
+                 * How Offer() handled a publish
+                 */
+                enum class OfferResult
+                {
+                    /* Submit the publish to the native client directly */
+                    Submit,
+                    /* The publish waits for the limits, the SubmitHandler gets it */
+                    Queued,
+                    /* The publish could not be queued, aws_last_error() tells why */
+                    Failed,
+                };
+
+                Mqtt5PublishRateLimiter(
+                    const PublishRateLimitOptions &options,
+                    SubmitHandler &&submit,
+                    ScheduleHandler &&schedule,
+                    Allocator *allocator) noexcept;
+                Mqtt5PublishRateLimiter(const Mqtt5PublishRateLimiter &) = delete;
+                Mqtt5PublishRateLimiter &operator=(const Mqtt5PublishRateLimiter &) = delete;
+
+                /**
+                 * Takes the tokens of a publish, or queues it. packet holds the memory publish points into, if any;
+                 * otherwise the publish is copied when queued. onPublishCompletion is moved from when queued.
+                 */
+                OfferResult Offer(
+                    const aws_mqtt5_packet_publish_view &publish,
+                    const std::shared_ptr<PublishPacket> &packet,
+                    OnPublishCompletionHandler &onPublishCompletion,
+                    uint64_t offlineQueueEndOffset) noexcept;
+
+                /**
+                 * Submits the queued publishes the limits allow, in order, and schedules the next timer.
+                 */
+                void OnTimer() noexcept;
+
+                /**
+                 * Drops the queued publishes without calling their completion callbacks, and stops submitting.
+                 * Called once the callback gate of the client is closed. Offer() fails with AWS_ERROR_INVALID_STATE
+                 * from then on.
+                 */
+                void Close() noexcept;
+
+                /**
+                 * Publishes queued so far, and the total time they waited
+                 */
+                uint64_t GetPublishesRateLimited() noexcept;
+                uint64_t GetDelayNanos() noexcept;
+
+              private:
+                struct QueuedPublish
+                {
+                    std::shared_ptr<PublishPacket> packet;
+                    OnPublishCompletionHandler onPublishCompletion;
+                    uint64_t offlineQueueEndOffset;
+                    uint64_t bytes;
+                    uint64_t queuedAtNs;
+                };
+
+                struct Lane
+                {
+                    Lane(const PublishRateLimit &limit, uint64_t nowNs, Allocator *allocator) noexcept;
+
+                    /* Nanoseconds until a publish of bytes fits in the buckets, 0 if it does now */
+                    uint64_t GetDelayNanos(uint64_t bytes, uint64_t nowNs) noexcept;
+                    void Take(uint64_t bytes) noexcept;
+
+                    bool m_limitsMessages;
+                    bool m_limitsBytes;
+                    Mqtt5TokenBucket m_messages;
+                    Mqtt5TokenBucket m_bytes;
+                    List<QueuedPublish> m_queue;
+                };
+
+                Lane &LaneOf(aws_mqtt5_qos qos) noexcept { return qos == AWS_MQTT5_QOS_AT_MOST_ONCE ? m_qos0 : m_qos1; }
+
+                /* Schedules a timer for the earliest queued publish unless one is due before it, with m_lock held */
+                void ScheduleTimer(uint64_t nowNs) noexcept;
+
+                Allocator *m_allocator;
+                SubmitHandler m_submit;
+                ScheduleHandler m_schedule;
+
+                std::mutex m_lock;
+                Lane m_qos0;
+                Lane m_qos1;
+                bool m_closed;
+
+                /* Set while OnTimer() submits, during which new publishes queue up behind the ones it took */
+                bool m_draining;
+
+                /* When the earliest scheduled timer is due, 0 if none is */
+                uint64_t m_timerDueNs;
+
+                uint64_t m_publishesRateLimited;
+                uint64_t m_delayNanos;
+            };
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
@@ -12,6 +12,7 @@
 #include <aws/crt/StlAllocator.h>
 #include <aws/crt/Types.h>
 #include <aws/crt/http/HttpConnection.h>
+#include <aws/crt/io/ConnectionSetupMetrics.h>
 #include <aws/crt/io/SocketOptions.h>
 #include <aws/crt/io/TlsOptions.h>
 #include <aws/crt/mqtt/MqttTypes.h>
@@ -29,6 +30,7 @@ namespace Aws
         namespace Mqtt
         {
             class MqttConnection;
+            struct PubCallbackData;
 
             /**
              * @internal
@@ -172,6 +174,18 @@ namespace Aws
                     OnMessageReceivedHandler &&onMessage,
                     OnSubAckHandler &&onSubAck) noexcept;
 
+                /**
+                 * @internal
+                 * Subscribes to topicFilter, handing messages to onMessage without copying their topic.
+                 *
+                 * @return packet id of the subscribe request, or 0 if the attempt failed synchronously
+                 */
+                uint16_t SubscribeWithCursorHandler(
+                    const char *topicFilter,
+                    QOS qos,
+                    OnMessageReceivedCursorHandler &&onMessage,
+                    OnSubAckHandler &&onSubAck) noexcept;
+
                 /**
                  * @internal
                  * Subscribes to multiple topicFilters. OnMessageReceivedHandler will be invoked from an event-loop
@@ -190,6 +204,18 @@ namespace Aws
                     QOS qos,
                     OnMultiSubAckHandler &&onOpComplete) noexcept;
 
+                /**
+                 * @internal
+                 * Subscribes to multiple topicFilters sharing onMessage, which gets the index of the matching filter.
+                 *
+                 * @return packet id of the subscribe request, or 0 if the attempt failed synchronously
+                 */
+                uint16_t SubscribeWithSharedHandler(
+                    const Vector<const char *> &topicFilters,
+                    QOS qos,
+                    OnSharedMessageReceivedHandler &&onMessage,
+                    OnMultiSubAckHandler &&onOpComplete) noexcept;
+
                 /**
                  * @internal
                  * Installs a handler for all incoming publish messages, regardless of if Subscribe has been
@@ -200,6 +226,15 @@ namespace Aws
                  */
                 bool SetOnMessageHandler(OnMessageReceivedHandler &&onMessage) noexcept;
 
+                /**
+                 * @internal
+                 * Installs a handler for all incoming publish messages, handing them to onMessage without copying
+                 * their topic.
+                 *
+                 * @return success/failure
+                 */
+                bool SetOnMessageCursorHandler(OnMessageReceivedCursorHandler &&onMessage) noexcept;
+
                 /**
                  * @internal
                  * Unsubscribes from topicFilter. OnOperationCompleteHandler will be invoked upon receipt of
@@ -233,6 +268,19 @@ namespace Aws
                     const ByteBuf &payload,
                     OnOperationCompleteHandler &&onOpComplete) noexcept;
 
+                /**
+                 * @internal
+                 * Publishes to a topic given as a cursor. Allocates no callback data without onOpComplete.
+                 *
+                 * @return packet id of the publish request, or 0 if the attempt failed synchronously
+                 */
+                uint16_t Publish(
+                    ByteCursor topic,
+                    QOS qos,
+                    bool retain,
+                    ByteCursor payload,
+                    OnOperationCompleteHandler &&onOpComplete) noexcept;
+
                 /**
                  * @internal
                  * Get the statistics about the current state of the connection's queue of operations
@@ -242,6 +290,22 @@ namespace Aws
                 const MqttConnectionOperationStatistics &GetOperationStatistics() noexcept;
 
               private:
+                /**
+                 * @internal
+                 * Subscribes to topicFilter with pubCallbackData, which it takes over.
+                 */
+                uint16_t SubscribeWithCallbackData(
+                    const char *topicFilter,
+                    QOS qos,
+                    PubCallbackData *pubCallbackData,
+                    OnSubAckHandler &&onSubAck) noexcept;
+
+                /**
+                 * @internal
+                 * Installs pubCallbackData as the handler of all incoming publish messages, taking it over.
+                 */
+                bool SetOnMessageCallbackData(PubCallbackData *pubCallbackData) noexcept;
+
                 /**
                  * @internal
                  * Factory method for instantiation of MqttConnectCore.
@@ -304,6 +368,14 @@ namespace Aws
                     enum aws_mqtt_qos qos,
                     bool retain,
                     void *userData);
+                static void s_onSharedPublish(
+                    aws_mqtt_client_connection *connection,
+                    const aws_byte_cursor *topic,
+                    const aws_byte_cursor *payload,
+                    bool dup,
+                    enum aws_mqtt_qos qos,
+                    bool retain,
+                    void *userData);
 
                 static void s_onSubAck(
                     aws_mqtt_client_connection *connection,
@@ -372,6 +444,7 @@ namespace Aws
                 bool m_useTls;
                 bool m_useWebsocket;
                 MqttConnectionOperationStatistics m_operationStatistics;
+                Io::ConnectionSetupObserver m_setupObserver;
                 Allocator *m_allocator;
 
                 /**
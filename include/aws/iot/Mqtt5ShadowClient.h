@@ -0,0 +1,300 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Exports.h>
+#include <aws/crt/JsonObject.h>
+#include <aws/crt/io/EventLoopGroup.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+
+#include <mutex>
+
+namespace Aws
+{
+    namespace Iot
+    {
+        /**
+         * The shadow operations the service can reject
+         */
+        enum class ShadowOperation
+        {
+            Get,
+            Update,
+        };
+
+        /**
+         * Invoked with the "state" of a get/accepted response, holding the "desired", "reported" and "delta"
+         * documents of the shadow. The view is only valid during the call.
+         */
+        using OnShadowDocumentHandler = std::function<void(const Crt::JsonView &state, int64_t version)>;
+
+        /**
+         * Invoked with the "state" of an update/delta message once it has been applied to the local desired
+         * document. The view is only valid during the call.
+         */
+        using OnShadowDeltaHandler = std::function<void(const Crt::JsonView &delta, int64_t version)>;
+
+        /**
+         * Invoked when the service rejects a get or update request
+         */
+        using OnShadowRejectedHandler =
+            std::function<void(ShadowOperation operation, int code, const Crt::String &message)>;
+
+        /**
+         * Invoked when an update request carrying reported state completes. On success its state is merged into the
+         * local reported document, otherwise it is pending again and goes out with the next flush.
+         */
+        using OnShadowReportedPublishedHandler = std::function<void(int errorCode)>;
+
+        /**
+         * Counters of a Mqtt5ShadowClient
+         */
+        struct AWS_CRT_CPP_API Mqtt5ShadowClientMetrics
+        {
+            Mqtt5ShadowClientMetrics() noexcept;
+
+            /* Deltas merged into the local desired document */
+            uint64_t deltasApplied;
+
+            /* Deltas dropped because their version was not newer than the local document */
+            uint64_t staleDeltasDropped;
+
+            /* Calls to UpdateReported() */
+            uint64_t reportedUpdates;
+
+            /* Update requests published, each carrying one or more coalesced reported updates */
+            uint64_t reportedPublishes;
+
+            /* Update requests which failed to publish, their reported state was queued again */
+            uint64_t reportedPublishFailures;
+        };
+
+        /**
+         * Configuration of a Mqtt5ShadowClient
+         */
+        class AWS_CRT_CPP_API Mqtt5ShadowClientOptions final
+        {
+            friend class Mqtt5ShadowClient;
+
+          public:
+            Mqtt5ShadowClientOptions(Crt::Allocator *allocator = Crt::ApiAllocator()) noexcept;
+
+            /**
+             * Sets the name of the thing whose shadow to track. Required.
+             *
+             * @return this options object
+             */
+            Mqtt5ShadowClientOptions &WithThingName(const Crt::String &thingName) noexcept;
+
+            /**
+             * Sets the name of the named shadow to track. The classic shadow of the thing is tracked if unset.
+             *
+             * @return this options object
+             */
+            Mqtt5ShadowClientOptions &WithShadowName(const Crt::String &shadowName) noexcept;
+
+            /**
+             * Sets how long UpdateReported() waits for further updates to publish them all in one update request.
+             *
+             * @param delayMs delay in milliseconds, 0 to publish every update right away. Defaults to 0.
+             *
+             * @return this options object
+             */
+            Mqtt5ShadowClientOptions &WithReportedCoalescingDelayMs(uint32_t delayMs) noexcept;
+
+            /**
+             * Sets the event loop group running the coalescing timer. Defaults to the static default event loop
+             * group.
+             *
+             * @return this options object
+             */
+            Mqtt5ShadowClientOptions &WithEventLoopGroup(Crt::Io::EventLoopGroup *eventLoopGroup) noexcept;
+
+            /**
+             * Sets the callback invoked with the shadow document returned by RequestDocument()
+             *
+             * @return this options object
+             */
+            Mqtt5ShadowClientOptions &WithDocumentCallback(OnShadowDocumentHandler callback) noexcept;
+
+            /**
+             * Sets the callback invoked with each delta applied to the local desired document
+             *
+             * @return this options object
+             */
+            Mqtt5ShadowClientOptions &WithDeltaCallback(OnShadowDeltaHandler callback) noexcept;
+
+            /**
+             * Sets the callback invoked when the service rejects a request
+             *
+             * @return this options object
+             */
+            Mqtt5ShadowClientOptions &WithRejectedCallback(OnShadowRejectedHandler callback) noexcept;
+
+            /**
+             * Sets the callback invoked when an update request carrying reported state completes
+             *
+             * @return this options object
+             */
+            Mqtt5ShadowClientOptions &WithReportedPublishedCallback(OnShadowReportedPublishedHandler callback) noexcept;
+
+          private:
+            Crt::Allocator *m_allocator;
+            Crt::String m_thingName;
+            Crt::Optional<Crt::String> m_shadowName;
+            uint32_t m_reportedCoalescingDelayMs;
+            Crt::Io::EventLoopGroup *m_eventLoopGroup;
+
+            OnShadowDocumentHandler m_onDocument;
+            OnShadowDeltaHandler m_onDelta;
+            OnShadowRejectedHandler m_onRejected;
+            OnShadowReportedPublishedHandler m_onReportedPublished;
+        };
+
+        /**
+         * Keeps a local copy of an AWS IoT device shadow in sync over a Mqtt5Client, and reports state changes to
+         * it.
+         *
+         * Deltas are parsed straight from the received payload and merged into the local desired document as JSON
+         * merge patches, so that each message costs in proportion to its own size rather than to the size of the
+         * document. Reported state changes are merged the same way into a pending update, which is published as one
+         * update request once the coalescing delay elapses: a burst of changes to the same keys costs one message.
+         * One update request is in flight at a time, so that the service applies them in order, and its state only
+         * reaches the local reported document once it has been published.
+         *
+         * The topics of the shadow are built once, and its requests are published from templates.
+         *
+         * The client does not receive publishes by itself: forward those the Mqtt5Client receives to
+         * OnPublishReceived(), which tells whether they were for the shadow.
+         */
+        class AWS_CRT_CPP_API Mqtt5ShadowClient final : public std::enable_shared_from_this<Mqtt5ShadowClient>
+        {
+          public:
+            /**
+             * Factory function for shadow clients
+             *
+             * @param client the client to send requests and subscribe with
+             * @param options thing and shadow names, coalescing delay and callbacks
+             * @param allocator allocator to use
+             * @return a new shadow client, or nullptr with the error raised
+             */
+            static std::shared_ptr<Mqtt5ShadowClient> NewMqtt5ShadowClient(
+                std::shared_ptr<Crt::Mqtt5::Mqtt5Client> client,
+                const Mqtt5ShadowClientOptions &options,
+                Crt::Allocator *allocator = Crt::ApiAllocator()) noexcept;
+
+            ~Mqtt5ShadowClient();
+            Mqtt5ShadowClient(const Mqtt5ShadowClient &) = delete;
+            Mqtt5ShadowClient(Mqtt5ShadowClient &&) = delete;
+            Mqtt5ShadowClient &operator=(const Mqtt5ShadowClient &) = delete;
+            Mqtt5ShadowClient &operator=(Mqtt5ShadowClient &&) = delete;
+
+            /**
+             * Subscribes to the delta, get and update response topics of the shadow, in one SUBSCRIBE.
+             *
+             * @return true if the subscribe operation was submitted, otherwise false
+             */
+            bool Subscribe(Crt::Mqtt5::OnSubscribeCompletionHandler onSubscribeCompletion = nullptr) noexcept;
+
+            /**
+             * Requests the shadow document, which replaces the local one and is handed to the document callback.
+             *
+             * @return true if the publish operation was submitted, otherwise false
+             */
+            bool RequestDocument(Crt::Mqtt5::OnPublishCompletionHandler onPublishCompletion = nullptr) noexcept;
+
+            /**
+             * Handles a publish received by the Mqtt5Client if it is addressed to this shadow.
+             *
+             * @return true if the publish was for this shadow, otherwise false
+             */
+            bool OnPublishReceived(const Crt::Mqtt5::PublishReceivedEventData &eventData) noexcept;
+
+            /**
+             * Merges reported into the pending reported state, published after the coalescing delay. A null
+             * member removes its key from the reported document of the shadow.
+             *
+             * @return true if the update was accepted, false if the client is closed or publishing failed, in which
+             * case the update stays pending
+             */
+            bool UpdateReported(const Crt::JsonView &reported) noexcept;
+
+            /**
+             * Publishes the pending reported state now, if any, or once the update request in flight completes.
+             *
+             * @return true if there was nothing to publish or the publish operation was submitted or deferred,
+             * otherwise false with the state still pending
+             */
+            bool FlushReported() noexcept;
+
+            /**
+             * @return a copy of the local desired document
+             */
+            Crt::JsonObject GetDesired() const;
+
+            /**
+             * @return a copy of the local reported document, including the updates published successfully so far
+             */
+            Crt::JsonObject GetReported() const;
+
+            /**
+             * @return the version of the local document, 0 until a document or a delta has been received
+             */
+            int64_t GetVersion() const noexcept;
+
+            Mqtt5ShadowClientMetrics GetMetrics() const noexcept;
+
+            /**
+             * Drops the pending reported state and rejects further updates. Call FlushReported() first to publish
+             * it.
+             */
+            void Close() noexcept;
+
+          private:
+            Mqtt5ShadowClient(
+                std::shared_ptr<Crt::Mqtt5::Mqtt5Client> &&client,
+                const Mqtt5ShadowClientOptions &options,
+                Crt::Allocator *allocator) noexcept;
+
+            bool ScheduleFlush() noexcept;
+            void OnDelta(const Crt::JsonView &message) noexcept;
+            void OnDocument(const Crt::JsonView &message) noexcept;
+            void OnRejected(ShadowOperation operation, const Crt::JsonView &message) noexcept;
+
+            /* Settles the update request in flight, returns true if pending state is waiting for it to complete */
+            bool CompleteReportedPublish(int errorCode) noexcept;
+            void OnReportedPublished(int errorCode) noexcept;
+
+            Crt::Allocator *m_allocator;
+            std::shared_ptr<Crt::Mqtt5::Mqtt5Client> m_client;
+            uint32_t m_reportedCoalescingDelayMs;
+            Crt::Io::EventLoopGroup *m_eventLoopGroup;
+            OnShadowDocumentHandler m_onDocument;
+            OnShadowDeltaHandler m_onDelta;
+            OnShadowRejectedHandler m_onRejected;
+            OnShadowReportedPublishedHandler m_onReportedPublished;
+
+            /* "$aws/things/<thing>/shadow/" or "$aws/things/<thing>/shadow/name/<shadow>/" */
+            Crt::String m_topicPrefix;
+            std::shared_ptr<const Crt::Mqtt5::PublishTemplate> m_getTemplate;
+            std::shared_ptr<const Crt::Mqtt5::PublishTemplate> m_updateTemplate;
+
+            mutable std::mutex m_lock;
+            Crt::JsonObject m_desired;
+            Crt::JsonObject m_reported;
+            int64_t m_version;
+            Crt::JsonObject m_pendingReported;
+            bool m_hasPendingReported;
+
+            /* The reported state of the update request in flight */
+            Crt::JsonObject m_inFlightReported;
+            bool m_hasInFlightReported;
+
+            bool m_flushScheduled;
+            bool m_closed;
+            Mqtt5ShadowClientMetrics m_metrics;
+        };
+    } // namespace Iot
+} // namespace Aws
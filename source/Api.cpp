@@ -37,6 +37,8 @@ namespace Aws
         std::mutex ApiHandle::s_lock_client_bootstrap;
         std::mutex ApiHandle::s_lock_event_loop_group;
         std::mutex ApiHandle::s_lock_default_host_resolver;
+        Io::TlsContextCache *ApiHandle::s_static_tls_context_cache = nullptr;
+        std::mutex ApiHandle::s_lock_tls_context_cache;
 
         ApiHandle::ApiHandle(Allocator *allocator) noexcept
             : m_logger(), m_shutdownBehavior(ApiHandleShutdownBehavior::Blocking),
@@ -59,6 +61,7 @@ namespace Aws
             ReleaseStaticDefaultClientBootstrap();
             ReleaseStaticDefaultEventLoopGroup();
             ReleaseStaticDefaultHostResolver();
+            ReleaseStaticDefaultTlsContextCache();
 
             if (m_shutdownBehavior == ApiHandleShutdownBehavior::Blocking)
             {
@@ -394,6 +397,26 @@ namespace Aws
             }
         }
 
+        Io::TlsContextCache *ApiHandle::GetOrCreateStaticDefaultTlsContextCache()
+        {
+            std::lock_guard<std::mutex> lock(s_lock_tls_context_cache);
+            if (s_static_tls_context_cache == nullptr)
+            {
+                s_static_tls_context_cache = Aws::Crt::New<Io::TlsContextCache>(ApiAllocator(), ApiAllocator());
+            }
+            return s_static_tls_context_cache;
+        }
+
+        void ApiHandle::ReleaseStaticDefaultTlsContextCache()
+        {
+            std::lock_guard<std::mutex> lock(s_lock_tls_context_cache);
+            if (s_static_tls_context_cache != nullptr)
+            {
+                Aws::Crt::Delete(s_static_tls_context_cache, ApiAllocator());
+                s_static_tls_context_cache = nullptr;
+            }
+        }
+
         const Io::NewTlsContextImplCallback &ApiHandle::GetBYOCryptoNewTlsContextImplCallback()
         {
             return s_BYOCryptoNewTlsContextImplCallback;
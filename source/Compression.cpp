@@ -0,0 +1,593 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Compression.h>
+
+#include <algorithm>
+
+#if defined(AWS_CRT_CPP_HAS_ZLIB)
+#    include <zlib.h>
+#endif
+
+#if defined(AWS_CRT_CPP_HAS_ZSTD)
+#    include <zstd.h>
+#endif
+
+namespace Aws
+{
+    namespace Crt
+    {
+        /*
+         * Backend interface. Implementations append to output and advance input; they raise an aws error and return
+         * false on failure. Update() stops with AWS_ERROR_SHORT_BUFFER once output grows past outputLimit.
+         */
+        class StreamCodecImpl
+        {
+          public:
+            virtual ~StreamCodecImpl() = default;
+
+            virtual bool Update(ByteCursor &input, ByteBuf &output, size_t outputLimit) = 0;
+            virtual bool Flush(ByteBuf &output) = 0;
+            virtual bool Finish(ByteBuf &output) = 0;
+        };
+
+#if defined(AWS_CRT_CPP_HAS_ZLIB) || defined(AWS_CRT_CPP_HAS_ZSTD)
+        /* Output is produced in chunks of at least this size, growing the caller's buffer as needed. */
+        static const size_t s_outputChunkSize = 16 * 1024;
+
+        /*
+         * Makes room for the next output chunk and sets available to its size. The chunk never reaches more than one
+         * byte past outputLimit, so a codec producing more than allowed fills it and fails on the next call before
+         * it can produce any further.
+         */
+        static bool s_ReserveOutputChunk(ByteBuf &output, size_t outputLimit, size_t &available)
+        {
+            if (output.len > outputLimit)
+            {
+                aws_raise_error(AWS_ERROR_SHORT_BUFFER);
+                return false;
+            }
+
+            size_t allowed = outputLimit - output.len;
+            if (allowed < SIZE_MAX)
+            {
+                ++allowed;
+            }
+
+            if (output.capacity - output.len < std::min(allowed, s_outputChunkSize / 4) &&
+                aws_byte_buf_reserve_relative(&output, std::min(allowed, s_outputChunkSize)) != AWS_OP_SUCCESS)
+            {
+                return false;
+            }
+
+            available = std::min(output.capacity - output.len, allowed);
+            return true;
+        }
+#endif
+
+#if defined(AWS_CRT_CPP_HAS_ZLIB)
+        static voidpf s_ZlibAlloc(voidpf opaque, uInt items, uInt size)
+        {
+            return aws_mem_calloc(static_cast<Allocator *>(opaque), items, size);
+        }
+
+        static void s_ZlibFree(voidpf opaque, voidpf address)
+        {
+            aws_mem_release(static_cast<Allocator *>(opaque), address);
+        }
+
+        class ZlibCodec final : public StreamCodecImpl
+        {
+          public:
+            ZlibCodec(Allocator *allocator, bool compress)
+                : m_compress(compress), m_initialized(false), m_streamEnded(false)
+            {
+                AWS_ZERO_STRUCT(m_stream);
+                m_stream.zalloc = s_ZlibAlloc;
+                m_stream.zfree = s_ZlibFree;
+                m_stream.opaque = allocator;
+            }
+
+            ~ZlibCodec() override
+            {
+                if (m_initialized)
+                {
+                    m_compress ? deflateEnd(&m_stream) : inflateEnd(&m_stream);
+                }
+            }
+
+            bool Init(int level)
+            {
+                int result = m_compress ? deflateInit(&m_stream, level < 0 ? Z_DEFAULT_COMPRESSION : level)
+                                        : inflateInit(&m_stream);
+                m_initialized = result == Z_OK;
+                if (!m_initialized)
+                {
+                    aws_raise_error(result == Z_MEM_ERROR ? AWS_ERROR_OOM : AWS_ERROR_INVALID_ARGUMENT);
+                }
+                return m_initialized;
+            }
+
+            bool Update(ByteCursor &input, ByteBuf &output, size_t outputLimit) override
+            {
+                return Run(input, output, Z_NO_FLUSH, outputLimit);
+            }
+
+            bool Flush(ByteBuf &output) override
+            {
+                if (!m_compress)
+                {
+                    return true;
+                }
+
+                ByteCursor empty;
+                AWS_ZERO_STRUCT(empty);
+                return Run(empty, output, Z_SYNC_FLUSH, SIZE_MAX);
+            }
+
+            bool Finish(ByteBuf &output) override
+            {
+                bool complete = true;
+                if (m_compress)
+                {
+                    ByteCursor empty;
+                    AWS_ZERO_STRUCT(empty);
+                    complete = Run(empty, output, Z_FINISH, SIZE_MAX);
+                    deflateReset(&m_stream);
+                }
+                else
+                {
+                    if (!m_streamEnded)
+                    {
+                        aws_raise_error(AWS_ERROR_INVALID_STATE);
+                        complete = false;
+                    }
+                    inflateReset(&m_stream);
+                }
+
+                m_streamEnded = false;
+                return complete;
+            }
+
+          private:
+            /* zlib counts bytes in uInt: larger inputs and output chunks are handed over in slices of this size */
+            static const uInt s_sliceSize = 1u << 30;
+
+            bool Run(ByteCursor &input, ByteBuf &output, int flush, size_t outputLimit)
+            {
+                ByteCursor remaining = input;
+                m_stream.avail_in = 0;
+
+                for (;;)
+                {
+                    if (m_stream.avail_in == 0 && remaining.len > 0)
+                    {
+                        size_t slice = std::min(remaining.len, static_cast<size_t>(s_sliceSize));
+                        m_stream.next_in = remaining.ptr;
+                        m_stream.avail_in = static_cast<uInt>(slice);
+                        aws_byte_cursor_advance(&remaining, slice);
+                    }
+
+                    size_t available = 0;
+                    if (!s_ReserveOutputChunk(output, outputLimit, available))
+                    {
+                        return false;
+                    }
+
+                    available = std::min(available, static_cast<size_t>(s_sliceSize));
+                    m_stream.next_out = output.buffer + output.len;
+                    m_stream.avail_out = static_cast<uInt>(available);
+
+                    /* Flushing or finishing only applies once the last slice of input is handed over */
+                    int sliceFlush = remaining.len > 0 ? Z_NO_FLUSH : flush;
+                    int result = m_compress ? deflate(&m_stream, sliceFlush) : inflate(&m_stream, Z_NO_FLUSH);
+                    output.len += available - m_stream.avail_out;
+                    bool inputConsumed = m_stream.avail_in == 0 && remaining.len == 0;
+
+                    if (result == Z_STREAM_END)
+                    {
+                        if (m_compress)
+                        {
+                            break;
+                        }
+
+                        if (inputConsumed)
+                        {
+                            m_streamEnded = true;
+                            break;
+                        }
+
+                        /* Data following the end of a stream starts a new one. */
+                        inflateReset(&m_stream);
+                        m_streamEnded = false;
+                        continue;
+                    }
+
+                    if (result != Z_OK && result != Z_BUF_ERROR)
+                    {
+                        aws_raise_error(result == Z_MEM_ERROR ? AWS_ERROR_OOM : AWS_ERROR_INVALID_ARGUMENT);
+                        return false;
+                    }
+
+                    /* Done once all input is consumed and zlib had room to spare for pending output. */
+                    if (inputConsumed && m_stream.avail_out != 0)
+                    {
+                        break;
+                    }
+                }
+
+                aws_byte_cursor_advance(&input, input.len);
+                return true;
+            }
+
+            z_stream m_stream;
+            bool m_compress;
+            bool m_initialized;
+            bool m_streamEnded;
+        };
+#endif /* AWS_CRT_CPP_HAS_ZLIB */
+
+#if defined(AWS_CRT_CPP_HAS_ZSTD)
+        class ZstdCompressor final : public StreamCodecImpl
+        {
+          public:
+            ZstdCompressor() : m_context(ZSTD_createCCtx()) {}
+            ~ZstdCompressor() override { ZSTD_freeCCtx(m_context); }
+
+            bool Init(int level)
+            {
+                if (m_context == nullptr)
+                {
+                    aws_raise_error(AWS_ERROR_OOM);
+                    return false;
+                }
+
+                if (level >= 0 && ZSTD_isError(ZSTD_CCtx_setParameter(m_context, ZSTD_c_compressionLevel, level)))
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return false;
+                }
+
+                return true;
+            }
+
+            bool Update(ByteCursor &input, ByteBuf &output, size_t outputLimit) override
+            {
+                return Run(input, output, ZSTD_e_continue, outputLimit);
+            }
+
+            bool Flush(ByteBuf &output) override
+            {
+                ByteCursor empty;
+                AWS_ZERO_STRUCT(empty);
+                return Run(empty, output, ZSTD_e_flush, SIZE_MAX);
+            }
+
+            bool Finish(ByteBuf &output) override
+            {
+                ByteCursor empty;
+                AWS_ZERO_STRUCT(empty);
+                bool complete = Run(empty, output, ZSTD_e_end, SIZE_MAX);
+                ZSTD_CCtx_reset(m_context, ZSTD_reset_session_only);
+                return complete;
+            }
+
+          private:
+            bool Run(ByteCursor &input, ByteBuf &output, ZSTD_EndDirective directive, size_t outputLimit)
+            {
+                ZSTD_inBuffer in = {input.ptr, input.len, 0};
+                for (;;)
+                {
+                    size_t available = 0;
+                    if (!s_ReserveOutputChunk(output, outputLimit, available))
+                    {
+                        return false;
+                    }
+
+                    ZSTD_outBuffer out = {output.buffer + output.len, available, 0};
+                    size_t remaining = ZSTD_compressStream2(m_context, &out, &in, directive);
+                    output.len += out.pos;
+
+                    if (ZSTD_isError(remaining))
+                    {
+                        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                        return false;
+                    }
+
+                    bool consumed = in.pos == in.size;
+                    bool flushed = directive == ZSTD_e_continue || remaining == 0;
+                    if (consumed && flushed)
+                    {
+                        break;
+                    }
+                }
+
+                aws_byte_cursor_advance(&input, input.len);
+                return true;
+            }
+
+            ZSTD_CCtx *m_context;
+        };
+
+        class ZstdDecompressor final : public StreamCodecImpl
+        {
+          public:
+            ZstdDecompressor() : m_context(ZSTD_createDCtx()), m_frameComplete(false) {}
+            ~ZstdDecompressor() override { ZSTD_freeDCtx(m_context); }
+
+            bool Init()
+            {
+                if (m_context == nullptr)
+                {
+                    aws_raise_error(AWS_ERROR_OOM);
+                    return false;
+                }
+                return true;
+            }
+
+            bool Update(ByteCursor &input, ByteBuf &output, size_t outputLimit) override
+            {
+                ZSTD_inBuffer in = {input.ptr, input.len, 0};
+                for (;;)
+                {
+                    size_t available = 0;
+                    if (!s_ReserveOutputChunk(output, outputLimit, available))
+                    {
+                        return false;
+                    }
+
+                    ZSTD_outBuffer out = {output.buffer + output.len, available, 0};
+                    size_t result = ZSTD_decompressStream(m_context, &out, &in);
+                    output.len += out.pos;
+
+                    if (ZSTD_isError(result))
+                    {
+                        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                        return false;
+                    }
+
+                    m_frameComplete = result == 0;
+
+                    /* Done once all input is consumed and the decoder had room to spare for pending output. */
+                    if (in.pos == in.size && out.pos < out.size)
+                    {
+                        break;
+                    }
+                }
+
+                aws_byte_cursor_advance(&input, input.len);
+                return true;
+            }
+
+            bool Flush(ByteBuf &) override { return true; }
+
+            bool Finish(ByteBuf &) override
+            {
+                bool complete = m_frameComplete;
+                ZSTD_DCtx_reset(m_context, ZSTD_reset_session_only);
+                m_frameComplete = false;
+                if (!complete)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_STATE);
+                }
+                return complete;
+            }
+
+          private:
+            ZSTD_DCtx *m_context;
+            bool m_frameComplete;
+        };
+#endif /* AWS_CRT_CPP_HAS_ZSTD */
+
+        StreamCodec::StreamCodec(StreamCodecImpl *impl, Allocator *allocator, int lastError) noexcept
+            : m_impl(impl), m_allocator(allocator), m_lastError(lastError)
+        {
+        }
+
+        StreamCodec::~StreamCodec()
+        {
+            Delete(m_impl, m_allocator);
+            m_impl = nullptr;
+        }
+
+        StreamCodec::StreamCodec(StreamCodec &&toMove) noexcept
+            : m_impl(toMove.m_impl), m_allocator(toMove.m_allocator), m_lastError(toMove.m_lastError)
+        {
+            toMove.m_impl = nullptr;
+        }
+
+        StreamCodec &StreamCodec::operator=(StreamCodec &&toMove) noexcept
+        {
+            if (this != &toMove)
+            {
+                Delete(m_impl, m_allocator);
+                m_impl = toMove.m_impl;
+                m_allocator = toMove.m_allocator;
+                m_lastError = toMove.m_lastError;
+                toMove.m_impl = nullptr;
+            }
+
+            return *this;
+        }
+
+        StreamCodec::operator bool() const noexcept { return m_impl != nullptr; }
+
+        bool StreamCodec::IsSupported(CompressionAlgorithm algorithm) noexcept
+        {
+            switch (algorithm)
+            {
+#if defined(AWS_CRT_CPP_HAS_ZLIB)
+                case CompressionAlgorithm::Deflate:
+                    return true;
+#endif
+#if defined(AWS_CRT_CPP_HAS_ZSTD)
+                case CompressionAlgorithm::Zstd:
+                    return true;
+#endif
+                default:
+                    return false;
+            }
+        }
+
+        StreamCodec StreamCodec::CreateCompressor(
+            CompressionAlgorithm algorithm,
+            int level,
+            Allocator *allocator) noexcept
+        {
+            (void)level;
+            switch (algorithm)
+            {
+#if defined(AWS_CRT_CPP_HAS_ZLIB)
+                case CompressionAlgorithm::Deflate:
+                {
+                    auto *codec = New<ZlibCodec>(allocator, allocator, true);
+                    if (codec != nullptr && !codec->Init(level))
+                    {
+                        Delete(codec, allocator);
+                        codec = nullptr;
+                    }
+                    return StreamCodec(codec, allocator, codec != nullptr ? AWS_ERROR_SUCCESS : aws_last_error());
+                }
+#endif
+#if defined(AWS_CRT_CPP_HAS_ZSTD)
+                case CompressionAlgorithm::Zstd:
+                {
+                    auto *codec = New<ZstdCompressor>(allocator);
+                    if (codec != nullptr && !codec->Init(level))
+                    {
+                        Delete(codec, allocator);
+                        codec = nullptr;
+                    }
+                    return StreamCodec(codec, allocator, codec != nullptr ? AWS_ERROR_SUCCESS : aws_last_error());
+                }
+#endif
+                default:
+                    aws_raise_error(AWS_ERROR_UNSUPPORTED_OPERATION);
+                    return StreamCodec(nullptr, allocator, AWS_ERROR_UNSUPPORTED_OPERATION);
+            }
+        }
+
+        StreamCodec StreamCodec::CreateDecompressor(CompressionAlgorithm algorithm, Allocator *allocator) noexcept
+        {
+            switch (algorithm)
+            {
+#if defined(AWS_CRT_CPP_HAS_ZLIB)
+                case CompressionAlgorithm::Deflate:
+                {
+                    auto *codec = New<ZlibCodec>(allocator, allocator, false);
+                    if (codec != nullptr && !codec->Init(-1))
+                    {
+                        Delete(codec, allocator);
+                        codec = nullptr;
+                    }
+                    return StreamCodec(codec, allocator, codec != nullptr ? AWS_ERROR_SUCCESS : aws_last_error());
+                }
+#endif
+#if defined(AWS_CRT_CPP_HAS_ZSTD)
+                case CompressionAlgorithm::Zstd:
+                {
+                    auto *codec = New<ZstdDecompressor>(allocator);
+                    if (codec != nullptr && !codec->Init())
+                    {
+                        Delete(codec, allocator);
+                        codec = nullptr;
+                    }
+                    return StreamCodec(codec, allocator, codec != nullptr ? AWS_ERROR_SUCCESS : aws_last_error());
+                }
+#endif
+                default:
+                    aws_raise_error(AWS_ERROR_UNSUPPORTED_OPERATION);
+                    return StreamCodec(nullptr, allocator, AWS_ERROR_UNSUPPORTED_OPERATION);
+            }
+        }
+
+        bool StreamCodec::Update(ByteCursor &input, ByteBuf &output, size_t maxOutputSize) noexcept
+        {
+            if (m_impl == nullptr)
+            {
+                m_lastError = AWS_ERROR_INVALID_STATE;
+                aws_raise_error(m_lastError);
+                return false;
+            }
+
+            size_t outputLimit = output.len + std::min(maxOutputSize, SIZE_MAX - output.len);
+            if (!m_impl->Update(input, output, outputLimit))
+            {
+                m_lastError = aws_last_error();
+                return false;
+            }
+
+            /* The last chunk may have been filled to one byte past the limit */
+            if (output.len > outputLimit)
+            {
+                m_lastError = AWS_ERROR_SHORT_BUFFER;
+                aws_raise_error(m_lastError);
+                return false;
+            }
+
+            return true;
+        }
+
+        bool StreamCodec::Flush(ByteBuf &output) noexcept
+        {
+            if (m_impl == nullptr)
+            {
+                m_lastError = AWS_ERROR_INVALID_STATE;
+                aws_raise_error(m_lastError);
+                return false;
+            }
+
+            if (!m_impl->Flush(output))
+            {
+                m_lastError = aws_last_error();
+                return false;
+            }
+
+            return true;
+        }
+
+        bool StreamCodec::Finish(ByteBuf &output) noexcept
+        {
+            if (m_impl == nullptr)
+            {
+                m_lastError = AWS_ERROR_INVALID_STATE;
+                aws_raise_error(m_lastError);
+                return false;
+            }
+
+            if (!m_impl->Finish(output))
+            {
+                m_lastError = aws_last_error();
+                return false;
+            }
+
+            return true;
+        }
+
+        bool StreamCodec::CompressOneShot(
+            CompressionAlgorithm algorithm,
+            const ByteCursor &input,
+            ByteBuf &output,
+            int level,
+            Allocator *allocator) noexcept
+        {
+            StreamCodec compressor = CreateCompressor(algorithm, level, allocator);
+            ByteCursor toCompress = input;
+            return compressor && compressor.Update(toCompress, output) && compressor.Finish(output);
+        }
+
+        bool StreamCodec::DecompressOneShot(
+            CompressionAlgorithm algorithm,
+            const ByteCursor &input,
+            ByteBuf &output,
+            size_t maxOutputSize,
+            Allocator *allocator) noexcept
+        {
+            StreamCodec decompressor = CreateDecompressor(algorithm, allocator);
+            ByteCursor toDecompress = input;
+            return decompressor && decompressor.Update(toDecompress, output, maxOutputSize) &&
+                   decompressor.Finish(output);
+        }
+    } // namespace Crt
+} // namespace Aws
@@ -26,6 +26,11 @@ namespace Aws
             m_value = aws_json_value_new_from_string(ApiAllocator(), ByteCursorFromString(stringToParse));
         }
 
+        JsonObject::JsonObject(ByteCursor stringToParse)
+        {
+            m_value = aws_json_value_new_from_string(ApiAllocator(), stringToParse);
+        }
+
         JsonObject::JsonObject(const JsonObject &other) : JsonObject(other.m_value) {}
 
         JsonObject::JsonObject(JsonObject &&other) noexcept
@@ -268,6 +273,88 @@ namespace Aws
             return *this;
         }
 
+        struct JsonMergePatchContext
+        {
+            aws_json_value *target;
+            bool keepNulls;
+        };
+
+        static void s_mergePatch(aws_json_value *target, const aws_json_value *patch, bool keepNulls);
+
+        static int s_mergePatchMember(
+            const aws_byte_cursor *key,
+            const aws_json_value *value,
+            bool *out_should_continue,
+            void *user_data)
+        {
+            (void)out_should_continue;
+            auto *context = static_cast<JsonMergePatchContext *>(user_data);
+            aws_json_value *existing = aws_json_value_get_from_object(context->target, *key);
+
+            if (aws_json_value_is_object(value) && existing != nullptr && aws_json_value_is_object(existing))
+            {
+                s_mergePatch(existing, value, context->keepNulls);
+                return AWS_OP_SUCCESS;
+            }
+
+            if (existing != nullptr)
+            {
+                aws_json_value_remove_from_object(context->target, *key);
+            }
+            if (aws_json_value_is_null(value) && !context->keepNulls)
+            {
+                return AWS_OP_SUCCESS;
+            }
+
+            aws_json_value *member = nullptr;
+            if (aws_json_value_is_object(value))
+            {
+                /* Merged rather than copied, so that nulls nested in it are applied too */
+                member = aws_json_value_new_object(ApiAllocator());
+                if (member != nullptr)
+                {
+                    s_mergePatch(member, value, context->keepNulls);
+                }
+            }
+            else
+            {
+                member = aws_json_value_duplicate(value);
+            }
+
+            if (member != nullptr && aws_json_value_add_to_object(context->target, *key, member) != AWS_OP_SUCCESS)
+            {
+                aws_json_value_destroy(member);
+            }
+            return AWS_OP_SUCCESS;
+        }
+
+        static void s_mergePatch(aws_json_value *target, const aws_json_value *patch, bool keepNulls)
+        {
+            JsonMergePatchContext context = {target, keepNulls};
+            aws_json_const_iterate_object(patch, s_mergePatchMember, &context);
+        }
+
+        JsonObject &JsonObject::MergePatch(const JsonView &patch, bool keepNulls)
+        {
+            if (patch.m_value == nullptr || patch.m_value == m_value)
+            {
+                return *this;
+            }
+
+            if (!aws_json_value_is_object(patch.m_value))
+            {
+                return AsNewValue(aws_json_value_duplicate(patch.m_value));
+            }
+
+            if (m_value == nullptr || !aws_json_value_is_object(m_value))
+            {
+                AsNewValue(aws_json_value_new_object(ApiAllocator()));
+            }
+
+            s_mergePatch(m_value, patch.m_value, keepNulls);
+            return *this;
+        }
+
         bool JsonObject::operator==(const JsonObject &other) const
         {
             if (m_value != nullptr && other.m_value != nullptr)
@@ -0,0 +1,135 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/LatencyHistogram.h>
+
+#include <aws/common/math.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        const size_t LatencyHistogramSnapshot::BucketCount;
+
+        LatencyHistogramSnapshot::LatencyHistogramSnapshot() noexcept : buckets(), count(0), sumNanos(0), maxNanos(0)
+        {
+        }
+
+        double LatencyHistogramSnapshot::GetMeanNanos() const noexcept
+        {
+            return count > 0 ? static_cast<double>(sumNanos) / static_cast<double>(count) : 0.0;
+        }
+
+        uint64_t LatencyHistogramSnapshot::GetPercentileNanos(double percentile) const noexcept
+        {
+            if (count == 0)
+            {
+                return 0;
+            }
+
+            if (percentile < 0.0)
+            {
+                percentile = 0.0;
+            }
+            else if (percentile > 100.0)
+            {
+                percentile = 100.0;
+            }
+
+            uint64_t target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(count));
+            if (target == 0)
+            {
+                target = 1;
+            }
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BucketCount; ++i)
+            {
+                seen += buckets[i];
+                if (seen >= target)
+                {
+                    uint64_t upperBound = GetBucketUpperBoundNanos(i);
+                    return upperBound < maxNanos ? upperBound : maxNanos;
+                }
+            }
+
+            return maxNanos;
+        }
+
+        void LatencyHistogramSnapshot::Merge(const LatencyHistogramSnapshot &other) noexcept
+        {
+            for (size_t i = 0; i < BucketCount; ++i)
+            {
+                buckets[i] += other.buckets[i];
+            }
+            count += other.count;
+            sumNanos += other.sumNanos;
+            maxNanos = other.maxNanos > maxNanos ? other.maxNanos : maxNanos;
+        }
+
+        uint64_t LatencyHistogramSnapshot::GetBucketUpperBoundNanos(size_t bucket) noexcept
+        {
+            if (bucket + 1 >= BucketCount)
+            {
+                return UINT64_MAX;
+            }
+
+            return static_cast<uint64_t>(1) << (bucket + 1);
+        }
+
+        LatencyHistogram::LatencyHistogram() noexcept
+        {
+            Reset();
+        }
+
+        size_t LatencyHistogram::GetBucketIndex(uint64_t nanos) noexcept
+        {
+            if (nanos < 2)
+            {
+                return 0;
+            }
+
+            size_t bucket = 63 - aws_clz_u64(nanos);
+            return bucket < LatencyHistogramSnapshot::BucketCount ? bucket : LatencyHistogramSnapshot::BucketCount - 1;
+        }
+
+        void LatencyHistogram::Record(uint64_t nanos) noexcept
+        {
+            m_buckets[GetBucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+            m_count.fetch_add(1, std::memory_order_relaxed);
+            m_sumNanos.fetch_add(nanos, std::memory_order_relaxed);
+
+            uint64_t currentMax = m_maxNanos.load(std::memory_order_relaxed);
+            while (nanos > currentMax &&
+                   !m_maxNanos.compare_exchange_weak(currentMax, nanos, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        LatencyHistogramSnapshot LatencyHistogram::GetSnapshot() const noexcept
+        {
+            LatencyHistogramSnapshot snapshot;
+            for (size_t i = 0; i < LatencyHistogramSnapshot::BucketCount; ++i)
+            {
+                snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+            }
+            snapshot.count = m_count.load(std::memory_order_relaxed);
+            snapshot.sumNanos = m_sumNanos.load(std::memory_order_relaxed);
+            snapshot.maxNanos = m_maxNanos.load(std::memory_order_relaxed);
+
+            return snapshot;
+        }
+
+        void LatencyHistogram::Reset() noexcept
+        {
+            for (size_t i = 0; i < LatencyHistogramSnapshot::BucketCount; ++i)
+            {
+                m_buckets[i].store(0, std::memory_order_relaxed);
+            }
+            m_count.store(0, std::memory_order_relaxed);
+            m_sumNanos.store(0, std::memory_order_relaxed);
+            m_maxNanos.store(0, std::memory_order_relaxed);
+        }
+    } // namespace Crt
+} // namespace Aws
@@ -23,6 +23,7 @@ namespace Aws
                 Allocator *allocator;
                 OnConnectionSetup onConnectionSetup;
                 OnConnectionShutdown onConnectionShutdown;
+                Io::ConnectionSetupObserver setupObserver;
             };
 
             class UnmanagedConnection final : public HttpClientConnection
@@ -149,6 +150,20 @@ namespace Aws
 
                     options.tls_options =
                         const_cast<aws_tls_connection_options *>(connectionOptions.TlsOptions->GetUnderlyingHandle());
+
+                    if (connectionOptions.OnConnectionSetupMetricsCallback)
+                    {
+                        /* callbackData lives until the connection shuts down, well past the handshake. */
+                        Io::OnConnectionSetupMetrics onMetrics = connectionOptions.OnConnectionSetupMetricsCallback;
+                        callbackData->setupObserver.SetCallback(std::move(onMetrics));
+                        options.tls_options = callbackData->setupObserver.Instrument(*options.tls_options);
+                        if (options.tls_options == nullptr)
+                        {
+                            Delete(callbackData, allocator);
+                            return false;
+                        }
+                        callbackData->setupObserver.OnAttemptStarted();
+                    }
                 }
                 options.allocator = allocator;
                 options.user_data = callbackData;
@@ -159,6 +174,7 @@ namespace Aws
                 options.on_setup = HttpClientConnection::s_onClientConnectionSetup;
                 options.on_shutdown = HttpClientConnection::s_onClientConnectionShutdown;
                 options.manual_window_management = connectionOptions.ManualWindowManagement;
+                options.requested_event_loop = connectionOptions.RequestedEventLoop.GetUnderlyingHandle();
 
                 aws_http_proxy_options proxyOptions;
                 AWS_ZERO_STRUCT(proxyOptions);
@@ -401,7 +417,7 @@ namespace Aws
             HttpClientConnectionOptions::HttpClientConnectionOptions()
                 : Bootstrap(nullptr), InitialWindowSize(SIZE_MAX), OnConnectionSetupCallback(),
                   OnConnectionShutdownCallback(), HostName(), Port(0), SocketOptions(), TlsOptions(), ProxyOptions(),
-                  ManualWindowManagement(false)
+                  ManualWindowManagement(false), RequestedEventLoop(), OnConnectionSetupMetricsCallback()
             {
             }
         } // namespace Http
@@ -100,7 +100,8 @@ namespace Aws
                 s_GatherStatistics,
             };
 
-            ChannelHandler::ChannelHandler(Allocator *allocator) : m_allocator(allocator)
+            ChannelHandler::ChannelHandler(Allocator *allocator)
+                : m_allocator(allocator), m_freeTaskWrappers(nullptr), m_freeTaskWrapperCount(0)
             {
                 AWS_ZERO_STRUCT(m_handler);
                 m_handler.alloc = allocator;
@@ -108,6 +109,16 @@ namespace Aws
                 m_handler.vtable = &ChannelHandler::s_vtable;
             }
 
+            ChannelHandler::~ChannelHandler()
+            {
+                while (m_freeTaskWrappers != nullptr)
+                {
+                    TaskWrapper *next = m_freeTaskWrappers->next;
+                    Delete(m_freeTaskWrappers, m_allocator);
+                    m_freeTaskWrappers = next;
+                }
+            }
+
             struct aws_channel_handler *ChannelHandler::SeatForCInterop(const std::shared_ptr<ChannelHandler> &selfRef)
             {
                 AWS_FATAL_ASSERT(this == selfRef.get());
@@ -142,6 +153,39 @@ namespace Aws
                            GetSlot(), message, static_cast<aws_channel_direction>(direction)) == AWS_OP_SUCCESS;
             }
 
+            bool ChannelHandler::SendData(
+                const ByteCursor &data,
+                ChannelDirection direction,
+                aws_channel_on_message_write_completed_fn *onCompletion,
+                void *userData)
+            {
+                ByteCursor remaining = data;
+                while (remaining.len > 0)
+                {
+                    struct aws_io_message *message =
+                        AcquireMessageFromPool(MessageType::ApplicationData, remaining.len);
+                    if (message == nullptr)
+                    {
+                        return false;
+                    }
+
+                    aws_byte_buf_write_to_capacity(&message->message_data, &remaining);
+                    if (remaining.len == 0)
+                    {
+                        message->on_completion = onCompletion;
+                        message->user_data = userData;
+                    }
+
+                    if (!SendMessage(message, direction))
+                    {
+                        aws_mem_release(message->allocator, message);
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
             bool ChannelHandler::IncrementUpstreamReadWindow(size_t windowUpdateSize)
             {
                 return aws_channel_slot_increment_read_window(GetSlot(), windowUpdateSize) == AWS_OP_SUCCESS;
@@ -178,44 +222,106 @@ namespace Aws
                 return m_handler.slot;
             }
 
-            struct TaskWrapper
+            /*
+             * Upper bound on the number of idle task wrappers a handler keeps around for reuse. Handlers rarely have
+             * more than a handful of tasks in flight, so this is plenty to make steady-state rescheduling
+             * allocation-free without holding on to memory after a burst.
+             */
+            static const size_t s_maxFreeTaskWrappers = 16;
+
+            struct ChannelHandler::TaskWrapper
             {
                 struct aws_channel_task task
                 {
                 };
+                ChannelHandler *handler{};
                 Allocator *allocator{};
-                std::function<void(TaskStatus)> wrappingFn;
+                ChannelTask wrappingFn;
+                TaskWrapper *next{};
             };
 
-            static void s_ChannelTaskCallback(struct aws_channel_task *, void *arg, enum aws_task_status status)
+            void ChannelHandler::s_ChannelTaskCallback(
+                struct aws_channel_task *,
+                void *arg,
+                enum aws_task_status status)
             {
                 auto *taskWrapper = reinterpret_cast<TaskWrapper *>(arg);
                 taskWrapper->wrappingFn(static_cast<TaskStatus>(status));
-                Delete(taskWrapper, taskWrapper->allocator);
+                taskWrapper->wrappingFn = nullptr;
+
+                /*
+                 * Canceled tasks run while the channel is tearing down (or after the event loop is gone), so don't
+                 * touch the handler; just give the memory back.
+                 */
+                if (status == AWS_TASK_STATUS_RUN_READY)
+                {
+                    taskWrapper->handler->ReleaseTaskWrapper(taskWrapper);
+                }
+                else
+                {
+                    Delete(taskWrapper, taskWrapper->allocator);
+                }
             }
 
-            void ChannelHandler::ScheduleTask(std::function<void(TaskStatus)> &&task, std::chrono::nanoseconds run_in)
+            ChannelHandler::TaskWrapper *ChannelHandler::AcquireTaskWrapper()
             {
+                /* The free list is only ever touched from the channel's thread, other threads always allocate. */
+                if (ChannelsThreadIsCallersThread() && m_freeTaskWrappers != nullptr)
+                {
+                    TaskWrapper *wrapper = m_freeTaskWrappers;
+                    m_freeTaskWrappers = wrapper->next;
+                    --m_freeTaskWrapperCount;
+                    wrapper->next = nullptr;
+                    return wrapper;
+                }
+
                 auto *wrapper = New<TaskWrapper>(m_allocator);
-                wrapper->wrappingFn = std::move(task);
+                wrapper->handler = this;
                 wrapper->allocator = m_allocator;
-                aws_channel_task_init(
-                    &wrapper->task, s_ChannelTaskCallback, wrapper, "cpp-crt-custom-channel-handler-task");
+                return wrapper;
+            }
 
-                uint64_t currentTimestamp = 0;
-                aws_channel_current_clock_time(GetSlot()->channel, &currentTimestamp);
-                aws_channel_schedule_task_future(GetSlot()->channel, &wrapper->task, currentTimestamp + run_in.count());
+            void ChannelHandler::ReleaseTaskWrapper(TaskWrapper *wrapper)
+            {
+                if (m_freeTaskWrapperCount >= s_maxFreeTaskWrappers)
+                {
+                    Delete(wrapper, wrapper->allocator);
+                    return;
+                }
+
+                wrapper->next = m_freeTaskWrappers;
+                m_freeTaskWrappers = wrapper;
+                ++m_freeTaskWrapperCount;
             }
 
-            void ChannelHandler::ScheduleTask(std::function<void(TaskStatus)> &&task)
+            void ChannelHandler::ScheduleChannelTask(ChannelTask &&task, const std::chrono::nanoseconds *runIn)
             {
-                auto *wrapper = New<TaskWrapper>(m_allocator);
+                auto *wrapper = AcquireTaskWrapper();
                 wrapper->wrappingFn = std::move(task);
-                wrapper->allocator = m_allocator;
                 aws_channel_task_init(
                     &wrapper->task, s_ChannelTaskCallback, wrapper, "cpp-crt-custom-channel-handler-task");
 
-                aws_channel_schedule_task_now(GetSlot()->channel, &wrapper->task);
+                if (runIn != nullptr)
+                {
+                    uint64_t currentTimestamp = 0;
+                    aws_channel_current_clock_time(GetSlot()->channel, &currentTimestamp);
+                    aws_channel_schedule_task_future(
+                        GetSlot()->channel, &wrapper->task, currentTimestamp + runIn->count());
+                }
+                else
+                {
+                    aws_channel_schedule_task_now(GetSlot()->channel, &wrapper->task);
+                }
+            }
+
+            void ChannelHandler::ScheduleTask(std::function<void(TaskStatus)> &&task, std::chrono::nanoseconds run_in)
+            {
+                ScheduleChannelTask(ChannelTask(std::move(task), m_allocator), &run_in);
+            }
+
+            void ChannelHandler::ScheduleTask(std::function<void(TaskStatus)> &&task)
+            {
+                ScheduleChannelTask(ChannelTask(std::move(task), m_allocator), nullptr);
             }
 
         } // namespace Io
@@ -0,0 +1,168 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/io/CompressionHandler.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            CompressionHandler::CompressionHandler(
+                StreamCodec &&compressor,
+                StreamCodec &&decompressor,
+                size_t initialWindowSize,
+                size_t maxPendingReadSize,
+                Allocator *allocator)
+                : ChannelHandler(allocator), m_compressor(std::move(compressor)),
+                  m_decompressor(std::move(decompressor)), m_initialWindowSize(initialWindowSize),
+                  m_maxPendingReadSize(maxPendingReadSize), m_pendingReadOffset(0), m_pendingUpstreamCredit(0),
+                  m_readFailed(false)
+            {
+                AWS_ZERO_STRUCT(m_writeBuffer);
+                m_writeBuffer.allocator = allocator;
+                AWS_ZERO_STRUCT(m_pendingRead);
+                m_pendingRead.allocator = allocator;
+            }
+
+            CompressionHandler::~CompressionHandler()
+            {
+                aws_byte_buf_clean_up(&m_writeBuffer);
+                aws_byte_buf_clean_up(&m_pendingRead);
+            }
+
+            int CompressionHandler::ProcessReadMessage(struct aws_io_message *message)
+            {
+                if (m_readFailed)
+                {
+                    /* The channel is shutting down */
+                    aws_mem_release(message->allocator, message);
+                    return AWS_OP_SUCCESS;
+                }
+
+                ByteCursor input = aws_byte_cursor_from_buf(&message->message_data);
+                size_t inputSize = input.len;
+
+                /* Drop what was forwarded already, so that the bound only counts data still held */
+                if (m_pendingReadOffset > 0)
+                {
+                    memmove(
+                        m_pendingRead.buffer,
+                        m_pendingRead.buffer + m_pendingReadOffset,
+                        m_pendingRead.len - m_pendingReadOffset);
+                    m_pendingRead.len -= m_pendingReadOffset;
+                    m_pendingReadOffset = 0;
+                }
+
+                size_t room = m_maxPendingReadSize - std::min(m_maxPendingReadSize, m_pendingRead.len);
+                bool appended = false;
+                if (m_decompressor)
+                {
+                    appended = m_decompressor.Update(input, m_pendingRead, room);
+                }
+                else if (input.len > room)
+                {
+                    aws_raise_error(AWS_ERROR_SHORT_BUFFER);
+                }
+                else
+                {
+                    appended = aws_byte_buf_append_dynamic(&m_pendingRead, &input) == AWS_OP_SUCCESS;
+                }
+
+                int errorCode = appended ? AWS_ERROR_SUCCESS : aws_last_error();
+                aws_mem_release(message->allocator, message);
+                if (!appended)
+                {
+                    /* The decompressor is left mid-stream, so nothing further can be read */
+                    m_readFailed = true;
+                    ShutDownChannel(errorCode);
+                    return AWS_OP_SUCCESS;
+                }
+
+                m_pendingUpstreamCredit += inputSize;
+                ForwardPendingReads();
+                return AWS_OP_SUCCESS;
+            }
+
+            int CompressionHandler::ProcessWriteMessage(struct aws_io_message *message)
+            {
+                if (!m_compressor)
+                {
+                    return SendMessage(message, ChannelDirection::Write) ? AWS_OP_SUCCESS : AWS_OP_ERR;
+                }
+
+                ByteCursor input = aws_byte_cursor_from_buf(&message->message_data);
+                m_writeBuffer.len = 0;
+                if (!m_compressor.Update(input, m_writeBuffer) || !m_compressor.Flush(m_writeBuffer))
+                {
+                    return AWS_OP_ERR;
+                }
+
+                if (!SendData(
+                        aws_byte_cursor_from_buf(&m_writeBuffer),
+                        ChannelDirection::Write,
+                        message->on_completion,
+                        message->user_data))
+                {
+                    return AWS_OP_ERR;
+                }
+
+                aws_mem_release(message->allocator, message);
+                return AWS_OP_SUCCESS;
+            }
+
+            int CompressionHandler::IncrementReadWindow(size_t)
+            {
+                /* Upstream is credited as decompressed data is forwarded, so this only unblocks pending data. */
+                ForwardPendingReads();
+                return AWS_OP_SUCCESS;
+            }
+
+            void CompressionHandler::ProcessShutdown(
+                ChannelDirection dir,
+                int errorCode,
+                bool freeScarceResourcesImmediately)
+            {
+                OnShutdownComplete(dir, errorCode, freeScarceResourcesImmediately);
+            }
+
+            size_t CompressionHandler::InitialWindowSize() { return m_initialWindowSize; }
+
+            size_t CompressionHandler::MessageOverhead() { return 0; }
+
+            void CompressionHandler::ForwardPendingReads()
+            {
+                size_t pending = m_pendingRead.len - m_pendingReadOffset;
+                size_t toForward = std::min(pending, DownstreamReadWindow());
+                if (toForward > 0)
+                {
+                    ByteCursor data = aws_byte_cursor_from_array(m_pendingRead.buffer + m_pendingReadOffset, toForward);
+                    if (!SendData(data, ChannelDirection::Read))
+                    {
+                        ShutDownChannel(aws_last_error());
+                        return;
+                    }
+                    m_pendingReadOffset += toForward;
+                }
+
+                if (m_pendingReadOffset == m_pendingRead.len)
+                {
+                    m_pendingRead.len = 0;
+                    m_pendingReadOffset = 0;
+
+                    if (m_pendingUpstreamCredit > 0)
+                    {
+                        size_t credit = m_pendingUpstreamCredit;
+                        m_pendingUpstreamCredit = 0;
+                        IncrementUpstreamReadWindow(credit);
+                    }
+                }
+            }
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
@@ -0,0 +1,148 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/io/ConnectionSetupMetrics.h>
+
+#include <aws/common/array_list.h>
+#include <aws/common/clock.h>
+#include <aws/io/channel.h>
+#include <aws/io/statistics.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            ConnectionSetupMetrics::ConnectionSetupMetrics() noexcept
+                : attemptStartNs(0), tlsHandshakeStartNs(0), tlsHandshakeEndNs(0), tlsErrorCode(AWS_ERROR_SUCCESS)
+            {
+            }
+
+            std::chrono::nanoseconds ConnectionSetupMetrics::ResolveAndConnectDuration() const noexcept
+            {
+                if (attemptStartNs == 0 || tlsHandshakeStartNs < attemptStartNs)
+                {
+                    return std::chrono::nanoseconds(0);
+                }
+
+                return std::chrono::nanoseconds(tlsHandshakeStartNs - attemptStartNs);
+            }
+
+            std::chrono::nanoseconds ConnectionSetupMetrics::TlsHandshakeDuration() const noexcept
+            {
+                if (tlsHandshakeStartNs == 0 || tlsHandshakeEndNs < tlsHandshakeStartNs)
+                {
+                    return std::chrono::nanoseconds(0);
+                }
+
+                return std::chrono::nanoseconds(tlsHandshakeEndNs - tlsHandshakeStartNs);
+            }
+
+            ConnectionSetupObserver::ConnectionSetupObserver() noexcept
+                : m_hasTlsOptions(false), m_chainedOnNegotiationResult(nullptr), m_chainedUserData(nullptr),
+                  m_attemptStartNs(0)
+            {
+                AWS_ZERO_STRUCT(m_tlsOptions);
+            }
+
+            ConnectionSetupObserver::~ConnectionSetupObserver()
+            {
+                if (m_hasTlsOptions)
+                {
+                    aws_tls_connection_options_clean_up(&m_tlsOptions);
+                }
+            }
+
+            aws_tls_connection_options *ConnectionSetupObserver::Instrument(
+                const aws_tls_connection_options &tlsOptions) noexcept
+            {
+                if (m_hasTlsOptions)
+                {
+                    aws_tls_connection_options_clean_up(&m_tlsOptions);
+                    m_hasTlsOptions = false;
+                }
+
+                if (aws_tls_connection_options_copy(&m_tlsOptions, &tlsOptions))
+                {
+                    return nullptr;
+                }
+
+                m_hasTlsOptions = true;
+                m_chainedOnNegotiationResult = tlsOptions.on_negotiation_result;
+                m_chainedUserData = tlsOptions.user_data;
+                m_tlsOptions.on_negotiation_result = s_OnNegotiationResult;
+                m_tlsOptions.user_data = this;
+                return &m_tlsOptions;
+            }
+
+            void ConnectionSetupObserver::OnAttemptStarted() noexcept
+            {
+                uint64_t now = 0;
+                aws_high_res_clock_get_ticks(&now);
+                m_attemptStartNs.store(now, std::memory_order_relaxed);
+            }
+
+            void ConnectionSetupObserver::s_OnNegotiationResult(
+                struct aws_channel_handler *handler,
+                struct aws_channel_slot *slot,
+                int errorCode,
+                void *userData)
+            {
+                auto *observer = static_cast<ConnectionSetupObserver *>(userData);
+
+                if (observer->m_callback)
+                {
+                    ConnectionSetupMetrics metrics;
+                    metrics.attemptStartNs = observer->m_attemptStartNs.exchange(0, std::memory_order_relaxed);
+                    metrics.tlsErrorCode = errorCode;
+
+                    /* The TLS handlers time the handshake themselves and publish it with their statistics. */
+                    if (handler->vtable->gather_statistics != nullptr)
+                    {
+                        void *statisticsStorage[4];
+                        struct aws_array_list statistics;
+                        aws_array_list_init_static(
+                            &statistics, statisticsStorage, AWS_ARRAY_SIZE(statisticsStorage), sizeof(void *));
+                        handler->vtable->gather_statistics(handler, &statistics);
+
+                        for (size_t i = 0; i < aws_array_list_length(&statistics); ++i)
+                        {
+                            struct aws_crt_statistics_base *base = nullptr;
+                            aws_array_list_get_at(&statistics, &base, i);
+                            if (base != nullptr && base->category == AWS_CRT_STATISTICS_CATEGORY_TLS)
+                            {
+                                auto *tlsStatistics = reinterpret_cast<struct aws_crt_statistics_tls *>(base);
+                                metrics.tlsHandshakeStartNs = tlsStatistics->handshake_start_ns;
+                                metrics.tlsHandshakeEndNs = tlsStatistics->handshake_end_ns;
+                            }
+                        }
+                    }
+
+                    if (metrics.tlsHandshakeEndNs == 0)
+                    {
+                        aws_channel_current_clock_time(slot->channel, &metrics.tlsHandshakeEndNs);
+                    }
+
+                    if (errorCode == AWS_ERROR_SUCCESS)
+                    {
+                        struct aws_byte_buf protocol = aws_tls_handler_protocol(handler);
+                        if (protocol.len > 0)
+                        {
+                            metrics.negotiatedProtocol.assign(
+                                reinterpret_cast<const char *>(protocol.buffer), protocol.len);
+                        }
+                    }
+
+                    observer->m_callback(metrics);
+                }
+
+                if (observer->m_chainedOnNegotiationResult != nullptr)
+                {
+                    observer->m_chainedOnNegotiationResult(handler, slot, errorCode, observer->m_chainedUserData);
+                }
+            }
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
@@ -3,7 +3,16 @@
  * SPDX-License-Identifier: Apache-2.0.
  */
 #include <aws/crt/io/EventLoopGroup.h>
+
+#include <aws/common/clock.h>
+#include <aws/common/system_info.h>
+
 #include <iostream>
+#include <new>
+
+#if defined(__linux__)
+#    include <sched.h>
+#endif
 
 namespace Aws
 {
@@ -11,25 +20,532 @@ namespace Aws
     {
         namespace Io
         {
-            EventLoopGroup::EventLoopGroup(uint16_t threadCount, Allocator *allocator) noexcept
-                : m_eventLoopGroup(nullptr), m_lastError(AWS_ERROR_SUCCESS)
+            struct EventLoopInstrumentation
             {
-                m_eventLoopGroup = aws_event_loop_group_new_default(allocator, threadCount, NULL);
-                if (m_eventLoopGroup == nullptr)
+                aws_event_loop *eventLoop{};
+                EventLoopGroupInstrumentation *group{};
+                int32_t cpuGroup{-1};
+                int32_t cpuId{-1};
+
+                std::atomic<uint64_t> tasksScheduled{0};
+                std::atomic<uint64_t> tasksRun{0};
+                std::atomic<uint64_t> tasksCanceled{0};
+                LatencyHistogram taskLatency;
+                LatencyHistogram probeLatency;
+
+                struct aws_task probeTask
                 {
-                    m_lastError = aws_last_error();
+                };
+                uint64_t probeDueAt{};
+                std::atomic<bool> probeScheduled{false};
+            };
+
+            struct EventLoopGroupInstrumentation
+            {
+                explicit EventLoopGroupInstrumentation(Allocator *alloc) : allocator(alloc) {}
+
+                Allocator *allocator;
+                EventLoopInstrumentation *loops{};
+                size_t loopCount{};
+                std::atomic<uint64_t> probeIntervalNanos{0};
+
+                /*
+                 * Set once the group is created. From then on the group owns the instrumentation and frees it when it
+                 * shuts down; until then the EventLoopGroup constructor does.
+                 */
+                bool ownedByGroup{false};
+            };
+
+            static void s_OnEventLoopGroupShutdown(void *userData)
+            {
+                auto *instrumentation = reinterpret_cast<EventLoopGroupInstrumentation *>(userData);
+
+                /* A group failing to be created may shut down before returning, the constructor frees it then */
+                if (instrumentation == nullptr || !instrumentation->ownedByGroup)
+                {
+                    return;
+                }
+
+                for (size_t i = 0; i < instrumentation->loopCount; ++i)
+                {
+                    instrumentation->loops[i].~EventLoopInstrumentation();
+                }
+                aws_mem_release(instrumentation->allocator, instrumentation->loops);
+                Delete(instrumentation, instrumentation->allocator);
+            }
+
+            static uint64_t s_CurrentClockTime(aws_event_loop *eventLoop)
+            {
+                uint64_t currentTimestamp = 0;
+                aws_event_loop_current_clock_time(eventLoop, &currentTimestamp);
+                return currentTimestamp;
+            }
+
+            static void s_RecordLateness(LatencyHistogram &histogram, uint64_t dueAt, uint64_t ranAt)
+            {
+                histogram.Record(ranAt > dueAt ? ranAt - dueAt : 0);
+            }
+
+            static void s_LatencyProbeTask(struct aws_task *, void *arg, enum aws_task_status status);
+
+            static void s_ScheduleLatencyProbe(EventLoopInstrumentation *loop, uint64_t intervalNanos)
+            {
+                loop->probeDueAt = s_CurrentClockTime(loop->eventLoop) + intervalNanos;
+                aws_event_loop_schedule_task_future(loop->eventLoop, &loop->probeTask, loop->probeDueAt);
+            }
+
+            static void s_LatencyProbeTask(struct aws_task *, void *arg, enum aws_task_status status)
+            {
+                auto *loop = reinterpret_cast<EventLoopInstrumentation *>(arg);
+                if (status != AWS_TASK_STATUS_RUN_READY)
+                {
+                    loop->probeScheduled.store(false);
+                    return;
+                }
+
+                s_RecordLateness(loop->probeLatency, loop->probeDueAt, s_CurrentClockTime(loop->eventLoop));
+
+                uint64_t intervalNanos = loop->group->probeIntervalNanos.load();
+                if (intervalNanos != 0)
+                {
+                    s_ScheduleLatencyProbe(loop, intervalNanos);
+                    return;
+                }
+
+                /* Disabled: park, unless it got re-enabled while we were parking. */
+                loop->probeScheduled.store(false);
+                intervalNanos = loop->group->probeIntervalNanos.load();
+                bool expected = false;
+                if (intervalNanos != 0 && loop->probeScheduled.compare_exchange_strong(expected, true))
+                {
+                    s_ScheduleLatencyProbe(loop, intervalNanos);
+                }
+            }
+
+            /*
+             * Cores chosen for each loop of a group being created, consumed in order by s_NewPlacedEventLoop.
+             */
+            struct EventLoopPlacementPlan
+            {
+                explicit EventLoopPlacementPlan(Allocator *allocator) : cpuIds(allocator), cpuGroups(allocator) {}
+
+                Vector<int32_t> cpuIds;
+                Vector<int32_t> cpuGroups;
+                size_t nextLoop{};
+            };
+
+            static Vector<struct aws_cpu_info> s_GetCpusForGroup(uint16_t group)
+            {
+                Vector<struct aws_cpu_info> cpuInfos(aws_get_cpu_count_for_group(group));
+                aws_get_cpu_ids_for_group(group, cpuInfos.data(), cpuInfos.size());
+                return cpuInfos;
+            }
+
+            static void s_PlanSpreadAcrossCpuGroups(EventLoopPlacementPlan &plan, size_t threadCount)
+            {
+                uint16_t groupCount = aws_get_cpu_group_count();
+                Vector<Vector<int32_t>> coresPerGroup;
+                size_t totalCores = 0;
+                for (uint16_t group = 0; group < groupCount; ++group)
+                {
+                    Vector<struct aws_cpu_info> cpuInfos = s_GetCpusForGroup(group);
+
+                    Vector<int32_t> cores;
+                    for (const struct aws_cpu_info &cpuInfo : cpuInfos)
+                    {
+                        if (!cpuInfo.suspected_hyper_thread)
+                        {
+                            cores.push_back(cpuInfo.cpu_id);
+                        }
+                    }
+
+                    /* If every core looks like a hyper-thread, the detection is not useful: use them all. */
+                    if (cores.empty())
+                    {
+                        for (const struct aws_cpu_info &cpuInfo : cpuInfos)
+                        {
+                            cores.push_back(cpuInfo.cpu_id);
+                        }
+                    }
+
+                    totalCores += cores.size();
+                    coresPerGroup.push_back(std::move(cores));
+                }
+
+                if (threadCount == 0)
+                {
+                    threadCount = totalCores;
+                }
+
+                /* Round-robin across groups so that each group gets its share of loops. */
+                for (size_t round = 0; plan.cpuIds.size() < threadCount && totalCores > 0; ++round)
+                {
+                    for (size_t group = 0; group < coresPerGroup.size() && plan.cpuIds.size() < threadCount; ++group)
+                    {
+                        const Vector<int32_t> &cores = coresPerGroup[group];
+                        if (cores.empty())
+                        {
+                            continue;
+                        }
+
+                        /* More loops than cores: wrap around and share cores. */
+                        plan.cpuIds.push_back(cores[round % cores.size()]);
+                        plan.cpuGroups.push_back(static_cast<int32_t>(group));
+                    }
+                }
+            }
+
+            static struct aws_event_loop *s_NewPlacedEventLoop(
+                struct aws_allocator *allocator,
+                const struct aws_event_loop_options *options,
+                void *userData)
+            {
+                auto *plan = reinterpret_cast<EventLoopPlacementPlan *>(userData);
+
+                struct aws_thread_options threadOptions =
+                    options->thread_options != nullptr ? *options->thread_options : *aws_default_thread_options();
+                if (plan->nextLoop < plan->cpuIds.size())
+                {
+                    threadOptions.cpu_id = plan->cpuIds[plan->nextLoop];
+                }
+                ++plan->nextLoop;
+
+                struct aws_event_loop_options loopOptions = *options;
+                loopOptions.thread_options = &threadOptions;
+                return aws_event_loop_new_default_with_options(allocator, &loopOptions);
+            }
+
+            /*
+             * @return the CPU group of the core the calling thread is running on, or -1 if unknown.
+             */
+            static int32_t s_GetCallersCpuGroup()
+            {
+#if defined(__linux__)
+                int cpu = sched_getcpu();
+                if (cpu < 0)
+                {
+                    return -1;
+                }
+
+                uint16_t groupCount = aws_get_cpu_group_count();
+                for (uint16_t group = 0; group < groupCount; ++group)
+                {
+                    Vector<struct aws_cpu_info> cpuInfos = s_GetCpusForGroup(group);
+                    for (const struct aws_cpu_info &cpuInfo : cpuInfos)
+                    {
+                        if (cpuInfo.cpu_id == cpu)
+                        {
+                            return static_cast<int32_t>(group);
+                        }
+                    }
+                }
+#endif
+                return -1;
+            }
+
+            struct EventLoopTaskWrapper
+            {
+                struct aws_task task
+                {
+                };
+                Allocator *allocator{};
+                EventLoopInstrumentation *instrumentation{};
+                uint64_t dueAt{};
+                EventLoopTask wrappingFn;
+            };
+
+            static void s_EventLoopTaskCallback(struct aws_task *, void *arg, enum aws_task_status status)
+            {
+                auto *taskWrapper = reinterpret_cast<EventLoopTaskWrapper *>(arg);
+                EventLoopInstrumentation *instrumentation = taskWrapper->instrumentation;
+                if (instrumentation != nullptr)
+                {
+                    if (status == AWS_TASK_STATUS_RUN_READY)
+                    {
+                        s_RecordLateness(
+                            instrumentation->taskLatency,
+                            taskWrapper->dueAt,
+                            s_CurrentClockTime(instrumentation->eventLoop));
+                        instrumentation->tasksRun.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else
+                    {
+                        instrumentation->tasksCanceled.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+
+                taskWrapper->wrappingFn(static_cast<TaskStatus>(status));
+                Delete(taskWrapper, taskWrapper->allocator);
+            }
+
+            static bool s_ScheduleOnEventLoop(
+                aws_event_loop *eventLoop,
+                Allocator *allocator,
+                EventLoopInstrumentation *instrumentation,
+                EventLoopTask &&task,
+                const std::chrono::nanoseconds *delay)
+            {
+                if (eventLoop == nullptr || !task)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return false;
+                }
+
+                auto *wrapper = New<EventLoopTaskWrapper>(allocator);
+                if (wrapper == nullptr)
+                {
+                    return false;
+                }
+
+                wrapper->allocator = allocator;
+                wrapper->instrumentation = instrumentation;
+                wrapper->wrappingFn = std::move(task);
+                aws_task_init(&wrapper->task, s_EventLoopTaskCallback, wrapper, "cpp-crt-event-loop-task");
+
+                wrapper->dueAt = s_CurrentClockTime(eventLoop);
+                if (delay != nullptr)
+                {
+                    wrapper->dueAt += static_cast<uint64_t>(delay->count());
+                }
+
+                if (instrumentation != nullptr)
+                {
+                    instrumentation->tasksScheduled.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                if (delay != nullptr)
+                {
+                    aws_event_loop_schedule_task_future(eventLoop, &wrapper->task, wrapper->dueAt);
+                }
+                else
+                {
+                    aws_event_loop_schedule_task_now(eventLoop, &wrapper->task);
+                }
+
+                return true;
+            }
+
+            EventLoopStatistics::EventLoopStatistics() noexcept
+                : loadFactor(0), busyRatio(0.0), tasksScheduled(0), tasksRun(0), tasksCanceled(0)
+            {
+            }
+
+            EventLoop::EventLoop() noexcept
+                : m_eventLoop(nullptr), m_allocator(ApiAllocator()), m_instrumentation(nullptr)
+            {
+            }
+
+            EventLoop::EventLoop(aws_event_loop *eventLoop, Allocator *allocator) noexcept
+                : m_eventLoop(eventLoop), m_allocator(allocator), m_instrumentation(nullptr)
+            {
+            }
+
+            EventLoop::EventLoop(
+                aws_event_loop *eventLoop,
+                Allocator *allocator,
+                EventLoopInstrumentation *instrumentation) noexcept
+                : m_eventLoop(eventLoop), m_allocator(allocator), m_instrumentation(instrumentation)
+            {
+            }
+
+            EventLoop::operator bool() const noexcept
+            {
+                return m_eventLoop != nullptr;
+            }
+
+            bool EventLoop::Schedule(EventLoopTask &&task)
+            {
+                return s_ScheduleOnEventLoop(m_eventLoop, m_allocator, m_instrumentation, std::move(task), nullptr);
+            }
+
+            bool EventLoop::ScheduleAfter(EventLoopTask &&task, std::chrono::nanoseconds delay)
+            {
+                return s_ScheduleOnEventLoop(m_eventLoop, m_allocator, m_instrumentation, std::move(task), &delay);
+            }
+
+            bool EventLoop::IsCallersThread() const noexcept
+            {
+                return m_eventLoop != nullptr && aws_event_loop_thread_is_callers_thread(m_eventLoop);
+            }
+
+            size_t EventLoop::GetLoadFactor() const noexcept
+            {
+                return m_eventLoop != nullptr ? aws_event_loop_get_load_factor(m_eventLoop) : 0;
+            }
+
+            EventLoopStatistics EventLoop::GetStatistics() const noexcept
+            {
+                EventLoopStatistics statistics;
+                statistics.loadFactor = GetLoadFactor();
+
+                /* The load factor is the busy time, in nanoseconds, over a one second window. */
+                double busyRatio = static_cast<double>(statistics.loadFactor) / 1e9;
+                statistics.busyRatio = busyRatio < 1.0 ? busyRatio : 1.0;
+
+                if (m_instrumentation != nullptr)
+                {
+                    statistics.tasksScheduled = m_instrumentation->tasksScheduled.load(std::memory_order_relaxed);
+                    statistics.tasksRun = m_instrumentation->tasksRun.load(std::memory_order_relaxed);
+                    statistics.tasksCanceled = m_instrumentation->tasksCanceled.load(std::memory_order_relaxed);
+                    statistics.taskLatency = m_instrumentation->taskLatency.GetSnapshot();
+                    statistics.probeLatency = m_instrumentation->probeLatency.GetSnapshot();
                 }
+
+                return statistics;
+            }
+
+            int32_t EventLoop::GetCpuGroup() const noexcept
+            {
+                return m_instrumentation != nullptr ? m_instrumentation->cpuGroup : -1;
+            }
+
+            int32_t EventLoop::GetCpuId() const noexcept
+            {
+                return m_instrumentation != nullptr ? m_instrumentation->cpuId : -1;
+            }
+
+            aws_event_loop *EventLoop::GetUnderlyingHandle() const noexcept
+            {
+                return m_eventLoop;
+            }
+
+            EventLoopGroup::EventLoopGroup(uint16_t threadCount, Allocator *allocator) noexcept
+                : m_eventLoopGroup(nullptr), m_instrumentation(nullptr), m_allocator(allocator), m_nextLoopIndex(0),
+                  m_lastError(AWS_ERROR_SUCCESS)
+            {
+                m_instrumentation = New<EventLoopGroupInstrumentation>(allocator, allocator);
+
+                struct aws_shutdown_callback_options shutdownOptions;
+                shutdownOptions.shutdown_callback_fn = s_OnEventLoopGroupShutdown;
+                shutdownOptions.shutdown_callback_user_data = m_instrumentation;
+
+                m_eventLoopGroup = aws_event_loop_group_new_default(allocator, threadCount, &shutdownOptions);
+                InitInstrumentation();
             }
 
             EventLoopGroup::EventLoopGroup(uint16_t cpuGroup, uint16_t threadCount, Allocator *allocator) noexcept
-                : m_eventLoopGroup(nullptr), m_lastError(AWS_ERROR_SUCCESS)
+                : m_eventLoopGroup(nullptr), m_instrumentation(nullptr), m_allocator(allocator), m_nextLoopIndex(0),
+                  m_lastError(AWS_ERROR_SUCCESS)
+            {
+                m_instrumentation = New<EventLoopGroupInstrumentation>(allocator, allocator);
+
+                struct aws_shutdown_callback_options shutdownOptions;
+                shutdownOptions.shutdown_callback_fn = s_OnEventLoopGroupShutdown;
+                shutdownOptions.shutdown_callback_user_data = m_instrumentation;
+
+                m_eventLoopGroup = aws_event_loop_group_new_default_pinned_to_cpu_group(
+                    allocator, threadCount, cpuGroup, &shutdownOptions);
+                InitInstrumentation();
+
+                if (m_instrumentation != nullptr)
+                {
+                    for (size_t i = 0; i < m_instrumentation->loopCount; ++i)
+                    {
+                        m_instrumentation->loops[i].cpuGroup = cpuGroup;
+                    }
+                }
+            }
+
+            EventLoopGroup::EventLoopGroup(
+                EventLoopPlacement placement,
+                uint16_t threadCount,
+                Allocator *allocator) noexcept
+                : m_eventLoopGroup(nullptr), m_instrumentation(nullptr), m_allocator(allocator), m_nextLoopIndex(0),
+                  m_lastError(AWS_ERROR_SUCCESS)
+            {
+                m_instrumentation = New<EventLoopGroupInstrumentation>(allocator, allocator);
+
+                struct aws_shutdown_callback_options shutdownOptions;
+                shutdownOptions.shutdown_callback_fn = s_OnEventLoopGroupShutdown;
+                shutdownOptions.shutdown_callback_user_data = m_instrumentation;
+
+                if (placement != EventLoopPlacement::SpreadAcrossCpuGroups)
+                {
+                    m_eventLoopGroup = aws_event_loop_group_new_default(allocator, threadCount, &shutdownOptions);
+                    InitInstrumentation();
+                    return;
+                }
+
+                EventLoopPlacementPlan plan(allocator);
+                s_PlanSpreadAcrossCpuGroups(plan, threadCount);
+                if (plan.cpuIds.empty() || plan.cpuIds.size() > UINT16_MAX)
+                {
+                    m_lastError = AWS_ERROR_INVALID_ARGUMENT;
+                    Delete(m_instrumentation, m_allocator);
+                    m_instrumentation = nullptr;
+                    return;
+                }
+
+                m_eventLoopGroup = aws_event_loop_group_new(
+                    allocator,
+                    aws_high_res_clock_get_ticks,
+                    static_cast<uint16_t>(plan.cpuIds.size()),
+                    s_NewPlacedEventLoop,
+                    &plan,
+                    &shutdownOptions);
+                InitInstrumentation();
+
+                if (m_instrumentation != nullptr)
+                {
+                    for (size_t i = 0; i < m_instrumentation->loopCount && i < plan.cpuIds.size(); ++i)
+                    {
+                        m_instrumentation->loops[i].cpuId = plan.cpuIds[i];
+                        m_instrumentation->loops[i].cpuGroup = plan.cpuGroups[i];
+                    }
+                }
+            }
+
+            void EventLoopGroup::InitInstrumentation() noexcept
             {
-                m_eventLoopGroup =
-                    aws_event_loop_group_new_default_pinned_to_cpu_group(allocator, threadCount, cpuGroup, NULL);
                 if (m_eventLoopGroup == nullptr)
                 {
                     m_lastError = aws_last_error();
+                    Delete(m_instrumentation, m_allocator);
+                    m_instrumentation = nullptr;
+                    return;
+                }
+
+                if (m_instrumentation == nullptr)
+                {
+                    return;
+                }
+                m_instrumentation->ownedByGroup = true;
+
+                size_t loopCount = aws_event_loop_group_get_loop_count(m_eventLoopGroup);
+                m_instrumentation->loops = reinterpret_cast<EventLoopInstrumentation *>(
+                    aws_mem_calloc(m_allocator, loopCount, sizeof(EventLoopInstrumentation)));
+                if (m_instrumentation->loops == nullptr)
+                {
+                    /* The group works without, its loops just report no statistics */
+                    return;
+                }
+
+                for (size_t i = 0; i < loopCount; ++i)
+                {
+                    auto *loop = new (&m_instrumentation->loops[i]) EventLoopInstrumentation();
+                    loop->eventLoop = aws_event_loop_group_get_loop_at(m_eventLoopGroup, i);
+                    loop->group = m_instrumentation;
+                    aws_task_init(&loop->probeTask, s_LatencyProbeTask, loop, "cpp-crt-event-loop-latency-probe");
+                }
+                m_instrumentation->loopCount = loopCount;
+            }
+
+            EventLoopInstrumentation *EventLoopGroup::GetInstrumentation(aws_event_loop *eventLoop) const noexcept
+            {
+                if (m_instrumentation == nullptr)
+                {
+                    return nullptr;
                 }
+
+                for (size_t i = 0; i < m_instrumentation->loopCount; ++i)
+                {
+                    if (m_instrumentation->loops[i].eventLoop == eventLoop)
+                    {
+                        return &m_instrumentation->loops[i];
+                    }
+                }
+
+                return nullptr;
             }
 
             EventLoopGroup::~EventLoopGroup()
@@ -38,18 +554,25 @@ namespace Aws
             }
 
             EventLoopGroup::EventLoopGroup(EventLoopGroup &&toMove) noexcept
-                : m_eventLoopGroup(toMove.m_eventLoopGroup), m_lastError(toMove.m_lastError)
+                : m_eventLoopGroup(toMove.m_eventLoopGroup), m_instrumentation(toMove.m_instrumentation),
+                  m_allocator(toMove.m_allocator),
+                  m_nextLoopIndex(toMove.m_nextLoopIndex.load()), m_lastError(toMove.m_lastError)
             {
                 toMove.m_lastError = AWS_ERROR_UNKNOWN;
                 toMove.m_eventLoopGroup = nullptr;
+                toMove.m_instrumentation = nullptr;
             }
 
             EventLoopGroup &EventLoopGroup::operator=(EventLoopGroup &&toMove) noexcept
             {
                 m_eventLoopGroup = toMove.m_eventLoopGroup;
+                m_instrumentation = toMove.m_instrumentation;
+                m_allocator = toMove.m_allocator;
+                m_nextLoopIndex = toMove.m_nextLoopIndex.load();
                 m_lastError = toMove.m_lastError;
                 toMove.m_lastError = AWS_ERROR_UNKNOWN;
                 toMove.m_eventLoopGroup = nullptr;
+                toMove.m_instrumentation = nullptr;
 
                 return *this;
             }
@@ -74,6 +597,180 @@ namespace Aws
                 return nullptr;
             }
 
+            size_t EventLoopGroup::GetLoopCount() const noexcept
+            {
+                if (!*this)
+                {
+                    return 0;
+                }
+
+                return aws_event_loop_group_get_loop_count(m_eventLoopGroup);
+            }
+
+            EventLoop EventLoopGroup::GetLoopAt(size_t index) const noexcept
+            {
+                if (index >= GetLoopCount())
+                {
+                    return EventLoop();
+                }
+
+                aws_event_loop *eventLoop = aws_event_loop_group_get_loop_at(m_eventLoopGroup, index);
+                return EventLoop(eventLoop, m_allocator, GetInstrumentation(eventLoop));
+            }
+
+            EventLoop EventLoopGroup::GetNextLoop(LoopSelection selection) noexcept
+            {
+                size_t loopCount = GetLoopCount();
+                if (loopCount == 0)
+                {
+                    return EventLoop();
+                }
+
+                if (selection == LoopSelection::RoundRobin)
+                {
+                    return GetLoopAt(m_nextLoopIndex.fetch_add(1, std::memory_order_relaxed) % loopCount);
+                }
+
+                aws_event_loop *eventLoop = aws_event_loop_group_get_next_loop(m_eventLoopGroup);
+                return EventLoop(eventLoop, m_allocator, GetInstrumentation(eventLoop));
+            }
+
+            EventLoop EventLoopGroup::GetCallersLoop() const noexcept
+            {
+                size_t loopCount = GetLoopCount();
+                for (size_t i = 0; i < loopCount; ++i)
+                {
+                    EventLoop eventLoop = GetLoopAt(i);
+                    if (eventLoop.IsCallersThread())
+                    {
+                        return eventLoop;
+                    }
+                }
+
+                return EventLoop();
+            }
+
+            EventLoop EventLoopGroup::GetLoopNearCaller() noexcept
+            {
+                int32_t callersCpuGroup = s_GetCallersCpuGroup();
+                if (callersCpuGroup >= 0)
+                {
+                    EventLoop nearest;
+                    size_t nearestLoadFactor = SIZE_MAX;
+                    size_t loopCount = GetLoopCount();
+                    for (size_t i = 0; i < loopCount; ++i)
+                    {
+                        EventLoop eventLoop = GetLoopAt(i);
+                        if (eventLoop.GetCpuGroup() != callersCpuGroup)
+                        {
+                            continue;
+                        }
+
+                        size_t loadFactor = eventLoop.GetLoadFactor();
+                        if (!nearest || loadFactor < nearestLoadFactor)
+                        {
+                            nearest = eventLoop;
+                            nearestLoadFactor = loadFactor;
+                        }
+                    }
+
+                    if (nearest)
+                    {
+                        return nearest;
+                    }
+                }
+
+                return GetNextLoop();
+            }
+
+            bool EventLoopGroup::Schedule(EventLoopTask &&task, LoopSelection selection)
+            {
+                return GetNextLoop(selection).Schedule(std::move(task));
+            }
+
+            bool EventLoopGroup::ScheduleAfter(
+                EventLoopTask &&task,
+                std::chrono::nanoseconds delay,
+                LoopSelection selection)
+            {
+                return GetNextLoop(selection).ScheduleAfter(std::move(task), delay);
+            }
+
+            bool EventLoopGroup::Post(EventLoopTask &&task)
+            {
+                EventLoop callersLoop = GetCallersLoop();
+                if (callersLoop)
+                {
+                    return callersLoop.Schedule(std::move(task));
+                }
+
+                return Schedule(std::move(task));
+            }
+
+            Vector<EventLoopStatistics> EventLoopGroup::GetStatistics() const
+            {
+                Vector<EventLoopStatistics> statistics;
+                size_t loopCount = GetLoopCount();
+                statistics.reserve(loopCount);
+                for (size_t i = 0; i < loopCount; ++i)
+                {
+                    statistics.push_back(GetLoopAt(i).GetStatistics());
+                }
+
+                return statistics;
+            }
+
+            void EventLoopGroup::ResetStatistics() noexcept
+            {
+                if (m_instrumentation == nullptr)
+                {
+                    return;
+                }
+
+                for (size_t i = 0; i < m_instrumentation->loopCount; ++i)
+                {
+                    EventLoopInstrumentation &loop = m_instrumentation->loops[i];
+                    loop.tasksScheduled.store(0, std::memory_order_relaxed);
+                    loop.tasksRun.store(0, std::memory_order_relaxed);
+                    loop.tasksCanceled.store(0, std::memory_order_relaxed);
+                    loop.taskLatency.Reset();
+                    loop.probeLatency.Reset();
+                }
+            }
+
+            bool EventLoopGroup::EnableLatencyProbe(std::chrono::milliseconds interval) noexcept
+            {
+                if (m_instrumentation == nullptr || interval.count() <= 0)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return false;
+                }
+
+                uint64_t intervalNanos =
+                    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count());
+                m_instrumentation->probeIntervalNanos.store(intervalNanos);
+
+                for (size_t i = 0; i < m_instrumentation->loopCount; ++i)
+                {
+                    EventLoopInstrumentation *loop = &m_instrumentation->loops[i];
+                    bool expected = false;
+                    if (loop->probeScheduled.compare_exchange_strong(expected, true))
+                    {
+                        s_ScheduleLatencyProbe(loop, intervalNanos);
+                    }
+                }
+
+                return true;
+            }
+
+            void EventLoopGroup::DisableLatencyProbe() noexcept
+            {
+                if (m_instrumentation != nullptr)
+                {
+                    m_instrumentation->probeIntervalNanos.store(0);
+                }
+            }
+
         } // namespace Io
 
     } // namespace Crt
@@ -0,0 +1,325 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/io/FramingHandler.h>
+
+#include <aws/io/io.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            FramingHandlerOptions::FramingHandlerOptions()
+                : Mode(FramingMode::LengthPrefix), LengthPrefixSize(4), Delimiter("\n"), MaxFrameSize(1024 * 1024),
+                  MaxBufferedSize(16 * 1024 * 1024), InitialWindowSize(SIZE_MAX), OnFrameReceivedCallback()
+            {
+            }
+
+            FramingHandler::FramingHandler(const FramingHandlerOptions &options, Allocator *allocator)
+                : ChannelHandler(allocator), m_options(options), m_scannedBytes(0), m_delivering(false),
+                  m_readFailed(false)
+            {
+                AWS_FATAL_ASSERT(
+                    m_options.Mode != FramingMode::LengthPrefix ||
+                    (m_options.LengthPrefixSize >= 1 && m_options.LengthPrefixSize <= 8));
+                AWS_FATAL_ASSERT(m_options.Mode != FramingMode::Delimiter || !m_options.Delimiter.empty());
+                AWS_FATAL_ASSERT(
+                    m_options.MaxBufferedSize >= MessageOverhead() &&
+                    m_options.MaxBufferedSize - MessageOverhead() >= m_options.MaxFrameSize);
+
+                AWS_ZERO_STRUCT(m_readBuffer);
+                m_readBuffer.allocator = allocator;
+            }
+
+            FramingHandler::~FramingHandler() { aws_byte_buf_clean_up(&m_readBuffer); }
+
+            bool FramingHandler::SendFrame(const ByteCursor &payload) { return EncodeFrame(payload, nullptr, nullptr); }
+
+            int FramingHandler::ProcessReadMessage(struct aws_io_message *message)
+            {
+                if (m_readFailed)
+                {
+                    /* The channel is shutting down */
+                    aws_mem_release(message->allocator, message);
+                    return AWS_OP_SUCCESS;
+                }
+
+                /* The upstream window may be far larger than the bound, so a peer can outrun a stalled downstream */
+                ByteCursor data = aws_byte_cursor_from_buf(&message->message_data);
+                size_t room = m_options.MaxBufferedSize - std::min(m_options.MaxBufferedSize, m_readBuffer.len);
+                if (data.len > room)
+                {
+                    aws_mem_release(message->allocator, message);
+                    m_readFailed = true;
+                    ShutDownChannel(AWS_IO_CHANNEL_ERROR_ERROR_CANT_ACCEPT_INPUT);
+                    return AWS_OP_SUCCESS;
+                }
+
+                if (aws_byte_buf_append_dynamic(&m_readBuffer, &data))
+                {
+                    return AWS_OP_ERR;
+                }
+
+                aws_mem_release(message->allocator, message);
+                DeliverFrames();
+                return AWS_OP_SUCCESS;
+            }
+
+            int FramingHandler::ProcessWriteMessage(struct aws_io_message *message)
+            {
+                if (!EncodeFrame(
+                        aws_byte_cursor_from_buf(&message->message_data), message->on_completion, message->user_data))
+                {
+                    return AWS_OP_ERR;
+                }
+
+                aws_mem_release(message->allocator, message);
+                return AWS_OP_SUCCESS;
+            }
+
+            int FramingHandler::IncrementReadWindow(size_t)
+            {
+                /* Upstream is credited as frames are delivered, so a larger downstream window only unblocks them. */
+                DeliverFrames();
+                return AWS_OP_SUCCESS;
+            }
+
+            void FramingHandler::ProcessShutdown(
+                ChannelDirection dir,
+                int errorCode,
+                bool freeScarceResourcesImmediately)
+            {
+                OnShutdownComplete(dir, errorCode, freeScarceResourcesImmediately);
+            }
+
+            size_t FramingHandler::InitialWindowSize() { return m_options.InitialWindowSize; }
+
+            size_t FramingHandler::MessageOverhead()
+            {
+                return m_options.Mode == FramingMode::LengthPrefix ? m_options.LengthPrefixSize
+                                                                   : m_options.Delimiter.size();
+            }
+
+            bool FramingHandler::EncodeFrame(
+                const ByteCursor &payload,
+                aws_channel_on_message_write_completed_fn *onCompletion,
+                void *userData)
+            {
+                size_t overhead = MessageOverhead();
+                ByteCursor trailer;
+                AWS_ZERO_STRUCT(trailer);
+
+                if (m_options.Mode == FramingMode::LengthPrefix)
+                {
+                    if (overhead < sizeof(uint64_t) && (static_cast<uint64_t>(payload.len) >> (overhead * 8)) != 0)
+                    {
+                        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                        return false;
+                    }
+                }
+                else
+                {
+                    trailer = ByteCursorFromString(m_options.Delimiter);
+                }
+
+                struct aws_io_message *message =
+                    AcquireMessageFromPool(MessageType::ApplicationData, payload.len + overhead);
+                if (message == nullptr)
+                {
+                    return false;
+                }
+
+                /* The prefix and as much of the payload as fits go out in the same message. */
+                if (m_options.Mode == FramingMode::LengthPrefix)
+                {
+                    AWS_FATAL_ASSERT(message->message_data.capacity >= overhead);
+                    for (size_t i = 0; i < overhead; ++i)
+                    {
+                        uint64_t shifted = static_cast<uint64_t>(payload.len) >> (8 * (overhead - 1 - i));
+                        aws_byte_buf_write_u8(&message->message_data, static_cast<uint8_t>(shifted));
+                    }
+                }
+
+                ByteCursor remaining = payload;
+                aws_byte_buf_write_to_capacity(&message->message_data, &remaining);
+                if (remaining.len == 0)
+                {
+                    aws_byte_buf_write_to_capacity(&message->message_data, &trailer);
+                }
+
+                bool complete = remaining.len == 0 && trailer.len == 0;
+                if (complete)
+                {
+                    message->on_completion = onCompletion;
+                    message->user_data = userData;
+                }
+
+                if (!SendMessage(message, ChannelDirection::Write))
+                {
+                    aws_mem_release(message->allocator, message);
+                    return false;
+                }
+
+                if (complete)
+                {
+                    return true;
+                }
+
+                if (!SendData(
+                        remaining,
+                        ChannelDirection::Write,
+                        trailer.len == 0 ? onCompletion : nullptr,
+                        trailer.len == 0 ? userData : nullptr))
+                {
+                    return false;
+                }
+
+                return SendData(trailer, ChannelDirection::Write, onCompletion, userData);
+            }
+
+            bool FramingHandler::NextFrame(
+                const ByteCursor &buffered,
+                size_t scanFrom,
+                ByteCursor &frame,
+                size_t &frameSize)
+            {
+                frameSize = 0;
+
+                if (m_options.Mode == FramingMode::LengthPrefix)
+                {
+                    size_t prefixSize = m_options.LengthPrefixSize;
+                    if (buffered.len < prefixSize)
+                    {
+                        return true;
+                    }
+
+                    uint64_t payloadSize = 0;
+                    for (size_t i = 0; i < prefixSize; ++i)
+                    {
+                        payloadSize = (payloadSize << 8) | buffered.ptr[i];
+                    }
+
+                    if (payloadSize > m_options.MaxFrameSize)
+                    {
+                        aws_raise_error(AWS_IO_CHANNEL_ERROR_ERROR_CANT_ACCEPT_INPUT);
+                        return false;
+                    }
+
+                    if (buffered.len - prefixSize < payloadSize)
+                    {
+                        return true;
+                    }
+
+                    frame = aws_byte_cursor_from_array(buffered.ptr + prefixSize, static_cast<size_t>(payloadSize));
+                    frameSize = prefixSize + static_cast<size_t>(payloadSize);
+                    return true;
+                }
+
+                const String &delimiter = m_options.Delimiter;
+                for (size_t offset = scanFrom; offset + delimiter.size() <= buffered.len; ++offset)
+                {
+                    if (memcmp(buffered.ptr + offset, delimiter.data(), delimiter.size()) == 0)
+                    {
+                        frame = aws_byte_cursor_from_array(buffered.ptr, offset);
+                        frameSize = offset + delimiter.size();
+                        break;
+                    }
+                }
+
+                /* Without a complete frame, all but the last few bytes (a possible partial delimiter) are payload. */
+                size_t payloadSize = frameSize > 0                       ? frame.len
+                                     : buffered.len >= delimiter.size() ? buffered.len - delimiter.size() + 1
+                                                                        : 0;
+                if (payloadSize > m_options.MaxFrameSize)
+                {
+                    aws_raise_error(AWS_IO_CHANNEL_ERROR_ERROR_CANT_ACCEPT_INPUT);
+                    return false;
+                }
+
+                return true;
+            }
+
+            void FramingHandler::DeliverFrames()
+            {
+                if (m_delivering || m_readFailed)
+                {
+                    return;
+                }
+                m_delivering = true;
+
+                ByteCursor buffered = aws_byte_cursor_from_buf(&m_readBuffer);
+                size_t scanFrom = m_scannedBytes;
+                size_t delivered = 0;
+                bool incomplete = false;
+                int errorCode = AWS_ERROR_SUCCESS;
+
+                for (;;)
+                {
+                    ByteCursor frame;
+                    AWS_ZERO_STRUCT(frame);
+                    size_t frameSize = 0;
+                    if (!NextFrame(buffered, scanFrom, frame, frameSize))
+                    {
+                        errorCode = aws_last_error();
+                        break;
+                    }
+
+                    if (frameSize == 0)
+                    {
+                        incomplete = true;
+                        break;
+                    }
+
+                    if (m_options.OnFrameReceivedCallback)
+                    {
+                        m_options.OnFrameReceivedCallback(frame);
+                    }
+                    else
+                    {
+                        if (DownstreamReadWindow() < frame.len)
+                        {
+                            break;
+                        }
+
+                        if (!SendData(frame, ChannelDirection::Read))
+                        {
+                            errorCode = aws_last_error();
+                            break;
+                        }
+                    }
+
+                    aws_byte_cursor_advance(&buffered, frameSize);
+                    delivered += frameSize;
+                    scanFrom = 0;
+                }
+
+                /* Remember how far the partial frame was scanned, allowing for a delimiter split across reads. */
+                size_t delimiterSize = m_options.Delimiter.size();
+                m_scannedBytes = incomplete && m_options.Mode == FramingMode::Delimiter && buffered.len >= delimiterSize
+                                     ? buffered.len - delimiterSize + 1
+                                     : 0;
+
+                if (delivered > 0)
+                {
+                    memmove(m_readBuffer.buffer, buffered.ptr, buffered.len);
+                    m_readBuffer.len = buffered.len;
+                    IncrementUpstreamReadWindow(delivered);
+                }
+
+                m_delivering = false;
+
+                if (errorCode != AWS_ERROR_SUCCESS)
+                {
+                    m_readFailed = true;
+                    ShutDownChannel(errorCode);
+                }
+            }
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
@@ -0,0 +1,220 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/io/MetricsHandler.h>
+
+#include <aws/common/array_list.h>
+#include <aws/common/clock.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            /*
+             * Upper bound on the number of idle write completion records a handler keeps around for reuse, so that
+             * steady-state writes do not allocate.
+             */
+            static const size_t s_maxFreeWriteCompletions = 64;
+
+            struct MetricsHandler::WriteCompletion
+            {
+                MetricsHandler *handler;
+                aws_channel_on_message_write_completed_fn *onCompletion;
+                void *userData;
+                uint64_t startNanos;
+                WriteCompletion *next;
+            };
+
+            static uint64_t s_Now()
+            {
+                uint64_t now = 0;
+                aws_high_res_clock_get_ticks(&now);
+                return now;
+            }
+
+            ChannelMetrics::ChannelMetrics() noexcept
+                : bytesRead(0), bytesWritten(0), messagesRead(0), messagesWritten(0), writeCompletionLatency(),
+                  readProcessingLatency()
+            {
+            }
+
+            MetricsHandler::MetricsHandler(Allocator *allocator)
+                : ChannelHandler(allocator), m_bytesRead(0), m_bytesWritten(0), m_messagesRead(0),
+                  m_messagesWritten(0), m_freeWriteCompletions(nullptr), m_freeWriteCompletionCount(0)
+            {
+                AWS_ZERO_STRUCT(m_intervalStatistics);
+                m_intervalStatistics.category = ChannelMetricsStatisticsCategory;
+            }
+
+            MetricsHandler::~MetricsHandler()
+            {
+                while (m_freeWriteCompletions != nullptr)
+                {
+                    WriteCompletion *next = m_freeWriteCompletions->next;
+                    Delete(m_freeWriteCompletions, m_allocator);
+                    m_freeWriteCompletions = next;
+                }
+            }
+
+            ChannelMetrics MetricsHandler::GetMetrics() const noexcept
+            {
+                ChannelMetrics metrics;
+                metrics.bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+                metrics.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+                metrics.messagesRead = m_messagesRead.load(std::memory_order_relaxed);
+                metrics.messagesWritten = m_messagesWritten.load(std::memory_order_relaxed);
+                metrics.writeCompletionLatency = m_writeCompletionLatency.GetSnapshot();
+                metrics.readProcessingLatency = m_readProcessingLatency.GetSnapshot();
+                return metrics;
+            }
+
+            int MetricsHandler::ProcessReadMessage(struct aws_io_message *message)
+            {
+                size_t size = message->message_data.len;
+
+                uint64_t start = s_Now();
+                if (!SendMessage(message, ChannelDirection::Read))
+                {
+                    return AWS_OP_ERR;
+                }
+                m_readProcessingLatency.Record(s_Now() - start);
+
+                m_intervalStatistics.bytesRead += size;
+                ++m_intervalStatistics.messagesRead;
+                m_bytesRead.fetch_add(size, std::memory_order_relaxed);
+                m_messagesRead.fetch_add(1, std::memory_order_relaxed);
+                return AWS_OP_SUCCESS;
+            }
+
+            int MetricsHandler::ProcessWriteMessage(struct aws_io_message *message)
+            {
+                size_t size = message->message_data.len;
+
+                WriteCompletion *completion = AcquireWriteCompletion();
+                if (completion != nullptr)
+                {
+                    completion->onCompletion = message->on_completion;
+                    completion->userData = message->user_data;
+                    completion->startNanos = s_Now();
+                    message->on_completion = s_OnWriteCompleted;
+                    message->user_data = completion;
+                }
+
+                if (!SendMessage(message, ChannelDirection::Write))
+                {
+                    /* The caller keeps ownership of the message: give it back untouched. */
+                    if (completion != nullptr)
+                    {
+                        message->on_completion = completion->onCompletion;
+                        message->user_data = completion->userData;
+                        ReleaseWriteCompletion(completion);
+                    }
+                    return AWS_OP_ERR;
+                }
+
+                m_intervalStatistics.bytesWritten += size;
+                ++m_intervalStatistics.messagesWritten;
+                m_bytesWritten.fetch_add(size, std::memory_order_relaxed);
+                m_messagesWritten.fetch_add(1, std::memory_order_relaxed);
+                return AWS_OP_SUCCESS;
+            }
+
+            int MetricsHandler::IncrementReadWindow(size_t size)
+            {
+                return IncrementUpstreamReadWindow(size) ? AWS_OP_SUCCESS : AWS_OP_ERR;
+            }
+
+            void MetricsHandler::ProcessShutdown(
+                ChannelDirection dir,
+                int errorCode,
+                bool freeScarceResourcesImmediately)
+            {
+                OnShutdownComplete(dir, errorCode, freeScarceResourcesImmediately);
+            }
+
+            size_t MetricsHandler::InitialWindowSize()
+            {
+                /* Window updates are passed straight through, so this handler never holds data back. */
+                return SIZE_MAX;
+            }
+
+            size_t MetricsHandler::MessageOverhead() { return 0; }
+
+            void MetricsHandler::ResetStatistics()
+            {
+                m_intervalStatistics.bytesRead = 0;
+                m_intervalStatistics.bytesWritten = 0;
+                m_intervalStatistics.messagesRead = 0;
+                m_intervalStatistics.messagesWritten = 0;
+            }
+
+            void MetricsHandler::GatherStatistics(struct aws_array_list *statsList)
+            {
+                void *statistics = &m_intervalStatistics;
+                aws_array_list_push_back(statsList, &statistics);
+            }
+
+            MetricsHandler::WriteCompletion *MetricsHandler::AcquireWriteCompletion()
+            {
+                WriteCompletion *completion = m_freeWriteCompletions;
+                if (completion != nullptr)
+                {
+                    m_freeWriteCompletions = completion->next;
+                    --m_freeWriteCompletionCount;
+                }
+                else
+                {
+                    completion = New<WriteCompletion>(m_allocator);
+                    if (completion == nullptr)
+                    {
+                        return nullptr;
+                    }
+                }
+
+                completion->handler = this;
+                completion->next = nullptr;
+                return completion;
+            }
+
+            void MetricsHandler::ReleaseWriteCompletion(WriteCompletion *completion)
+            {
+                if (m_freeWriteCompletionCount >= s_maxFreeWriteCompletions)
+                {
+                    Delete(completion, m_allocator);
+                    return;
+                }
+
+                completion->next = m_freeWriteCompletions;
+                m_freeWriteCompletions = completion;
+                ++m_freeWriteCompletionCount;
+            }
+
+            void MetricsHandler::s_OnWriteCompleted(
+                struct aws_channel *channel,
+                struct aws_io_message *message,
+                int errorCode,
+                void *userData)
+            {
+                auto *completion = reinterpret_cast<WriteCompletion *>(userData);
+                MetricsHandler *handler = completion->handler;
+
+                if (errorCode == AWS_ERROR_SUCCESS)
+                {
+                    handler->m_writeCompletionLatency.Record(s_Now() - completion->startNanos);
+                }
+
+                aws_channel_on_message_write_completed_fn *onCompletion = completion->onCompletion;
+                void *originalUserData = completion->userData;
+                handler->ReleaseWriteCompletion(completion);
+
+                if (onCompletion != nullptr)
+                {
+                    onCompletion(channel, message, errorCode, originalUserData);
+                }
+            }
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
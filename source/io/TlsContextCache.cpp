@@ -0,0 +1,150 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/io/TlsContextCache.h>
+
+#include <aws/crt/crypto/Hash.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            TlsContextCacheStatistics::TlsContextCacheStatistics() noexcept : hits(0), misses(0), uncacheable(0) {}
+
+            TlsContextCache::TlsContextCache(Allocator *allocator) noexcept
+                : m_allocator(allocator),
+                  m_entries(
+                      std::less<String>(),
+                      StlAllocator<std::pair<const String, std::weak_ptr<aws_tls_ctx>>>(allocator))
+            {
+            }
+
+            TlsContextCache::~TlsContextCache() = default;
+
+            TlsContext TlsContextCache::GetOrCreate(TlsContextOptions &options, TlsMode mode) noexcept
+            {
+                String key(StlAllocator<char>(m_allocator));
+                if (!s_ComputeKey(options, mode, key))
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(m_lock);
+                        ++m_statistics.uncacheable;
+                    }
+                    return TlsContext(options, mode, m_allocator);
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    auto found = m_entries.find(key);
+                    if (found != m_entries.end())
+                    {
+                        std::shared_ptr<aws_tls_ctx> ctx = found->second.lock();
+                        if (ctx)
+                        {
+                            ++m_statistics.hits;
+                            return TlsContext(std::move(ctx));
+                        }
+                    }
+                }
+
+                /* Loading certificates can be slow: build outside the lock, a concurrent build of the same
+                 * configuration may win the race below and is used instead. */
+                TlsContext context(options, mode, m_allocator);
+                if (!context)
+                {
+                    return context;
+                }
+
+                std::lock_guard<std::mutex> lock(m_lock);
+                ++m_statistics.misses;
+                PurgeExpired();
+
+                std::weak_ptr<aws_tls_ctx> &entry = m_entries[key];
+                std::shared_ptr<aws_tls_ctx> raced = entry.lock();
+                if (raced)
+                {
+                    return TlsContext(std::move(raced));
+                }
+
+                entry = context.m_ctx;
+                return context;
+            }
+
+            size_t TlsContextCache::Size() const noexcept
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                size_t size = 0;
+                for (const auto &entry : m_entries)
+                {
+                    if (!entry.second.expired())
+                    {
+                        ++size;
+                    }
+                }
+
+                return size;
+            }
+
+            TlsContextCacheStatistics TlsContextCache::GetStatistics() const noexcept
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_statistics;
+            }
+
+            bool TlsContextCache::s_ComputeKey(const TlsContextOptions &options, TlsMode mode, String &key) noexcept
+            {
+                if (!options.m_isInit || !options.m_cacheable)
+                {
+                    return false;
+                }
+
+                Crypto::Hash hash = Crypto::Hash::CreateSHA256();
+                if (!hash)
+                {
+                    return false;
+                }
+
+                /* m_fingerprint is ordered by input name, so the order the options were set in does not matter. */
+                String canonical(mode == TlsMode::CLIENT ? "client" : "server");
+                for (const auto &input : options.m_fingerprint)
+                {
+                    canonical.push_back('\n');
+                    canonical.append(input.first);
+                    canonical.push_back('=');
+                    canonical.append(std::to_string(input.second.size()).c_str());
+                    canonical.push_back(':');
+                    canonical.append(input.second);
+                }
+
+                bool hashed = hash.Update(ByteCursorFromString(canonical));
+                uint8_t digest[Crypto::SHA256_DIGEST_SIZE];
+                ByteBuf digestBuf = aws_byte_buf_from_empty_array(digest, sizeof(digest));
+                if (!hashed || !hash.Digest(digestBuf))
+                {
+                    return false;
+                }
+
+                key.assign(reinterpret_cast<const char *>(digest), digestBuf.len);
+                return true;
+            }
+
+            void TlsContextCache::PurgeExpired() noexcept
+            {
+                for (auto entry = m_entries.begin(); entry != m_entries.end();)
+                {
+                    if (entry->second.expired())
+                    {
+                        entry = m_entries.erase(entry);
+                    }
+                    else
+                    {
+                        ++entry;
+                    }
+                }
+            }
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
@@ -7,6 +7,7 @@
 #include <aws/crt/io/Pkcs11.h>
 
 #include <aws/crt/Api.h>
+#include <aws/crt/crypto/Hash.h>
 #include <aws/io/logging.h>
 #include <aws/io/tls_channel_handler.h>
 
@@ -24,12 +25,13 @@ namespace Aws
                 }
             }
 
-            TlsContextOptions::TlsContextOptions() noexcept : m_isInit(false)
+            TlsContextOptions::TlsContextOptions() noexcept : m_cacheable(true), m_isInit(false)
             {
                 AWS_ZERO_STRUCT(m_options);
             }
 
             TlsContextOptions::TlsContextOptions(TlsContextOptions &&other) noexcept
+                : m_fingerprint(std::move(other.m_fingerprint)), m_cacheable(other.m_cacheable)
             {
                 m_options = other.m_options;
                 m_isInit = other.m_isInit;
@@ -47,6 +49,8 @@ namespace Aws
                     }
 
                     m_options = other.m_options;
+                    m_fingerprint = std::move(other.m_fingerprint);
+                    m_cacheable = other.m_cacheable;
                     m_isInit = other.m_isInit;
                     AWS_ZERO_STRUCT(other.m_options);
                     other.m_isInit = false;
@@ -60,6 +64,7 @@ namespace Aws
                 TlsContextOptions ctxOptions;
                 aws_tls_ctx_options_init_default_client(&ctxOptions.m_options, allocator);
                 ctxOptions.m_isInit = true;
+                ctxOptions.RecordFingerprint("credentials", {aws_byte_cursor_from_c_str("default-client")}, false);
                 return ctxOptions;
             }
 
@@ -73,6 +78,12 @@ namespace Aws
                         &ctxOptions.m_options, allocator, certPath, pKeyPath))
                 {
                     ctxOptions.m_isInit = true;
+                    ctxOptions.RecordFingerprint(
+                        "credentials",
+                        {aws_byte_cursor_from_c_str("mtls-path"),
+                         aws_byte_cursor_from_c_str(certPath),
+                         aws_byte_cursor_from_c_str(pKeyPath)},
+                        true);
                 }
                 return ctxOptions;
             }
@@ -90,6 +101,8 @@ namespace Aws
                         const_cast<ByteCursor *>(&pkey)))
                 {
                     ctxOptions.m_isInit = true;
+                    ctxOptions.RecordFingerprint(
+                        "credentials", {aws_byte_cursor_from_c_str("mtls"), cert, pkey}, true);
                 }
                 return ctxOptions;
             }
@@ -105,6 +118,9 @@ namespace Aws
                 {
                     ctxOptions.m_isInit = true;
                 }
+
+                /* The private key lives behind a PKCS#11 session, there is no input to tell two setups apart by. */
+                ctxOptions.m_cacheable = false;
                 return ctxOptions;
             }
 
@@ -119,6 +135,10 @@ namespace Aws
                         &ctxOptions.m_options, allocator, pkcs12Path, &password))
                 {
                     ctxOptions.m_isInit = true;
+                    ctxOptions.RecordFingerprint(
+                        "credentials",
+                        {aws_byte_cursor_from_c_str("pkcs12-path"), aws_byte_cursor_from_c_str(pkcs12Path), password},
+                        true);
                 }
                 return ctxOptions;
             }
@@ -126,7 +146,13 @@ namespace Aws
             bool TlsContextOptions::SetKeychainPath(ByteCursor &keychain_path) noexcept
             {
                 AWS_ASSERT(m_isInit);
-                return aws_tls_ctx_options_set_keychain_path(&m_options, &keychain_path) == 0;
+                if (aws_tls_ctx_options_set_keychain_path(&m_options, &keychain_path))
+                {
+                    return false;
+                }
+
+                RecordFingerprint("keychain", {keychain_path}, true);
+                return true;
             }
 
             TlsContextOptions TlsContextOptions::InitClientWithMtlsSystemPath(
@@ -138,6 +164,10 @@ namespace Aws
                         &ctxOptions.m_options, allocator, windowsCertStorePath))
                 {
                     ctxOptions.m_isInit = true;
+                    ctxOptions.RecordFingerprint(
+                        "credentials",
+                        {aws_byte_cursor_from_c_str("system-path"), aws_byte_cursor_from_c_str(windowsCertStorePath)},
+                        true);
                 }
                 return ctxOptions;
             }
@@ -155,37 +185,111 @@ namespace Aws
             bool TlsContextOptions::SetAlpnList(const char *alpn_list) noexcept
             {
                 AWS_ASSERT(m_isInit);
-                return aws_tls_ctx_options_set_alpn_list(&m_options, alpn_list) == 0;
+                if (aws_tls_ctx_options_set_alpn_list(&m_options, alpn_list))
+                {
+                    return false;
+                }
+
+                RecordFingerprint("alpn", {aws_byte_cursor_from_c_str(alpn_list)}, false);
+                return true;
             }
 
             void TlsContextOptions::SetVerifyPeer(bool verify_peer) noexcept
             {
                 AWS_ASSERT(m_isInit);
                 aws_tls_ctx_options_set_verify_peer(&m_options, verify_peer);
+                RecordFingerprint("verifyPeer", {aws_byte_cursor_from_c_str(verify_peer ? "1" : "0")}, false);
             }
 
             void TlsContextOptions::SetMinimumTlsVersion(aws_tls_versions minimumTlsVersion)
             {
                 AWS_ASSERT(m_isInit);
                 aws_tls_ctx_options_set_minimum_tls_version(&m_options, minimumTlsVersion);
+                String version = std::to_string(static_cast<int>(minimumTlsVersion)).c_str();
+                RecordFingerprint("minimumTlsVersion", {ByteCursorFromString(version)}, false);
             }
 
             void TlsContextOptions::SetTlsCipherPreference(aws_tls_cipher_pref cipher_pref)
             {
                 AWS_ASSERT(m_isInit);
                 aws_tls_ctx_options_set_tls_cipher_preference(&m_options, cipher_pref);
+                String preference = std::to_string(static_cast<int>(cipher_pref)).c_str();
+                RecordFingerprint("cipherPreference", {ByteCursorFromString(preference)}, false);
             }
 
             bool TlsContextOptions::OverrideDefaultTrustStore(const char *caPath, const char *caFile) noexcept
             {
                 AWS_ASSERT(m_isInit);
-                return aws_tls_ctx_options_override_default_trust_store_from_path(&m_options, caPath, caFile) == 0;
+                if (aws_tls_ctx_options_override_default_trust_store_from_path(&m_options, caPath, caFile))
+                {
+                    return false;
+                }
+
+                RecordFingerprint(
+                    "trustStore",
+                    {aws_byte_cursor_from_c_str("path"),
+                     aws_byte_cursor_from_c_str(caPath != nullptr ? caPath : ""),
+                     aws_byte_cursor_from_c_str(caFile != nullptr ? caFile : "")},
+                    true);
+                return true;
             }
 
             bool TlsContextOptions::OverrideDefaultTrustStore(const ByteCursor &ca) noexcept
             {
                 AWS_ASSERT(m_isInit);
-                return aws_tls_ctx_options_override_default_trust_store(&m_options, const_cast<ByteCursor *>(&ca)) == 0;
+                if (aws_tls_ctx_options_override_default_trust_store(&m_options, const_cast<ByteCursor *>(&ca)))
+                {
+                    return false;
+                }
+
+                RecordFingerprint("trustStore", {aws_byte_cursor_from_c_str("pem"), ca}, true);
+                return true;
+            }
+
+            void TlsContextOptions::RecordFingerprint(
+                const char *name,
+                std::initializer_list<ByteCursor> parts,
+                bool digest) noexcept
+            {
+                String value;
+                if (!digest)
+                {
+                    for (const ByteCursor &part : parts)
+                    {
+                        value.append(reinterpret_cast<const char *>(part.ptr), part.len);
+                        value.push_back('\0');
+                    }
+                }
+                else
+                {
+                    Crypto::Hash hash = Crypto::Hash::CreateSHA256();
+                    bool digested = static_cast<bool>(hash);
+                    for (const ByteCursor &part : parts)
+                    {
+                        /* Length prefixes keep ("ab", "c") and ("a", "bc") apart. */
+                        uint64_t length = part.len;
+                        ByteCursor lengthCursor =
+                            aws_byte_cursor_from_array(reinterpret_cast<const uint8_t *>(&length), sizeof(length));
+                        digested = digested && hash.Update(lengthCursor) && hash.Update(part);
+                    }
+
+                    uint8_t output[Crypto::SHA256_DIGEST_SIZE];
+                    ByteBuf outputBuf = aws_byte_buf_from_empty_array(output, sizeof(output));
+                    if (!digested || !hash.Digest(outputBuf))
+                    {
+                        m_cacheable = false;
+                        return;
+                    }
+
+                    static const char s_hexDigits[] = "0123456789abcdef";
+                    for (size_t i = 0; i < outputBuf.len; ++i)
+                    {
+                        value.push_back(s_hexDigits[output[i] >> 4]);
+                        value.push_back(s_hexDigits[output[i] & 0x0f]);
+                    }
+                }
+
+                m_fingerprint[String(name)] = std::move(value);
             }
 
             TlsContextPkcs11Options::TlsContextPkcs11Options(
@@ -407,6 +511,11 @@ namespace Aws
 
             TlsContext::TlsContext() noexcept : m_ctx(nullptr), m_initializationError(AWS_ERROR_SUCCESS) {}
 
+            TlsContext::TlsContext(std::shared_ptr<aws_tls_ctx> ctx) noexcept
+                : m_ctx(std::move(ctx)), m_initializationError(AWS_ERROR_SUCCESS)
+            {
+            }
+
             TlsContext::TlsContext(TlsContextOptions &options, TlsMode mode, Allocator *allocator) noexcept
                 : m_ctx(nullptr), m_initializationError(AWS_ERROR_SUCCESS)
             {
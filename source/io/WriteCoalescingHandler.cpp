@@ -0,0 +1,358 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/io/WriteCoalescingHandler.h>
+
+#include <algorithm>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Io
+        {
+            /* Upper bound on the number of idle batch records a handler keeps around for reuse. */
+            static const size_t s_maxFreeBatches = 16;
+
+            struct WriteCoalescingHandler::Batch
+            {
+                /* A message packed into the batch, kept to be handed back to its write completion callback */
+                struct PendingCompletion
+                {
+                    struct aws_io_message *message;
+                };
+
+                explicit Batch(Allocator *allocator) : completions(StlAllocator<PendingCompletion>(allocator)) {}
+
+                WriteCoalescingHandler *handler{};
+                Vector<PendingCompletion> completions;
+                Batch *next{};
+            };
+
+            WriteCoalescingOptions::WriteCoalescingOptions() : MaxDelay(0), MaxBytes(0) {}
+
+            WriteCoalescingStatistics::WriteCoalescingStatistics() noexcept : messagesIn(0), messagesOut(0), bytesOut(0)
+            {
+            }
+
+            WriteCoalescingHandler::WriteCoalescingHandler(const WriteCoalescingOptions &options, Allocator *allocator)
+                : ChannelHandler(allocator), m_options(options), m_pending(nullptr), m_pendingBatch(nullptr),
+                  m_pendingLimit(0), m_batchStartNanos(0), m_flushScheduled(false), m_freeBatches(nullptr),
+                  m_freeBatchCount(0), m_messagesIn(0), m_messagesOut(0), m_bytesOut(0)
+            {
+            }
+
+            WriteCoalescingHandler::~WriteCoalescingHandler()
+            {
+                /* The pending batch is flushed when the write direction shuts down, before the channel goes away. */
+                AWS_ASSERT(m_pending == nullptr);
+                if (m_pendingBatch != nullptr)
+                {
+                    for (const Batch::PendingCompletion &completion : m_pendingBatch->completions)
+                    {
+                        aws_mem_release(completion.message->allocator, completion.message);
+                    }
+                    Delete(m_pendingBatch, m_allocator);
+                }
+
+                while (m_freeBatches != nullptr)
+                {
+                    Batch *next = m_freeBatches->next;
+                    Delete(m_freeBatches, m_allocator);
+                    m_freeBatches = next;
+                }
+            }
+
+            WriteCoalescingStatistics WriteCoalescingHandler::GetStatistics() const noexcept
+            {
+                WriteCoalescingStatistics statistics;
+                statistics.messagesIn = m_messagesIn.load(std::memory_order_relaxed);
+                statistics.messagesOut = m_messagesOut.load(std::memory_order_relaxed);
+                statistics.bytesOut = m_bytesOut.load(std::memory_order_relaxed);
+                return statistics;
+            }
+
+            int WriteCoalescingHandler::ProcessReadMessage(struct aws_io_message *message)
+            {
+                return SendMessage(message, ChannelDirection::Read) ? AWS_OP_SUCCESS : AWS_OP_ERR;
+            }
+
+            int WriteCoalescingHandler::ProcessWriteMessage(struct aws_io_message *message)
+            {
+                m_messagesIn.fetch_add(1, std::memory_order_relaxed);
+                size_t size = message->message_data.len;
+
+                if (m_pending != nullptr && m_pending->message_data.len + size > m_pendingLimit)
+                {
+                    if (!Flush())
+                    {
+                        return AWS_OP_ERR;
+                    }
+                }
+
+                if (m_pending == nullptr)
+                {
+                    /* Big writes gain nothing from batching: keep them in their own message. */
+                    if (size >= BatchLimit())
+                    {
+                        return SendPassthrough(message) ? AWS_OP_SUCCESS : AWS_OP_ERR;
+                    }
+
+                    if (!StartBatch())
+                    {
+                        return AWS_OP_ERR;
+                    }
+                }
+
+                ByteCursor data = aws_byte_cursor_from_buf(&message->message_data);
+                if (!aws_byte_buf_write_from_whole_cursor(&m_pending->message_data, data))
+                {
+                    /* Only a write larger than the message the batch got does not fit, which leaves it empty. */
+                    return SendPassthrough(message) ? AWS_OP_SUCCESS : AWS_OP_ERR;
+                }
+
+                if (message->on_completion != nullptr)
+                {
+                    m_pendingBatch->completions.push_back({message});
+                }
+                else
+                {
+                    aws_mem_release(message->allocator, message);
+                }
+
+                /*
+                 * The message is ours from here on. A failed flush has already completed it and shut the channel
+                 * down, so it is not reported to the caller, which would release and complete it again.
+                 */
+                if (m_pending->message_data.len >= m_pendingLimit)
+                {
+                    Flush();
+                    return AWS_OP_SUCCESS;
+                }
+
+                if (!m_flushScheduled)
+                {
+                    ScheduleFlush(static_cast<uint64_t>(m_options.MaxDelay.count()));
+                }
+
+                return AWS_OP_SUCCESS;
+            }
+
+            int WriteCoalescingHandler::IncrementReadWindow(size_t size)
+            {
+                return IncrementUpstreamReadWindow(size) ? AWS_OP_SUCCESS : AWS_OP_ERR;
+            }
+
+            void WriteCoalescingHandler::ProcessShutdown(
+                ChannelDirection dir,
+                int errorCode,
+                bool freeScarceResourcesImmediately)
+            {
+                if (dir == ChannelDirection::Write)
+                {
+                    /* The handlers to the left still accept writes at this point. */
+                    Flush();
+
+                    if (m_pending != nullptr)
+                    {
+                        aws_mem_release(m_pending->allocator, m_pending);
+                        m_pending = nullptr;
+                    }
+
+                    /* Whatever could not be sent completes with the shutdown error. */
+                    if (m_pendingBatch != nullptr)
+                    {
+                        s_OnBatchWritten(
+                            GetSlot()->channel,
+                            nullptr,
+                            errorCode != AWS_ERROR_SUCCESS ? errorCode : AWS_IO_CHANNEL_ERROR_ERROR_CANT_ACCEPT_INPUT,
+                            m_pendingBatch);
+                        m_pendingBatch = nullptr;
+                    }
+                }
+
+                OnShutdownComplete(dir, errorCode, freeScarceResourcesImmediately);
+            }
+
+            size_t WriteCoalescingHandler::InitialWindowSize()
+            {
+                /* Window updates are passed straight through, so this handler never holds data back. */
+                return SIZE_MAX;
+            }
+
+            size_t WriteCoalescingHandler::MessageOverhead() { return 0; }
+
+            bool WriteCoalescingHandler::Flush()
+            {
+                if (m_pending == nullptr || m_pending->message_data.len == 0)
+                {
+                    return true;
+                }
+
+                struct aws_io_message *message = m_pending;
+                Batch *batch = m_pendingBatch;
+                m_pending = nullptr;
+                m_pendingBatch = nullptr;
+
+                message->on_completion = s_OnBatchWritten;
+                message->user_data = batch;
+
+                size_t size = message->message_data.len;
+                if (!SendMessage(message, ChannelDirection::Write))
+                {
+                    int errorCode = aws_last_error();
+                    s_OnBatchWritten(GetSlot()->channel, message, errorCode, batch);
+                    aws_mem_release(message->allocator, message);
+                    ShutDownChannel(errorCode);
+                    return false;
+                }
+
+                m_messagesOut.fetch_add(1, std::memory_order_relaxed);
+                m_bytesOut.fetch_add(size, std::memory_order_relaxed);
+                return true;
+            }
+
+            size_t WriteCoalescingHandler::BatchLimit() const
+            {
+                /* The size AcquireMaxSizeMessageForWrite() would give, without acquiring a message */
+                size_t overhead = aws_channel_slot_upstream_message_overhead(GetSlot());
+                size_t limit =
+                    overhead < g_aws_channel_max_fragment_size ? g_aws_channel_max_fragment_size - overhead : 0;
+                return m_options.MaxBytes > 0 ? std::min(limit, m_options.MaxBytes) : limit;
+            }
+
+            bool WriteCoalescingHandler::StartBatch()
+            {
+                m_pending = AcquireMaxSizeMessageForWrite();
+                if (m_pending == nullptr)
+                {
+                    return false;
+                }
+
+                m_pendingBatch = AcquireBatch();
+                if (m_pendingBatch == nullptr)
+                {
+                    aws_mem_release(m_pending->allocator, m_pending);
+                    m_pending = nullptr;
+                    return false;
+                }
+
+                m_pendingLimit = std::min(m_pending->message_data.capacity, BatchLimit());
+
+                aws_channel_current_clock_time(GetSlot()->channel, &m_batchStartNanos);
+                return true;
+            }
+
+            bool WriteCoalescingHandler::SendPassthrough(struct aws_io_message *message)
+            {
+                size_t size = message->message_data.len;
+                if (!SendMessage(message, ChannelDirection::Write))
+                {
+                    return false;
+                }
+
+                m_messagesOut.fetch_add(1, std::memory_order_relaxed);
+                m_bytesOut.fetch_add(size, std::memory_order_relaxed);
+                return true;
+            }
+
+            void WriteCoalescingHandler::ScheduleFlush(uint64_t delayNanos)
+            {
+                m_flushScheduled = true;
+                auto onTimer = [this](TaskStatus status)
+                {
+                    if (status == TaskStatus::RunReady)
+                    {
+                        OnFlushTimer();
+                    }
+                };
+
+                if (delayNanos == 0)
+                {
+                    ScheduleTask(onTimer);
+                }
+                else
+                {
+                    ScheduleTask(onTimer, std::chrono::nanoseconds(delayNanos));
+                }
+            }
+
+            void WriteCoalescingHandler::OnFlushTimer()
+            {
+                m_flushScheduled = false;
+                if (m_pending == nullptr)
+                {
+                    return;
+                }
+
+                /* The batch that armed the timer may have been sent already: give the current one its full delay. */
+                uint64_t now = 0;
+                aws_channel_current_clock_time(GetSlot()->channel, &now);
+                uint64_t dueAt = m_batchStartNanos + static_cast<uint64_t>(m_options.MaxDelay.count());
+                if (now < dueAt)
+                {
+                    ScheduleFlush(dueAt - now);
+                    return;
+                }
+
+                Flush();
+            }
+
+            WriteCoalescingHandler::Batch *WriteCoalescingHandler::AcquireBatch()
+            {
+                Batch *batch = m_freeBatches;
+                if (batch != nullptr)
+                {
+                    m_freeBatches = batch->next;
+                    --m_freeBatchCount;
+                }
+                else
+                {
+                    batch = New<Batch>(m_allocator, m_allocator);
+                    if (batch == nullptr)
+                    {
+                        return nullptr;
+                    }
+                }
+
+                batch->handler = this;
+                batch->next = nullptr;
+                return batch;
+            }
+
+            void WriteCoalescingHandler::ReleaseBatch(Batch *batch)
+            {
+                batch->completions.clear();
+                if (m_freeBatchCount >= s_maxFreeBatches)
+                {
+                    Delete(batch, m_allocator);
+                    return;
+                }
+
+                batch->next = m_freeBatches;
+                m_freeBatches = batch;
+                ++m_freeBatchCount;
+            }
+
+            void WriteCoalescingHandler::s_OnBatchWritten(
+                struct aws_channel *channel,
+                struct aws_io_message *message,
+                int errorCode,
+                void *userData)
+            {
+                auto *batch = reinterpret_cast<Batch *>(userData);
+                (void)message;
+                for (const Batch::PendingCompletion &completion : batch->completions)
+                {
+                    /* Each writer gets back the message it wrote, as if it had been sent on its own. */
+                    struct aws_io_message *written = completion.message;
+                    written->on_completion(channel, written, errorCode, written->user_data);
+                    aws_mem_release(written->allocator, written);
+                }
+
+                batch->handler->ReleaseBatch(batch);
+            }
+        } // namespace Io
+    } // namespace Crt
+} // namespace Aws
@@ -0,0 +1,468 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/iot/Mqtt5ShadowClient.h>
+
+#include <aws/crt/Api.h>
+
+#include <cstring>
+
+namespace Aws
+{
+    namespace Iot
+    {
+        static const char *s_deltaSuffix = "update/delta";
+        static const char *s_getAcceptedSuffix = "get/accepted";
+        static const char *s_getRejectedSuffix = "get/rejected";
+        static const char *s_updateRejectedSuffix = "update/rejected";
+
+        Mqtt5ShadowClientMetrics::Mqtt5ShadowClientMetrics() noexcept
+            : deltasApplied(0), staleDeltasDropped(0), reportedUpdates(0), reportedPublishes(0),
+              reportedPublishFailures(0)
+        {
+        }
+
+        Mqtt5ShadowClientOptions::Mqtt5ShadowClientOptions(Crt::Allocator *allocator) noexcept
+            : m_allocator(allocator), m_thingName(Crt::StlAllocator<char>(allocator)),
+              m_reportedCoalescingDelayMs(0), m_eventLoopGroup(nullptr)
+        {
+        }
+
+        Mqtt5ShadowClientOptions &Mqtt5ShadowClientOptions::WithThingName(const Crt::String &thingName) noexcept
+        {
+            m_thingName = thingName;
+            return *this;
+        }
+
+        Mqtt5ShadowClientOptions &Mqtt5ShadowClientOptions::WithShadowName(const Crt::String &shadowName) noexcept
+        {
+            m_shadowName = shadowName;
+            return *this;
+        }
+
+        Mqtt5ShadowClientOptions &Mqtt5ShadowClientOptions::WithReportedCoalescingDelayMs(uint32_t delayMs) noexcept
+        {
+            m_reportedCoalescingDelayMs = delayMs;
+            return *this;
+        }
+
+        Mqtt5ShadowClientOptions &Mqtt5ShadowClientOptions::WithEventLoopGroup(
+            Crt::Io::EventLoopGroup *eventLoopGroup) noexcept
+        {
+            m_eventLoopGroup = eventLoopGroup;
+            return *this;
+        }
+
+        Mqtt5ShadowClientOptions &Mqtt5ShadowClientOptions::WithDocumentCallback(
+            OnShadowDocumentHandler callback) noexcept
+        {
+            m_onDocument = std::move(callback);
+            return *this;
+        }
+
+        Mqtt5ShadowClientOptions &Mqtt5ShadowClientOptions::WithDeltaCallback(OnShadowDeltaHandler callback) noexcept
+        {
+            m_onDelta = std::move(callback);
+            return *this;
+        }
+
+        Mqtt5ShadowClientOptions &Mqtt5ShadowClientOptions::WithRejectedCallback(
+            OnShadowRejectedHandler callback) noexcept
+        {
+            m_onRejected = std::move(callback);
+            return *this;
+        }
+
+        Mqtt5ShadowClientOptions &Mqtt5ShadowClientOptions::WithReportedPublishedCallback(
+            OnShadowReportedPublishedHandler callback) noexcept
+        {
+            m_onReportedPublished = std::move(callback);
+            return *this;
+        }
+
+        static std::shared_ptr<const Crt::Mqtt5::PublishTemplate> s_NewRequestTemplate(
+            const Crt::String &topic,
+            Crt::Allocator *allocator)
+        {
+            Crt::Mqtt5::PublishPacket fields(
+                topic, Crt::ByteCursor(), Crt::Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator);
+            return Crt::Mqtt5::PublishTemplate::NewPublishTemplate(fields, allocator);
+        }
+
+        std::shared_ptr<Mqtt5ShadowClient> Mqtt5ShadowClient::NewMqtt5ShadowClient(
+            std::shared_ptr<Crt::Mqtt5::Mqtt5Client> client,
+            const Mqtt5ShadowClientOptions &options,
+            Crt::Allocator *allocator) noexcept
+        {
+            if (!client || options.m_thingName.empty() || (options.m_shadowName && options.m_shadowName->empty()))
+            {
+                aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                return nullptr;
+            }
+
+            Mqtt5ShadowClient *toSeat =
+                reinterpret_cast<Mqtt5ShadowClient *>(aws_mem_acquire(allocator, sizeof(Mqtt5ShadowClient)));
+            if (toSeat == nullptr)
+            {
+                return nullptr;
+            }
+
+            toSeat = new (toSeat) Mqtt5ShadowClient(std::move(client), options, allocator);
+            std::shared_ptr<Mqtt5ShadowClient> shadowClient(
+                toSeat, [allocator](Mqtt5ShadowClient *shadow) { Crt::Delete(shadow, allocator); });
+            if (!shadowClient->m_getTemplate || !shadowClient->m_updateTemplate)
+            {
+                return nullptr;
+            }
+            return shadowClient;
+        }
+
+        Mqtt5ShadowClient::Mqtt5ShadowClient(
+            std::shared_ptr<Crt::Mqtt5::Mqtt5Client> &&client,
+            const Mqtt5ShadowClientOptions &options,
+            Crt::Allocator *allocator) noexcept
+            : m_allocator(allocator), m_client(std::move(client)),
+              m_reportedCoalescingDelayMs(options.m_reportedCoalescingDelayMs),
+              m_eventLoopGroup(options.m_eventLoopGroup), m_onDocument(options.m_onDocument),
+              m_onDelta(options.m_onDelta), m_onRejected(options.m_onRejected),
+              m_onReportedPublished(options.m_onReportedPublished), m_topicPrefix(Crt::StlAllocator<char>(allocator)),
+              m_version(0), m_hasPendingReported(false), m_hasInFlightReported(false), m_flushScheduled(false),
+              m_closed(false)
+        {
+            if (m_eventLoopGroup == nullptr)
+            {
+                m_eventLoopGroup = Crt::ApiHandle::GetOrCreateStaticDefaultEventLoopGroup();
+            }
+
+            m_topicPrefix = "$aws/things/" + options.m_thingName + "/shadow/";
+            if (options.m_shadowName)
+            {
+                m_topicPrefix += "name/" + *options.m_shadowName + "/";
+            }
+
+            m_getTemplate = s_NewRequestTemplate(m_topicPrefix + "get", allocator);
+            m_updateTemplate = s_NewRequestTemplate(m_topicPrefix + "update", allocator);
+        }
+
+        Mqtt5ShadowClient::~Mqtt5ShadowClient() {}
+
+        bool Mqtt5ShadowClient::Subscribe(Crt::Mqtt5::OnSubscribeCompletionHandler onSubscribeCompletion) noexcept
+        {
+            auto subscribePacket = Crt::MakeShared<Crt::Mqtt5::SubscribePacket>(m_allocator, m_allocator);
+            if (!subscribePacket)
+            {
+                return false;
+            }
+
+            for (const char *suffix : {s_deltaSuffix, s_getAcceptedSuffix, s_getRejectedSuffix, s_updateRejectedSuffix})
+            {
+                subscribePacket->WithSubscription(Crt::Mqtt5::Subscription(
+                    m_topicPrefix + suffix, Crt::Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, m_allocator));
+            }
+            return m_client->Subscribe(subscribePacket, std::move(onSubscribeCompletion));
+        }
+
+        bool Mqtt5ShadowClient::RequestDocument(Crt::Mqtt5::OnPublishCompletionHandler onPublishCompletion) noexcept
+        {
+            return m_client->Publish(m_getTemplate, Crt::ByteCursorFromCString("{}"), std::move(onPublishCompletion));
+        }
+
+        bool Mqtt5ShadowClient::OnPublishReceived(const Crt::Mqtt5::PublishReceivedEventData &eventData) noexcept
+        {
+            if (!eventData.publishPacket)
+            {
+                return false;
+            }
+
+            /* Matched against the prefix built once and constant suffixes, without building any topic */
+            const Crt::String &topic = eventData.publishPacket->getTopic();
+            if (topic.size() <= m_topicPrefix.size() || topic.compare(0, m_topicPrefix.size(), m_topicPrefix) != 0)
+            {
+                return false;
+            }
+
+            const char *suffix = topic.c_str() + m_topicPrefix.size();
+            bool isDelta = strcmp(suffix, s_deltaSuffix) == 0;
+            bool isDocument = !isDelta && strcmp(suffix, s_getAcceptedSuffix) == 0;
+            bool isGetRejected = !isDelta && !isDocument && strcmp(suffix, s_getRejectedSuffix) == 0;
+            bool isUpdateRejected =
+                !isDelta && !isDocument && !isGetRejected && strcmp(suffix, s_updateRejectedSuffix) == 0;
+            if (!isDelta && !isDocument && !isGetRejected && !isUpdateRejected)
+            {
+                return false;
+            }
+
+            Crt::JsonObject message(eventData.publishPacket->getPayload());
+            if (!message.WasParseSuccessful())
+            {
+                AWS_LOGF_ERROR(
+                    AWS_LS_MQTT5_CLIENT, "Shadow client: dropping a message with invalid JSON on %s.", topic.c_str());
+                return true;
+            }
+
+            Crt::JsonView view = message.View();
+            if (isDelta)
+            {
+                OnDelta(view);
+            }
+            else if (isDocument)
+            {
+                OnDocument(view);
+            }
+            else
+            {
+                OnRejected(isGetRejected ? ShadowOperation::Get : ShadowOperation::Update, view);
+            }
+            return true;
+        }
+
+        void Mqtt5ShadowClient::OnDelta(const Crt::JsonView &message) noexcept
+        {
+            int64_t version = message.GetInt64("version");
+            Crt::JsonView delta = message.GetJsonObject("state");
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (version <= m_version)
+                {
+                    ++m_metrics.staleDeltasDropped;
+                    return;
+                }
+
+                m_desired.MergePatch(delta);
+                m_version = version;
+                ++m_metrics.deltasApplied;
+            }
+
+            if (m_onDelta)
+            {
+                m_onDelta(delta, version);
+            }
+        }
+
+        void Mqtt5ShadowClient::OnDocument(const Crt::JsonView &message) noexcept
+        {
+            int64_t version = message.GetInt64("version");
+            Crt::JsonView state = message.GetJsonObject("state");
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (version < m_version)
+                {
+                    /* Deltas newer than the document were applied already */
+                    return;
+                }
+
+                m_desired = state.GetJsonObject("desired").Materialize();
+                m_reported = state.GetJsonObject("reported").Materialize();
+
+                /* Updates not published yet still apply on top of the document */
+                if (m_hasInFlightReported)
+                {
+                    m_reported.MergePatch(m_inFlightReported.View());
+                }
+                if (m_hasPendingReported)
+                {
+                    m_reported.MergePatch(m_pendingReported.View());
+                }
+                m_version = version;
+            }
+
+            if (m_onDocument)
+            {
+                m_onDocument(state, version);
+            }
+        }
+
+        void Mqtt5ShadowClient::OnRejected(ShadowOperation operation, const Crt::JsonView &message) noexcept
+        {
+            if (m_onRejected)
+            {
+                m_onRejected(operation, message.GetInteger("code"), message.GetString("message"));
+            }
+        }
+
+        bool Mqtt5ShadowClient::UpdateReported(const Crt::JsonView &reported) noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (m_closed)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_STATE);
+                    return false;
+                }
+
+                m_pendingReported.MergePatch(reported, true);
+                m_hasPendingReported = true;
+                ++m_metrics.reportedUpdates;
+                if (m_reportedCoalescingDelayMs > 0)
+                {
+                    if (m_flushScheduled)
+                    {
+                        return true;
+                    }
+                    m_flushScheduled = true;
+                }
+            }
+
+            if (m_reportedCoalescingDelayMs > 0 && ScheduleFlush())
+            {
+                return true;
+            }
+            return FlushReported();
+        }
+
+        bool Mqtt5ShadowClient::ScheduleFlush() noexcept
+        {
+            std::weak_ptr<Mqtt5ShadowClient> weakSelf = shared_from_this();
+            bool scheduled = m_eventLoopGroup->ScheduleAfter(
+                [weakSelf](Crt::Io::TaskStatus)
+                {
+                    auto self = weakSelf.lock();
+                    if (!self)
+                    {
+                        return;
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> lock(self->m_lock);
+                        self->m_flushScheduled = false;
+                    }
+                    self->FlushReported();
+                },
+                std::chrono::milliseconds(m_reportedCoalescingDelayMs));
+            if (!scheduled)
+            {
+                AWS_LOGF_ERROR(AWS_LS_MQTT5_CLIENT, "Shadow client: failed to schedule its coalescing timer.");
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_flushScheduled = false;
+            }
+            return scheduled;
+        }
+
+        bool Mqtt5ShadowClient::FlushReported() noexcept
+        {
+            Crt::JsonObject reported;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                /* Pending state waiting for the update in flight goes out when it completes */
+                if (m_closed || !m_hasPendingReported || m_hasInFlightReported)
+                {
+                    return true;
+                }
+
+                m_inFlightReported = std::move(m_pendingReported);
+                m_pendingReported = Crt::JsonObject();
+                m_hasPendingReported = false;
+                m_hasInFlightReported = true;
+                reported = m_inFlightReported;
+            }
+
+            Crt::JsonObject state;
+            state.WithObject("reported", std::move(reported));
+            Crt::JsonObject request;
+            request.WithObject("state", std::move(state));
+            Crt::String payload = request.View().WriteCompact();
+
+            std::weak_ptr<Mqtt5ShadowClient> weakSelf = shared_from_this();
+            if (!m_client->Publish(
+                    m_updateTemplate,
+                    Crt::ByteCursorFromString(payload),
+                    [weakSelf](int errorCode, std::shared_ptr<Crt::Mqtt5::PublishResult>)
+                    {
+                        auto self = weakSelf.lock();
+                        if (self)
+                        {
+                            self->OnReportedPublished(errorCode);
+                        }
+                    }))
+            {
+                int errorCode = aws_last_error();
+                CompleteReportedPublish(errorCode);
+                aws_raise_error(errorCode);
+                return false;
+            }
+            return true;
+        }
+
+        bool Mqtt5ShadowClient::CompleteReportedPublish(int errorCode) noexcept
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_hasInFlightReported = false;
+            if (errorCode == AWS_ERROR_SUCCESS)
+            {
+                m_reported.MergePatch(m_inFlightReported.View());
+                m_inFlightReported = Crt::JsonObject();
+                ++m_metrics.reportedPublishes;
+                return !m_closed && m_hasPendingReported && !m_flushScheduled;
+            }
+
+            ++m_metrics.reportedPublishFailures;
+            if (!m_closed)
+            {
+                /* Updates made since the failed request are newer, so they go on top of it */
+                if (m_hasPendingReported)
+                {
+                    m_inFlightReported.MergePatch(m_pendingReported.View(), true);
+                }
+                m_pendingReported = std::move(m_inFlightReported);
+                m_hasPendingReported = true;
+            }
+            m_inFlightReported = Crt::JsonObject();
+            return false;
+        }
+
+        void Mqtt5ShadowClient::OnReportedPublished(int errorCode) noexcept
+        {
+            if (errorCode != AWS_ERROR_SUCCESS)
+            {
+                AWS_LOGF_ERROR(
+                    AWS_LS_MQTT5_CLIENT,
+                    "Shadow client: update request failed with error %d (%s), its reported state is pending again.",
+                    errorCode,
+                    aws_error_debug_str(errorCode));
+            }
+
+            bool flush = CompleteReportedPublish(errorCode);
+            if (m_onReportedPublished)
+            {
+                m_onReportedPublished(errorCode);
+            }
+            if (flush)
+            {
+                FlushReported();
+            }
+        }
+
+        Crt::JsonObject Mqtt5ShadowClient::GetDesired() const
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_desired;
+        }
+
+        Crt::JsonObject Mqtt5ShadowClient::GetReported() const
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_reported;
+        }
+
+        int64_t Mqtt5ShadowClient::GetVersion() const noexcept
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_version;
+        }
+
+        Mqtt5ShadowClientMetrics Mqtt5ShadowClient::GetMetrics() const noexcept
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_metrics;
+        }
+
+        void Mqtt5ShadowClient::Close() noexcept
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_closed = true;
+            m_pendingReported = Crt::JsonObject();
+            m_hasPendingReported = false;
+        }
+    } // namespace Iot
+} // namespace Aws
@@ -0,0 +1,70 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/mqtt/private/Mqtt5CallbackGate.h>
+
+#include <mutex>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            /* Innermost scope of the calling thread, so that Close() does not wait on the scopes it runs in */
+            static thread_local const Mqtt5CallbackGate::Scope *s_innermostScope = nullptr;
+
+            /* Highest bit of the state of a gate, set once it is closed; the rest counts the scopes in flight */
+            static const size_t s_closedFlag = ~(~static_cast<size_t>(0) >> 1);
+
+            Mqtt5CallbackGate::Scope::Scope(Mqtt5CallbackGate &gate) noexcept
+                : m_gate(gate), m_outer(s_innermostScope), m_admitted(false)
+            {
+                m_admitted = (m_gate.m_state.fetch_add(1) & s_closedFlag) == 0;
+                s_innermostScope = this;
+            }
+
+            Mqtt5CallbackGate::Scope::~Scope()
+            {
+                s_innermostScope = m_outer;
+
+                /* While the gate is open, nothing waits on the count */
+                size_t state = m_gate.m_state.load();
+                while ((state & s_closedFlag) == 0)
+                {
+                    if (m_gate.m_state.compare_exchange_weak(state, state - 1))
+                    {
+                        return;
+                    }
+                }
+
+                /*
+                 * Counted out under the lock, which Close() holds while checking the count, so that it neither misses
+                 * the notification nor returns, letting the gate go away, before this is done with it.
+                 */
+                std::lock_guard<std::mutex> lock(m_gate.m_closeLock);
+                m_gate.m_state.fetch_sub(1);
+                m_gate.m_scopeReturned.notify_all();
+            }
+
+            Mqtt5CallbackGate::Mqtt5CallbackGate() noexcept : m_state(0) {}
+
+            void Mqtt5CallbackGate::Close() noexcept
+            {
+                size_t calling = 0;
+                for (const Scope *scope = s_innermostScope; scope != nullptr; scope = scope->m_outer)
+                {
+                    if (&scope->m_gate == this)
+                    {
+                        ++calling;
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(m_closeLock);
+                m_state.fetch_or(s_closedFlag);
+                m_scopeReturned.wait(lock, [this, calling]() { return (m_state.load() & ~s_closedFlag) <= calling; });
+            }
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
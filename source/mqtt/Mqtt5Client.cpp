@@ -127,6 +127,21 @@ namespace Aws
                 return m_client_core->Publish(publishOptions, onPublishCompletionCallback);
             }
 
+            bool Mqtt5Client::Publish(
+                std::shared_ptr<const PublishTemplate> publishTemplate,
+                ByteCursor payload,
+                OnPublishCompletionHandler onPublishCompletionCallback) noexcept
+            {
+                if (m_client_core == nullptr || publishTemplate == nullptr)
+                {
+                    AWS_LOGF_DEBUG(
+                        AWS_LS_MQTT5_CLIENT, "Failed to publish: the Mqtt5 client or the publish template is invalid.");
+                    return false;
+                }
+
+                return m_client_core->Publish(publishTemplate, payload, onPublishCompletionCallback);
+            }
+
             bool Mqtt5Client::Subscribe(
                 std::shared_ptr<SubscribePacket> subscribeOptions,
                 OnSubscribeCompletionHandler onSubscribeCompletionCallback) noexcept
@@ -174,6 +189,37 @@ namespace Aws
                 return m_operationStatistics;
             }
 
+            Mqtt5ClientMetrics Mqtt5Client::GetMetrics() noexcept
+            {
+                if (m_client_core == nullptr)
+                {
+                    return Mqtt5ClientMetrics();
+                }
+                Mqtt5ClientMetrics metrics = m_client_core->m_metrics.GetMetrics();
+                if (m_client_core->m_publishRateLimiter)
+                {
+                    metrics.publishesRateLimited = m_client_core->m_publishRateLimiter->GetPublishesRateLimited();
+                    metrics.rateLimitDelayNanos = m_client_core->m_publishRateLimiter->GetDelayNanos();
+                }
+                return metrics;
+            }
+
+            PayloadCompressionOptions::PayloadCompressionOptions() noexcept
+                : m_algorithm(CompressionAlgorithm::Deflate), m_thresholdBytes(256), m_level(-1),
+                  m_maxDecompressedBytes(0)
+            {
+            }
+
+            PublishRateLimit::PublishRateLimit() noexcept : m_messagesPerSecond(0), m_bytesPerSecond(0) {}
+
+            Mqtt5ClientMetrics::Mqtt5ClientMetrics() noexcept
+                : publishesSentQos0(0), publishesSentQos1(0), publishesReceivedQos0(0), publishesReceivedQos1(0),
+                  publishBytesSent(0), publishBytesReceived(0), connectionSuccesses(0), reconnects(0),
+                  incompleteOperationCount(0), incompleteOperationPeak(0), flowControlBlockedNanos(0),
+                  publishesRateLimited(0), rateLimitDelayNanos(0)
+            {
+            }
+
             /*****************************************************
              *
              * Mqtt5ClientOptions
@@ -316,6 +362,27 @@ namespace Aws
                 return *this;
             }
 
+            Mqtt5ClientOptions &Mqtt5ClientOptions::WithDurableOfflineQueue(
+                const DurableOfflineQueueOptions &durableOfflineQueueOptions) noexcept
+            {
+                m_durableOfflineQueueOptions = durableOfflineQueueOptions;
+                return *this;
+            }
+
+            Mqtt5ClientOptions &Mqtt5ClientOptions::WithPayloadCompression(
+                const PayloadCompressionOptions &payloadCompressionOptions) noexcept
+            {
+                m_payloadCompressionOptions = payloadCompressionOptions;
+                return *this;
+            }
+
+            Mqtt5ClientOptions &Mqtt5ClientOptions::WithPublishRateLimit(
+                const PublishRateLimitOptions &publishRateLimitOptions) noexcept
+            {
+                m_publishRateLimitOptions = publishRateLimitOptions;
+                return *this;
+            }
+
             Mqtt5ClientOptions &Mqtt5ClientOptions::WithTopicAliasingOptions(
                 TopicAliasingOptions topicAliasingOptions) noexcept
             {
@@ -405,6 +472,13 @@ namespace Aws
                 return *this;
             }
 
+            Mqtt5ClientOptions &Mqtt5ClientOptions::WithConnectionSetupMetricsCallback(
+                OnConnectionSetupMetricsHandler callback) noexcept
+            {
+                onConnectionSetupMetrics = std::move(callback);
+                return *this;
+            }
+
             Mqtt5ClientOptions &Mqtt5ClientOptions::WithPublishReceivedCallback(
                 OnPublishReceivedHandler callback) noexcept
             {
@@ -13,6 +13,10 @@
 #include <aws/crt/Api.h>
 #include <aws/crt/StlAllocator.h>
 #include <aws/crt/http/HttpRequestResponse.h>
+#include <aws/crt/io/EventLoopGroup.h>
+
+#include <aws/common/clock.h>
+#include <aws/io/channel_bootstrap.h>
 
 namespace Aws
 {
@@ -20,13 +24,27 @@ namespace Aws
     {
         namespace Mqtt5
         {
+            /* Largest packet the MQTT5 encoding allows: a remaining length of 2^28 - 1 and a 5 byte fixed header */
+            static const size_t s_mqtt5MaximumPacketSize = 268435460;
+
             struct PubAckCallbackData : public std::enable_shared_from_this<PubAckCallbackData>
             {
-                PubAckCallbackData(Allocator *alloc = ApiAllocator()) : clientCore(nullptr), allocator(alloc) {}
+                PubAckCallbackData(Allocator *alloc = ApiAllocator())
+                    : clientCore(nullptr), allocator(alloc), qos(AWS_MQTT5_QOS_AT_MOST_ONCE), bytes(0), wireBytes(0),
+                      submittedNs(0), offlineQueueEndOffset(0)
+                {
+                }
 
                 Mqtt5ClientCore *clientCore;
                 OnPublishCompletionHandler onPublishCompletion;
                 Allocator *allocator;
+
+                /* What the metrics and the durable offline queue need to know about the publish when it completes */
+                aws_mqtt5_qos qos;
+                size_t bytes;
+                size_t wireBytes;
+                uint64_t submittedNs;
+                uint64_t offlineQueueEndOffset;
             };
 
             struct SubAckCallbackData
@@ -46,6 +64,147 @@ namespace Aws
                 Allocator *allocator;
             };
 
+            Mqtt5ClientMetricsRecorder::Mqtt5ClientMetricsRecorder() noexcept
+                : m_publishesSentQos0(0), m_publishesSentQos1(0), m_publishesReceivedQos0(0),
+                  m_publishesReceivedQos1(0), m_publishBytesSent(0), m_publishBytesReceived(0),
+                  m_connectionSuccesses(0), m_incompleteOperations(0), m_incompleteOperationPeak(0), m_connected(false),
+                  m_receiveMaximum(0), m_incompleteQos1Publishes(0), m_blockedSinceNs(0), m_blockedNanos(0)
+            {
+            }
+
+            void Mqtt5ClientMetricsRecorder::OnOperationSubmitted(bool qos1Publish) noexcept
+            {
+                uint64_t incomplete = m_incompleteOperations.fetch_add(1, std::memory_order_relaxed) + 1;
+                uint64_t peak = m_incompleteOperationPeak.load(std::memory_order_relaxed);
+                while (incomplete > peak &&
+                       !m_incompleteOperationPeak.compare_exchange_weak(peak, incomplete, std::memory_order_relaxed))
+                {
+                }
+
+                if (qos1Publish)
+                {
+                    uint64_t now = 0;
+                    aws_high_res_clock_get_ticks(&now);
+                    std::lock_guard<std::mutex> lock(m_flowControlLock);
+                    ++m_incompleteQos1Publishes;
+                    UpdateFlowControl(now);
+                }
+            }
+
+            void Mqtt5ClientMetricsRecorder::OnOperationCompleted(bool qos1Publish) noexcept
+            {
+                m_incompleteOperations.fetch_sub(1, std::memory_order_relaxed);
+
+                if (qos1Publish)
+                {
+                    uint64_t now = 0;
+                    aws_high_res_clock_get_ticks(&now);
+                    std::lock_guard<std::mutex> lock(m_flowControlLock);
+                    --m_incompleteQos1Publishes;
+                    UpdateFlowControl(now);
+                }
+            }
+
+            void Mqtt5ClientMetricsRecorder::OnPublishSent(
+                aws_mqtt5_qos qos,
+                size_t bytes,
+                uint64_t submittedNs) noexcept
+            {
+                m_publishBytesSent.fetch_add(bytes, std::memory_order_relaxed);
+                if (qos == AWS_MQTT5_QOS_AT_MOST_ONCE)
+                {
+                    m_publishesSentQos0.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                m_publishesSentQos1.fetch_add(1, std::memory_order_relaxed);
+                uint64_t now = 0;
+                aws_high_res_clock_get_ticks(&now);
+                m_pubAckLatency.Record(now > submittedNs ? now - submittedNs : 0);
+            }
+
+            void Mqtt5ClientMetricsRecorder::OnPublishReceived(aws_mqtt5_qos qos, size_t bytes) noexcept
+            {
+                m_publishBytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+                if (qos == AWS_MQTT5_QOS_AT_MOST_ONCE)
+                {
+                    m_publishesReceivedQos0.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    m_publishesReceivedQos1.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            void Mqtt5ClientMetricsRecorder::OnConnectionSuccess(uint16_t receiveMaximum) noexcept
+            {
+                m_connectionSuccesses.fetch_add(1, std::memory_order_relaxed);
+
+                uint64_t now = 0;
+                aws_high_res_clock_get_ticks(&now);
+                std::lock_guard<std::mutex> lock(m_flowControlLock);
+                m_connected = true;
+                m_receiveMaximum = receiveMaximum;
+                UpdateFlowControl(now);
+            }
+
+            void Mqtt5ClientMetricsRecorder::OnDisconnection() noexcept
+            {
+                uint64_t now = 0;
+                aws_high_res_clock_get_ticks(&now);
+                std::lock_guard<std::mutex> lock(m_flowControlLock);
+                m_connected = false;
+                UpdateFlowControl(now);
+            }
+
+            void Mqtt5ClientMetricsRecorder::UpdateFlowControl(uint64_t now) noexcept
+            {
+                bool blocked = m_connected && m_receiveMaximum > 0 && m_incompleteQos1Publishes >= m_receiveMaximum;
+                if (blocked && m_blockedSinceNs == 0)
+                {
+                    m_blockedSinceNs = now;
+                }
+                else if (!blocked && m_blockedSinceNs != 0)
+                {
+                    m_blockedNanos += now - m_blockedSinceNs;
+                    m_blockedSinceNs = 0;
+                }
+            }
+
+            Mqtt5ClientMetrics Mqtt5ClientMetricsRecorder::GetMetrics() noexcept
+            {
+                Mqtt5ClientMetrics metrics;
+                metrics.publishesSentQos0 = m_publishesSentQos0.load(std::memory_order_relaxed);
+                metrics.publishesSentQos1 = m_publishesSentQos1.load(std::memory_order_relaxed);
+                metrics.publishesReceivedQos0 = m_publishesReceivedQos0.load(std::memory_order_relaxed);
+                metrics.publishesReceivedQos1 = m_publishesReceivedQos1.load(std::memory_order_relaxed);
+                metrics.publishBytesSent = m_publishBytesSent.load(std::memory_order_relaxed);
+                metrics.publishBytesReceived = m_publishBytesReceived.load(std::memory_order_relaxed);
+                metrics.pubAckLatency = m_pubAckLatency.GetSnapshot();
+                metrics.connectionSuccesses = m_connectionSuccesses.load(std::memory_order_relaxed);
+                metrics.reconnects = metrics.connectionSuccesses > 0 ? metrics.connectionSuccesses - 1 : 0;
+
+                /* The next interval starts from the current depth */
+                metrics.incompleteOperationCount = m_incompleteOperations.load(std::memory_order_relaxed);
+                metrics.incompleteOperationPeak =
+                    m_incompleteOperationPeak.exchange(metrics.incompleteOperationCount, std::memory_order_relaxed);
+                if (metrics.incompleteOperationPeak < metrics.incompleteOperationCount)
+                {
+                    metrics.incompleteOperationPeak = metrics.incompleteOperationCount;
+                }
+
+                uint64_t now = 0;
+                aws_high_res_clock_get_ticks(&now);
+                std::lock_guard<std::mutex> lock(m_flowControlLock);
+                metrics.flowControlBlockedNanos = m_blockedNanos;
+                if (m_blockedSinceNs != 0)
+                {
+                    metrics.flowControlBlockedNanos += now - m_blockedSinceNs;
+                }
+
+                return metrics;
+            }
+
             void Mqtt5ClientCore::s_lifeCycleEventCallback(const struct aws_mqtt5_client_lifecycle_event *event)
             {
                 Mqtt5ClientCore *client_core = reinterpret_cast<Mqtt5ClientCore *>(event->user_data);
@@ -55,8 +214,32 @@ namespace Aws
                     return;
                 }
 
-                std::lock_guard<std::recursive_mutex> lock(client_core->m_callback_lock);
-                if (client_core->m_callbackFlag != Mqtt5ClientCore::CallbackFlag::INVOKE)
+                /* Metrics are kept whether or not the callbacks are still invoked */
+                if (event->event_type == AWS_MQTT5_CLET_CONNECTION_SUCCESS)
+                {
+                    client_core->m_metrics.OnConnectionSuccess(
+                        event->settings != nullptr ? event->settings->receive_maximum_from_server : 0);
+                }
+                else if (event->event_type == AWS_MQTT5_CLET_DISCONNECTION)
+                {
+                    client_core->m_metrics.OnDisconnection();
+                }
+
+                /* Replays publishes, which enter the callback gate themselves */
+                if (client_core->m_durableOfflineQueue)
+                {
+                    if (event->event_type == AWS_MQTT5_CLET_CONNECTION_SUCCESS)
+                    {
+                        client_core->m_durableOfflineQueue->OnConnectionSuccess();
+                    }
+                    else if (event->event_type == AWS_MQTT5_CLET_DISCONNECTION)
+                    {
+                        client_core->m_durableOfflineQueue->OnDisconnection();
+                    }
+                }
+
+                Mqtt5CallbackGate::Scope scope(client_core->m_callbackGate);
+                if (!scope)
                 {
                     AWS_LOGF_INFO(
                         AWS_LS_MQTT5_CLIENT, "Lifecycle event: mqtt5 client is not valid, revoke the callbacks.");
@@ -76,6 +259,7 @@ namespace Aws
 
                     case AWS_MQTT5_CLET_ATTEMPTING_CONNECT:
                         AWS_LOGF_INFO(AWS_LS_MQTT5_CLIENT, "Lifecycle event: Attempting Connect!");
+                        client_core->m_setupObserver.OnAttemptStarted();
                         if (client_core->onAttemptingConnect != nullptr)
                         {
                             OnAttemptingConnectEventData eventData;
@@ -166,14 +350,19 @@ namespace Aws
                     return;
                 }
 
+                if (publish != nullptr)
+                {
+                    client_core->m_metrics.OnPublishReceived(publish->qos, publish->topic.len + publish->payload.len);
+                }
+
                 /* Callback not set */
                 if (client_core->onPublishReceived == nullptr)
                 {
                     return;
                 }
 
-                std::lock_guard<std::recursive_mutex> lock(client_core->m_callback_lock);
-                if (client_core->m_callbackFlag != Mqtt5ClientCore::CallbackFlag::INVOKE)
+                Mqtt5CallbackGate::Scope scope(client_core->m_callbackGate);
+                if (!scope)
                 {
                     AWS_LOGF_INFO(
                         AWS_LS_MQTT5_CLIENT,
@@ -185,8 +374,24 @@ namespace Aws
                 {
                     if (publish != nullptr)
                     {
+                        Mqtt5PayloadTransformStorage decompressed(client_core->m_allocator);
+                        aws_mqtt5_packet_publish_view applicationPublish = *publish;
+                        if (client_core->m_payloadCompression &&
+                            !client_core->m_payloadCompression->Decompress(applicationPublish, decompressed))
+                        {
+                            int errorCode = aws_last_error();
+                            AWS_LOGF_ERROR(
+                                AWS_LS_MQTT5_CLIENT,
+                                "Publish Received Event: failed to decompress the payload of a publish to \"" PRInSTR
+                                "\" with error %d(%s), dropping it.",
+                                AWS_BYTE_CURSOR_PRI(publish->topic),
+                                errorCode,
+                                aws_error_debug_str(errorCode));
+                            return;
+                        }
+
                         std::shared_ptr<PublishPacket> packet =
-                            std::make_shared<PublishPacket>(*publish, client_core->m_allocator);
+                            std::make_shared<PublishPacket>(applicationPublish, client_core->m_allocator);
                         PublishReceivedEventData eventData;
                         eventData.publishPacket = packet;
                         client_core->onPublishReceived(eventData);
@@ -210,6 +415,22 @@ namespace Aws
                 AWS_ASSERT(callbackData != nullptr);
                 AWS_ASSERT(callbackData->clientCore != nullptr);
 
+                {
+                    Mqtt5ClientMetricsRecorder &metrics = callbackData->clientCore->m_metrics;
+                    if (error_code == AWS_ERROR_SUCCESS)
+                    {
+                        metrics.OnPublishSent(callbackData->qos, callbackData->wireBytes, callbackData->submittedNs);
+                    }
+                    metrics.OnOperationCompleted(callbackData->qos != AWS_MQTT5_QOS_AT_MOST_ONCE);
+                }
+
+                /* May replay further publishes, so outside of the callback scope */
+                if (callbackData->clientCore->m_durableOfflineQueue)
+                {
+                    callbackData->clientCore->m_durableOfflineQueue->OnPublishCompleted(
+                        callbackData->bytes, callbackData->offlineQueueEndOffset);
+                }
+
                 /* callback not set */
                 if (callbackData->onPublishCompletion == nullptr)
                 {
@@ -217,17 +438,15 @@ namespace Aws
                 }
 
                 {
-                    std::lock_guard<std::recursive_mutex> lock(callbackData->clientCore->m_callback_lock);
-                    if (callbackData->clientCore->m_callbackFlag != Mqtt5ClientCore::CallbackFlag::INVOKE)
+                    Mqtt5CallbackGate::Scope scope(callbackData->clientCore->m_callbackGate);
+                    if (!scope)
                     {
                         AWS_LOGF_INFO(
                             AWS_LS_MQTT5_CLIENT,
                             "Publish Completion Callback: mqtt5 client is not valid, revoke the callbacks.");
                         goto on_publishCompletionCleanup;
                     }
-                }
 
-                {
                     std::shared_ptr<PublishResult> publish = nullptr;
                     switch (packet_type)
                     {
@@ -280,8 +499,8 @@ namespace Aws
                 /* The websocketInterceptor must be set */
                 AWS_FATAL_ASSERT(client_core->websocketInterceptor);
 
-                std::lock_guard<std::recursive_mutex> lock(client_core->m_callback_lock);
-                if (client_core->m_callbackFlag != Mqtt5ClientCore::CallbackFlag::INVOKE)
+                Mqtt5CallbackGate::Scope scope(client_core->m_callbackGate);
+                if (!scope)
                 {
                     AWS_LOGF_INFO(
                         AWS_LS_MQTT5_CLIENT, "Websocket Handshake: mqtt5 client is not valid, revoke the callbacks.");
@@ -320,6 +539,7 @@ namespace Aws
                 auto callbackData = reinterpret_cast<SubAckCallbackData *>(complete_ctx);
                 AWS_ASSERT(callbackData != nullptr);
                 AWS_ASSERT(callbackData->clientCore != nullptr);
+                callbackData->clientCore->m_metrics.OnOperationCompleted(false);
 
                 /* callback not set */
                 if (callbackData->onSubscribeCompletion == NULL)
@@ -328,17 +548,15 @@ namespace Aws
                 }
 
                 {
-                    std::lock_guard<std::recursive_mutex> lock(callbackData->clientCore->m_callback_lock);
-                    if (callbackData->clientCore->m_callbackFlag != Mqtt5ClientCore::CallbackFlag::INVOKE)
+                    Mqtt5CallbackGate::Scope scope(callbackData->clientCore->m_callbackGate);
+                    if (!scope)
                     {
                         AWS_LOGF_INFO(
                             AWS_LS_MQTT5_CLIENT,
                             "Subscribe Completion Callback: mqtt5 client is not valid, revoke the callbacks.");
                         goto on_subscribeCompletionCleanup;
                     }
-                }
 
-                {
                     std::shared_ptr<SubAckPacket> packet = nullptr;
                     if (suback != nullptr)
                     {
@@ -369,6 +587,7 @@ namespace Aws
                 UnSubAckCallbackData *callbackData = reinterpret_cast<UnSubAckCallbackData *>(complete_ctx);
                 AWS_ASSERT(callbackData != nullptr);
                 AWS_ASSERT(callbackData->clientCore != nullptr);
+                callbackData->clientCore->m_metrics.OnOperationCompleted(false);
 
                 /* callback not set */
                 if (callbackData->onUnsubscribeCompletion == NULL)
@@ -377,17 +596,15 @@ namespace Aws
                 }
 
                 {
-                    std::lock_guard<std::recursive_mutex> lock(callbackData->clientCore->m_callback_lock);
-                    if (callbackData->clientCore->m_callbackFlag != Mqtt5ClientCore::CallbackFlag::INVOKE)
+                    Mqtt5CallbackGate::Scope scope(callbackData->clientCore->m_callbackGate);
+                    if (!scope)
                     {
                         AWS_LOGF_INFO(
                             AWS_LS_MQTT5_CLIENT,
                             "Unsubscribe Completion Callback: mqtt5 client is not valid, revoke the callbacks.");
                         goto on_unsubscribeCompletionCleanup;
                     }
-                }
 
-                {
                     std::shared_ptr<UnSubAckPacket> packet = nullptr;
                     if (unsuback != nullptr)
                     {
@@ -410,7 +627,7 @@ namespace Aws
             }
 
             Mqtt5ClientCore::Mqtt5ClientCore(const Mqtt5ClientOptions &options, Allocator *allocator) noexcept
-                : m_callbackFlag(CallbackFlag::INVOKE), m_client(nullptr), m_allocator(allocator)
+                : m_client(nullptr), m_allocator(allocator)
             {
                 aws_mqtt5_client_options clientOptions;
 
@@ -454,6 +671,124 @@ namespace Aws
                     this->onAttemptingConnect = options.onAttemptingConnect;
                 }
 
+                if (options.onConnectionSetupMetrics && clientOptions.tls_options != nullptr)
+                {
+                    this->onConnectionSetupMetrics = options.onConnectionSetupMetrics;
+                    m_setupObserver.SetCallback(
+                        [this](const Io::ConnectionSetupMetrics &metrics)
+                        {
+                            Mqtt5CallbackGate::Scope scope(m_callbackGate);
+                            if (scope && onConnectionSetupMetrics)
+                            {
+                                onConnectionSetupMetrics(metrics);
+                            }
+                        });
+
+                    clientOptions.tls_options = m_setupObserver.Instrument(*clientOptions.tls_options);
+                    if (clientOptions.tls_options == nullptr)
+                    {
+                        return;
+                    }
+                }
+
+                if (options.m_payloadCompressionOptions.has_value())
+                {
+                    const PayloadCompressionOptions &compressionOptions = options.m_payloadCompressionOptions.value();
+                    if (!StreamCodec::IsSupported(compressionOptions.m_algorithm))
+                    {
+                        AWS_LOGF_ERROR(
+                            AWS_LS_MQTT5_CLIENT, "Payload compression: the algorithm is not supported by this build.");
+                        aws_raise_error(AWS_ERROR_UNSUPPORTED_OPERATION);
+                        return;
+                    }
+
+                    /* Nothing larger than a packet the server may send us needs decompressing */
+                    size_t maxDecompressedBytes = compressionOptions.m_maxDecompressedBytes;
+                    if (maxDecompressedBytes == 0)
+                    {
+                        maxDecompressedBytes = s_mqtt5MaximumPacketSize;
+                        if (clientOptions.connect_options->maximum_packet_size_bytes != nullptr)
+                        {
+                            maxDecompressedBytes = *clientOptions.connect_options->maximum_packet_size_bytes;
+                        }
+                    }
+
+                    m_payloadCompression = ScopedResource<Mqtt5PayloadCompression>(
+                        Crt::New<Mqtt5PayloadCompression>(
+                            allocator, compressionOptions, maxDecompressedBytes, allocator),
+                        [allocator](Mqtt5PayloadCompression *compression) { Crt::Delete(compression, allocator); });
+                }
+
+                if (options.m_publishRateLimitOptions.has_value())
+                {
+                    Io::EventLoop eventLoop(
+                        aws_event_loop_group_get_next_loop(clientOptions.bootstrap->event_loop_group), allocator);
+                    m_publishRateLimiter = ScopedResource<Mqtt5PublishRateLimiter>(
+                        Crt::New<Mqtt5PublishRateLimiter>(
+                            allocator,
+                            options.m_publishRateLimitOptions.value(),
+                            [this](
+                                const aws_mqtt5_packet_publish_view &publish,
+                                OnPublishCompletionHandler &&onPublishCompletion,
+                                uint64_t endOffset)
+                            { SubmitRateLimitedPublish(publish, std::move(onPublishCompletion), endOffset); },
+                            [this, eventLoop](uint64_t delayNs) mutable
+                            {
+                                /* Only scheduled from Publish() and replays, once a shared pointer owns the core */
+                                std::weak_ptr<Mqtt5ClientCore> weakCore = shared_from_this();
+                                return eventLoop.ScheduleAfter(
+                                    [weakCore](Io::TaskStatus status)
+                                    {
+                                        std::shared_ptr<Mqtt5ClientCore> core = weakCore.lock();
+                                        if (status == Io::TaskStatus::RunReady && core)
+                                        {
+                                            core->m_publishRateLimiter->OnTimer();
+                                        }
+                                    },
+                                    std::chrono::nanoseconds(delayNs));
+                            },
+                            allocator),
+                        [allocator](Mqtt5PublishRateLimiter *limiter) { Crt::Delete(limiter, allocator); });
+                }
+
+                if (options.m_durableOfflineQueueOptions.has_value())
+                {
+                    m_durableOfflineQueue = Mqtt5DurableOfflineQueue::NewDurableOfflineQueue(
+                        options.m_durableOfflineQueueOptions.value(),
+                        [this](
+                            const aws_mqtt5_packet_publish_view &publish,
+                            OnPublishCompletionHandler &&onPublishCompletion,
+                            uint64_t endOffset)
+                        {
+                            Mqtt5CallbackGate::Scope scope(m_callbackGate);
+                            if (!scope || m_client == nullptr)
+                            {
+                                return false;
+                            }
+
+                            OnPublishCompletionHandler retained = onPublishCompletion;
+                            if (PacePublish(publish, nullptr, std::move(onPublishCompletion), endOffset))
+                            {
+                                return true;
+                            }
+
+                            /* The queue keeps the record and its callback, to replay it on the next connection */
+                            int errorCode = aws_last_error();
+                            AWS_LOGF_ERROR(
+                                AWS_LS_MQTT5_CLIENT,
+                                "Durable offline queue: failed to replay a publish with error %d(%s)",
+                                errorCode,
+                                aws_error_debug_str(errorCode));
+                            onPublishCompletion = std::move(retained);
+                            return false;
+                        },
+                        allocator);
+                    if (!m_durableOfflineQueue)
+                    {
+                        return;
+                    }
+                }
+
                 clientOptions.publish_received_handler_user_data = this;
                 clientOptions.publish_received_handler = &Mqtt5ClientCore::s_publishReceivedCallback;
 
@@ -520,20 +855,163 @@ namespace Aws
                 aws_mqtt5_packet_publish_view publish;
                 publishOptions->initializeRawOptions(publish);
 
+                return OfferPublish(publish, publishOptions, std::move(onPublishCompletionCallback));
+            }
+
+            bool Mqtt5ClientCore::Publish(
+                const std::shared_ptr<const PublishTemplate> &publishTemplate,
+                ByteCursor payload,
+                OnPublishCompletionHandler onPublishCompletionCallback) noexcept
+            {
+                if (m_client == nullptr || publishTemplate == nullptr)
+                {
+                    return false;
+                }
+
+                aws_mqtt5_packet_publish_view publish;
+                publishTemplate->initializeRawOptions(publish, payload);
+
+                /* No packet: the rate limiter copies the publish if it holds it back */
+                return OfferPublish(publish, nullptr, std::move(onPublishCompletionCallback));
+            }
+
+            bool Mqtt5ClientCore::OfferPublish(
+                const aws_mqtt5_packet_publish_view &publish,
+                const std::shared_ptr<PublishPacket> &packet,
+                OnPublishCompletionHandler &&onPublishCompletionCallback) noexcept
+            {
+                if (m_durableOfflineQueue)
+                {
+                    switch (m_durableOfflineQueue->Offer(publish, onPublishCompletionCallback))
+                    {
+                        case Mqtt5DurableOfflineQueue::OfferResult::Spilled:
+                            return true;
+                        case Mqtt5DurableOfflineQueue::OfferResult::Failed:
+                            return false;
+                        case Mqtt5DurableOfflineQueue::OfferResult::Submit:
+                            break;
+                    }
+
+                    if (!PacePublish(publish, packet, std::move(onPublishCompletionCallback), 0))
+                    {
+                        int errorCode = aws_last_error();
+                        m_durableOfflineQueue->OnPublishCompleted(publish.topic.len + publish.payload.len, 0);
+                        aws_raise_error(errorCode);
+                        return false;
+                    }
+                    return true;
+                }
+
+                return PacePublish(publish, packet, std::move(onPublishCompletionCallback), 0);
+            }
+
+            bool Mqtt5ClientCore::PacePublish(
+                const aws_mqtt5_packet_publish_view &publish,
+                const std::shared_ptr<PublishPacket> &packet,
+                OnPublishCompletionHandler &&onPublishCompletionCallback,
+                uint64_t offlineQueueEndOffset) noexcept
+            {
+                if (m_publishRateLimiter)
+                {
+                    switch (m_publishRateLimiter->Offer(
+                        publish, packet, onPublishCompletionCallback, offlineQueueEndOffset))
+                    {
+                        case Mqtt5PublishRateLimiter::OfferResult::Queued:
+                            return true;
+                        case Mqtt5PublishRateLimiter::OfferResult::Failed:
+                            return false;
+                        case Mqtt5PublishRateLimiter::OfferResult::Submit:
+                            break;
+                    }
+                }
+
+                return SubmitPublish(publish, std::move(onPublishCompletionCallback), offlineQueueEndOffset);
+            }
+
+            void Mqtt5ClientCore::SubmitRateLimitedPublish(
+                const aws_mqtt5_packet_publish_view &publish,
+                OnPublishCompletionHandler &&onPublishCompletionCallback,
+                uint64_t offlineQueueEndOffset) noexcept
+            {
+                int errorCode = AWS_ERROR_INVALID_STATE;
+                {
+                    Mqtt5CallbackGate::Scope scope(m_callbackGate);
+                    if (!scope || m_client == nullptr)
+                    {
+                        return;
+                    }
+
+                    OnPublishCompletionHandler onFailure = onPublishCompletionCallback;
+                    if (SubmitPublish(publish, std::move(onPublishCompletionCallback), offlineQueueEndOffset))
+                    {
+                        return;
+                    }
+
+                    /* Publish() already returned true for it, so the failure goes to the callback */
+                    errorCode = aws_last_error();
+                    AWS_LOGF_ERROR(
+                        AWS_LS_MQTT5_CLIENT,
+                        "Publish rate limiter: failed to submit a publish with error %d(%s)",
+                        errorCode,
+                        aws_error_debug_str(errorCode));
+                    if (onFailure)
+                    {
+                        onFailure(errorCode, nullptr);
+                    }
+                }
+
+                if (m_durableOfflineQueue)
+                {
+                    size_t bytes = publish.topic.len + publish.payload.len;
+                    if (offlineQueueEndOffset != 0)
+                    {
+                        /* A replayed record stays uncommitted, to be replayed again */
+                        m_durableOfflineQueue->OnReplayFailed(bytes);
+                    }
+                    else
+                    {
+                        /* May replay further publishes, so outside of the callback scope */
+                        m_durableOfflineQueue->OnPublishCompleted(bytes, 0);
+                    }
+                }
+            }
+
+            bool Mqtt5ClientCore::SubmitPublish(
+                const aws_mqtt5_packet_publish_view &publish,
+                OnPublishCompletionHandler &&onPublishCompletionCallback,
+                uint64_t offlineQueueEndOffset) noexcept
+            {
+                /* After the durable offline queue, so that it keeps payloads as the application gave them */
+                Mqtt5PayloadTransformStorage compressed(m_allocator);
+                aws_mqtt5_packet_publish_view wirePublish = publish;
+                if (m_payloadCompression && !m_payloadCompression->Compress(wirePublish, compressed))
+                {
+                    return false;
+                }
+
                 PubAckCallbackData *pubCallbackData = Aws::Crt::New<PubAckCallbackData>(m_allocator);
 
                 pubCallbackData->clientCore = this;
                 pubCallbackData->allocator = m_allocator;
-                pubCallbackData->onPublishCompletion = onPublishCompletionCallback;
+                pubCallbackData->onPublishCompletion = std::move(onPublishCompletionCallback);
+                pubCallbackData->qos = publish.qos;
+                pubCallbackData->bytes = publish.topic.len + publish.payload.len;
+                pubCallbackData->wireBytes = wirePublish.topic.len + wirePublish.payload.len;
+                pubCallbackData->offlineQueueEndOffset = offlineQueueEndOffset;
+                aws_high_res_clock_get_ticks(&pubCallbackData->submittedNs);
 
                 aws_mqtt5_publish_completion_options options{};
 
                 options.completion_callback = Mqtt5ClientCore::s_publishCompletionCallback;
                 options.completion_user_data = pubCallbackData;
 
-                int result = aws_mqtt5_client_publish(m_client, &publish, &options);
+                /* Counted before submitting, as the publish may complete before aws_mqtt5_client_publish returns */
+                bool qos1Publish = publish.qos != AWS_MQTT5_QOS_AT_MOST_ONCE;
+                m_metrics.OnOperationSubmitted(qos1Publish);
+                int result = aws_mqtt5_client_publish(m_client, &wirePublish, &options);
                 if (result != AWS_OP_SUCCESS)
                 {
+                    m_metrics.OnOperationCompleted(qos1Publish);
                     Crt::Delete(pubCallbackData, pubCallbackData->allocator);
                     return false;
                 }
@@ -566,9 +1044,11 @@ namespace Aws
                 options.completion_user_data = subCallbackData;
 
                 /* Subscribe to topic */
+                m_metrics.OnOperationSubmitted(false);
                 int result = aws_mqtt5_client_subscribe(m_client, &subscribe, &options);
                 if (result != AWS_OP_SUCCESS)
                 {
+                    m_metrics.OnOperationCompleted(false);
                     Crt::Delete(subCallbackData, subCallbackData->allocator);
                     return false;
                 }
@@ -598,9 +1078,11 @@ namespace Aws
                 options.completion_callback = Mqtt5ClientCore::s_unsubscribeCompletionCallback;
                 options.completion_user_data = unSubCallbackData;
 
+                m_metrics.OnOperationSubmitted(false);
                 int result = aws_mqtt5_client_unsubscribe(m_client, &unsubscribe, &options);
                 if (result != AWS_OP_SUCCESS)
                 {
+                    m_metrics.OnOperationCompleted(false);
                     Crt::Delete(unSubCallbackData, unSubCallbackData->allocator);
                     return false;
                 }
@@ -609,8 +1091,16 @@ namespace Aws
 
             void Mqtt5ClientCore::Close() noexcept
             {
-                std::lock_guard<std::recursive_mutex> lock(m_callback_lock);
-                m_callbackFlag = CallbackFlag::IGNORE;
+                /* Once the gate returns, no callback or replayed publish uses the client any longer */
+                m_callbackGate.Close();
+                if (m_durableOfflineQueue)
+                {
+                    m_durableOfflineQueue->Close();
+                }
+                if (m_publishRateLimiter)
+                {
+                    m_publishRateLimiter->Close();
+                }
                 if (m_client != nullptr)
                 {
                     aws_mqtt5_client_release(m_client);
@@ -0,0 +1,760 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/mqtt/Mqtt5ClientFleet.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/crt/mqtt/private/Mqtt5CallbackGate.h>
+
+#include <aws/crt/Api.h>
+#include <aws/crt/http/HttpRequestResponse.h>
+
+#include <atomic>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            /* Room in front of each allocation of a client for its size, keeping the allocation aligned */
+            static const size_t s_allocationHeaderSize = 16;
+            static_assert(s_allocationHeaderSize >= sizeof(size_t), "allocation header too small");
+
+            struct Mqtt5ClientFleetMember
+            {
+                /*
+                 * The native client allocates through this allocator, which accounts the bytes to the member and
+                 * forwards to the allocator of the fleet.
+                 */
+                aws_allocator allocator;
+                std::atomic<size_t> bytes;
+                Mqtt5ClientFleetShared *shared;
+                aws_mqtt5_client *client;
+                size_t index;
+
+                /* Set once the client has released its reference to the shared state */
+                std::atomic<bool> terminated;
+            };
+
+            struct Mqtt5ClientFleetShared
+            {
+                Allocator *allocator;
+                size_t memoryBudgetPerClient;
+
+                OnFleetConnectionSuccessHandler onConnectionSuccess;
+                OnFleetConnectionFailureHandler onConnectionFailure;
+                OnFleetDisconnectionHandler onDisconnection;
+                OnFleetStoppedHandler onStopped;
+                OnFleetPublishReceivedHandler onPublishReceived;
+                OnWebSocketHandshakeIntercept websocketInterceptor;
+
+                Mqtt5ClientFleetMember *members;
+                size_t memberCount;
+
+                /* One per client until it terminates, plus one held by the fleet */
+                std::atomic<size_t> references;
+
+                /* Closed when the fleet is destroyed, after which callbacks are dropped */
+                Mqtt5CallbackGate callbackGate;
+            };
+
+            static void *s_memberAcquire(struct aws_allocator *allocator, size_t size)
+            {
+                auto member = reinterpret_cast<Mqtt5ClientFleetMember *>(allocator->impl);
+                auto block = reinterpret_cast<uint8_t *>(
+                    aws_mem_acquire(member->shared->allocator, size + s_allocationHeaderSize));
+                if (block == nullptr)
+                {
+                    return nullptr;
+                }
+
+                *reinterpret_cast<size_t *>(block) = size;
+                member->bytes.fetch_add(size, std::memory_order_relaxed);
+                return block + s_allocationHeaderSize;
+            }
+
+            static void s_memberRelease(struct aws_allocator *allocator, void *ptr)
+            {
+                auto member = reinterpret_cast<Mqtt5ClientFleetMember *>(allocator->impl);
+                uint8_t *block = reinterpret_cast<uint8_t *>(ptr) - s_allocationHeaderSize;
+                member->bytes.fetch_sub(*reinterpret_cast<size_t *>(block), std::memory_order_relaxed);
+                aws_mem_release(member->shared->allocator, block);
+            }
+
+            static void s_releaseShared(Mqtt5ClientFleetShared *shared, size_t count) noexcept
+            {
+                if (shared->references.fetch_sub(count) != count)
+                {
+                    return;
+                }
+
+                Allocator *allocator = shared->allocator;
+                for (size_t i = 0; i < shared->memberCount; ++i)
+                {
+                    shared->members[i].~Mqtt5ClientFleetMember();
+                }
+                aws_mem_release(allocator, shared->members);
+                Crt::Delete(shared, allocator);
+            }
+
+            static void s_onLifecycleEvent(const struct aws_mqtt5_client_lifecycle_event *event)
+            {
+                auto member = reinterpret_cast<Mqtt5ClientFleetMember *>(event->user_data);
+                Mqtt5ClientFleetShared *shared = member->shared;
+                Mqtt5CallbackGate::Scope scope(shared->callbackGate);
+                if (!scope)
+                {
+                    return;
+                }
+
+                switch (event->event_type)
+                {
+                    case AWS_MQTT5_CLET_STOPPED:
+                        if (shared->onStopped)
+                        {
+                            OnStoppedEventData eventData;
+                            shared->onStopped(member->index, eventData);
+                        }
+                        break;
+
+                    case AWS_MQTT5_CLET_ATTEMPTING_CONNECT:
+                        break;
+
+                    case AWS_MQTT5_CLET_CONNECTION_FAILURE:
+                        if (shared->onConnectionFailure)
+                        {
+                            OnConnectionFailureEventData eventData;
+                            eventData.errorCode = event->error_code;
+                            if (event->connack_data != nullptr)
+                            {
+                                eventData.connAckPacket = Aws::Crt::MakeShared<ConnAckPacket>(
+                                    shared->allocator, *event->connack_data, shared->allocator);
+                            }
+                            shared->onConnectionFailure(member->index, eventData);
+                        }
+                        break;
+
+                    case AWS_MQTT5_CLET_CONNECTION_SUCCESS:
+                        if (shared->onConnectionSuccess)
+                        {
+                            OnConnectionSuccessEventData eventData;
+                            if (event->connack_data != nullptr)
+                            {
+                                eventData.connAckPacket = Aws::Crt::MakeShared<ConnAckPacket>(
+                                    shared->allocator, *event->connack_data, shared->allocator);
+                            }
+                            if (event->settings != nullptr)
+                            {
+                                eventData.negotiatedSettings = Aws::Crt::MakeShared<NegotiatedSettings>(
+                                    shared->allocator, *event->settings, shared->allocator);
+                            }
+                            shared->onConnectionSuccess(member->index, eventData);
+                        }
+                        break;
+
+                    case AWS_MQTT5_CLET_DISCONNECTION:
+                        if (shared->onDisconnection)
+                        {
+                            OnDisconnectionEventData eventData;
+                            eventData.errorCode = event->error_code;
+                            if (event->disconnect_data != nullptr)
+                            {
+                                eventData.disconnectPacket = Aws::Crt::MakeShared<DisconnectPacket>(
+                                    shared->allocator, *event->disconnect_data, shared->allocator);
+                            }
+                            shared->onDisconnection(member->index, eventData);
+                        }
+                        break;
+                }
+            }
+
+            static void s_onPublishReceived(const struct aws_mqtt5_packet_publish_view *publish, void *user_data)
+            {
+                auto member = reinterpret_cast<Mqtt5ClientFleetMember *>(user_data);
+                Mqtt5ClientFleetShared *shared = member->shared;
+                if (!shared->onPublishReceived || publish == nullptr)
+                {
+                    return;
+                }
+
+                Mqtt5CallbackGate::Scope scope(shared->callbackGate);
+                if (!scope)
+                {
+                    return;
+                }
+
+                PublishReceivedEventData eventData;
+                eventData.publishPacket =
+                    Aws::Crt::MakeShared<PublishPacket>(shared->allocator, *publish, shared->allocator);
+                shared->onPublishReceived(member->index, eventData);
+            }
+
+            static void s_onWebsocketHandshake(
+                struct aws_http_message *rawRequest,
+                void *user_data,
+                aws_mqtt5_transform_websocket_handshake_complete_fn *complete_fn,
+                void *complete_ctx)
+            {
+                auto member = reinterpret_cast<Mqtt5ClientFleetMember *>(user_data);
+                Mqtt5ClientFleetShared *shared = member->shared;
+                Mqtt5CallbackGate::Scope scope(shared->callbackGate);
+                if (!scope)
+                {
+                    complete_fn(rawRequest, AWS_ERROR_INVALID_STATE, complete_ctx);
+                    return;
+                }
+
+                Allocator *allocator = shared->allocator;
+                // we have to do this because of private constructors.
+                auto toSeat =
+                    reinterpret_cast<Http::HttpRequest *>(aws_mem_acquire(allocator, sizeof(Http::HttpRequest)));
+                toSeat = new (toSeat) Http::HttpRequest(allocator, rawRequest);
+
+                std::shared_ptr<Http::HttpRequest> request = std::shared_ptr<Http::HttpRequest>(
+                    toSeat, [allocator](Http::HttpRequest *ptr) { Crt::Delete(ptr, allocator); });
+
+                auto onInterceptComplete =
+                    [complete_fn,
+                     complete_ctx](const std::shared_ptr<Http::HttpRequest> &transformedRequest, int errorCode)
+                { complete_fn(transformedRequest->GetUnderlyingMessage(), errorCode, complete_ctx); };
+
+                shared->websocketInterceptor(request, onInterceptComplete);
+            }
+
+            static void s_onClientTerminated(void *complete_ctx)
+            {
+                auto member = reinterpret_cast<Mqtt5ClientFleetMember *>(complete_ctx);
+                member->terminated.store(true);
+                s_releaseShared(member->shared, 1);
+            }
+
+            /*
+             * Completion data of an operation, allocated from the client so it counts towards its budget. Operations
+             * complete before their client terminates, so the shared state is still there.
+             */
+            template <typename Handler> struct FleetCompletionData
+            {
+                FleetCompletionData(Mqtt5ClientFleetShared *fleetShared, Allocator *alloc, Handler &&completion)
+                    : shared(fleetShared), allocator(alloc), onCompletion(std::move(completion))
+                {
+                }
+
+                Mqtt5ClientFleetShared *shared;
+                Allocator *allocator;
+                Handler onCompletion;
+            };
+
+            using FleetPublishCompletionData = FleetCompletionData<OnPublishCompletionHandler>;
+            using FleetSubscribeCompletionData = FleetCompletionData<OnSubscribeCompletionHandler>;
+            using FleetUnsubscribeCompletionData = FleetCompletionData<OnUnsubscribeCompletionHandler>;
+
+            static void s_onPublishCompletion(
+                enum aws_mqtt5_packet_type packet_type,
+                const void *packet,
+                int error_code,
+                void *complete_ctx)
+            {
+                auto data = reinterpret_cast<FleetPublishCompletionData *>(complete_ctx);
+                if (data->onCompletion)
+                {
+                    Mqtt5CallbackGate::Scope scope(data->shared->callbackGate);
+                    if (scope)
+                    {
+                        std::shared_ptr<PublishResult> result;
+                        if (packet_type == AWS_MQTT5_PT_PUBACK && packet != nullptr)
+                        {
+                            result = Aws::Crt::MakeShared<PublishResult>(
+                                data->shared->allocator,
+                                Aws::Crt::MakeShared<PubAckPacket>(
+                                    data->shared->allocator,
+                                    *reinterpret_cast<const aws_mqtt5_packet_puback_view *>(packet),
+                                    data->shared->allocator));
+                        }
+                        else if (packet_type == AWS_MQTT5_PT_NONE)
+                        {
+                            result = Aws::Crt::MakeShared<PublishResult>(data->shared->allocator, error_code);
+                        }
+                        else
+                        {
+                            result = Aws::Crt::MakeShared<PublishResult>(data->shared->allocator, AWS_ERROR_UNKNOWN);
+                        }
+                        data->onCompletion(error_code, result);
+                    }
+                }
+                Crt::Delete(data, data->allocator);
+            }
+
+            static void s_onSubscribeCompletion(
+                const struct aws_mqtt5_packet_suback_view *suback,
+                int error_code,
+                void *complete_ctx)
+            {
+                auto data = reinterpret_cast<FleetSubscribeCompletionData *>(complete_ctx);
+                if (data->onCompletion)
+                {
+                    Mqtt5CallbackGate::Scope scope(data->shared->callbackGate);
+                    if (scope)
+                    {
+                        std::shared_ptr<SubAckPacket> packet;
+                        if (suback != nullptr)
+                        {
+                            packet = Aws::Crt::MakeShared<SubAckPacket>(
+                                data->shared->allocator, *suback, data->shared->allocator);
+                        }
+                        data->onCompletion(error_code, packet);
+                    }
+                }
+                Crt::Delete(data, data->allocator);
+            }
+
+            static void s_onUnsubscribeCompletion(
+                const struct aws_mqtt5_packet_unsuback_view *unsuback,
+                int error_code,
+                void *complete_ctx)
+            {
+                auto data = reinterpret_cast<FleetUnsubscribeCompletionData *>(complete_ctx);
+                if (data->onCompletion)
+                {
+                    Mqtt5CallbackGate::Scope scope(data->shared->callbackGate);
+                    if (scope)
+                    {
+                        std::shared_ptr<UnSubAckPacket> packet;
+                        if (unsuback != nullptr)
+                        {
+                            packet = Aws::Crt::MakeShared<UnSubAckPacket>(
+                                data->shared->allocator, *unsuback, data->shared->allocator);
+                        }
+                        data->onCompletion(error_code, packet);
+                    }
+                }
+                Crt::Delete(data, data->allocator);
+            }
+
+            /* Rejects operations on clients over their budget, so a slow client cannot grow without bound */
+            static bool s_isOverBudget(const Mqtt5ClientFleetMember &member) noexcept
+            {
+                size_t budget = member.shared->memoryBudgetPerClient;
+                if (budget != 0 && member.bytes.load(std::memory_order_relaxed) >= budget)
+                {
+                    AWS_LOGF_DEBUG(
+                        AWS_LS_MQTT5_CLIENT,
+                        "Fleet client %zu is over its memory budget of %zu bytes, rejecting the operation.",
+                        member.index,
+                        budget);
+                    aws_raise_error(AWS_ERROR_OOM);
+                    return true;
+                }
+
+                return false;
+            }
+
+            /*****************************************************
+             *
+             * Mqtt5ClientFleetOptions
+             *
+             *****************************************************/
+
+            Mqtt5ClientFleetOptions::Mqtt5ClientFleetOptions(Allocator *allocator) noexcept
+                : m_clientCount(1), m_clientIdPrefix(StlAllocator<char>(allocator)), m_memoryBudgetPerClient(0)
+            {
+            }
+
+            Mqtt5ClientFleetOptions &Mqtt5ClientFleetOptions::WithClientCount(size_t clientCount) noexcept
+            {
+                m_clientCount = clientCount;
+                return *this;
+            }
+
+            Mqtt5ClientFleetOptions &Mqtt5ClientFleetOptions::WithClientIdPrefix(const String &clientIdPrefix) noexcept
+            {
+                m_clientIdPrefix = clientIdPrefix;
+                return *this;
+            }
+
+            Mqtt5ClientFleetOptions &Mqtt5ClientFleetOptions::WithMemoryBudgetPerClient(size_t bytes) noexcept
+            {
+                m_memoryBudgetPerClient = bytes;
+                return *this;
+            }
+
+            Mqtt5ClientFleetOptions &Mqtt5ClientFleetOptions::WithConnectionSuccessCallback(
+                OnFleetConnectionSuccessHandler callback) noexcept
+            {
+                m_onConnectionSuccess = std::move(callback);
+                return *this;
+            }
+
+            Mqtt5ClientFleetOptions &Mqtt5ClientFleetOptions::WithConnectionFailureCallback(
+                OnFleetConnectionFailureHandler callback) noexcept
+            {
+                m_onConnectionFailure = std::move(callback);
+                return *this;
+            }
+
+            Mqtt5ClientFleetOptions &Mqtt5ClientFleetOptions::WithDisconnectionCallback(
+                OnFleetDisconnectionHandler callback) noexcept
+            {
+                m_onDisconnection = std::move(callback);
+                return *this;
+            }
+
+            Mqtt5ClientFleetOptions &Mqtt5ClientFleetOptions::WithStoppedCallback(
+                OnFleetStoppedHandler callback) noexcept
+            {
+                m_onStopped = std::move(callback);
+                return *this;
+            }
+
+            Mqtt5ClientFleetOptions &Mqtt5ClientFleetOptions::WithPublishReceivedCallback(
+                OnFleetPublishReceivedHandler callback) noexcept
+            {
+                m_onPublishReceived = std::move(callback);
+                return *this;
+            }
+
+            /*****************************************************
+             *
+             * Mqtt5ClientFleet
+             *
+             *****************************************************/
+
+            Mqtt5ClientFleet::Mqtt5ClientFleet(
+                const Mqtt5ClientOptions &options,
+                const Mqtt5ClientFleetOptions &fleetOptions,
+                Allocator *allocator) noexcept
+                : m_allocator(allocator), m_clientCount(fleetOptions.m_clientCount), m_shared(nullptr)
+            {
+                Mqtt5ClientFleetShared *shared = Crt::New<Mqtt5ClientFleetShared>(allocator);
+                if (shared == nullptr)
+                {
+                    return;
+                }
+
+                shared->allocator = allocator;
+                shared->memoryBudgetPerClient = fleetOptions.m_memoryBudgetPerClient;
+                shared->onConnectionSuccess = fleetOptions.m_onConnectionSuccess;
+                shared->onConnectionFailure = fleetOptions.m_onConnectionFailure;
+                shared->onDisconnection = fleetOptions.m_onDisconnection;
+                shared->onStopped = fleetOptions.m_onStopped;
+                shared->onPublishReceived = fleetOptions.m_onPublishReceived;
+                shared->websocketInterceptor = options.websocketHandshakeTransform;
+                shared->memberCount = m_clientCount;
+                shared->references.store(m_clientCount + 1);
+                shared->members = reinterpret_cast<Mqtt5ClientFleetMember *>(
+                    aws_mem_calloc(allocator, m_clientCount, sizeof(Mqtt5ClientFleetMember)));
+                if (shared->members == nullptr)
+                {
+                    shared->memberCount = 0;
+                    s_releaseShared(shared, m_clientCount + 1);
+                    return;
+                }
+                m_shared = shared;
+
+                aws_mqtt5_client_options clientOptions;
+                options.initializeRawOptions(clientOptions);
+                if (shared->websocketInterceptor)
+                {
+                    clientOptions.websocket_handshake_transform = s_onWebsocketHandshake;
+                }
+                clientOptions.publish_received_handler = s_onPublishReceived;
+                clientOptions.lifecycle_event_handler = s_onLifecycleEvent;
+                clientOptions.client_termination_handler = s_onClientTerminated;
+
+                /* Each client connects with its own client id, the rest of the CONNECT packet is shared */
+                aws_mqtt5_packet_connect_view connectView = *clientOptions.connect_options;
+                clientOptions.connect_options = &connectView;
+                String clientIdPrefix = fleetOptions.m_clientIdPrefix;
+                if (clientIdPrefix.empty() && connectView.client_id.len > 0)
+                {
+                    clientIdPrefix.assign(
+                        reinterpret_cast<const char *>(connectView.client_id.ptr), connectView.client_id.len);
+                }
+                String clientId;
+
+                for (size_t i = 0; i < m_clientCount; ++i)
+                {
+                    Mqtt5ClientFleetMember *member = new (&shared->members[i]) Mqtt5ClientFleetMember();
+                    member->allocator.mem_acquire = s_memberAcquire;
+                    member->allocator.mem_release = s_memberRelease;
+                    member->allocator.mem_realloc = nullptr;
+                    member->allocator.mem_calloc = nullptr;
+                    member->allocator.impl = member;
+                    member->bytes.store(0);
+                    member->shared = shared;
+                    member->client = nullptr;
+                    member->index = i;
+                    member->terminated.store(false);
+
+                    if (!clientIdPrefix.empty())
+                    {
+                        clientId = clientIdPrefix;
+                        clientId.append(std::to_string(i).c_str());
+                        connectView.client_id = ByteCursorFromString(clientId);
+                    }
+
+                    clientOptions.websocket_handshake_transform_user_data = member;
+                    clientOptions.publish_received_handler_user_data = member;
+                    clientOptions.lifecycle_event_handler_user_data = member;
+                    clientOptions.client_termination_handler_user_data = member;
+
+                    member->client = aws_mqtt5_client_new(&member->allocator, &clientOptions);
+                    if (member->client == nullptr)
+                    {
+                        int errorCode = aws_last_error();
+                        AWS_LOGF_ERROR(
+                            AWS_LS_MQTT5_CLIENT,
+                            "Failed to create fleet client %zu with error %d(%s).",
+                            i,
+                            errorCode,
+                            aws_error_debug_str(errorCode));
+
+                        /*
+                         * The clients that were created release their reference as they terminate. The one that
+                         * failed may have terminated already, if it got as far as storing its configuration.
+                         */
+                        shared->callbackGate.Close();
+                        for (size_t j = 0; j < i; ++j)
+                        {
+                            aws_mqtt5_client_release(shared->members[j].client);
+                        }
+                        for (size_t j = i + 1; j < m_clientCount; ++j)
+                        {
+                            new (&shared->members[j]) Mqtt5ClientFleetMember();
+                        }
+                        size_t unreleased = m_clientCount - i + (member->terminated.load() ? 0 : 1);
+                        s_releaseShared(shared, unreleased);
+                        m_shared = nullptr;
+                        aws_raise_error(errorCode);
+                        return;
+                    }
+                }
+            }
+
+            Mqtt5ClientFleet::~Mqtt5ClientFleet()
+            {
+                if (m_shared == nullptr)
+                {
+                    return;
+                }
+
+                Mqtt5ClientFleetShared *shared = m_shared;
+                m_shared = nullptr;
+
+                /* Waits for the callbacks that were admitted before, except the calling one */
+                shared->callbackGate.Close();
+
+                for (size_t i = 0; i < m_clientCount; ++i)
+                {
+                    aws_mqtt5_client_release(shared->members[i].client);
+                }
+
+                s_releaseShared(shared, 1);
+            }
+
+            std::shared_ptr<Mqtt5ClientFleet> Mqtt5ClientFleet::NewMqtt5ClientFleet(
+                const Mqtt5ClientOptions &options,
+                const Mqtt5ClientFleetOptions &fleetOptions,
+                Allocator *allocator) noexcept
+            {
+                if (fleetOptions.m_clientCount == 0)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return nullptr;
+                }
+
+                /* As the constructor is private, make share would not work here. We do make_share manually. */
+                Mqtt5ClientFleet *toSeat =
+                    reinterpret_cast<Mqtt5ClientFleet *>(aws_mem_acquire(allocator, sizeof(Mqtt5ClientFleet)));
+                if (!toSeat)
+                {
+                    return nullptr;
+                }
+
+                toSeat = new (toSeat) Mqtt5ClientFleet(options, fleetOptions, allocator);
+
+                /* Creation failed, make sure we release the allocated memory */
+                if (toSeat->m_shared == nullptr)
+                {
+                    Crt::Delete(toSeat, allocator);
+                    return nullptr;
+                }
+
+                return std::shared_ptr<Mqtt5ClientFleet>(
+                    toSeat, [allocator](Mqtt5ClientFleet *fleet) { Crt::Delete(fleet, allocator); });
+            }
+
+            int Mqtt5ClientFleet::LastError() const noexcept
+            {
+                return aws_last_error();
+            }
+
+            Mqtt5ClientFleetMember *Mqtt5ClientFleet::GetMember(size_t clientIndex) const noexcept
+            {
+                if (clientIndex >= m_clientCount)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return nullptr;
+                }
+
+                return &m_shared->members[clientIndex];
+            }
+
+            bool Mqtt5ClientFleet::Start() noexcept
+            {
+                bool started = true;
+                for (size_t i = 0; i < m_clientCount; ++i)
+                {
+                    started = Start(i) && started;
+                }
+                return started;
+            }
+
+            bool Mqtt5ClientFleet::Stop() noexcept
+            {
+                bool stopped = true;
+                for (size_t i = 0; i < m_clientCount; ++i)
+                {
+                    stopped = Stop(i) && stopped;
+                }
+                return stopped;
+            }
+
+            bool Mqtt5ClientFleet::Start(size_t clientIndex) noexcept
+            {
+                Mqtt5ClientFleetMember *member = GetMember(clientIndex);
+                return member != nullptr && aws_mqtt5_client_start(member->client) == AWS_OP_SUCCESS;
+            }
+
+            bool Mqtt5ClientFleet::Stop(size_t clientIndex, std::shared_ptr<DisconnectPacket> disconnectPacket) noexcept
+            {
+                Mqtt5ClientFleetMember *member = GetMember(clientIndex);
+                if (member == nullptr)
+                {
+                    return false;
+                }
+
+                if (disconnectPacket == nullptr)
+                {
+                    return aws_mqtt5_client_stop(member->client, NULL, NULL) == AWS_OP_SUCCESS;
+                }
+
+                aws_mqtt5_packet_disconnect_view disconnect;
+                if (!disconnectPacket->initializeRawOptions(disconnect))
+                {
+                    return false;
+                }
+                return aws_mqtt5_client_stop(member->client, &disconnect, NULL) == AWS_OP_SUCCESS;
+            }
+
+            bool Mqtt5ClientFleet::Publish(
+                size_t clientIndex,
+                std::shared_ptr<PublishPacket> publishPacket,
+                OnPublishCompletionHandler onPublishCompletionCallback) noexcept
+            {
+                Mqtt5ClientFleetMember *member = GetMember(clientIndex);
+                if (member == nullptr || publishPacket == nullptr || s_isOverBudget(*member))
+                {
+                    return false;
+                }
+
+                aws_mqtt5_packet_publish_view publish;
+                publishPacket->initializeRawOptions(publish);
+
+                auto data = Crt::New<FleetPublishCompletionData>(
+                    &member->allocator, m_shared, &member->allocator, std::move(onPublishCompletionCallback));
+
+                aws_mqtt5_publish_completion_options completionOptions{};
+                completionOptions.completion_callback = s_onPublishCompletion;
+                completionOptions.completion_user_data = data;
+
+                if (aws_mqtt5_client_publish(member->client, &publish, &completionOptions) != AWS_OP_SUCCESS)
+                {
+                    Crt::Delete(data, data->allocator);
+                    return false;
+                }
+                return true;
+            }
+
+            bool Mqtt5ClientFleet::Subscribe(
+                size_t clientIndex,
+                std::shared_ptr<SubscribePacket> subscribePacket,
+                OnSubscribeCompletionHandler onSubscribeCompletionCallback) noexcept
+            {
+                Mqtt5ClientFleetMember *member = GetMember(clientIndex);
+                if (member == nullptr || subscribePacket == nullptr || s_isOverBudget(*member))
+                {
+                    return false;
+                }
+
+                aws_mqtt5_packet_subscribe_view subscribe;
+                subscribePacket->initializeRawOptions(subscribe);
+
+                auto data = Crt::New<FleetSubscribeCompletionData>(
+                    &member->allocator, m_shared, &member->allocator, std::move(onSubscribeCompletionCallback));
+
+                aws_mqtt5_subscribe_completion_options completionOptions{};
+                completionOptions.completion_callback = s_onSubscribeCompletion;
+                completionOptions.completion_user_data = data;
+
+                if (aws_mqtt5_client_subscribe(member->client, &subscribe, &completionOptions) != AWS_OP_SUCCESS)
+                {
+                    Crt::Delete(data, data->allocator);
+                    return false;
+                }
+                return true;
+            }
+
+            bool Mqtt5ClientFleet::Unsubscribe(
+                size_t clientIndex,
+                std::shared_ptr<UnsubscribePacket> unsubscribePacket,
+                OnUnsubscribeCompletionHandler onUnsubscribeCompletionCallback) noexcept
+            {
+                Mqtt5ClientFleetMember *member = GetMember(clientIndex);
+                if (member == nullptr || unsubscribePacket == nullptr || s_isOverBudget(*member))
+                {
+                    return false;
+                }
+
+                aws_mqtt5_packet_unsubscribe_view unsubscribe;
+                unsubscribePacket->initializeRawOptions(unsubscribe);
+
+                auto data = Crt::New<FleetUnsubscribeCompletionData>(
+                    &member->allocator, m_shared, &member->allocator, std::move(onUnsubscribeCompletionCallback));
+
+                aws_mqtt5_unsubscribe_completion_options completionOptions{};
+                completionOptions.completion_callback = s_onUnsubscribeCompletion;
+                completionOptions.completion_user_data = data;
+
+                if (aws_mqtt5_client_unsubscribe(member->client, &unsubscribe, &completionOptions) != AWS_OP_SUCCESS)
+                {
+                    Crt::Delete(data, data->allocator);
+                    return false;
+                }
+                return true;
+            }
+
+            size_t Mqtt5ClientFleet::GetClientMemoryUsage(size_t clientIndex) const noexcept
+            {
+                Mqtt5ClientFleetMember *member = GetMember(clientIndex);
+                return member != nullptr ? member->bytes.load(std::memory_order_relaxed) : 0;
+            }
+
+            Mqtt5ClientOperationStatistics Mqtt5ClientFleet::GetOperationStatistics(size_t clientIndex) const noexcept
+            {
+                Mqtt5ClientOperationStatistics statistics = {0, 0, 0, 0};
+                Mqtt5ClientFleetMember *member = GetMember(clientIndex);
+                if (member != nullptr)
+                {
+                    aws_mqtt5_client_operation_statistics native = {0, 0, 0, 0};
+                    aws_mqtt5_client_get_stats(member->client, &native);
+                    statistics.incompleteOperationCount = native.incomplete_operation_count;
+                    statistics.incompleteOperationSize = native.incomplete_operation_size;
+                    statistics.unackedOperationCount = native.unacked_operation_count;
+                    statistics.unackedOperationSize = native.unacked_operation_size;
+                }
+                return statistics;
+            }
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
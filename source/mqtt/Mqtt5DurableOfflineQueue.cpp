@@ -0,0 +1,585 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/mqtt/private/Mqtt5DurableOfflineQueue.h>
+
+#include <aws/crt/checksum/CRC.h>
+
+#include <aws/common/file.h>
+
+#include <algorithm>
+#include <inttypes.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            static const uint32_t s_segmentMagic = 0x514D5741; /* "AWMQ" */
+            static const uint32_t s_segmentVersion = 1;
+            static const uint64_t s_segmentHeaderSize = 16;
+            static const uint64_t s_committedOffsetPosition = 8;
+
+            /* body length and CRC32 */
+            static const size_t s_recordPrefixSize = 8;
+
+            /* qos, retain and topic length at the start of the body */
+            static const size_t s_bodyHeaderSize = 4;
+
+            /* Completed records between two writes of the committed offset */
+            static const uint64_t s_commitBatchRecords = 32;
+
+            Mqtt5DurableOfflineQueue::Mqtt5DurableOfflineQueue(
+                const DurableOfflineQueueOptions &options,
+                SubmitHandler &&submit,
+                Allocator *allocator) noexcept
+                : m_allocator(allocator), m_path(options.m_segmentFilePath), m_submit(std::move(submit)),
+                  m_memoryWatermarkBytes(options.m_memoryWatermarkBytes), m_file(nullptr), m_connected(false),
+                  m_closed(false), m_draining(false), m_submitFailed(false), m_appendingCount(0), m_inMemoryBytes(0),
+                  m_committedOffset(s_segmentHeaderSize), m_persistedOffset(s_segmentHeaderSize),
+                  m_unpersistedCount(0), m_readOffset(s_segmentHeaderSize), m_writeOffset(s_segmentHeaderSize),
+                  m_pendingCount(0)
+            {
+                AWS_ZERO_STRUCT(m_readBuffer);
+                aws_byte_buf_init(&m_readBuffer, allocator, 0);
+            }
+
+            Mqtt5DurableOfflineQueue::~Mqtt5DurableOfflineQueue()
+            {
+                if (m_file != nullptr)
+                {
+                    fclose(m_file);
+                    m_file = nullptr;
+                }
+                aws_byte_buf_clean_up(&m_readBuffer);
+            }
+
+            ScopedResource<Mqtt5DurableOfflineQueue> Mqtt5DurableOfflineQueue::NewDurableOfflineQueue(
+                const DurableOfflineQueueOptions &options,
+                SubmitHandler &&submit,
+                Allocator *allocator) noexcept
+            {
+                if (options.m_segmentFilePath.empty())
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return nullptr;
+                }
+
+                ScopedResource<Mqtt5DurableOfflineQueue> queue = ScopedResource<Mqtt5DurableOfflineQueue>(
+                    Crt::New<Mqtt5DurableOfflineQueue>(allocator, options, std::move(submit), allocator),
+                    [allocator](Mqtt5DurableOfflineQueue *queue) { Crt::Delete(queue, allocator); });
+
+                if (!queue->Open())
+                {
+                    return nullptr;
+                }
+
+                return queue;
+            }
+
+            bool Mqtt5DurableOfflineQueue::Open() noexcept
+            {
+                m_file = aws_fopen(m_path.c_str(), "r+b");
+                if (m_file == nullptr)
+                {
+                    return Truncate();
+                }
+
+                int64_t fileLength = 0;
+                if (aws_file_get_length(m_file, &fileLength) != AWS_OP_SUCCESS)
+                {
+                    return false;
+                }
+
+                if (static_cast<uint64_t>(fileLength) < s_segmentHeaderSize)
+                {
+                    /* Created but never written, as after a crash right after creating it */
+                    return Truncate();
+                }
+
+                uint32_t magic = 0;
+                uint32_t version = 0;
+                uint64_t committedOffset = 0;
+                if (aws_fseek(m_file, 0, SEEK_SET) != AWS_OP_SUCCESS || fread(&magic, sizeof(magic), 1, m_file) != 1 ||
+                    fread(&version, sizeof(version), 1, m_file) != 1 ||
+                    fread(&committedOffset, sizeof(committedOffset), 1, m_file) != 1)
+                {
+                    aws_raise_error(AWS_ERROR_FILE_READ_FAILURE);
+                    return false;
+                }
+
+                if (magic != s_segmentMagic || version != s_segmentVersion || committedOffset < s_segmentHeaderSize ||
+                    committedOffset > static_cast<uint64_t>(fileLength))
+                {
+                    AWS_LOGF_ERROR(
+                        AWS_LS_MQTT5_CLIENT,
+                        "Durable offline queue: %s is not a segment file, refusing to overwrite it",
+                        m_path.c_str());
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return false;
+                }
+
+                /* Records end at the first one missing or torn */
+                uint64_t offset = committedOffset;
+                size_t recordSize = 0;
+                while ((recordSize = ReadRecord(offset, static_cast<uint64_t>(fileLength))) > 0)
+                {
+                    offset += recordSize;
+                    ++m_pendingCount;
+                }
+
+                if (m_pendingCount == 0)
+                {
+                    return Truncate();
+                }
+
+                m_committedOffset = committedOffset;
+                m_persistedOffset = committedOffset;
+                m_readOffset = committedOffset;
+                m_writeOffset = offset;
+
+                AWS_LOGF_INFO(
+                    AWS_LS_MQTT5_CLIENT,
+                    "Durable offline queue: recovered %" PRIu64 " publishes from %s",
+                    m_pendingCount,
+                    m_path.c_str());
+                return true;
+            }
+
+            bool Mqtt5DurableOfflineQueue::Truncate() noexcept
+            {
+                if (m_file != nullptr)
+                {
+                    fclose(m_file);
+                }
+
+                m_file = aws_fopen(m_path.c_str(), "w+b");
+                if (m_file == nullptr)
+                {
+                    return false;
+                }
+
+                if (fwrite(&s_segmentMagic, sizeof(s_segmentMagic), 1, m_file) != 1 ||
+                    fwrite(&s_segmentVersion, sizeof(s_segmentVersion), 1, m_file) != 1 ||
+                    fwrite(&s_segmentHeaderSize, sizeof(s_segmentHeaderSize), 1, m_file) != 1 || fflush(m_file) != 0)
+                {
+                    aws_raise_error(AWS_ERROR_FILE_WRITE_FAILURE);
+                    return false;
+                }
+
+                return true;
+            }
+
+            bool Mqtt5DurableOfflineQueue::WriteCommittedOffset(uint64_t committedOffset) noexcept
+            {
+                if (m_file == nullptr)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_FILE_HANDLE);
+                    return false;
+                }
+
+                if (aws_fseek(m_file, static_cast<int64_t>(s_committedOffsetPosition), SEEK_SET) != AWS_OP_SUCCESS ||
+                    fwrite(&committedOffset, sizeof(committedOffset), 1, m_file) != 1 || fflush(m_file) != 0)
+                {
+                    aws_raise_error(AWS_ERROR_FILE_WRITE_FAILURE);
+                    return false;
+                }
+
+                return true;
+            }
+
+            size_t Mqtt5DurableOfflineQueue::Append(
+                const aws_mqtt5_packet_publish_view &publish,
+                uint64_t offset) noexcept
+            {
+                /* Reopens the file if a previous truncation failed to */
+                if (m_file == nullptr && !Truncate())
+                {
+                    return 0;
+                }
+
+                if (publish.topic.len > UINT16_MAX ||
+                    publish.payload.len > UINT32_MAX - s_bodyHeaderSize - publish.topic.len)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return 0;
+                }
+
+                uint8_t bodyHeader[s_bodyHeaderSize];
+                bodyHeader[0] = static_cast<uint8_t>(publish.qos);
+                bodyHeader[1] = publish.retain ? 1 : 0;
+                uint16_t topicLength = static_cast<uint16_t>(publish.topic.len);
+                memcpy(bodyHeader + 2, &topicLength, sizeof(topicLength));
+
+                uint32_t bodyLength =
+                    static_cast<uint32_t>(s_bodyHeaderSize + publish.topic.len + publish.payload.len);
+                uint32_t crc = Checksum::ComputeCRC32(aws_byte_cursor_from_array(bodyHeader, sizeof(bodyHeader)));
+                crc = Checksum::ComputeCRC32(publish.topic, crc);
+                crc = Checksum::ComputeCRC32(publish.payload, crc);
+
+                /* A failed append leaves a torn record past the write offset, which the next append overwrites */
+                if (aws_fseek(m_file, static_cast<int64_t>(offset), SEEK_SET) != AWS_OP_SUCCESS ||
+                    fwrite(&bodyLength, sizeof(bodyLength), 1, m_file) != 1 ||
+                    fwrite(&crc, sizeof(crc), 1, m_file) != 1 ||
+                    fwrite(bodyHeader, sizeof(bodyHeader), 1, m_file) != 1 ||
+                    fwrite(publish.topic.ptr, 1, publish.topic.len, m_file) != publish.topic.len ||
+                    fwrite(publish.payload.ptr, 1, publish.payload.len, m_file) != publish.payload.len ||
+                    fflush(m_file) != 0)
+                {
+                    aws_raise_error(AWS_ERROR_FILE_WRITE_FAILURE);
+                    return 0;
+                }
+
+                return s_recordPrefixSize + bodyLength;
+            }
+
+            size_t Mqtt5DurableOfflineQueue::ReadRecord(uint64_t offset, uint64_t fileLength) noexcept
+            {
+                uint32_t bodyLength = 0;
+                uint32_t crc = 0;
+                if (m_file == nullptr || offset + s_recordPrefixSize > fileLength ||
+                    aws_fseek(m_file, static_cast<int64_t>(offset), SEEK_SET) != AWS_OP_SUCCESS ||
+                    fread(&bodyLength, sizeof(bodyLength), 1, m_file) != 1 || fread(&crc, sizeof(crc), 1, m_file) != 1)
+                {
+                    return 0;
+                }
+
+                if (bodyLength < s_bodyHeaderSize || offset + s_recordPrefixSize + bodyLength > fileLength)
+                {
+                    return 0;
+                }
+
+                m_readBuffer.len = 0;
+                if (aws_byte_buf_reserve(&m_readBuffer, bodyLength) != AWS_OP_SUCCESS ||
+                    fread(m_readBuffer.buffer, 1, bodyLength, m_file) != bodyLength)
+                {
+                    return 0;
+                }
+                m_readBuffer.len = bodyLength;
+
+                uint16_t topicLength = 0;
+                memcpy(&topicLength, m_readBuffer.buffer + 2, sizeof(topicLength));
+                if (Checksum::ComputeCRC32(aws_byte_cursor_from_buf(&m_readBuffer)) != crc ||
+                    s_bodyHeaderSize + topicLength > bodyLength)
+                {
+                    return 0;
+                }
+
+                return s_recordPrefixSize + bodyLength;
+            }
+
+            Mqtt5DurableOfflineQueue::OfferResult Mqtt5DurableOfflineQueue::Offer(
+                const aws_mqtt5_packet_publish_view &publish,
+                OnPublishCompletionHandler &onPublishCompletion) noexcept
+            {
+                size_t bytes = publish.topic.len + publish.payload.len;
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    if (m_closed)
+                    {
+                        aws_raise_error(AWS_ERROR_INVALID_STATE);
+                        return OfferResult::Failed;
+                    }
+
+                    /* Nothing may overtake the publishes already spilled, or being spilled */
+                    if (m_pendingCount == 0 && m_appendingCount == 0 && m_connected &&
+                        m_inMemoryBytes + bytes <= m_memoryWatermarkBytes)
+                    {
+                        m_inMemoryBytes += bytes;
+                        return OfferResult::Submit;
+                    }
+
+                    ++m_appendingCount;
+                }
+
+                bool drain = false;
+                {
+                    std::lock_guard<std::mutex> fileLock(m_fileLock);
+
+                    /* The write offset only moves with m_fileLock held, and may have been truncated back */
+                    uint64_t offset = 0;
+                    {
+                        std::lock_guard<std::mutex> lock(m_lock);
+                        offset = m_writeOffset;
+                    }
+
+                    size_t recordSize = Append(publish, offset);
+
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    --m_appendingCount;
+                    if (recordSize == 0)
+                    {
+                        return OfferResult::Failed;
+                    }
+
+                    m_writeOffset = offset + recordSize;
+                    if (onPublishCompletion)
+                    {
+                        PendingCallback pending;
+                        pending.offset = offset;
+                        pending.onPublishCompletion = std::move(onPublishCompletion);
+                        m_pendingCallbacks.push_back(std::move(pending));
+                    }
+
+                    ++m_pendingCount;
+                    drain = m_connected && HasRoom();
+                }
+
+                if (drain)
+                {
+                    Drain();
+                }
+
+                return OfferResult::Spilled;
+            }
+
+            bool Mqtt5DurableOfflineQueue::HasRoom() const noexcept
+            {
+                /* A publish larger than the watermark still goes out, alone */
+                return m_inMemoryBytes == 0 || m_inMemoryBytes < m_memoryWatermarkBytes;
+            }
+
+            bool Mqtt5DurableOfflineQueue::IsDrained() const noexcept
+            {
+                return !m_closed && m_pendingCount == 0 && m_appendingCount == 0 && m_inFlight.empty() &&
+                       m_committedOffset != s_segmentHeaderSize && m_committedOffset == m_writeOffset;
+            }
+
+            void Mqtt5DurableOfflineQueue::Drain() noexcept
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                if (m_draining)
+                {
+                    return;
+                }
+                m_draining = true;
+
+                /* Checked and cleared with m_lock held, so that a caller returning above is never left undrained */
+                while (!m_closed && m_connected && !m_submitFailed && m_pendingCount > 0 && HasRoom())
+                {
+                    uint64_t offset = m_readOffset;
+                    uint64_t writeOffset = m_writeOffset;
+                    lock.unlock();
+
+                    /* Records before the write offset are complete, and are not truncated while some are pending */
+                    size_t recordSize = 0;
+                    {
+                        std::lock_guard<std::mutex> fileLock(m_fileLock);
+                        recordSize = ReadRecord(offset, writeOffset);
+                    }
+
+                    lock.lock();
+                    if (recordSize == 0)
+                    {
+                        AWS_LOGF_ERROR(
+                            AWS_LS_MQTT5_CLIENT,
+                            "Durable offline queue: failed to read the record at offset %" PRIu64 " of %s",
+                            offset,
+                            m_path.c_str());
+                        break;
+                    }
+
+                    const uint8_t *body = m_readBuffer.buffer;
+                    uint16_t topicLength = 0;
+                    memcpy(&topicLength, body + 2, sizeof(topicLength));
+
+                    aws_mqtt5_packet_publish_view publish;
+                    AWS_ZERO_STRUCT(publish);
+                    publish.qos = static_cast<aws_mqtt5_qos>(body[0]);
+                    publish.retain = body[1] != 0;
+                    publish.topic = aws_byte_cursor_from_array(body + s_bodyHeaderSize, topicLength);
+                    publish.payload = aws_byte_cursor_from_array(
+                        body + s_bodyHeaderSize + topicLength, m_readBuffer.len - s_bodyHeaderSize - topicLength);
+                    size_t bytes = publish.topic.len + publish.payload.len;
+
+                    OnPublishCompletionHandler onPublishCompletion;
+                    if (!m_pendingCallbacks.empty() && m_pendingCallbacks.front().offset == offset)
+                    {
+                        onPublishCompletion = std::move(m_pendingCallbacks.front().onPublishCompletion);
+                        m_pendingCallbacks.pop_front();
+                    }
+
+                    uint64_t endOffset = offset + recordSize;
+                    m_readOffset = endOffset;
+                    m_inMemoryBytes += bytes;
+                    InFlightRecord inFlight;
+                    inFlight.endOffset = endOffset;
+                    inFlight.completed = false;
+                    m_inFlight.push_back(inFlight);
+
+                    /* m_readBuffer stays untouched while m_draining is set; the native client copies the publish */
+                    lock.unlock();
+                    bool submitted = m_submit(publish, std::move(onPublishCompletion), endOffset);
+                    lock.lock();
+
+                    if (!submitted)
+                    {
+                        /*
+                         * Puts the record back, uncommitted, still holding its callback. Only Drain() appends to
+                         * m_inFlight, and the record cannot have completed, so it is still the last one.
+                         */
+                        AWS_LOGF_WARN(
+                            AWS_LS_MQTT5_CLIENT,
+                            "Durable offline queue: failed to replay the record at offset %" PRIu64
+                            " of %s, retrying on the next connection",
+                            offset,
+                            m_path.c_str());
+                        m_inFlight.pop_back();
+                        m_inMemoryBytes -= std::min(static_cast<uint64_t>(bytes), m_inMemoryBytes);
+                        m_readOffset = offset;
+                        if (onPublishCompletion)
+                        {
+                            PendingCallback pending;
+                            pending.offset = offset;
+                            pending.onPublishCompletion = std::move(onPublishCompletion);
+                            m_pendingCallbacks.push_front(std::move(pending));
+                        }
+                        m_submitFailed = true;
+                        break;
+                    }
+
+                    --m_pendingCount;
+                }
+
+                m_draining = false;
+            }
+
+            void Mqtt5DurableOfflineQueue::CompletePublish(size_t bytes, uint64_t endOffset) noexcept
+            {
+                m_inMemoryBytes -= std::min(static_cast<uint64_t>(bytes), m_inMemoryBytes);
+
+                /* Once closed, whatever did not complete yet is left for the next client to replay */
+                if (endOffset == 0 || m_closed)
+                {
+                    return;
+                }
+
+                for (InFlightRecord &record : m_inFlight)
+                {
+                    if (record.endOffset == endOffset)
+                    {
+                        record.completed = true;
+                        break;
+                    }
+                }
+
+                /* Publishes may complete out of order: only commit the completed prefix */
+                while (!m_inFlight.empty() && m_inFlight.front().completed)
+                {
+                    m_committedOffset = m_inFlight.front().endOffset;
+                    m_inFlight.pop_front();
+                    ++m_unpersistedCount;
+                }
+            }
+
+            void Mqtt5DurableOfflineQueue::Sync() noexcept
+            {
+                std::lock_guard<std::mutex> fileLock(m_fileLock);
+
+                /*
+                 * With m_fileLock held nothing is appended or replayed, so a drained queue stays drained and the
+                 * committed offset can only move forward until the file is written.
+                 */
+                bool truncate = false;
+                uint64_t committedOffset = 0;
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    truncate = IsDrained();
+                    committedOffset = m_committedOffset;
+                    if (!truncate && committedOffset == m_persistedOffset)
+                    {
+                        return;
+                    }
+                    m_unpersistedCount = 0;
+                }
+
+                if (truncate)
+                {
+                    if (!Truncate())
+                    {
+                        AWS_LOGF_ERROR(
+                            AWS_LS_MQTT5_CLIENT,
+                            "Durable offline queue: failed to truncate %s, error %s",
+                            m_path.c_str(),
+                            aws_error_debug_str(aws_last_error()));
+                    }
+
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_committedOffset = s_segmentHeaderSize;
+                    m_persistedOffset = s_segmentHeaderSize;
+                    m_readOffset = s_segmentHeaderSize;
+                    m_writeOffset = s_segmentHeaderSize;
+                    return;
+                }
+
+                if (!WriteCommittedOffset(committedOffset))
+                {
+                    AWS_LOGF_ERROR(
+                        AWS_LS_MQTT5_CLIENT,
+                        "Durable offline queue: failed to commit offset %" PRIu64 " of %s, error %s",
+                        committedOffset,
+                        m_path.c_str(),
+                        aws_error_debug_str(aws_last_error()));
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_persistedOffset = committedOffset;
+            }
+
+            void Mqtt5DurableOfflineQueue::OnPublishCompleted(size_t bytes, uint64_t endOffset) noexcept
+            {
+                bool sync = false;
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    CompletePublish(bytes, endOffset);
+                    sync = IsDrained() || m_unpersistedCount >= s_commitBatchRecords;
+                }
+
+                if (sync)
+                {
+                    Sync();
+                }
+
+                Drain();
+            }
+
+            void Mqtt5DurableOfflineQueue::OnReplayFailed(size_t bytes) noexcept
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_inMemoryBytes -= std::min(static_cast<uint64_t>(bytes), m_inMemoryBytes);
+                m_submitFailed = true;
+            }
+
+            void Mqtt5DurableOfflineQueue::OnConnectionSuccess() noexcept
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_connected = true;
+                    m_submitFailed = false;
+                }
+
+                Drain();
+            }
+
+            void Mqtt5DurableOfflineQueue::OnDisconnection() noexcept
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_connected = false;
+            }
+
+            void Mqtt5DurableOfflineQueue::Close() noexcept
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_closed = true;
+                }
+
+                /* Commits what completed since the last batch */
+                Sync();
+            }
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
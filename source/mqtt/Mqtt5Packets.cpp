@@ -5,6 +5,9 @@
 #include <aws/crt/mqtt/Mqtt5Client.h>
 #include <aws/crt/mqtt/Mqtt5Packets.h>
 
+#include <cstring>
+#include <new>
+
 namespace Aws
 {
     namespace Crt
@@ -133,6 +136,39 @@ namespace Aws
                 }
             }
 
+            /* Shared properties first, then the packet's own */
+            void s_AllocateUnderlyingUserProperties(
+                aws_mqtt5_user_property *&dst,
+                const UserPropertyList &sharedProperties,
+                const Crt::Vector<UserProperty> &userProperties,
+                Allocator *allocator)
+            {
+                if (dst != nullptr)
+                {
+                    aws_mem_release(allocator, (void *)dst);
+                    dst = nullptr;
+                }
+
+                size_t sharedCount = sharedProperties.GetCount();
+                size_t count = sharedCount + userProperties.size();
+                if (count > 0)
+                {
+                    dst = reinterpret_cast<struct aws_mqtt5_user_property *>(
+                        aws_mem_calloc(allocator, count, sizeof(aws_mqtt5_user_property)));
+                    if (sharedCount > 0)
+                    {
+                        memcpy(dst, sharedProperties.GetNativeProperties(), sharedCount * sizeof(*dst));
+                    }
+                    for (size_t index = 0; index < userProperties.size(); ++index)
+                    {
+                        (dst + sharedCount + index)->name = aws_byte_cursor_from_array(
+                            userProperties[index].getName().c_str(), userProperties[index].getName().length());
+                        (dst + sharedCount + index)->value = aws_byte_cursor_from_array(
+                            userProperties[index].getValue().c_str(), userProperties[index].getValue().length());
+                    }
+                }
+            }
+
             void s_AllocateStringVector(
                 aws_array_list &dst,
                 const Crt::Vector<String> &stringVector,
@@ -463,6 +499,71 @@ namespace Aws
                 return *this;
             }
 
+            UserPropertyList::UserPropertyList(
+                aws_mqtt5_user_property *properties,
+                size_t count,
+                Allocator *allocator) noexcept
+                : m_properties(properties), m_count(count), m_allocator(allocator)
+            {
+            }
+
+            UserPropertyList::~UserPropertyList() {}
+
+            std::shared_ptr<const UserPropertyList> UserPropertyList::NewUserPropertyList(
+                const Vector<UserProperty> &userProperties,
+                Allocator *allocator) noexcept
+            {
+                /* The list, then the native array, then the names and values it points to, in one allocation */
+                size_t arrayOffset = sizeof(UserPropertyList);
+                arrayOffset += (alignof(aws_mqtt5_user_property) - arrayOffset % alignof(aws_mqtt5_user_property)) %
+                               alignof(aws_mqtt5_user_property);
+                size_t arenaOffset = 0;
+                if (aws_mul_size_checked(userProperties.size(), sizeof(aws_mqtt5_user_property), &arenaOffset) ||
+                    aws_add_size_checked(arenaOffset, arrayOffset, &arenaOffset))
+                {
+                    return nullptr;
+                }
+
+                size_t size = arenaOffset;
+                for (const UserProperty &property : userProperties)
+                {
+                    if (aws_add_size_checked(size, property.getName().size(), &size) ||
+                        aws_add_size_checked(size, property.getValue().size(), &size))
+                    {
+                        return nullptr;
+                    }
+                }
+
+                uint8_t *block = reinterpret_cast<uint8_t *>(aws_mem_acquire(allocator, size));
+                if (block == nullptr)
+                {
+                    return nullptr;
+                }
+
+                auto *properties = reinterpret_cast<aws_mqtt5_user_property *>(block + arrayOffset);
+                uint8_t *arena = block + arenaOffset;
+                for (size_t index = 0; index < userProperties.size(); ++index)
+                {
+                    const Crt::String &name = userProperties[index].getName();
+                    const Crt::String &value = userProperties[index].getValue();
+                    memcpy(arena, name.data(), name.size());
+                    properties[index].name = aws_byte_cursor_from_array(arena, name.size());
+                    arena += name.size();
+                    memcpy(arena, value.data(), value.size());
+                    properties[index].value = aws_byte_cursor_from_array(arena, value.size());
+                    arena += value.size();
+                }
+
+                UserPropertyList *list = new (block) UserPropertyList(properties, userProperties.size(), allocator);
+                return std::shared_ptr<const UserPropertyList>(
+                    list,
+                    [allocator](const UserPropertyList *toRelease)
+                    {
+                        toRelease->~UserPropertyList();
+                        aws_mem_release(allocator, const_cast<UserPropertyList *>(toRelease));
+                    });
+            }
+
             PublishPacket::PublishPacket(const aws_mqtt5_packet_publish_view &packet, Allocator *allocator) noexcept
                 : m_allocator(allocator), m_qos(packet.qos), m_retain(packet.retain),
                   m_topicName((const char *)packet.topic.ptr, packet.topic.len), m_userPropertiesStorage(nullptr)
@@ -521,6 +622,27 @@ namespace Aws
                 aws_byte_buf_clean_up(&m_payloadStorage);
                 aws_byte_buf_init_copy_from_cursor(&m_payloadStorage, m_allocator, payload);
                 m_payload = aws_byte_cursor_from_buf(&m_payloadStorage);
+                m_payloadOwner = nullptr;
+                return *this;
+            }
+
+            PublishPacket &PublishPacket::WithPayload(ByteBuf &&payload) noexcept
+            {
+                aws_byte_buf_clean_up(&m_payloadStorage);
+                m_payloadStorage = payload;
+                AWS_ZERO_STRUCT(payload);
+                m_payload = aws_byte_cursor_from_buf(&m_payloadStorage);
+                m_payloadOwner = nullptr;
+                return *this;
+            }
+
+            PublishPacket &PublishPacket::WithPayload(
+                ByteCursor payload,
+                std::shared_ptr<const void> payloadOwner) noexcept
+            {
+                aws_byte_buf_clean_up(&m_payloadStorage);
+                m_payload = payload;
+                m_payloadOwner = std::move(payloadOwner);
                 return *this;
             }
 
@@ -572,6 +694,12 @@ namespace Aws
                 return *this;
             }
 
+            PublishPacket &PublishPacket::WithContentType(ByteCursor contentType) noexcept
+            {
+                setPacketByteBufOptional(m_contentType, m_contentTypeStorage, m_allocator, &contentType);
+                return *this;
+            }
+
             PublishPacket &PublishPacket::WithUserProperties(const Vector<UserProperty> &userProperties) noexcept
             {
                 m_userProperties = userProperties;
@@ -590,6 +718,13 @@ namespace Aws
                 return *this;
             }
 
+            PublishPacket &PublishPacket::WithUserPropertyList(
+                std::shared_ptr<const UserPropertyList> userPropertyList) noexcept
+            {
+                m_userPropertyList = std::move(userPropertyList);
+                return *this;
+            }
+
             bool PublishPacket::initializeRawOptions(aws_mqtt5_packet_publish_view &raw_options) noexcept
             {
                 AWS_ZERO_STRUCT(raw_options);
@@ -619,10 +754,30 @@ namespace Aws
                 {
                     raw_options.correlation_data = &m_correlationData.value();
                 }
+                if (m_contentType.has_value())
+                {
+                    raw_options.content_type = &m_contentType.value();
+                }
 
-                s_AllocateUnderlyingUserProperties(m_userPropertiesStorage, m_userProperties, m_allocator);
-                raw_options.user_properties = m_userPropertiesStorage;
-                raw_options.user_property_count = m_userProperties.size();
+                if (m_userPropertyList && m_userProperties.empty())
+                {
+                    /* Encoded once for every packet sharing it */
+                    raw_options.user_properties = m_userPropertyList->GetNativeProperties();
+                    raw_options.user_property_count = m_userPropertyList->GetCount();
+                }
+                else if (m_userPropertyList)
+                {
+                    s_AllocateUnderlyingUserProperties(
+                        m_userPropertiesStorage, *m_userPropertyList, m_userProperties, m_allocator);
+                    raw_options.user_properties = m_userPropertiesStorage;
+                    raw_options.user_property_count = m_userPropertyList->GetCount() + m_userProperties.size();
+                }
+                else
+                {
+                    s_AllocateUnderlyingUserProperties(m_userPropertiesStorage, m_userProperties, m_allocator);
+                    raw_options.user_properties = m_userPropertiesStorage;
+                    raw_options.user_property_count = m_userProperties.size();
+                }
 
                 return true;
             }
@@ -687,19 +842,145 @@ namespace Aws
                 return m_userProperties;
             }
 
+            const std::shared_ptr<const UserPropertyList> &PublishPacket::getUserPropertyList() const noexcept
+            {
+                return m_userPropertyList;
+            }
+
             PublishPacket::~PublishPacket()
             {
                 aws_byte_buf_clean_up(&m_payloadStorage);
                 aws_byte_buf_clean_up(&m_correlationDataStorage);
                 aws_byte_buf_clean_up(&m_contentTypeStorage);
 
-                if (m_userProperties.size() > 0)
+                if (m_userPropertiesStorage != nullptr)
                 {
                     aws_mem_release(m_allocator, m_userPropertiesStorage);
                     m_userProperties.clear();
                 }
             }
 
+            static void s_CopyOptionalCursor(ByteBuf &storage, ByteCursor &cursor, const Optional<ByteCursor> &value)
+            {
+                if (value.has_value())
+                {
+                    aws_byte_buf_init_copy_from_cursor(&storage, storage.allocator, value.value());
+                    cursor = aws_byte_cursor_from_buf(&storage);
+                }
+            }
+
+            PublishTemplate::PublishTemplate(
+                const PublishPacket &fields,
+                std::shared_ptr<const UserPropertyList> &&userProperties,
+                Allocator *allocator) noexcept
+                : m_topic(fields.getTopic()), m_payloadFormatIndicator(fields.getPayloadFormatIndicator()),
+                  m_messageExpiryIntervalSec(fields.getMessageExpiryIntervalSec()),
+                  m_topicAlias(fields.getTopicAlias()), m_userProperties(std::move(userProperties))
+            {
+                AWS_ZERO_STRUCT(m_responseTopicCursor);
+                AWS_ZERO_STRUCT(m_correlationDataCursor);
+                AWS_ZERO_STRUCT(m_contentTypeCursor);
+                for (ByteBuf *storage : {&m_responseTopic, &m_correlationData, &m_contentType})
+                {
+                    AWS_ZERO_STRUCT(*storage);
+                    storage->allocator = allocator;
+                }
+                s_CopyOptionalCursor(m_responseTopic, m_responseTopicCursor, fields.getResponseTopic());
+                s_CopyOptionalCursor(m_correlationData, m_correlationDataCursor, fields.getCorrelationData());
+                s_CopyOptionalCursor(m_contentType, m_contentTypeCursor, fields.getContentType());
+
+                AWS_ZERO_STRUCT(m_view);
+                m_view.topic = ByteCursorFromString(m_topic);
+                m_view.qos = fields.getQOS();
+                m_view.retain = fields.getRetain();
+                if (m_payloadFormatIndicator.has_value())
+                {
+                    m_view.payload_format = &m_payloadFormatIndicator.value();
+                }
+                if (m_messageExpiryIntervalSec.has_value())
+                {
+                    m_view.message_expiry_interval_seconds = &m_messageExpiryIntervalSec.value();
+                }
+                if (m_topicAlias.has_value())
+                {
+                    m_view.topic_alias = &m_topicAlias.value();
+                }
+                if (fields.getResponseTopic().has_value())
+                {
+                    m_view.response_topic = &m_responseTopicCursor;
+                }
+                if (fields.getCorrelationData().has_value())
+                {
+                    m_view.correlation_data = &m_correlationDataCursor;
+                }
+                if (fields.getContentType().has_value())
+                {
+                    m_view.content_type = &m_contentTypeCursor;
+                }
+                if (m_userProperties)
+                {
+                    m_view.user_properties = m_userProperties->GetNativeProperties();
+                    m_view.user_property_count = m_userProperties->GetCount();
+                }
+            }
+
+            PublishTemplate::~PublishTemplate()
+            {
+                aws_byte_buf_clean_up(&m_responseTopic);
+                aws_byte_buf_clean_up(&m_correlationData);
+                aws_byte_buf_clean_up(&m_contentType);
+            }
+
+            std::shared_ptr<const PublishTemplate> PublishTemplate::NewPublishTemplate(
+                const PublishPacket &fields,
+                Allocator *allocator) noexcept
+            {
+                /* Shared lists are kept as they are, anything else is encoded into a list of the template */
+                std::shared_ptr<const UserPropertyList> userProperties = fields.getUserPropertyList();
+                if (!fields.getUserProperties().empty())
+                {
+                    Vector<UserProperty> combined;
+                    if (userProperties)
+                    {
+                        const aws_mqtt5_user_property *shared = userProperties->GetNativeProperties();
+                        for (size_t i = 0; i < userProperties->GetCount(); ++i)
+                        {
+                            combined.push_back(UserProperty(
+                                Crt::String((const char *)shared[i].name.ptr, shared[i].name.len),
+                                Crt::String((const char *)shared[i].value.ptr, shared[i].value.len)));
+                        }
+                    }
+                    combined.insert(
+                        combined.end(), fields.getUserProperties().begin(), fields.getUserProperties().end());
+
+                    userProperties = UserPropertyList::NewUserPropertyList(combined, allocator);
+                    if (!userProperties)
+                    {
+                        return nullptr;
+                    }
+                }
+
+                PublishTemplate *toSeat =
+                    reinterpret_cast<PublishTemplate *>(aws_mem_acquire(allocator, sizeof(PublishTemplate)));
+                if (toSeat == nullptr)
+                {
+                    return nullptr;
+                }
+
+                toSeat = new (toSeat) PublishTemplate(fields, std::move(userProperties), allocator);
+                return std::shared_ptr<const PublishTemplate>(
+                    toSeat,
+                    [allocator](const PublishTemplate *publishTemplate)
+                    { Crt::Delete(const_cast<PublishTemplate *>(publishTemplate), allocator); });
+            }
+
+            void PublishTemplate::initializeRawOptions(aws_mqtt5_packet_publish_view &raw_options, ByteCursor payload)
+                const noexcept
+            {
+                raw_options = m_view;
+                raw_options.payload = payload;
+            }
+
             DisconnectPacket::DisconnectPacket(Allocator *allocator) noexcept
                 : m_allocator(allocator), m_reasonCode(AWS_MQTT5_DRC_NORMAL_DISCONNECTION),
                   m_userPropertiesStorage(nullptr)
@@ -0,0 +1,191 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/mqtt/private/Mqtt5PayloadCompression.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            static const char *s_contentEncodingName = "content-encoding";
+
+            static ByteCursor s_EncodingOf(CompressionAlgorithm algorithm) noexcept
+            {
+                return ByteCursorFromCString(algorithm == CompressionAlgorithm::Zstd ? "zstd" : "deflate");
+            }
+
+            Mqtt5PayloadTransformStorage::Mqtt5PayloadTransformStorage(Allocator *allocator) noexcept
+                : userProperties(StlAllocator<aws_mqtt5_user_property>(allocator))
+            {
+                AWS_ZERO_STRUCT(payload);
+                aws_byte_buf_init(&payload, allocator, 0);
+            }
+
+            Mqtt5PayloadTransformStorage::~Mqtt5PayloadTransformStorage()
+            {
+                aws_byte_buf_clean_up(&payload);
+            }
+
+            Mqtt5PayloadCompression::Mqtt5PayloadCompression(
+                const PayloadCompressionOptions &options,
+                size_t maxDecompressedBytes,
+                Allocator *allocator) noexcept
+                : m_allocator(allocator), m_algorithm(options.m_algorithm), m_thresholdBytes(options.m_thresholdBytes),
+                  m_level(options.m_level), m_maxDecompressedBytes(maxDecompressedBytes),
+                  m_compressors(StlAllocator<StreamCodec>(allocator)),
+                  m_deflateDecompressors(StlAllocator<StreamCodec>(allocator)),
+                  m_zstdDecompressors(StlAllocator<StreamCodec>(allocator))
+            {
+            }
+
+            StreamCodec Mqtt5PayloadCompression::AcquireCodec(
+                Vector<StreamCodec> &pool,
+                bool compressor,
+                CompressionAlgorithm algorithm)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_poolLock);
+                    if (!pool.empty())
+                    {
+                        StreamCodec codec = std::move(pool.back());
+                        pool.pop_back();
+                        return codec;
+                    }
+                }
+
+                return compressor ? StreamCodec::CreateCompressor(algorithm, m_level, m_allocator)
+                                  : StreamCodec::CreateDecompressor(algorithm, m_allocator);
+            }
+
+            void Mqtt5PayloadCompression::ReleaseCodec(Vector<StreamCodec> &pool, StreamCodec &&codec) noexcept
+            {
+                std::lock_guard<std::mutex> lock(m_poolLock);
+                pool.push_back(std::move(codec));
+            }
+
+            bool Mqtt5PayloadCompression::Compress(
+                aws_mqtt5_packet_publish_view &publish,
+                Mqtt5PayloadTransformStorage &storage) noexcept
+            {
+                if (publish.payload.len == 0 || publish.payload.len < m_thresholdBytes)
+                {
+                    return true;
+                }
+
+                StreamCodec codec = AcquireCodec(m_compressors, true, m_algorithm);
+                if (!codec)
+                {
+                    aws_raise_error(codec.LastError());
+                    return false;
+                }
+
+                storage.payload.len = 0;
+                ByteCursor input = publish.payload;
+                if (!codec.Update(input, storage.payload) || !codec.Finish(storage.payload))
+                {
+                    /* The codec is left mid-stream, so it is not pooled */
+                    return false;
+                }
+                ReleaseCodec(m_compressors, std::move(codec));
+
+                /* Incompressible payloads, already compressed media for instance, go out as they are */
+                if (storage.payload.len >= publish.payload.len)
+                {
+                    return true;
+                }
+
+                storage.userProperties.assign(
+                    publish.user_properties, publish.user_properties + publish.user_property_count);
+                aws_mqtt5_user_property contentEncoding;
+                contentEncoding.name = ByteCursorFromCString(s_contentEncodingName);
+                contentEncoding.value = s_EncodingOf(m_algorithm);
+                storage.userProperties.push_back(contentEncoding);
+
+                publish.payload = ByteCursorFromByteBuf(storage.payload);
+                publish.user_properties = storage.userProperties.data();
+                publish.user_property_count = storage.userProperties.size();
+
+                /* Compressed bytes are not UTF-8 anymore */
+                publish.payload_format = nullptr;
+                return true;
+            }
+
+            bool Mqtt5PayloadCompression::Decompress(
+                aws_mqtt5_packet_publish_view &publish,
+                Mqtt5PayloadTransformStorage &storage) noexcept
+            {
+                ByteCursor contentEncodingName = ByteCursorFromCString(s_contentEncodingName);
+                size_t encodingIndex = publish.user_property_count;
+                for (size_t i = 0; i < publish.user_property_count; ++i)
+                {
+                    if (aws_byte_cursor_eq_ignore_case(&publish.user_properties[i].name, &contentEncodingName))
+                    {
+                        encodingIndex = i;
+                        break;
+                    }
+                }
+
+                if (encodingIndex == publish.user_property_count)
+                {
+                    return true;
+                }
+
+                const ByteCursor &encoding = publish.user_properties[encodingIndex].value;
+                CompressionAlgorithm algorithm = CompressionAlgorithm::Deflate;
+                ByteCursor zstd = s_EncodingOf(CompressionAlgorithm::Zstd);
+                ByteCursor deflate = s_EncodingOf(CompressionAlgorithm::Deflate);
+                if (aws_byte_cursor_eq_ignore_case(&encoding, &zstd))
+                {
+                    algorithm = CompressionAlgorithm::Zstd;
+                }
+                else if (!aws_byte_cursor_eq_ignore_case(&encoding, &deflate))
+                {
+                    /* Some other encoding, for the application to handle */
+                    return true;
+                }
+
+                Vector<StreamCodec> &pool =
+                    algorithm == CompressionAlgorithm::Zstd ? m_zstdDecompressors : m_deflateDecompressors;
+                StreamCodec codec = AcquireCodec(pool, false, algorithm);
+                if (!codec)
+                {
+                    aws_raise_error(codec.LastError());
+                    return false;
+                }
+
+                storage.payload.len = 0;
+                ByteCursor input = publish.payload;
+                if (!codec.Update(input, storage.payload, m_maxDecompressedBytes) || !codec.Finish(storage.payload))
+                {
+                    /* The codec is left mid-stream, so it is not pooled */
+                    return false;
+                }
+                ReleaseCodec(pool, std::move(codec));
+
+                /* The end of the stream may have flushed a few more bytes */
+                if (storage.payload.len > m_maxDecompressedBytes)
+                {
+                    aws_raise_error(AWS_ERROR_SHORT_BUFFER);
+                    return false;
+                }
+
+                storage.userProperties.clear();
+                for (size_t i = 0; i < publish.user_property_count; ++i)
+                {
+                    if (i != encodingIndex)
+                    {
+                        storage.userProperties.push_back(publish.user_properties[i]);
+                    }
+                }
+
+                publish.payload = ByteCursorFromByteBuf(storage.payload);
+                publish.user_properties = storage.userProperties.data();
+                publish.user_property_count = storage.userProperties.size();
+                return true;
+            }
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
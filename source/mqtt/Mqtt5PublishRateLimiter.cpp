@@ -0,0 +1,275 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/mqtt/private/Mqtt5PublishRateLimiter.h>
+
+#include <aws/common/clock.h>
+
+#include <algorithm>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            static uint64_t s_Now() noexcept
+            {
+                uint64_t now = 0;
+                aws_high_res_clock_get_ticks(&now);
+                return now;
+            }
+
+            Mqtt5TokenBucket::Mqtt5TokenBucket(uint64_t tokensPerSecond, uint64_t nowNs) noexcept
+                : m_tokensPerSecond(tokensPerSecond), m_tokens(static_cast<double>(tokensPerSecond)),
+                  m_refilledAtNs(nowNs)
+            {
+            }
+
+            void Mqtt5TokenBucket::Refill(uint64_t nowNs) noexcept
+            {
+                if (nowNs <= m_refilledAtNs)
+                {
+                    return;
+                }
+
+                double refill =
+                    static_cast<double>(nowNs - m_refilledAtNs) * m_tokensPerSecond / AWS_TIMESTAMP_NANOS;
+                m_tokens = std::min(m_tokens + refill, static_cast<double>(m_tokensPerSecond));
+                m_refilledAtNs = nowNs;
+            }
+
+            uint64_t Mqtt5TokenBucket::GetDelayNanos(uint64_t tokens, uint64_t nowNs) noexcept
+            {
+                Refill(nowNs);
+
+                double needed = static_cast<double>(std::min(tokens, m_tokensPerSecond));
+                if (m_tokens >= needed)
+                {
+                    return 0;
+                }
+
+                /* Rounded up so that the timer does not fire just before the tokens are there */
+                double delay = (needed - m_tokens) * AWS_TIMESTAMP_NANOS / m_tokensPerSecond;
+                return static_cast<uint64_t>(delay) + 1;
+            }
+
+            void Mqtt5TokenBucket::Take(uint64_t tokens) noexcept
+            {
+                m_tokens -= static_cast<double>(tokens);
+            }
+
+            Mqtt5PublishRateLimiter::Lane::Lane(
+                const PublishRateLimit &limit,
+                uint64_t nowNs,
+                Allocator *allocator) noexcept
+                : m_limitsMessages(limit.m_messagesPerSecond > 0), m_limitsBytes(limit.m_bytesPerSecond > 0),
+                  m_messages(limit.m_messagesPerSecond, nowNs), m_bytes(limit.m_bytesPerSecond, nowNs),
+                  m_queue(StlAllocator<QueuedPublish>(allocator))
+            {
+            }
+
+            uint64_t Mqtt5PublishRateLimiter::Lane::GetDelayNanos(uint64_t bytes, uint64_t nowNs) noexcept
+            {
+                uint64_t delay = 0;
+                if (m_limitsMessages)
+                {
+                    delay = m_messages.GetDelayNanos(1, nowNs);
+                }
+                if (m_limitsBytes)
+                {
+                    delay = std::max(delay, m_bytes.GetDelayNanos(bytes, nowNs));
+                }
+                return delay;
+            }
+
+            void Mqtt5PublishRateLimiter::Lane::Take(uint64_t bytes) noexcept
+            {
+                if (m_limitsMessages)
+                {
+                    m_messages.Take(1);
+                }
+                if (m_limitsBytes)
+                {
+                    m_bytes.Take(bytes);
+                }
+            }
+
+            Mqtt5PublishRateLimiter::Mqtt5PublishRateLimiter(
+                const PublishRateLimitOptions &options,
+                SubmitHandler &&submit,
+                ScheduleHandler &&schedule,
+                Allocator *allocator) noexcept
+                : m_allocator(allocator), m_submit(std::move(submit)), m_schedule(std::move(schedule)),
+                  m_qos0(options.m_qos0, s_Now(), allocator), m_qos1(options.m_qos1, s_Now(), allocator),
+                  m_closed(false), m_draining(false), m_timerDueNs(0), m_publishesRateLimited(0), m_delayNanos(0)
+            {
+            }
+
+            Mqtt5PublishRateLimiter::OfferResult Mqtt5PublishRateLimiter::Offer(
+                const aws_mqtt5_packet_publish_view &publish,
+                const std::shared_ptr<PublishPacket> &packet,
+                OnPublishCompletionHandler &onPublishCompletion,
+                uint64_t offlineQueueEndOffset) noexcept
+            {
+                uint64_t bytes = publish.topic.len + publish.payload.len;
+                uint64_t now = s_Now();
+
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (m_closed)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_STATE);
+                    return OfferResult::Failed;
+                }
+
+                Lane &lane = LaneOf(publish.qos);
+                if (!m_draining && lane.m_queue.empty() && lane.GetDelayNanos(bytes, now) == 0)
+                {
+                    lane.Take(bytes);
+                    return OfferResult::Submit;
+                }
+
+                QueuedPublish queued;
+                queued.packet = packet;
+                if (!queued.packet)
+                {
+                    /* A publish replayed by the durable offline queue points into a buffer it reuses */
+                    queued.packet = MakeShared<PublishPacket>(m_allocator, publish, m_allocator);
+                    if (!queued.packet)
+                    {
+                        return OfferResult::Failed;
+                    }
+                }
+                queued.onPublishCompletion = std::move(onPublishCompletion);
+                queued.offlineQueueEndOffset = offlineQueueEndOffset;
+                queued.bytes = bytes;
+                queued.queuedAtNs = now;
+                lane.m_queue.push_back(std::move(queued));
+                ++m_publishesRateLimited;
+
+                if (!m_draining)
+                {
+                    ScheduleTimer(now);
+                }
+                return OfferResult::Queued;
+            }
+
+            void Mqtt5PublishRateLimiter::ScheduleTimer(uint64_t nowNs) noexcept
+            {
+                uint64_t delay = UINT64_MAX;
+                for (Lane *lane : {&m_qos0, &m_qos1})
+                {
+                    if (!lane->m_queue.empty())
+                    {
+                        delay = std::min(delay, lane->GetDelayNanos(lane->m_queue.front().bytes, nowNs));
+                    }
+                }
+
+                if (delay == UINT64_MAX || m_closed)
+                {
+                    return;
+                }
+
+                uint64_t dueNs = nowNs + delay;
+                if (m_timerDueNs != 0 && m_timerDueNs <= dueNs)
+                {
+                    return;
+                }
+
+                if (!m_schedule(delay))
+                {
+                    /* Retried by the next Offer() */
+                    AWS_LOGF_ERROR(AWS_LS_MQTT5_CLIENT, "Publish rate limiter: failed to schedule its timer.");
+                    return;
+                }
+                m_timerDueNs = dueNs;
+            }
+
+            void Mqtt5PublishRateLimiter::OnTimer() noexcept
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                uint64_t now = s_Now();
+
+                /* Possibly an earlier timer than the one recorded, which at worst leads to a spare timer */
+                m_timerDueNs = 0;
+                if (m_draining)
+                {
+                    return;
+                }
+                m_draining = true;
+
+                while (!m_closed)
+                {
+                    /* The eligible head queued first, so that both QoS keep their relative order where they can */
+                    Lane *next = nullptr;
+                    for (Lane *lane : {&m_qos0, &m_qos1})
+                    {
+                        if (!lane->m_queue.empty() && lane->GetDelayNanos(lane->m_queue.front().bytes, now) == 0 &&
+                            (next == nullptr || lane->m_queue.front().queuedAtNs < next->m_queue.front().queuedAtNs))
+                        {
+                            next = lane;
+                        }
+                    }
+                    if (next == nullptr)
+                    {
+                        break;
+                    }
+
+                    QueuedPublish queued = std::move(next->m_queue.front());
+                    next->m_queue.pop_front();
+                    next->Take(queued.bytes);
+                    m_delayNanos += now - std::min(now, queued.queuedAtNs);
+
+                    lock.unlock();
+                    aws_mqtt5_packet_publish_view publish;
+                    queued.packet->initializeRawOptions(publish);
+                    m_submit(publish, std::move(queued.onPublishCompletion), queued.offlineQueueEndOffset);
+                    queued.packet = nullptr;
+                    lock.lock();
+
+                    now = s_Now();
+                }
+
+                m_draining = false;
+                ScheduleTimer(now);
+            }
+
+            void Mqtt5PublishRateLimiter::Close() noexcept
+            {
+                /* Released outside of the lock, as the callbacks may hold the last reference to anything */
+                List<QueuedPublish> dropped(StlAllocator<QueuedPublish>(m_allocator));
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_closed = true;
+                    dropped.splice(dropped.end(), m_qos0.m_queue);
+                    dropped.splice(dropped.end(), m_qos1.m_queue);
+                }
+
+                /*
+                 * The callback gate of the client is closed by now, so, like the native completions it drops, the
+                 * queued publishes are dropped without their completion callbacks.
+                 */
+                if (!dropped.empty())
+                {
+                    AWS_LOGF_INFO(
+                        AWS_LS_MQTT5_CLIENT,
+                        "Publish rate limiter: dropping %zu publishes on close.",
+                        static_cast<size_t>(dropped.size()));
+                }
+            }
+
+            uint64_t Mqtt5PublishRateLimiter::GetPublishesRateLimited() noexcept
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_publishesRateLimited;
+            }
+
+            uint64_t Mqtt5PublishRateLimiter::GetDelayNanos() noexcept
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_delayNanos;
+            }
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
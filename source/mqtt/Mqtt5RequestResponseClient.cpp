@@ -0,0 +1,407 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/mqtt/Mqtt5RequestResponseClient.h>
+
+#include <aws/crt/Api.h>
+
+#include <aws/common/byte_buf.h>
+#include <aws/common/clock.h>
+#include <aws/common/device_random.h>
+
+namespace Aws
+{
+    namespace Crt
+    {
+        namespace Mqtt5
+        {
+            /* Spans 51 seconds at the default resolution. Longer timeouts take more than one turn of the wheel. */
+            static const size_t s_wheelSlotCount = 512;
+
+            static uint64_t s_Now() noexcept
+            {
+                uint64_t now = 0;
+                aws_high_res_clock_get_ticks(&now);
+                return now;
+            }
+
+            RequestResponseClientMetrics::RequestResponseClientMetrics() noexcept
+                : requestsSent(0), requestsRejected(0), responsesMatched(0), responsesUnmatched(0),
+                  requestsTimedOut(0)
+            {
+            }
+
+            RequestResponseClientOptions::RequestResponseClientOptions(Allocator *allocator) noexcept
+                : m_responseTopic(StlAllocator<char>(allocator)), m_requestTimeoutMs(10000),
+                  m_timeoutResolutionMs(100), m_maxInFlightRequests(1024), m_eventLoopGroup(nullptr)
+            {
+            }
+
+            RequestResponseClientOptions &RequestResponseClientOptions::WithResponseTopic(
+                const String &responseTopic) noexcept
+            {
+                m_responseTopic = responseTopic;
+                return *this;
+            }
+
+            RequestResponseClientOptions &RequestResponseClientOptions::WithRequestTimeoutMs(
+                uint32_t timeoutMs) noexcept
+            {
+                m_requestTimeoutMs = timeoutMs;
+                return *this;
+            }
+
+            RequestResponseClientOptions &RequestResponseClientOptions::WithTimeoutResolutionMs(
+                uint32_t resolutionMs) noexcept
+            {
+                m_timeoutResolutionMs = resolutionMs;
+                return *this;
+            }
+
+            RequestResponseClientOptions &RequestResponseClientOptions::WithMaxInFlightRequests(
+                size_t maxInFlightRequests) noexcept
+            {
+                m_maxInFlightRequests = maxInFlightRequests;
+                return *this;
+            }
+
+            RequestResponseClientOptions &RequestResponseClientOptions::WithEventLoopGroup(
+                Io::EventLoopGroup *eventLoopGroup) noexcept
+            {
+                m_eventLoopGroup = eventLoopGroup;
+                return *this;
+            }
+
+            std::shared_ptr<RequestResponseClient> RequestResponseClient::NewRequestResponseClient(
+                std::shared_ptr<Mqtt5Client> client,
+                const RequestResponseClientOptions &options,
+                Allocator *allocator) noexcept
+            {
+                if (!client || options.m_responseTopic.empty() || options.m_requestTimeoutMs == 0 ||
+                    options.m_timeoutResolutionMs == 0 || options.m_maxInFlightRequests == 0)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return nullptr;
+                }
+
+                RequestResponseClient *toSeat = reinterpret_cast<RequestResponseClient *>(
+                    aws_mem_acquire(allocator, sizeof(RequestResponseClient)));
+                if (toSeat == nullptr)
+                {
+                    return nullptr;
+                }
+
+                toSeat = new (toSeat) RequestResponseClient(std::move(client), options, allocator);
+                return std::shared_ptr<RequestResponseClient>(
+                    toSeat, [allocator](RequestResponseClient *requestResponse)
+                    { Crt::Delete(requestResponse, allocator); });
+            }
+
+            RequestResponseClient::RequestResponseClient(
+                std::shared_ptr<Mqtt5Client> &&client,
+                const RequestResponseClientOptions &options,
+                Allocator *allocator) noexcept
+                : m_allocator(allocator), m_client(std::move(client)), m_responseTopic(options.m_responseTopic),
+                  m_maxInFlightRequests(options.m_maxInFlightRequests), m_eventLoopGroup(options.m_eventLoopGroup),
+                  m_startNs(s_Now()),
+                  m_tickNs(aws_timestamp_convert(
+                      options.m_timeoutResolutionMs, AWS_TIMESTAMP_MILLIS, AWS_TIMESTAMP_NANOS, NULL)),
+                  m_timeoutTicks(
+                      (options.m_requestTimeoutMs + options.m_timeoutResolutionMs - 1) / options.m_timeoutResolutionMs),
+                  m_processedTick(0), m_tickScheduled(false), m_nextRequestId(0), m_closed(false)
+            {
+                if (m_eventLoopGroup == nullptr)
+                {
+                    m_eventLoopGroup = ApiHandle::GetOrCreateStaticDefaultEventLoopGroup();
+                }
+
+                /* Sized once, so that requests never rehash the index */
+                m_requests.reserve(m_maxInFlightRequests);
+                m_wheel.resize(s_wheelSlotCount);
+
+                /* Without a random seed ids count from 0, which only risks clients sharing the response topic */
+                aws_device_random_u64(&m_nextRequestId);
+            }
+
+            RequestResponseClient::~RequestResponseClient() {}
+
+            bool RequestResponseClient::Subscribe(OnSubscribeCompletionHandler onSubscribeCompletion) noexcept
+            {
+                auto subscribePacket = MakeShared<SubscribePacket>(m_allocator, m_allocator);
+                if (!subscribePacket)
+                {
+                    return false;
+                }
+
+                subscribePacket->WithSubscription(
+                    Subscription(m_responseTopic, QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, m_allocator));
+                return m_client->Subscribe(subscribePacket, std::move(onSubscribeCompletion));
+            }
+
+            uint64_t RequestResponseClient::GetTick(uint64_t nowNs) const noexcept
+            {
+                return (nowNs - m_startNs) / m_tickNs;
+            }
+
+            bool RequestResponseClient::TakeRequest(uint64_t requestId, OnResponseHandler &onResponse) noexcept
+            {
+                auto it = m_requests.find(requestId);
+                if (it == m_requests.end())
+                {
+                    return false;
+                }
+
+                onResponse = std::move(it->second.onResponse);
+                m_requests.erase(it);
+                return true;
+            }
+
+            bool RequestResponseClient::Request(
+                std::shared_ptr<PublishPacket> request,
+                OnResponseHandler onResponse) noexcept
+            {
+                if (!request)
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return false;
+                }
+
+                uint64_t requestId = 0;
+                bool scheduleTick = false;
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    if (m_closed)
+                    {
+                        aws_raise_error(AWS_ERROR_INVALID_STATE);
+                        return false;
+                    }
+                    if (m_requests.size() >= m_maxInFlightRequests)
+                    {
+                        ++m_metrics.requestsRejected;
+                        aws_raise_error(AWS_ERROR_MQTT_QUEUE_FULL);
+                        return false;
+                    }
+
+                    /* One tick more than the timeout, as the current tick is already partly elapsed */
+                    requestId = ++m_nextRequestId;
+                    uint64_t deadlineTick = GetTick(s_Now()) + m_timeoutTicks + 1;
+                    m_requests.emplace(requestId, PendingRequest{std::move(onResponse), deadlineTick});
+                    m_wheel[deadlineTick % s_wheelSlotCount].push_back(requestId);
+
+                    scheduleTick = !m_tickScheduled;
+                    m_tickScheduled = true;
+                }
+
+                if (scheduleTick)
+                {
+                    ScheduleTick();
+                }
+
+                uint8_t correlationData[sizeof(uint64_t)];
+                ByteBuf correlationBuf = ByteBufFromEmptyArray(correlationData, sizeof(correlationData));
+                aws_byte_buf_write_be64(&correlationBuf, requestId);
+                request->WithResponseTopic(ByteCursorFromString(m_responseTopic))
+                    .WithCorrelationData(aws_byte_cursor_from_buf(&correlationBuf));
+
+                std::weak_ptr<RequestResponseClient> weakSelf = shared_from_this();
+                bool published = m_client->Publish(
+                    request,
+                    [weakSelf, requestId](int errorCode, std::shared_ptr<PublishResult>)
+                    {
+                        auto self = weakSelf.lock();
+                        if (!self || errorCode == AWS_ERROR_SUCCESS)
+                        {
+                            return;
+                        }
+
+                        OnResponseHandler onFailedResponse;
+                        {
+                            std::lock_guard<std::mutex> lock(self->m_lock);
+                            if (!self->TakeRequest(requestId, onFailedResponse))
+                            {
+                                return;
+                            }
+                        }
+                        if (onFailedResponse)
+                        {
+                            onFailedResponse(errorCode, nullptr);
+                        }
+                    });
+
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (published)
+                {
+                    ++m_metrics.requestsSent;
+                    return true;
+                }
+
+                /* Its wheel entry is skipped once the request is gone. If it timed out already, it was completed. */
+                int errorCode = aws_last_error();
+                OnResponseHandler dropped;
+                if (!TakeRequest(requestId, dropped))
+                {
+                    return true;
+                }
+                aws_raise_error(errorCode);
+                return false;
+            }
+
+            bool RequestResponseClient::OnPublishReceived(const PublishReceivedEventData &eventData) noexcept
+            {
+                if (!eventData.publishPacket || eventData.publishPacket->getTopic() != m_responseTopic)
+                {
+                    return false;
+                }
+
+                /* The correlation data is the big endian request id: looked up without copying it */
+                const Optional<ByteCursor> &correlationData = eventData.publishPacket->getCorrelationData();
+                ByteCursor idCursor = correlationData ? *correlationData : ByteCursor();
+                uint64_t requestId = 0;
+                bool hasId = idCursor.len == sizeof(uint64_t) && aws_byte_cursor_read_be64(&idCursor, &requestId);
+
+                OnResponseHandler onResponse;
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    if (!hasId || !TakeRequest(requestId, onResponse))
+                    {
+                        ++m_metrics.responsesUnmatched;
+                        return true;
+                    }
+                    ++m_metrics.responsesMatched;
+                }
+
+                if (onResponse)
+                {
+                    onResponse(AWS_ERROR_SUCCESS, eventData.publishPacket);
+                }
+                return true;
+            }
+
+            bool RequestResponseClient::ScheduleTick() noexcept
+            {
+                uint64_t now = s_Now();
+                uint64_t nextTickNs = m_startNs + (GetTick(now) + 1) * m_tickNs;
+
+                std::weak_ptr<RequestResponseClient> weakSelf = shared_from_this();
+                bool scheduled = m_eventLoopGroup->ScheduleAfter(
+                    [weakSelf](Io::TaskStatus)
+                    {
+                        auto self = weakSelf.lock();
+                        if (self)
+                        {
+                            self->OnTick();
+                        }
+                    },
+                    std::chrono::nanoseconds(nextTickNs - now));
+                if (!scheduled)
+                {
+                    AWS_LOGF_ERROR(
+                        AWS_LS_MQTT5_CLIENT, "Request/response client: failed to schedule its timeout timer.");
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_tickScheduled = false;
+                }
+                return scheduled;
+            }
+
+            void RequestResponseClient::OnTick() noexcept
+            {
+                Vector<OnResponseHandler> expired;
+                bool reschedule = false;
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_tickScheduled = false;
+                    if (m_closed)
+                    {
+                        return;
+                    }
+
+                    /* After a pause longer than a turn of the wheel, every slot is visited once */
+                    uint64_t nowTick = GetTick(s_Now());
+                    uint64_t tick = m_processedTick + 1;
+                    if (nowTick - m_processedTick > s_wheelSlotCount)
+                    {
+                        tick = nowTick - s_wheelSlotCount + 1;
+                    }
+
+                    for (; tick <= nowTick; ++tick)
+                    {
+                        Vector<uint64_t> &slot = m_wheel[tick % s_wheelSlotCount];
+                        size_t kept = 0;
+                        for (uint64_t requestId : slot)
+                        {
+                            auto it = m_requests.find(requestId);
+                            if (it == m_requests.end())
+                            {
+                                /* Completed already */
+                                continue;
+                            }
+                            if (it->second.deadlineTick > nowTick)
+                            {
+                                /* Due on a later turn of the wheel */
+                                slot[kept++] = requestId;
+                                continue;
+                            }
+
+                            expired.push_back(std::move(it->second.onResponse));
+                            m_requests.erase(it);
+                            ++m_metrics.requestsTimedOut;
+                        }
+                        slot.resize(kept);
+                    }
+                    m_processedTick = nowTick;
+
+                    reschedule = !m_requests.empty();
+                    m_tickScheduled = reschedule;
+                }
+
+                for (OnResponseHandler &onResponse : expired)
+                {
+                    if (onResponse)
+                    {
+                        onResponse(AWS_ERROR_MQTT_TIMEOUT, nullptr);
+                    }
+                }
+
+                if (reschedule)
+                {
+                    ScheduleTick();
+                }
+            }
+
+            size_t RequestResponseClient::GetInFlightRequestCount() const noexcept
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_requests.size();
+            }
+
+            RequestResponseClientMetrics RequestResponseClient::GetMetrics() const noexcept
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_metrics;
+            }
+
+            void RequestResponseClient::Close() noexcept
+            {
+                UnorderedMap<uint64_t, PendingRequest> outstanding;
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_closed = true;
+                    outstanding.swap(m_requests);
+                    for (Vector<uint64_t> &slot : m_wheel)
+                    {
+                        slot.clear();
+                    }
+                }
+
+                for (auto &request : outstanding)
+                {
+                    if (request.second.onResponse)
+                    {
+                        request.second.onResponse(AWS_ERROR_INVALID_STATE, nullptr);
+                    }
+                }
+            }
+        } // namespace Mqtt5
+    } // namespace Crt
+} // namespace Aws
@@ -215,6 +215,12 @@ namespace Aws
                 return m_connectionCore->SetOnMessageHandler(std::move(onMessage));
             }
 
+            bool MqttConnection::SetOnMessageCursorHandler(OnMessageReceivedCursorHandler &&onMessage) noexcept
+            {
+                AWS_ASSERT(m_connectionCore != nullptr);
+                return m_connectionCore->SetOnMessageCursorHandler(std::move(onMessage));
+            }
+
             uint16_t MqttConnection::Subscribe(
                 const char *topicFilter,
                 QOS qos,
@@ -241,6 +247,17 @@ namespace Aws
                 return m_connectionCore->Subscribe(topicFilter, qos, std::move(onMessage), std::move(onSubAck));
             }
 
+            uint16_t MqttConnection::SubscribeWithCursorHandler(
+                const char *topicFilter,
+                QOS qos,
+                OnMessageReceivedCursorHandler &&onMessage,
+                OnSubAckHandler &&onSubAck) noexcept
+            {
+                AWS_ASSERT(m_connectionCore != nullptr);
+                return m_connectionCore->SubscribeWithCursorHandler(
+                    topicFilter, qos, std::move(onMessage), std::move(onSubAck));
+            }
+
             uint16_t MqttConnection::Subscribe(
                 const Vector<std::pair<const char *, OnPublishReceivedHandler>> &topicFilters,
                 QOS qos,
@@ -271,6 +288,17 @@ namespace Aws
                 return m_connectionCore->Subscribe(topicFilters, qos, std::move(onOpComplete));
             }
 
+            uint16_t MqttConnection::SubscribeWithSharedHandler(
+                const Vector<const char *> &topicFilters,
+                QOS qos,
+                OnSharedMessageReceivedHandler &&onMessage,
+                OnMultiSubAckHandler &&onOpComplete) noexcept
+            {
+                AWS_ASSERT(m_connectionCore != nullptr);
+                return m_connectionCore->SubscribeWithSharedHandler(
+                    topicFilters, qos, std::move(onMessage), std::move(onOpComplete));
+            }
+
             uint16_t MqttConnection::Unsubscribe(
                 const char *topicFilter,
                 OnOperationCompleteHandler &&onOpComplete) noexcept
@@ -290,6 +318,17 @@ namespace Aws
                 return m_connectionCore->Publish(topic, qos, retain, payload, std::move(onOpComplete));
             }
 
+            uint16_t MqttConnection::Publish(
+                ByteCursor topic,
+                QOS qos,
+                bool retain,
+                ByteCursor payload,
+                OnOperationCompleteHandler &&onOpComplete) noexcept
+            {
+                AWS_ASSERT(m_connectionCore != nullptr);
+                return m_connectionCore->Publish(topic, qos, retain, payload, std::move(onOpComplete));
+            }
+
             const MqttConnectionOperationStatistics &MqttConnection::GetOperationStatistics() noexcept
             {
                 AWS_ASSERT(m_connectionCore != nullptr);
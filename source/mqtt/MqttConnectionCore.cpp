@@ -12,6 +12,8 @@
 #include <aws/crt/Api.h>
 #include <aws/crt/http/HttpRequestResponse.h>
 
+#include <atomic>
+
 #define AWS_MQTT_MAX_TOPIC_LENGTH 65535
 
 namespace Aws
@@ -29,9 +31,58 @@ namespace Aws
             {
                 MqttConnectionCore *connectionCore = nullptr;
                 OnMessageReceivedHandler onMessageReceived;
+                /* Set instead of onMessageReceived by the handlers that take cursors */
+                OnMessageReceivedCursorHandler onMessageReceivedCursor;
                 Allocator *allocator = nullptr;
             };
 
+            /**
+             * @internal
+             * Callback data shared by all the subscriptions of a SubscribeWithSharedHandler() call. It is allocated
+             * together with an array holding a pointer back to it for each topic filter, and each subscription gets
+             * the address of its own entry, so that the filter id is the offset of that entry in the array. Freed
+             * once the last of the subscriptions is cleaned up.
+             */
+            struct SharedPubCallbackData
+            {
+                MqttConnectionCore *connectionCore = nullptr;
+                OnSharedMessageReceivedHandler onMessageReceived;
+                Allocator *allocator = nullptr;
+                std::atomic<size_t> subscriptionCount;
+
+                SharedPubCallbackData **GetEntries() noexcept
+                {
+                    return reinterpret_cast<SharedPubCallbackData **>(this + 1);
+                }
+            };
+
+            static SharedPubCallbackData *s_newSharedPubCallbackData(Allocator *allocator, size_t filterCount)
+            {
+                void *memory =
+                    aws_mem_acquire(allocator, sizeof(SharedPubCallbackData) + filterCount * sizeof(void *));
+                if (memory == nullptr)
+                {
+                    return nullptr;
+                }
+
+                auto *callbackData = new (memory) SharedPubCallbackData();
+                callbackData->allocator = allocator;
+                callbackData->subscriptionCount = filterCount;
+                SharedPubCallbackData **entries = callbackData->GetEntries();
+                for (size_t i = 0; i < filterCount; ++i)
+                {
+                    entries[i] = callbackData;
+                }
+                return callbackData;
+            }
+
+            static void s_deleteSharedPubCallbackData(SharedPubCallbackData *callbackData)
+            {
+                Allocator *allocator = callbackData->allocator;
+                callbackData->~SharedPubCallbackData();
+                aws_mem_release(allocator, callbackData);
+            }
+
             MqttConnectionCore::MqttConnectionCore(
                 aws_mqtt_client *client,
                 aws_mqtt5_client *mqtt5Client,
@@ -304,7 +355,7 @@ namespace Aws
                 void *userData)
             {
                 auto *callbackData = reinterpret_cast<PubCallbackData *>(userData);
-                if (!callbackData->onMessageReceived)
+                if (!callbackData->onMessageReceived && !callbackData->onMessageReceivedCursor)
                 {
                     return;
                 }
@@ -319,11 +370,52 @@ namespace Aws
                 // At this point we ensured that the MqttConnection object will be alive for the duration of the
                 // callback execution, so no critical section is needed.
 
+                if (callbackData->onMessageReceivedCursor)
+                {
+                    callbackData->onMessageReceivedCursor(*connection, *topic, *payload, dup, qos, retain);
+                    return;
+                }
+
                 String topicStr(reinterpret_cast<char *>(topic->ptr), topic->len);
                 ByteBuf payloadBuf = aws_byte_buf_from_array(payload->ptr, payload->len);
                 callbackData->onMessageReceived(*connection, topicStr, payloadBuf, dup, qos, retain);
             }
 
+            static void s_cleanUpSharedPubData(void *userData)
+            {
+                auto *callbackData = *reinterpret_cast<SharedPubCallbackData **>(userData);
+                if (callbackData->subscriptionCount.fetch_sub(1) == 1)
+                {
+                    s_deleteSharedPubCallbackData(callbackData);
+                }
+            }
+
+            void MqttConnectionCore::s_onSharedPublish(
+                aws_mqtt_client_connection * /*connection*/,
+                const aws_byte_cursor *topic,
+                const aws_byte_cursor *payload,
+                bool dup,
+                enum aws_mqtt_qos qos,
+                bool retain,
+                void *userData)
+            {
+                auto *entry = reinterpret_cast<SharedPubCallbackData **>(userData);
+                auto *callbackData = *entry;
+                if (!callbackData->onMessageReceived)
+                {
+                    return;
+                }
+
+                auto connection = callbackData->connectionCore->obtainConnectionInstance();
+                if (!connection)
+                {
+                    return;
+                }
+
+                auto filterId = static_cast<uint32_t>(entry - callbackData->GetEntries());
+                callbackData->onMessageReceived(*connection, filterId, *topic, *payload, dup, qos, retain);
+            }
+
             struct OpCompleteCallbackData
             {
                 MqttConnectionCore *connectionCore = nullptr;
@@ -616,6 +708,28 @@ namespace Aws
                     reinterpret_cast<const uint8_t *>(m_hostName.data()), m_hostName.length());
                 options.tls_options =
                     m_useTls ? const_cast<aws_tls_connection_options *>(m_tlsOptions.GetUnderlyingHandle()) : nullptr;
+                if (m_useTls)
+                {
+                    std::shared_ptr<MqttConnection> connection = obtainConnectionInstance();
+                    if (connection && connection->OnConnectionSetupMetrics)
+                    {
+                        m_setupObserver.SetCallback(
+                            [this](const Io::ConnectionSetupMetrics &metrics)
+                            {
+                                std::shared_ptr<MqttConnection> instance = obtainConnectionInstance();
+                                if (instance && instance->OnConnectionSetupMetrics)
+                                {
+                                    instance->OnConnectionSetupMetrics(*instance, metrics);
+                                }
+                            });
+                        options.tls_options = m_setupObserver.Instrument(*m_tlsOptions.GetUnderlyingHandle());
+                        if (options.tls_options == nullptr)
+                        {
+                            return false;
+                        }
+                        m_setupObserver.OnAttemptStarted();
+                    }
+                }
                 options.port = m_port;
                 options.socket_options = &m_socketOptions.GetImpl();
                 options.clean_session = cleanSession;
@@ -682,8 +796,25 @@ namespace Aws
                     return false;
                 }
 
-                pubCallbackData->connectionCore = this;
                 pubCallbackData->onMessageReceived = std::move(onMessage);
+                return SetOnMessageCallbackData(pubCallbackData);
+            }
+
+            bool MqttConnectionCore::SetOnMessageCursorHandler(OnMessageReceivedCursorHandler &&onMessage) noexcept
+            {
+                auto *pubCallbackData = Aws::Crt::New<PubCallbackData>(m_allocator);
+                if (pubCallbackData == nullptr)
+                {
+                    return false;
+                }
+
+                pubCallbackData->onMessageReceivedCursor = std::move(onMessage);
+                return SetOnMessageCallbackData(pubCallbackData);
+            }
+
+            bool MqttConnectionCore::SetOnMessageCallbackData(PubCallbackData *pubCallbackData) noexcept
+            {
+                pubCallbackData->connectionCore = this;
                 pubCallbackData->allocator = m_allocator;
 
                 if (aws_mqtt_client_connection_set_on_any_publish_handler(
@@ -717,8 +848,34 @@ namespace Aws
                     return 0;
                 }
 
-                pubCallbackData->connectionCore = this;
                 pubCallbackData->onMessageReceived = std::move(onMessage);
+                return SubscribeWithCallbackData(topicFilter, qos, pubCallbackData, std::move(onSubAck));
+            }
+
+            uint16_t MqttConnectionCore::SubscribeWithCursorHandler(
+                const char *topicFilter,
+                QOS qos,
+                OnMessageReceivedCursorHandler &&onMessage,
+                OnSubAckHandler &&onSubAck) noexcept
+            {
+                auto *pubCallbackData = Crt::New<PubCallbackData>(m_allocator);
+
+                if (pubCallbackData == nullptr)
+                {
+                    return 0;
+                }
+
+                pubCallbackData->onMessageReceivedCursor = std::move(onMessage);
+                return SubscribeWithCallbackData(topicFilter, qos, pubCallbackData, std::move(onSubAck));
+            }
+
+            uint16_t MqttConnectionCore::SubscribeWithCallbackData(
+                const char *topicFilter,
+                QOS qos,
+                PubCallbackData *pubCallbackData,
+                OnSubAckHandler &&onSubAck) noexcept
+            {
+                pubCallbackData->connectionCore = this;
                 pubCallbackData->allocator = m_allocator;
 
                 auto *subAckCallbackData = Crt::New<SubAckCallbackData>(m_allocator);
@@ -844,6 +1001,74 @@ namespace Aws
                 return packetId;
             }
 
+            uint16_t MqttConnectionCore::SubscribeWithSharedHandler(
+                const Vector<const char *> &topicFilters,
+                QOS qos,
+                OnSharedMessageReceivedHandler &&onMessage,
+                OnMultiSubAckHandler &&onOpComplete) noexcept
+            {
+                if (topicFilters.empty())
+                {
+                    aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+                    return 0;
+                }
+
+                auto *subAckCallbackData = Crt::New<MultiSubAckCallbackData>(m_allocator);
+                if (subAckCallbackData == nullptr)
+                {
+                    return 0;
+                }
+
+                auto *pubCallbackData = s_newSharedPubCallbackData(m_allocator, topicFilters.size());
+                if (pubCallbackData == nullptr)
+                {
+                    Crt::Delete(subAckCallbackData, m_allocator);
+                    return 0;
+                }
+                pubCallbackData->connectionCore = this;
+                pubCallbackData->onMessageReceived = std::move(onMessage);
+
+                aws_array_list multiSub;
+                AWS_ZERO_STRUCT(multiSub);
+
+                uint16_t packetId = 0;
+                if (aws_array_list_init_dynamic(
+                        &multiSub, m_allocator, topicFilters.size(), sizeof(aws_mqtt_topic_subscription)) == 0)
+                {
+                    SharedPubCallbackData **entries = pubCallbackData->GetEntries();
+                    for (size_t i = 0; i < topicFilters.size(); ++i)
+                    {
+                        aws_mqtt_topic_subscription subscription;
+                        subscription.on_cleanup = s_cleanUpSharedPubData;
+                        subscription.on_publish = s_onSharedPublish;
+                        subscription.on_publish_ud = &entries[i];
+                        subscription.qos = qos;
+                        subscription.topic = aws_byte_cursor_from_c_str(topicFilters[i]);
+
+                        /* Cannot fail, the list holds all of them already */
+                        aws_array_list_push_back(&multiSub, reinterpret_cast<const void *>(&subscription));
+                    }
+
+                    subAckCallbackData->connectionCore = this;
+                    subAckCallbackData->onSubAck = std::move(onOpComplete);
+                    subAckCallbackData->topic = nullptr;
+                    subAckCallbackData->allocator = m_allocator;
+
+                    packetId = aws_mqtt_client_connection_subscribe_multiple(
+                        m_underlyingConnection, &multiSub, s_onMultiSubAck, subAckCallbackData);
+                    aws_array_list_clean_up(&multiSub);
+                }
+
+                if (packetId == 0U)
+                {
+                    /* None of the subscriptions were taken, so none of them will be cleaned up */
+                    s_deleteSharedPubCallbackData(pubCallbackData);
+                    Crt::Delete(subAckCallbackData, m_allocator);
+                }
+
+                return packetId;
+            }
+
             uint16_t MqttConnectionCore::Unsubscribe(
                 const char *topicFilter,
                 OnOperationCompleteHandler &&onOpComplete) noexcept
@@ -879,6 +1104,23 @@ namespace Aws
                 const ByteBuf &payload,
                 OnOperationCompleteHandler &&onOpComplete) noexcept
             {
+                ByteCursor topicCur = aws_byte_cursor_from_array(topic, strnlen(topic, AWS_MQTT_MAX_TOPIC_LENGTH));
+                return Publish(topicCur, qos, retain, aws_byte_cursor_from_buf(&payload), std::move(onOpComplete));
+            }
+
+            uint16_t MqttConnectionCore::Publish(
+                ByteCursor topic,
+                QOS qos,
+                bool retain,
+                ByteCursor payload,
+                OnOperationCompleteHandler &&onOpComplete) noexcept
+            {
+                /* Nothing to call back: no callback data to allocate and free for each publish */
+                if (!onOpComplete)
+                {
+                    return aws_mqtt_client_connection_publish(
+                        m_underlyingConnection, &topic, qos, retain, &payload, nullptr, nullptr);
+                }
 
                 auto *opCompleteCallbackData = Crt::New<OpCompleteCallbackData>(m_allocator);
                 if (opCompleteCallbackData == nullptr)
@@ -890,14 +1132,12 @@ namespace Aws
                 opCompleteCallbackData->allocator = m_allocator;
                 opCompleteCallbackData->onOperationComplete = std::move(onOpComplete);
 
-                ByteCursor topicCur = aws_byte_cursor_from_array(topic, strnlen(topic, AWS_MQTT_MAX_TOPIC_LENGTH));
-                ByteCursor payloadCur = aws_byte_cursor_from_buf(&payload);
                 uint16_t packetId = aws_mqtt_client_connection_publish(
                     m_underlyingConnection,
-                    &topicCur,
+                    &topic,
                     qos,
                     retain,
-                    &payloadCur,
+                    &payload,
                     s_onOpComplete,
                     opCompleteCallbackData);
 
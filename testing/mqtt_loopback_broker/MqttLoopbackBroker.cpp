@@ -0,0 +1,947 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/io/ChannelHandler.h>
+#include <aws/crt/io/SocketOptions.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+
+#include <aws/io/channel.h>
+#include <aws/io/channel_bootstrap.h>
+#include <aws/io/socket.h>
+#include <aws/mqtt/mqtt.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using Aws::Crt::ByteBuf;
+using Aws::Crt::ByteCursor;
+
+namespace
+{
+    enum MqttPacketType : uint8_t
+    {
+        Connect = 1,
+        Connack = 2,
+        Publish = 3,
+        Puback = 4,
+        Pubrec = 5,
+        Pubrel = 6,
+        Pubcomp = 7,
+        Subscribe = 8,
+        Suback = 9,
+        Unsubscribe = 10,
+        Unsuback = 11,
+        Pingreq = 12,
+        Pingresp = 13,
+        Disconnect = 14,
+    };
+
+    const uint8_t s_mqtt5ProtocolLevel = 5;
+    const uint8_t s_assignedClientIdentifierProperty = 0x12;
+    const uint8_t s_subackFailure = 0x80;
+    const uint8_t s_unsubackNoSubscriptionExisted = 0x11;
+    const uint8_t s_noMatch = 0xFF;
+
+    size_t s_VarIntSize(size_t value)
+    {
+        size_t size = 1;
+        while (value >= 128)
+        {
+            value /= 128;
+            ++size;
+        }
+        return size;
+    }
+
+    void s_AppendByte(ByteBuf &out, uint8_t value)
+    {
+        aws_byte_buf_append_byte_dynamic(&out, value);
+    }
+
+    void s_AppendBe16(ByteBuf &out, uint16_t value)
+    {
+        s_AppendByte(out, static_cast<uint8_t>(value >> 8));
+        s_AppendByte(out, static_cast<uint8_t>(value & 0xFF));
+    }
+
+    void s_AppendVarInt(ByteBuf &out, size_t value)
+    {
+        do
+        {
+            auto encoded = static_cast<uint8_t>(value % 128);
+            value /= 128;
+            if (value > 0)
+            {
+                encoded |= 0x80;
+            }
+            s_AppendByte(out, encoded);
+        } while (value > 0);
+    }
+
+    void s_AppendBytes(ByteBuf &out, ByteCursor bytes)
+    {
+        aws_byte_buf_append_dynamic(&out, &bytes);
+    }
+
+    void s_AppendString(ByteBuf &out, ByteCursor value)
+    {
+        s_AppendBe16(out, static_cast<uint16_t>(value.len));
+        s_AppendBytes(out, value);
+    }
+
+    bool s_ReadVarInt(ByteCursor &cursor, size_t &value)
+    {
+        value = 0;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            uint8_t encoded = 0;
+            if (!aws_byte_cursor_read_u8(&cursor, &encoded))
+            {
+                return false;
+            }
+
+            value |= static_cast<size_t>(encoded & 0x7F) << (7 * i);
+            if ((encoded & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool s_ReadBytes(ByteCursor &cursor, size_t length, ByteCursor &value)
+    {
+        if (cursor.len < length)
+        {
+            return false;
+        }
+
+        value = aws_byte_cursor_advance(&cursor, length);
+        return true;
+    }
+
+    bool s_ReadString(ByteCursor &cursor, ByteCursor &value)
+    {
+        uint16_t length = 0;
+        return aws_byte_cursor_read_be16(&cursor, &length) && s_ReadBytes(cursor, length, value);
+    }
+
+    /* end of the topic level starting at position */
+    size_t s_LevelEnd(ByteCursor name, size_t position)
+    {
+        while (position < name.len && name.ptr[position] != '/')
+        {
+            ++position;
+        }
+        return position;
+    }
+
+    bool s_SkipProperties(ByteCursor &cursor, ByteCursor *properties = nullptr)
+    {
+        size_t length = 0;
+        ByteCursor skipped;
+        if (!s_ReadVarInt(cursor, length) || !s_ReadBytes(cursor, length, skipped))
+        {
+            return false;
+        }
+
+        if (properties != nullptr)
+        {
+            *properties = skipped;
+        }
+        return true;
+    }
+} // namespace
+
+/*
+ * Server side of one client connection: last handler of the accepted channel, right of the socket handler.
+ */
+class MqttLoopbackSession : public Aws::Crt::Io::ChannelHandler
+{
+  public:
+    MqttLoopbackSession(MqttLoopbackBroker &broker, Aws::Crt::Allocator *allocator)
+        : Aws::Crt::Io::ChannelHandler(allocator), m_broker(broker), m_connected(false), m_closing(false),
+          m_mqtt5(false), m_subscriptions(Aws::Crt::StlAllocator<Subscription>(allocator)), m_nextPacketId(1),
+          m_flushScheduled(false), m_closed(false)
+    {
+        aws_byte_buf_init(&m_readBuffer, allocator, 4096);
+        aws_byte_buf_init(&m_pending, allocator, 4096);
+        aws_byte_buf_init(&m_writing, allocator, 4096);
+    }
+
+    ~MqttLoopbackSession() override
+    {
+        aws_byte_buf_clean_up(&m_readBuffer);
+        aws_byte_buf_clean_up(&m_pending);
+        aws_byte_buf_clean_up(&m_writing);
+    }
+
+    int ProcessReadMessage(struct aws_io_message *message) override
+    {
+        ByteCursor data = aws_byte_cursor_from_buf(&message->message_data);
+        aws_byte_buf_append_dynamic(&m_readBuffer, &data);
+        aws_mem_release(message->allocator, message);
+
+        ByteCursor buffered = aws_byte_cursor_from_buf(&m_readBuffer);
+        while (!m_closing)
+        {
+            ByteCursor packet = buffered;
+            uint8_t header = 0;
+            size_t remainingLength = 0;
+            if (!aws_byte_cursor_read_u8(&packet, &header))
+            {
+                break;
+            }
+
+            size_t lengthBytesAvailable = packet.len;
+            if (!s_ReadVarInt(packet, remainingLength))
+            {
+                if (lengthBytesAvailable >= 4)
+                {
+                    Fail();
+                }
+                break;
+            }
+
+            ByteCursor body;
+            if (!s_ReadBytes(packet, remainingLength, body))
+            {
+                break;
+            }
+
+            buffered = packet;
+            if (!HandlePacket(header, body))
+            {
+                Fail();
+            }
+        }
+
+        size_t consumed = m_readBuffer.len - buffered.len;
+        if (consumed > 0)
+        {
+            memmove(m_readBuffer.buffer, m_readBuffer.buffer + consumed, buffered.len);
+            m_readBuffer.len = buffered.len;
+        }
+
+        return AWS_OP_SUCCESS;
+    }
+
+    int ProcessWriteMessage(struct aws_io_message *message) override
+    {
+        return SendMessage(message, Aws::Crt::Io::ChannelDirection::Write) ? AWS_OP_SUCCESS : AWS_OP_ERR;
+    }
+
+    int IncrementReadWindow(size_t) override { return AWS_OP_SUCCESS; }
+
+    void ProcessShutdown(
+        Aws::Crt::Io::ChannelDirection dir,
+        int errorCode,
+        bool freeScarceResourcesImmediately) override
+    {
+        if (dir == Aws::Crt::Io::ChannelDirection::Read)
+        {
+            m_closing = true;
+            {
+                std::lock_guard<std::mutex> lock(m_outLock);
+                m_closed = true;
+            }
+            m_broker.Unregister(this);
+        }
+
+        OnShutdownComplete(dir, errorCode, freeScarceResourcesImmediately);
+    }
+
+    size_t InitialWindowSize() override { return SIZE_MAX; }
+
+    size_t MessageOverhead() override { return 0; }
+
+    /*
+     * Returns the highest QoS granted by a subscription matching topic, or s_noMatch. Called with the broker's lock
+     * held.
+     */
+    uint8_t GrantedQos(ByteCursor topic) const
+    {
+        uint8_t granted = s_noMatch;
+        for (const auto &subscription : m_subscriptions)
+        {
+            if (MqttLoopbackBroker::TopicMatches(Aws::Crt::ByteCursorFromString(subscription.first), topic))
+            {
+                granted = granted == s_noMatch ? subscription.second : std::max(granted, subscription.second);
+            }
+        }
+        return granted;
+    }
+
+    /*
+     * Queues a PUBLISH to this client. Called with the broker's lock held, from any thread.
+     */
+    void Deliver(ByteCursor topic, uint8_t qos, ByteCursor properties, ByteCursor payload)
+    {
+        uint16_t packetId = 0;
+        if (qos > 0)
+        {
+            packetId = m_nextPacketId++;
+            if (m_nextPacketId == 0)
+            {
+                m_nextPacketId = 1;
+            }
+        }
+
+        size_t remainingLength = 2 + topic.len + (qos > 0 ? 2 : 0) + payload.len;
+        if (m_mqtt5)
+        {
+            remainingLength += s_VarIntSize(properties.len) + properties.len;
+        }
+
+        Enqueue(
+            [&](ByteBuf &out)
+            {
+                s_AppendByte(out, static_cast<uint8_t>((Publish << 4) | (qos << 1)));
+                s_AppendVarInt(out, remainingLength);
+                s_AppendString(out, topic);
+                if (qos > 0)
+                {
+                    s_AppendBe16(out, packetId);
+                }
+                if (m_mqtt5)
+                {
+                    s_AppendVarInt(out, properties.len);
+                    s_AppendBytes(out, properties);
+                }
+                s_AppendBytes(out, payload);
+            });
+    }
+
+    bool IsMqtt5() const { return m_mqtt5; }
+
+    bool HasSubscriptions() const { return !m_subscriptions.empty(); }
+
+  private:
+    using Subscription = std::pair<Aws::Crt::String, uint8_t>;
+
+    void Fail()
+    {
+        m_closing = true;
+        ShutDownChannel(AWS_ERROR_MQTT_PROTOCOL_ERROR);
+    }
+
+    bool HandlePacket(uint8_t header, ByteCursor body)
+    {
+        auto type = static_cast<uint8_t>(header >> 4);
+        if (!m_connected && type != Connect)
+        {
+            return false;
+        }
+
+        switch (type)
+        {
+            case Connect:
+                return HandleConnect(body);
+            case Publish:
+                return HandlePublish(header, body);
+            case Puback:
+            case Pubcomp:
+                return true;
+            case Pubrec:
+                return HandleAck(body, static_cast<uint8_t>((Pubrel << 4) | 0x02));
+            case Pubrel:
+                return HandleAck(body, static_cast<uint8_t>(Pubcomp << 4));
+            case Subscribe:
+                return HandleSubscribe(body);
+            case Unsubscribe:
+                return HandleUnsubscribe(body);
+            case Pingreq:
+                Enqueue(
+                    [](ByteBuf &out)
+                    {
+                        s_AppendByte(out, static_cast<uint8_t>(Pingresp << 4));
+                        s_AppendByte(out, 0);
+                    });
+                return true;
+            case Disconnect:
+                m_closing = true;
+                ShutDownChannel(AWS_ERROR_SUCCESS);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool HandleConnect(ByteCursor body)
+    {
+        ByteCursor protocolName;
+        uint8_t protocolLevel = 0;
+        uint8_t connectFlags = 0;
+        uint16_t keepAlive = 0;
+        ByteCursor clientId;
+        if (m_connected || !s_ReadString(body, protocolName) || !aws_byte_cursor_read_u8(&body, &protocolLevel) ||
+            !aws_byte_cursor_read_u8(&body, &connectFlags) || !aws_byte_cursor_read_be16(&body, &keepAlive))
+        {
+            return false;
+        }
+
+        m_mqtt5 = protocolLevel == s_mqtt5ProtocolLevel;
+        if ((m_mqtt5 && !s_SkipProperties(body)) || !s_ReadString(body, clientId))
+        {
+            return false;
+        }
+
+        m_connected = true;
+        if (!m_mqtt5)
+        {
+            Enqueue(
+                [](ByteBuf &out)
+                {
+                    s_AppendByte(out, static_cast<uint8_t>(Connack << 4));
+                    s_AppendByte(out, 2);
+                    s_AppendBe16(out, 0);
+                });
+            return true;
+        }
+
+        Aws::Crt::String assignedClientId;
+        if (clientId.len == 0)
+        {
+            assignedClientId = "loopback-";
+            assignedClientId += std::to_string(++m_broker.m_assignedClientIds).c_str();
+        }
+        size_t propertiesLength = assignedClientId.empty() ? 0 : 3 + assignedClientId.size();
+
+        Enqueue(
+            [&](ByteBuf &out)
+            {
+                s_AppendByte(out, static_cast<uint8_t>(Connack << 4));
+                s_AppendVarInt(out, 2 + s_VarIntSize(propertiesLength) + propertiesLength);
+                s_AppendByte(out, 0); /* session present */
+                s_AppendByte(out, 0); /* success */
+                s_AppendVarInt(out, propertiesLength);
+                if (propertiesLength > 0)
+                {
+                    s_AppendByte(out, s_assignedClientIdentifierProperty);
+                    s_AppendString(out, Aws::Crt::ByteCursorFromString(assignedClientId));
+                }
+            });
+        return true;
+    }
+
+    bool HandlePublish(uint8_t header, ByteCursor body)
+    {
+        auto qos = static_cast<uint8_t>((header >> 1) & 0x03);
+        ByteCursor topic;
+        uint16_t packetId = 0;
+        ByteCursor properties;
+        AWS_ZERO_STRUCT(properties);
+        if (qos > 2 || !s_ReadString(body, topic) || (qos > 0 && !aws_byte_cursor_read_be16(&body, &packetId)) ||
+            (m_mqtt5 && !s_SkipProperties(body, &properties)))
+        {
+            return false;
+        }
+
+        m_broker.Route(topic, qos, properties, m_mqtt5, body);
+
+        if (qos > 0)
+        {
+            uint8_t ack = static_cast<uint8_t>((qos == 1 ? Puback : Pubrec) << 4);
+            Enqueue(
+                [ack, packetId](ByteBuf &out)
+                {
+                    s_AppendByte(out, ack);
+                    s_AppendByte(out, 2);
+                    s_AppendBe16(out, packetId);
+                });
+        }
+        return true;
+    }
+
+    bool HandleAck(ByteCursor body, uint8_t response)
+    {
+        uint16_t packetId = 0;
+        if (!aws_byte_cursor_read_be16(&body, &packetId))
+        {
+            return false;
+        }
+
+        Enqueue(
+            [response, packetId](ByteBuf &out)
+            {
+                s_AppendByte(out, response);
+                s_AppendByte(out, 2);
+                s_AppendBe16(out, packetId);
+            });
+        return true;
+    }
+
+    bool HandleSubscribe(ByteCursor body)
+    {
+        uint16_t packetId = 0;
+        if (!aws_byte_cursor_read_be16(&body, &packetId) || (m_mqtt5 && !s_SkipProperties(body)))
+        {
+            return false;
+        }
+
+        Aws::Crt::String reasonCodes;
+        while (body.len > 0)
+        {
+            ByteCursor filter;
+            uint8_t options = 0;
+            if (!s_ReadString(body, filter) || !aws_byte_cursor_read_u8(&body, &options))
+            {
+                return false;
+            }
+
+            auto qos = static_cast<uint8_t>(options & 0x03);
+            if (qos > 2 || filter.len == 0)
+            {
+                reasonCodes.push_back(static_cast<char>(s_subackFailure));
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_broker.m_lock);
+                Aws::Crt::String filterString(
+                    reinterpret_cast<const char *>(filter.ptr), filter.len, Aws::Crt::StlAllocator<char>(m_allocator));
+                auto existing = std::find_if(
+                    m_subscriptions.begin(),
+                    m_subscriptions.end(),
+                    [&filterString](const Subscription &subscription) { return subscription.first == filterString; });
+                if (existing != m_subscriptions.end())
+                {
+                    existing->second = qos;
+                }
+                else
+                {
+                    m_subscriptions.emplace_back(std::move(filterString), qos);
+                }
+            }
+            reasonCodes.push_back(static_cast<char>(qos));
+        }
+
+        SendSubscriptionAck(static_cast<uint8_t>(Suback << 4), packetId, reasonCodes);
+        return true;
+    }
+
+    bool HandleUnsubscribe(ByteCursor body)
+    {
+        uint16_t packetId = 0;
+        if (!aws_byte_cursor_read_be16(&body, &packetId) || (m_mqtt5 && !s_SkipProperties(body)))
+        {
+            return false;
+        }
+
+        Aws::Crt::String reasonCodes;
+        while (body.len > 0)
+        {
+            ByteCursor filter;
+            if (!s_ReadString(body, filter))
+            {
+                return false;
+            }
+
+            size_t removed = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_broker.m_lock);
+                size_t before = m_subscriptions.size();
+                m_subscriptions.erase(
+                    std::remove_if(
+                        m_subscriptions.begin(),
+                        m_subscriptions.end(),
+                        [&filter](const Subscription &subscription)
+                        {
+                            ByteCursor subscribed = Aws::Crt::ByteCursorFromString(subscription.first);
+                            return aws_byte_cursor_eq(&filter, &subscribed);
+                        }),
+                    m_subscriptions.end());
+                removed = before - m_subscriptions.size();
+            }
+            reasonCodes.push_back(static_cast<char>(removed > 0 ? 0 : s_unsubackNoSubscriptionExisted));
+        }
+
+        /* MQTT 3.1.1 UNSUBACKs carry no reason codes */
+        SendSubscriptionAck(static_cast<uint8_t>(Unsuback << 4), packetId, m_mqtt5 ? reasonCodes : Aws::Crt::String());
+        return true;
+    }
+
+    void SendSubscriptionAck(uint8_t header, uint16_t packetId, const Aws::Crt::String &reasonCodes)
+    {
+        Enqueue(
+            [&](ByteBuf &out)
+            {
+                s_AppendByte(out, header);
+                s_AppendVarInt(out, 2 + (m_mqtt5 ? 1 : 0) + reasonCodes.size());
+                s_AppendBe16(out, packetId);
+                if (m_mqtt5)
+                {
+                    s_AppendVarInt(out, 0);
+                }
+                s_AppendBytes(out, Aws::Crt::ByteCursorFromString(reasonCodes));
+            });
+    }
+
+    /*
+     * Appends a packet to the outgoing buffer and makes sure a flush is scheduled on the channel's thread, so
+     * packets queued in a burst go out in as few writes as possible.
+     */
+    template <typename WriteFn> void Enqueue(WriteFn &&write)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_outLock);
+            if (m_closed)
+            {
+                return;
+            }
+
+            write(m_pending);
+            if (m_flushScheduled)
+            {
+                return;
+            }
+            m_flushScheduled = true;
+        }
+
+        ScheduleTask([this](Aws::Crt::Io::TaskStatus status) { Flush(status); });
+    }
+
+    void Flush(Aws::Crt::Io::TaskStatus status)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_outLock);
+            m_flushScheduled = false;
+            std::swap(m_pending, m_writing);
+        }
+
+        if (status == Aws::Crt::Io::TaskStatus::RunReady && m_writing.len > 0 &&
+            !SendData(aws_byte_cursor_from_buf(&m_writing), Aws::Crt::Io::ChannelDirection::Write))
+        {
+            m_closing = true;
+            ShutDownChannel(aws_last_error());
+        }
+        aws_byte_buf_reset(&m_writing, false);
+    }
+
+    MqttLoopbackBroker &m_broker;
+
+    /* channel thread only */
+    ByteBuf m_readBuffer;
+    bool m_connected;
+    bool m_closing;
+
+    /* written by CONNECT before any subscription exists, read under the broker's lock afterwards */
+    bool m_mqtt5;
+
+    /* guarded by the broker's lock */
+    Aws::Crt::Vector<Subscription> m_subscriptions;
+    uint16_t m_nextPacketId;
+
+    std::mutex m_outLock;
+    ByteBuf m_pending;
+    bool m_flushScheduled;
+    bool m_closed;
+
+    /* channel thread only */
+    ByteBuf m_writing;
+};
+
+MqttLoopbackBroker::MqttLoopbackBroker(Aws::Crt::Io::EventLoopGroup &eventLoopGroup, Aws::Crt::Allocator *allocator)
+    : m_eventLoopGroup(eventLoopGroup), m_allocator(allocator), m_bootstrap(nullptr), m_listener(nullptr), m_port(0),
+      m_sessions(Aws::Crt::StlAllocator<std::shared_ptr<MqttLoopbackSession>>(allocator)), m_openChannels(0),
+      m_listenerDestroyed(true), m_stopping(false), m_assignedClientIds(0)
+{
+}
+
+MqttLoopbackBroker::~MqttLoopbackBroker()
+{
+    Stop();
+}
+
+bool MqttLoopbackBroker::Start()
+{
+    m_bootstrap = aws_server_bootstrap_new(m_allocator, m_eventLoopGroup.GetUnderlyingHandle());
+    if (m_bootstrap == nullptr)
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_statistics = MqttLoopbackBrokerStatistics();
+        m_listenerDestroyed = false;
+        m_stopping = false;
+    }
+
+    Aws::Crt::Io::SocketOptions socketOptions;
+
+    struct aws_server_socket_channel_bootstrap_options listenerOptions;
+    AWS_ZERO_STRUCT(listenerOptions);
+    listenerOptions.bootstrap = m_bootstrap;
+    listenerOptions.host_name = "127.0.0.1";
+    listenerOptions.port = 0;
+    listenerOptions.socket_options = &socketOptions.GetImpl();
+    listenerOptions.incoming_callback = s_OnIncomingChannelSetup;
+    listenerOptions.shutdown_callback = s_OnIncomingChannelShutdown;
+    listenerOptions.destroy_callback = s_OnListenerDestroyed;
+    listenerOptions.user_data = this;
+
+    m_listener = aws_server_bootstrap_new_socket_listener(&listenerOptions);
+    if (m_listener == nullptr)
+    {
+        int errorCode = aws_last_error();
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_listenerDestroyed = true;
+        }
+        Stop();
+        aws_raise_error(errorCode);
+        return false;
+    }
+
+    struct aws_socket_endpoint endpoint;
+    AWS_ZERO_STRUCT(endpoint);
+    if (aws_socket_get_bound_address(m_listener, &endpoint))
+    {
+        int errorCode = aws_last_error();
+        Stop();
+        aws_raise_error(errorCode);
+        return false;
+    }
+
+    m_port = endpoint.port;
+    return true;
+}
+
+void MqttLoopbackBroker::Stop()
+{
+    if (m_listener != nullptr)
+    {
+        aws_server_bootstrap_destroy_socket_listener(m_bootstrap, m_listener);
+        m_listener = nullptr;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_stopping = true;
+        for (const auto &session : m_sessions)
+        {
+            session->ShutDownChannel(AWS_ERROR_SUCCESS);
+        }
+        m_signal.wait(lock, [this]() { return m_listenerDestroyed && m_openChannels == 0; });
+    }
+
+    if (m_bootstrap != nullptr)
+    {
+        aws_server_bootstrap_release(m_bootstrap);
+        m_bootstrap = nullptr;
+    }
+    m_port = 0;
+}
+
+MqttLoopbackBrokerStatistics MqttLoopbackBroker::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_statistics;
+}
+
+bool MqttLoopbackBroker::TopicMatches(ByteCursor filter, ByteCursor topic)
+{
+    /* a topic position past topic.len means every level of the topic has been consumed */
+    size_t filterPosition = 0;
+    size_t topicPosition = 0;
+    while (filterPosition < filter.len)
+    {
+        if (filter.ptr[filterPosition] == '#')
+        {
+            return true;
+        }
+
+        if (topicPosition > topic.len)
+        {
+            return false;
+        }
+
+        size_t filterLevelEnd = s_LevelEnd(filter, filterPosition);
+        size_t topicLevelEnd = s_LevelEnd(topic, topicPosition);
+        size_t filterLevelLength = filterLevelEnd - filterPosition;
+        size_t topicLevelLength = topicLevelEnd - topicPosition;
+        bool wildcard = filterLevelLength == 1 && filter.ptr[filterPosition] == '+';
+        if (!wildcard && (filterLevelLength != topicLevelLength ||
+                          memcmp(filter.ptr + filterPosition, topic.ptr + topicPosition, filterLevelLength) != 0))
+        {
+            return false;
+        }
+
+        if (filterLevelEnd == filter.len)
+        {
+            return topicLevelEnd == topic.len;
+        }
+
+        filterPosition = filterLevelEnd + 1;
+        topicPosition = topicLevelEnd + 1;
+    }
+
+    return false;
+}
+
+std::shared_ptr<Aws::Crt::Mqtt5::Mqtt5Client> MqttLoopbackBroker::NewMqtt5Client(
+    const char *clientId,
+    uint32_t port,
+    std::promise<void> &connected,
+    std::promise<void> &stopped,
+    Aws::Crt::Mqtt5::OnPublishReceivedHandler &&onPublishReceived,
+    Aws::Crt::Allocator *allocator,
+    const std::function<void(Aws::Crt::Mqtt5::Mqtt5ClientOptions &)> &configure)
+{
+    auto connectPacket = Aws::Crt::MakeShared<Aws::Crt::Mqtt5::ConnectPacket>(allocator, allocator);
+    connectPacket->WithClientId(clientId);
+
+    Aws::Crt::Mqtt5::Mqtt5ClientOptions options(allocator);
+    options.WithHostName("127.0.0.1")
+        .WithPort(port)
+        .WithBootstrap(Aws::Crt::ApiHandle::GetOrCreateStaticDefaultClientBootstrap())
+        .WithConnectOptions(connectPacket)
+        .WithClientConnectionSuccessCallback([&connected](const Aws::Crt::Mqtt5::OnConnectionSuccessEventData &)
+                                             { connected.set_value(); })
+        .WithClientStoppedCallback([&stopped](const Aws::Crt::Mqtt5::OnStoppedEventData &) { stopped.set_value(); })
+        .WithPublishReceivedCallback(std::move(onPublishReceived));
+    if (configure)
+    {
+        configure(options);
+    }
+
+    return Aws::Crt::Mqtt5::Mqtt5Client::NewMqtt5Client(options, allocator);
+}
+
+Aws::Crt::Mqtt5::OnPublishReceivedHandler MqttLoopbackBroker::EchoResponder(
+    const std::shared_ptr<Aws::Crt::Mqtt5::Mqtt5Client> &responder,
+    Aws::Crt::Allocator *allocator)
+{
+    return [&responder, allocator](const Aws::Crt::Mqtt5::PublishReceivedEventData &eventData)
+    {
+        const Aws::Crt::Mqtt5::PublishPacket &request = *eventData.publishPacket;
+        if (!request.getResponseTopic() || !request.getCorrelationData())
+        {
+            return;
+        }
+
+        auto response = Aws::Crt::MakeShared<Aws::Crt::Mqtt5::PublishPacket>(
+            allocator,
+            Aws::Crt::String((const char *)request.getResponseTopic()->ptr, request.getResponseTopic()->len),
+            request.getPayload(),
+            Aws::Crt::Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+            allocator);
+        response->WithCorrelationData(*request.getCorrelationData());
+        responder->Publish(response);
+    };
+}
+
+void MqttLoopbackBroker::Route(
+    ByteCursor topic,
+    uint8_t qos,
+    ByteCursor properties,
+    bool propertiesAreMqtt5,
+    ByteCursor payload)
+{
+    ByteCursor noProperties;
+    AWS_ZERO_STRUCT(noProperties);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    ++m_statistics.publishesReceived;
+    for (const auto &session : m_sessions)
+    {
+        if (!session->HasSubscriptions())
+        {
+            continue;
+        }
+
+        uint8_t granted = session->GrantedQos(topic);
+        if (granted == s_noMatch)
+        {
+            continue;
+        }
+
+        bool forwardProperties = propertiesAreMqtt5 && session->IsMqtt5();
+        session->Deliver(topic, std::min(qos, granted), forwardProperties ? properties : noProperties, payload);
+        ++m_statistics.publishesDelivered;
+    }
+}
+
+void MqttLoopbackBroker::Unregister(const MqttLoopbackSession *session)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_sessions.erase(
+        std::remove_if(
+            m_sessions.begin(),
+            m_sessions.end(),
+            [session](const std::shared_ptr<MqttLoopbackSession> &registered) { return registered.get() == session; }),
+        m_sessions.end());
+}
+
+void MqttLoopbackBroker::s_OnIncomingChannelSetup(
+    struct aws_server_bootstrap *,
+    int errorCode,
+    struct aws_channel *channel,
+    void *userData)
+{
+    auto *broker = static_cast<MqttLoopbackBroker *>(userData);
+    if (errorCode != AWS_ERROR_SUCCESS)
+    {
+        return;
+    }
+
+    auto session = Aws::Crt::MakeShared<MqttLoopbackSession>(broker->m_allocator, *broker, broker->m_allocator);
+    struct aws_channel_slot *slot = aws_channel_slot_new(channel);
+    bool attached = session != nullptr && slot != nullptr;
+    if (attached)
+    {
+        aws_channel_slot_insert_end(channel, slot);
+        aws_channel_slot_set_handler(slot, session->SeatForCInterop(session));
+    }
+
+    /* registered under the same lock Stop() checks m_stopping under, so no connection escapes a Stop() */
+    bool stopping = false;
+    {
+        std::lock_guard<std::mutex> lock(broker->m_lock);
+        ++broker->m_openChannels;
+        ++broker->m_statistics.connections;
+        stopping = broker->m_stopping;
+        if (attached)
+        {
+            broker->m_sessions.push_back(session);
+        }
+    }
+
+    if (!attached)
+    {
+        aws_channel_shutdown(channel, AWS_ERROR_OOM);
+        return;
+    }
+
+    if (stopping)
+    {
+        session->ShutDownChannel(AWS_ERROR_SUCCESS);
+    }
+}
+
+void MqttLoopbackBroker::s_OnIncomingChannelShutdown(
+    struct aws_server_bootstrap *,
+    int,
+    struct aws_channel *,
+    void *userData)
+{
+    auto *broker = static_cast<MqttLoopbackBroker *>(userData);
+    std::lock_guard<std::mutex> lock(broker->m_lock);
+    --broker->m_openChannels;
+    broker->m_signal.notify_all();
+}
+
+void MqttLoopbackBroker::s_OnListenerDestroyed(struct aws_server_bootstrap *, void *userData)
+{
+    auto *broker = static_cast<MqttLoopbackBroker *>(userData);
+    std::lock_guard<std::mutex> lock(broker->m_lock);
+    broker->m_listenerDestroyed = true;
+    broker->m_signal.notify_all();
+}
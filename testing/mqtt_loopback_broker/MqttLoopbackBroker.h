@@ -0,0 +1,134 @@
+#pragma once
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Types.h>
+#include <aws/crt/io/EventLoopGroup.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+
+struct aws_channel;
+struct aws_server_bootstrap;
+struct aws_socket;
+
+class MqttLoopbackSession;
+
+struct MqttLoopbackBrokerStatistics
+{
+    /* connections accepted since Start() */
+    uint64_t connections = 0;
+
+    /* PUBLISH packets received from clients */
+    uint64_t publishesReceived = 0;
+
+    /* PUBLISH packets sent to subscribers */
+    uint64_t publishesDelivered = 0;
+};
+
+/*
+ * In-process MQTT 3.1.1 / MQTT 5 broker stand-in listening on 127.0.0.1, so MqttConnection and Mqtt5Client can be
+ * tested and benchmarked without an endpoint.
+ *
+ * It implements what clients need to connect and exchange messages: CONNECT, SUBSCRIBE and UNSUBSCRIBE with '+' and
+ * '#' wildcards, PUBLISH at QoS 0, 1 and 2, PINGREQ and DISCONNECT. There are no persistent sessions, retained or
+ * will messages, shared subscriptions, authentication or QoS 2 duplicate detection. MQTT 5 properties of a PUBLISH
+ * are forwarded as-is to MQTT 5 subscribers and otherwise ignored.
+ *
+ * Packets are routed on the publisher's event loop thread and written on the subscriber's, batched per subscriber.
+ */
+class MqttLoopbackBroker
+{
+  public:
+    MqttLoopbackBroker(Aws::Crt::Io::EventLoopGroup &eventLoopGroup, Aws::Crt::Allocator *allocator);
+    ~MqttLoopbackBroker();
+    MqttLoopbackBroker(const MqttLoopbackBroker &) = delete;
+    MqttLoopbackBroker &operator=(const MqttLoopbackBroker &) = delete;
+
+    /*
+     * Starts listening on an ephemeral port of 127.0.0.1. Returns false and raises an error on failure.
+     */
+    bool Start();
+
+    /*
+     * Closes the listener and every connection, and waits for them to shut down.
+     */
+    void Stop();
+
+    uint32_t GetPort() const { return m_port; }
+
+    MqttLoopbackBrokerStatistics GetStatistics() const;
+
+    /*
+     * Returns true if topic matches the MQTT topic filter.
+     */
+    static bool TopicMatches(Aws::Crt::ByteCursor filter, Aws::Crt::ByteCursor topic);
+
+    /*
+     * Creates an Mqtt5Client for the broker listening on port, using the default client bootstrap. connected is
+     * fulfilled on connection success and stopped once the client stops. configure, if set, adds to or overrides
+     * these options before the client is created. The client is not started.
+     */
+    static std::shared_ptr<Aws::Crt::Mqtt5::Mqtt5Client> NewMqtt5Client(
+        const char *clientId,
+        uint32_t port,
+        std::promise<void> &connected,
+        std::promise<void> &stopped,
+        Aws::Crt::Mqtt5::OnPublishReceivedHandler &&onPublishReceived,
+        Aws::Crt::Allocator *allocator,
+        const std::function<void(Aws::Crt::Mqtt5::Mqtt5ClientOptions &)> &configure = nullptr);
+
+    /*
+     * Publish received handler answering every request that carries a response topic and correlation data with a
+     * QoS 1 publish of the same payload and correlation data to the response topic, through responder. responder
+     * is referenced rather than copied: it may be assigned after the handler is created and must outlive the client.
+     */
+    static Aws::Crt::Mqtt5::OnPublishReceivedHandler EchoResponder(
+        const std::shared_ptr<Aws::Crt::Mqtt5::Mqtt5Client> &responder,
+        Aws::Crt::Allocator *allocator);
+
+  private:
+    friend class MqttLoopbackSession;
+
+    void Route(
+        Aws::Crt::ByteCursor topic,
+        uint8_t qos,
+        Aws::Crt::ByteCursor properties,
+        bool propertiesAreMqtt5,
+        Aws::Crt::ByteCursor payload);
+    void Unregister(const MqttLoopbackSession *session);
+
+    static void s_OnIncomingChannelSetup(
+        struct aws_server_bootstrap *bootstrap,
+        int errorCode,
+        struct aws_channel *channel,
+        void *userData);
+    static void s_OnIncomingChannelShutdown(
+        struct aws_server_bootstrap *bootstrap,
+        int errorCode,
+        struct aws_channel *channel,
+        void *userData);
+    static void s_OnListenerDestroyed(struct aws_server_bootstrap *bootstrap, void *userData);
+
+    Aws::Crt::Io::EventLoopGroup &m_eventLoopGroup;
+    Aws::Crt::Allocator *m_allocator;
+    struct aws_server_bootstrap *m_bootstrap;
+    struct aws_socket *m_listener;
+    uint32_t m_port;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_signal;
+    /* sessions that can receive publishes, guarded by m_lock along with their subscriptions */
+    Aws::Crt::Vector<std::shared_ptr<MqttLoopbackSession>> m_sessions;
+    size_t m_openChannels;
+    bool m_listenerDestroyed;
+    bool m_stopping;
+    MqttLoopbackBrokerStatistics m_statistics;
+    std::atomic<uint64_t> m_assignedClientIds;
+};
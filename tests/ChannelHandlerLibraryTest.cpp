@@ -0,0 +1,558 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Api.h>
+#include <aws/crt/Compression.h>
+#include <aws/crt/io/CompressionHandler.h>
+#include <aws/crt/io/FramingHandler.h>
+#include <aws/crt/io/MetricsHandler.h>
+#include <aws/crt/io/WriteCoalescingHandler.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <utility>
+
+/*
+ * Left-most handler that turns every write message back into read messages, split into chunks of at most
+ * chunkSize bytes, so a channel can be exercised without a socket.
+ */
+class LoopbackHandler : public Aws::Crt::Io::ChannelHandler
+{
+  public:
+    LoopbackHandler(Aws::Crt::Allocator *allocator, size_t chunkSize)
+        : Aws::Crt::Io::ChannelHandler(allocator), m_chunkSize(chunkSize)
+    {
+    }
+
+    int ProcessReadMessage(struct aws_io_message *) override { return AWS_OP_ERR; }
+
+    int ProcessWriteMessage(struct aws_io_message *message) override
+    {
+        Aws::Crt::ByteCursor remaining = aws_byte_cursor_from_buf(&message->message_data);
+        while (remaining.len > 0)
+        {
+            Aws::Crt::ByteCursor chunk = aws_byte_cursor_advance(&remaining, std::min(remaining.len, m_chunkSize));
+            if (!SendData(chunk, Aws::Crt::Io::ChannelDirection::Read))
+            {
+                return AWS_OP_ERR;
+            }
+        }
+
+        if (message->on_completion != nullptr)
+        {
+            message->on_completion(GetSlot()->channel, message, AWS_ERROR_SUCCESS, message->user_data);
+        }
+        aws_mem_release(message->allocator, message);
+        return AWS_OP_SUCCESS;
+    }
+
+    int IncrementReadWindow(size_t) override { return AWS_OP_SUCCESS; }
+
+    void ProcessShutdown(Aws::Crt::Io::ChannelDirection dir, int errorCode, bool freeScarceResourcesImmediately)
+        override
+    {
+        OnShutdownComplete(dir, errorCode, freeScarceResourcesImmediately);
+    }
+
+    size_t InitialWindowSize() override { return SIZE_MAX; }
+
+    size_t MessageOverhead() override { return 0; }
+
+  private:
+    size_t m_chunkSize;
+};
+
+/*
+ * Right-most handler that writes whatever it is given and counts the bytes it reads. Its read window never grows
+ * past initialWindowSize.
+ */
+class SinkHandler : public Aws::Crt::Io::ChannelHandler
+{
+  public:
+    SinkHandler(Aws::Crt::Allocator *allocator, size_t initialWindowSize = SIZE_MAX)
+        : Aws::Crt::Io::ChannelHandler(allocator), m_initialWindowSize(initialWindowSize), m_bytesRead(0)
+    {
+    }
+
+    bool Write(
+        const Aws::Crt::ByteCursor &data,
+        aws_channel_on_message_write_completed_fn *onCompletion = nullptr,
+        void *userData = nullptr)
+    {
+        return SendData(data, Aws::Crt::Io::ChannelDirection::Write, onCompletion, userData);
+    }
+
+    size_t GetBytesRead() const { return m_bytesRead.load(); }
+
+    int ProcessReadMessage(struct aws_io_message *message) override
+    {
+        m_bytesRead += message->message_data.len;
+        aws_mem_release(message->allocator, message);
+        return AWS_OP_SUCCESS;
+    }
+
+    int ProcessWriteMessage(struct aws_io_message *) override { return AWS_OP_ERR; }
+
+    int IncrementReadWindow(size_t) override { return AWS_OP_SUCCESS; }
+
+    void ProcessShutdown(Aws::Crt::Io::ChannelDirection dir, int errorCode, bool freeScarceResourcesImmediately)
+        override
+    {
+        OnShutdownComplete(dir, errorCode, freeScarceResourcesImmediately);
+    }
+
+    size_t InitialWindowSize() override { return m_initialWindowSize; }
+
+    size_t MessageOverhead() override { return 0; }
+
+  private:
+    size_t m_initialWindowSize;
+    std::atomic<size_t> m_bytesRead;
+};
+
+struct LoopbackChannel
+{
+    Aws::Crt::Vector<std::shared_ptr<Aws::Crt::Io::ChannelHandler>> handlers;
+    std::promise<int> setupPromise;
+    std::promise<int> shutdownPromise;
+    std::shared_future<int> shutdownFuture = shutdownPromise.get_future().share();
+    struct aws_channel *channel = nullptr;
+};
+
+static void s_OnLoopbackChannelSetup(struct aws_channel *channel, int errorCode, void *userData)
+{
+    auto *loopback = static_cast<LoopbackChannel *>(userData);
+    if (errorCode == AWS_ERROR_SUCCESS)
+    {
+        for (const auto &handler : loopback->handlers)
+        {
+            struct aws_channel_slot *slot = aws_channel_slot_new(channel);
+            aws_channel_slot_insert_end(channel, slot);
+            aws_channel_slot_set_handler(slot, handler->SeatForCInterop(handler));
+        }
+    }
+    loopback->setupPromise.set_value(errorCode);
+}
+
+static void s_OnLoopbackChannelShutdown(struct aws_channel *, int errorCode, void *userData)
+{
+    auto *loopback = static_cast<LoopbackChannel *>(userData);
+    loopback->shutdownPromise.set_value(errorCode);
+}
+
+static int s_StartLoopbackChannel(
+    struct aws_allocator *allocator,
+    Aws::Crt::Io::EventLoopGroup &eventLoopGroup,
+    LoopbackChannel &loopback)
+{
+    struct aws_channel_options channelOptions;
+    AWS_ZERO_STRUCT(channelOptions);
+    channelOptions.event_loop = aws_event_loop_group_get_next_loop(eventLoopGroup.GetUnderlyingHandle());
+    channelOptions.on_setup_completed = s_OnLoopbackChannelSetup;
+    channelOptions.on_shutdown_completed = s_OnLoopbackChannelShutdown;
+    channelOptions.setup_user_data = &loopback;
+    channelOptions.shutdown_user_data = &loopback;
+
+    loopback.channel = aws_channel_new(allocator, &channelOptions);
+    ASSERT_NOT_NULL(loopback.channel);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, loopback.setupPromise.get_future().get());
+    return AWS_OP_SUCCESS;
+}
+
+static void s_StopLoopbackChannel(LoopbackChannel &loopback)
+{
+    aws_channel_shutdown(loopback.channel, AWS_ERROR_SUCCESS);
+    loopback.shutdownFuture.wait();
+    loopback.handlers.clear();
+    aws_channel_destroy(loopback.channel);
+}
+
+static Aws::Crt::String s_MakePayload(size_t index, size_t size)
+{
+    Aws::Crt::String payload;
+    while (payload.size() < size)
+    {
+        payload += "frame " + Aws::Crt::String(std::to_string(index).c_str()) + " of the loopback test; ";
+    }
+    payload.resize(size);
+    return payload;
+}
+
+/*
+ * Sends frameCount frames through framing -> (compression) -> metrics -> loopback and back, and checks that every
+ * frame arrives intact and in order.
+ */
+static int s_RunFramedLoopback(
+    struct aws_allocator *allocator,
+    const Aws::Crt::Io::FramingHandlerOptions &baseOptions,
+    bool compress,
+    size_t chunkSize,
+    size_t frameCount,
+    size_t frameSize)
+{
+    Aws::Crt::Io::EventLoopGroup eventLoopGroup(1, allocator);
+    ASSERT_TRUE(eventLoopGroup);
+
+    size_t framesReceived = 0;
+    size_t framesCorrupted = 0;
+    std::promise<void> allReceived;
+
+    Aws::Crt::Io::FramingHandlerOptions framingOptions = baseOptions;
+    framingOptions.OnFrameReceivedCallback = [&](const Aws::Crt::ByteCursor &frame)
+    {
+        Aws::Crt::String expected = s_MakePayload(framesReceived, frameSize);
+        if (frame.len != expected.size() || memcmp(frame.ptr, expected.data(), frame.len) != 0)
+        {
+            ++framesCorrupted;
+        }
+
+        if (++framesReceived == frameCount)
+        {
+            allReceived.set_value();
+        }
+    };
+
+    auto framing = Aws::Crt::MakeShared<Aws::Crt::Io::FramingHandler>(allocator, framingOptions, allocator);
+    auto metrics = Aws::Crt::MakeShared<Aws::Crt::Io::MetricsHandler>(allocator, allocator);
+
+    LoopbackChannel loopback;
+    loopback.handlers.push_back(Aws::Crt::MakeShared<LoopbackHandler>(allocator, allocator, chunkSize));
+    loopback.handlers.push_back(metrics);
+    if (compress)
+    {
+        loopback.handlers.push_back(Aws::Crt::MakeShared<Aws::Crt::Io::CompressionHandler>(
+            allocator,
+            Aws::Crt::StreamCodec::CreateCompressor(Aws::Crt::CompressionAlgorithm::Deflate, -1, allocator),
+            Aws::Crt::StreamCodec::CreateDecompressor(Aws::Crt::CompressionAlgorithm::Deflate, allocator),
+            SIZE_MAX,
+            16 * 1024 * 1024,
+            allocator));
+    }
+    loopback.handlers.push_back(framing);
+    ASSERT_SUCCESS(s_StartLoopbackChannel(allocator, eventLoopGroup, loopback));
+
+    Aws::Crt::Vector<Aws::Crt::String> payloads;
+    for (size_t i = 0; i < frameCount; ++i)
+    {
+        payloads.push_back(s_MakePayload(i, frameSize));
+    }
+
+    framing->ScheduleTask(
+        [&](Aws::Crt::Io::TaskStatus)
+        {
+            for (const Aws::Crt::String &payload : payloads)
+            {
+                framing->SendFrame(Aws::Crt::ByteCursorFromString(payload));
+            }
+        });
+    allReceived.get_future().wait();
+
+    ASSERT_UINT_EQUALS(frameCount, framesReceived);
+    ASSERT_UINT_EQUALS(0u, framesCorrupted);
+
+    Aws::Crt::Io::ChannelMetrics channelMetrics = metrics->GetMetrics();
+    ASSERT_UINT_EQUALS(channelMetrics.bytesWritten, channelMetrics.bytesRead);
+    ASSERT_TRUE(channelMetrics.writeCompletionLatency.count == channelMetrics.messagesWritten);
+    if (!compress)
+    {
+        size_t overhead = baseOptions.Mode == Aws::Crt::Io::FramingMode::LengthPrefix ? baseOptions.LengthPrefixSize
+                                                                                       : baseOptions.Delimiter.size();
+        ASSERT_UINT_EQUALS(frameCount * (frameSize + overhead), channelMetrics.bytesRead);
+    }
+
+    s_StopLoopbackChannel(loopback);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_TestChannelHandlerLibrary(struct aws_allocator *allocator, void *)
+{
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+
+        Aws::Crt::Io::FramingHandlerOptions lengthPrefix;
+        lengthPrefix.LengthPrefixSize = 2;
+        Aws::Crt::Io::FramingHandlerOptions delimiter;
+        delimiter.Mode = Aws::Crt::Io::FramingMode::Delimiter;
+        delimiter.Delimiter = "\r\n";
+
+        /* frames split across many small reads are reassembled */
+        ASSERT_SUCCESS(s_RunFramedLoopback(allocator, lengthPrefix, false, 7, 100, 300));
+        ASSERT_SUCCESS(s_RunFramedLoopback(allocator, delimiter, false, 7, 100, 300));
+
+        /* long bursts of frames */
+        ASSERT_SUCCESS(
+            s_RunFramedLoopback(allocator, Aws::Crt::Io::FramingHandlerOptions(), false, SIZE_MAX, 100000, 1024));
+        if (Aws::Crt::StreamCodec::IsSupported(Aws::Crt::CompressionAlgorithm::Deflate))
+        {
+            ASSERT_SUCCESS(
+                s_RunFramedLoopback(allocator, Aws::Crt::Io::FramingHandlerOptions(), true, SIZE_MAX, 100000, 1024));
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(ChannelHandlerLibrary, s_TestChannelHandlerLibrary)
+
+static int s_TestFramingHandlerReadBufferBound(struct aws_allocator *allocator, void *)
+{
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+        Aws::Crt::Io::EventLoopGroup eventLoopGroup(1, allocator);
+        ASSERT_TRUE(eventLoopGroup);
+
+        /* The sink never opens its window, so every frame stays in the framing handler */
+        Aws::Crt::Io::FramingHandlerOptions framingOptions;
+        framingOptions.MaxFrameSize = 1024;
+        framingOptions.MaxBufferedSize = 16 * 1024;
+        auto framing = Aws::Crt::MakeShared<Aws::Crt::Io::FramingHandler>(allocator, framingOptions, allocator);
+        auto sink = Aws::Crt::MakeShared<SinkHandler>(allocator, allocator, 0);
+        LoopbackChannel loopback;
+        loopback.handlers.push_back(Aws::Crt::MakeShared<LoopbackHandler>(allocator, allocator, SIZE_MAX));
+        loopback.handlers.push_back(framing);
+        loopback.handlers.push_back(sink);
+        ASSERT_SUCCESS(s_StartLoopbackChannel(allocator, eventLoopGroup, loopback));
+
+        Aws::Crt::String payload = s_MakePayload(0, 1000);
+        framing->ScheduleTask(
+            [&](Aws::Crt::Io::TaskStatus)
+            {
+                for (size_t i = 0; i < 32; ++i)
+                {
+                    framing->SendFrame(Aws::Crt::ByteCursorFromString(payload));
+                }
+            });
+        ASSERT_TRUE(std::future_status::ready == loopback.shutdownFuture.wait_for(std::chrono::seconds(10)));
+        ASSERT_INT_EQUALS(AWS_IO_CHANNEL_ERROR_ERROR_CANT_ACCEPT_INPUT, loopback.shutdownFuture.get());
+        ASSERT_UINT_EQUALS(0, sink->GetBytesRead());
+
+        s_StopLoopbackChannel(loopback);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(FramingHandlerReadBufferBound, s_TestFramingHandlerReadBufferBound)
+
+/* Registered only in builds with zlib, see tests/CMakeLists.txt */
+static int s_TestCompressionHandlerPendingReadBound(struct aws_allocator *allocator, void *)
+{
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+        ASSERT_TRUE(Aws::Crt::StreamCodec::IsSupported(Aws::Crt::CompressionAlgorithm::Deflate));
+        Aws::Crt::Io::EventLoopGroup eventLoopGroup(1, allocator);
+        ASSERT_TRUE(eventLoopGroup);
+
+        /* One stream: 32 KiB, then a few KiB expanding to 16 MiB */
+        Aws::Crt::StreamCodec compressor =
+            Aws::Crt::StreamCodec::CreateCompressor(Aws::Crt::CompressionAlgorithm::Deflate, -1, allocator);
+        Aws::Crt::Vector<uint8_t> plain(16 * 1024 * 1024, 'x');
+        Aws::Crt::ByteBuf small = Aws::Crt::ByteBufInit(allocator, 0);
+        Aws::Crt::ByteBuf bomb = Aws::Crt::ByteBufInit(allocator, 0);
+        Aws::Crt::ByteCursor smallInput = aws_byte_cursor_from_array(plain.data(), 32 * 1024);
+        Aws::Crt::ByteCursor bombInput = aws_byte_cursor_from_array(plain.data(), plain.size());
+        ASSERT_TRUE(compressor.Update(smallInput, small) && compressor.Flush(small));
+        ASSERT_TRUE(compressor.Update(bombInput, bomb) && compressor.Flush(bomb));
+        ASSERT_TRUE(bomb.len < 64 * 1024);
+
+        /* Without a valid compressor writes pass through, so the loopback reads back exactly what the sink wrote */
+        Aws::Crt::StreamCodec noCompressor =
+            Aws::Crt::StreamCodec::CreateCompressor(Aws::Crt::CompressionAlgorithm::Deflate, -1, allocator);
+        Aws::Crt::StreamCodec unused = std::move(noCompressor);
+        auto sink = Aws::Crt::MakeShared<SinkHandler>(allocator, allocator);
+        LoopbackChannel loopback;
+        loopback.handlers.push_back(Aws::Crt::MakeShared<LoopbackHandler>(allocator, allocator, SIZE_MAX));
+        loopback.handlers.push_back(Aws::Crt::MakeShared<Aws::Crt::Io::CompressionHandler>(
+            allocator,
+            std::move(noCompressor),
+            Aws::Crt::StreamCodec::CreateDecompressor(Aws::Crt::CompressionAlgorithm::Deflate, allocator),
+            SIZE_MAX,
+            64 * 1024,
+            allocator));
+        loopback.handlers.push_back(sink);
+        ASSERT_SUCCESS(s_StartLoopbackChannel(allocator, eventLoopGroup, loopback));
+
+        std::promise<bool> written;
+        sink->ScheduleTask([&](Aws::Crt::Io::TaskStatus)
+                           { written.set_value(sink->Write(aws_byte_cursor_from_buf(&small))); });
+        ASSERT_TRUE(written.get_future().get());
+        ASSERT_UINT_EQUALS(32 * 1024, sink->GetBytesRead());
+
+        std::promise<bool> bombWritten;
+        sink->ScheduleTask([&](Aws::Crt::Io::TaskStatus)
+                           { bombWritten.set_value(sink->Write(aws_byte_cursor_from_buf(&bomb))); });
+        bombWritten.get_future().wait();
+        ASSERT_TRUE(std::future_status::ready == loopback.shutdownFuture.wait_for(std::chrono::seconds(10)));
+        ASSERT_INT_EQUALS(AWS_ERROR_SHORT_BUFFER, loopback.shutdownFuture.get());
+        ASSERT_TRUE(sink->GetBytesRead() <= 32 * 1024 + 64 * 1024);
+
+        s_StopLoopbackChannel(loopback);
+        Aws::Crt::ByteBufDelete(small);
+        Aws::Crt::ByteBufDelete(bomb);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(CompressionHandlerPendingReadBound, s_TestCompressionHandlerPendingReadBound)
+
+static int s_TestWriteCoalescingHandler(struct aws_allocator *allocator, void *)
+{
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+        Aws::Crt::Io::EventLoopGroup eventLoopGroup(1, allocator);
+        ASSERT_TRUE(eventLoopGroup);
+
+        const size_t frameCount = 10000;
+        const size_t frameSize = 40;
+
+        std::atomic<size_t> framesReceived(0);
+        std::promise<void> burstReceived;
+        std::promise<void> lateFrameReceived;
+        Aws::Crt::Io::FramingHandlerOptions framingOptions;
+        framingOptions.OnFrameReceivedCallback = [&](const Aws::Crt::ByteCursor &)
+        {
+            size_t received = ++framesReceived;
+            if (received == frameCount)
+            {
+                burstReceived.set_value();
+            }
+            else if (received == frameCount + 1)
+            {
+                lateFrameReceived.set_value();
+            }
+        };
+
+        Aws::Crt::Io::WriteCoalescingOptions coalescingOptions;
+        coalescingOptions.MaxDelay = std::chrono::milliseconds(5);
+
+        auto framing = Aws::Crt::MakeShared<Aws::Crt::Io::FramingHandler>(allocator, framingOptions, allocator);
+        auto coalescing =
+            Aws::Crt::MakeShared<Aws::Crt::Io::WriteCoalescingHandler>(allocator, coalescingOptions, allocator);
+        auto metrics = Aws::Crt::MakeShared<Aws::Crt::Io::MetricsHandler>(allocator, allocator);
+
+        LoopbackChannel loopback;
+        loopback.handlers.push_back(Aws::Crt::MakeShared<LoopbackHandler>(allocator, allocator, SIZE_MAX));
+        loopback.handlers.push_back(metrics);
+        loopback.handlers.push_back(coalescing);
+        loopback.handlers.push_back(framing);
+        ASSERT_SUCCESS(s_StartLoopbackChannel(allocator, eventLoopGroup, loopback));
+
+        Aws::Crt::String payload = s_MakePayload(0, frameSize);
+        framing->ScheduleTask(
+            [&](Aws::Crt::Io::TaskStatus)
+            {
+                for (size_t i = 0; i < frameCount; ++i)
+                {
+                    framing->SendFrame(Aws::Crt::ByteCursorFromString(payload));
+                }
+            });
+        burstReceived.get_future().wait();
+
+        /* a lone write goes out once the delay expires */
+        framing->ScheduleTask([&](Aws::Crt::Io::TaskStatus)
+                              { framing->SendFrame(Aws::Crt::ByteCursorFromString(payload)); });
+        ASSERT_TRUE(
+            std::future_status::ready == lateFrameReceived.get_future().wait_for(std::chrono::seconds(10)));
+
+        Aws::Crt::Io::WriteCoalescingStatistics statistics = coalescing->GetStatistics();
+        Aws::Crt::Io::ChannelMetrics channelMetrics = metrics->GetMetrics();
+        ASSERT_UINT_EQUALS(frameCount + 1, statistics.messagesIn);
+        ASSERT_UINT_EQUALS(statistics.messagesOut, channelMetrics.messagesWritten);
+        ASSERT_UINT_EQUALS((frameCount + 1) * (frameSize + framingOptions.LengthPrefixSize), statistics.bytesOut);
+        ASSERT_TRUE(statistics.messagesOut * 100 < statistics.messagesIn);
+
+        s_StopLoopbackChannel(loopback);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(WriteCoalescingHandler, s_TestWriteCoalescingHandler)
+
+struct CoalescedWrite
+{
+    Aws::Crt::String data;
+    std::promise<bool> completed;
+};
+
+static void s_OnCoalescedWriteCompleted(
+    struct aws_channel *,
+    struct aws_io_message *message,
+    int errorCode,
+    void *userData)
+{
+    /* The completion gets the message that was written, not the batch it was packed into */
+    auto *write = static_cast<CoalescedWrite *>(userData);
+    Aws::Crt::ByteCursor data = Aws::Crt::ByteCursorFromString(write->data);
+    write->completed.set_value(
+        errorCode == AWS_ERROR_SUCCESS && message->user_data == userData &&
+        aws_byte_cursor_eq_byte_buf(&data, &message->message_data));
+}
+
+static int s_TestWriteCoalescingHandlerCompletions(struct aws_allocator *allocator, void *)
+{
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+        Aws::Crt::Io::EventLoopGroup eventLoopGroup(1, allocator);
+        ASSERT_TRUE(eventLoopGroup);
+
+        auto coalescing = Aws::Crt::MakeShared<Aws::Crt::Io::WriteCoalescingHandler>(
+            allocator, Aws::Crt::Io::WriteCoalescingOptions(), allocator);
+        auto sink = Aws::Crt::MakeShared<SinkHandler>(allocator, allocator);
+        LoopbackChannel loopback;
+        loopback.handlers.push_back(Aws::Crt::MakeShared<LoopbackHandler>(allocator, allocator, SIZE_MAX));
+        loopback.handlers.push_back(coalescing);
+        loopback.handlers.push_back(sink);
+        ASSERT_SUCCESS(s_StartLoopbackChannel(allocator, eventLoopGroup, loopback));
+
+        /* Small writes share a batch, a write of a full message goes through on its own */
+        const size_t smallWriteCount = 8;
+        Aws::Crt::Vector<CoalescedWrite> writes(smallWriteCount + 1);
+        for (size_t i = 0; i < smallWriteCount; ++i)
+        {
+            writes[i].data = s_MakePayload(i, 16 + i);
+        }
+        writes[smallWriteCount].data = s_MakePayload(smallWriteCount, g_aws_channel_max_fragment_size);
+
+        std::promise<bool> written;
+        sink->ScheduleTask(
+            [&](Aws::Crt::Io::TaskStatus)
+            {
+                bool ok = true;
+                for (CoalescedWrite &write : writes)
+                {
+                    ok = ok &&
+                         sink->Write(Aws::Crt::ByteCursorFromString(write.data), s_OnCoalescedWriteCompleted, &write);
+                }
+                written.set_value(ok);
+            });
+        ASSERT_TRUE(written.get_future().get());
+        for (CoalescedWrite &write : writes)
+        {
+            ASSERT_TRUE(write.completed.get_future().get());
+        }
+
+        size_t bytesWritten = 0;
+        for (const CoalescedWrite &write : writes)
+        {
+            bytesWritten += write.data.size();
+        }
+        Aws::Crt::Io::WriteCoalescingStatistics statistics = coalescing->GetStatistics();
+        ASSERT_UINT_EQUALS(smallWriteCount + 1, statistics.messagesIn);
+        ASSERT_UINT_EQUALS(2, statistics.messagesOut);
+        ASSERT_UINT_EQUALS(bytesWritten, statistics.bytesOut);
+        ASSERT_UINT_EQUALS(bytesWritten, sink->GetBytesRead());
+
+        s_StopLoopbackChannel(loopback);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(WriteCoalescingHandlerCompletions, s_TestWriteCoalescingHandlerCompletions)
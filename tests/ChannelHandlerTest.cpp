@@ -6,6 +6,7 @@
 #include <aws/crt/io/ChannelHandler.h>
 #include <aws/testing/aws_test_harness.h>
 
+#include <future>
 #include <utility>
 
 class ChannelHandlerMock : public Aws::Crt::Io::ChannelHandler
@@ -104,3 +105,138 @@ static int s_TestChannelHandlerInterop(struct aws_allocator *allocator, void *)
 }
 
 AWS_TEST_CASE(ChannelHandlerInterop, s_TestChannelHandlerInterop)
+
+class PassthroughHandlerMock : public Aws::Crt::Io::ChannelHandler
+{
+  public:
+    PassthroughHandlerMock(Aws::Crt::Allocator *allocator) : Aws::Crt::Io::ChannelHandler(allocator) {}
+
+    int ProcessReadMessage(struct aws_io_message *message) override
+    {
+        aws_mem_release(message->allocator, message);
+        return AWS_OP_SUCCESS;
+    }
+
+    int ProcessWriteMessage(struct aws_io_message *message) override
+    {
+        aws_mem_release(message->allocator, message);
+        return AWS_OP_SUCCESS;
+    }
+
+    int IncrementReadWindow(size_t) override { return AWS_OP_SUCCESS; }
+
+    void ProcessShutdown(Aws::Crt::Io::ChannelDirection dir, int errorCode, bool freeScarceResourcesImmediately)
+        override
+    {
+        OnShutdownComplete(dir, errorCode, freeScarceResourcesImmediately);
+    }
+
+    size_t InitialWindowSize() override { return SIZE_MAX; }
+
+    size_t MessageOverhead() override { return 0; }
+
+    /* Reschedules itself from the channel's thread until `remaining` reaches zero. */
+    void RescheduleUntilDone(size_t remaining, std::promise<size_t> &done, bool useStdFunction)
+    {
+        if (remaining == 0)
+        {
+            done.set_value(TasksRun);
+            return;
+        }
+
+        auto task = [this, remaining, &done, useStdFunction](Aws::Crt::Io::TaskStatus status)
+        {
+            if (status == Aws::Crt::Io::TaskStatus::RunReady)
+            {
+                ++TasksRun;
+                RescheduleUntilDone(remaining - 1, done, useStdFunction);
+            }
+        };
+
+        if (useStdFunction)
+        {
+            ScheduleTask(std::function<void(Aws::Crt::Io::TaskStatus)>(task));
+        }
+        else
+        {
+            ScheduleTask(task);
+        }
+    }
+
+    size_t TasksRun = 0;
+};
+
+struct ChannelTestContext
+{
+    std::shared_ptr<PassthroughHandlerMock> handler;
+    std::promise<int> setupPromise;
+    std::promise<void> shutdownPromise;
+};
+
+static void s_OnChannelSetup(struct aws_channel *channel, int errorCode, void *userData)
+{
+    auto *context = static_cast<ChannelTestContext *>(userData);
+    if (errorCode == AWS_ERROR_SUCCESS)
+    {
+        struct aws_channel_slot *slot = aws_channel_slot_new(channel);
+        aws_channel_slot_insert_end(channel, slot);
+        aws_channel_slot_set_handler(slot, context->handler->SeatForCInterop(context->handler));
+    }
+    context->setupPromise.set_value(errorCode);
+}
+
+static void s_OnChannelShutdown(struct aws_channel *, int, void *userData)
+{
+    auto *context = static_cast<ChannelTestContext *>(userData);
+    context->shutdownPromise.set_value();
+}
+
+static int s_RunScheduleTaskChain(struct aws_allocator *allocator, bool useStdFunction)
+{
+    const size_t taskCount = 100000;
+
+    Aws::Crt::Io::EventLoopGroup eventLoopGroup(1, allocator);
+    ASSERT_TRUE(eventLoopGroup);
+
+    ChannelTestContext context;
+    context.handler = Aws::Crt::MakeShared<PassthroughHandlerMock>(allocator, allocator);
+
+    struct aws_channel_options channelOptions;
+    AWS_ZERO_STRUCT(channelOptions);
+    channelOptions.event_loop = aws_event_loop_group_get_next_loop(eventLoopGroup.GetUnderlyingHandle());
+    channelOptions.on_setup_completed = s_OnChannelSetup;
+    channelOptions.on_shutdown_completed = s_OnChannelShutdown;
+    channelOptions.setup_user_data = &context;
+    channelOptions.shutdown_user_data = &context;
+
+    struct aws_channel *channel = aws_channel_new(allocator, &channelOptions);
+    ASSERT_NOT_NULL(channel);
+    ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, context.setupPromise.get_future().get());
+
+    std::promise<size_t> done;
+    context.handler->ScheduleTask(
+        [&context, &done, taskCount, useStdFunction](Aws::Crt::Io::TaskStatus)
+        { context.handler->RescheduleUntilDone(taskCount, done, useStdFunction); });
+    ASSERT_UINT_EQUALS(taskCount, done.get_future().get());
+
+    aws_channel_shutdown(channel, AWS_ERROR_SUCCESS);
+    context.shutdownPromise.get_future().wait();
+    context.handler = nullptr;
+    aws_channel_destroy(channel);
+
+    return AWS_OP_SUCCESS;
+}
+
+static int s_TestChannelHandlerScheduleTask(struct aws_allocator *allocator, void *)
+{
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+
+        ASSERT_SUCCESS(s_RunScheduleTaskChain(allocator, true));
+        ASSERT_SUCCESS(s_RunScheduleTaskChain(allocator, false));
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(ChannelHandlerScheduleTask, s_TestChannelHandlerScheduleTask)
@@ -0,0 +1,114 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Api.h>
+#include <aws/crt/Compression.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <algorithm>
+#include <string>
+
+static int s_RunStreamCodecRoundTrip(struct aws_allocator *allocator, Aws::Crt::CompressionAlgorithm algorithm)
+{
+    Aws::Crt::String input;
+    for (size_t i = 0; input.size() < 256 * 1024; ++i)
+    {
+        input += "stream codec round trip " + Aws::Crt::String(std::to_string(i % 97).c_str()) + "\n";
+    }
+
+    Aws::Crt::StreamCodec compressor = Aws::Crt::StreamCodec::CreateCompressor(algorithm, -1, allocator);
+    Aws::Crt::StreamCodec decompressor = Aws::Crt::StreamCodec::CreateDecompressor(algorithm, allocator);
+    ASSERT_TRUE(compressor);
+    ASSERT_TRUE(decompressor);
+
+    Aws::Crt::ByteBuf compressed = Aws::Crt::ByteBufInit(allocator, 0);
+    Aws::Crt::ByteBuf decompressed = Aws::Crt::ByteBufInit(allocator, 0);
+
+    /* every flushed piece can be decoded on its own, before the stream ends */
+    const size_t pieceSize = 10000;
+    for (size_t offset = 0; offset < input.size(); offset += pieceSize)
+    {
+        size_t start = compressed.len;
+        Aws::Crt::ByteCursor piece = aws_byte_cursor_from_array(
+            reinterpret_cast<const uint8_t *>(input.data()) + offset, std::min(pieceSize, input.size() - offset));
+        ASSERT_TRUE(compressor.Update(piece, compressed));
+        ASSERT_UINT_EQUALS(0u, piece.len);
+        ASSERT_TRUE(compressor.Flush(compressed));
+
+        Aws::Crt::ByteCursor flushed = aws_byte_cursor_from_array(compressed.buffer + start, compressed.len - start);
+        ASSERT_TRUE(decompressor.Update(flushed, decompressed));
+        ASSERT_UINT_EQUALS(offset + std::min(pieceSize, input.size() - offset), decompressed.len);
+    }
+
+    size_t start = compressed.len;
+    ASSERT_TRUE(compressor.Finish(compressed));
+    Aws::Crt::ByteCursor tail = aws_byte_cursor_from_array(compressed.buffer + start, compressed.len - start);
+    ASSERT_TRUE(decompressor.Update(tail, decompressed));
+    ASSERT_TRUE(decompressor.Finish(decompressed));
+    ASSERT_BIN_ARRAYS_EQUALS(input.data(), input.size(), decompressed.buffer, decompressed.len);
+    ASSERT_TRUE(compressed.len < input.size() / 10);
+
+    /* one-shot helpers, and truncated input is detected */
+    Aws::Crt::ByteBuf oneShot = Aws::Crt::ByteBufInit(allocator, 0);
+    Aws::Crt::ByteBuf restored = Aws::Crt::ByteBufInit(allocator, 0);
+    ASSERT_TRUE(Aws::Crt::StreamCodec::CompressOneShot(
+        algorithm, Aws::Crt::ByteCursorFromString(input), oneShot, -1, allocator));
+    ASSERT_TRUE(Aws::Crt::StreamCodec::DecompressOneShot(
+        algorithm, aws_byte_cursor_from_buf(&oneShot), restored, input.size(), allocator));
+    ASSERT_BIN_ARRAYS_EQUALS(input.data(), input.size(), restored.buffer, restored.len);
+
+    restored.len = 0;
+    ASSERT_FALSE(Aws::Crt::StreamCodec::DecompressOneShot(
+        algorithm, aws_byte_cursor_from_array(oneShot.buffer, oneShot.len / 2), restored, input.size(), allocator));
+
+    /* output past the limit is refused, whether the stream ends right after it or goes on for much longer */
+    restored.len = 0;
+    ASSERT_FALSE(Aws::Crt::StreamCodec::DecompressOneShot(
+        algorithm, aws_byte_cursor_from_buf(&oneShot), restored, input.size() - 1, allocator));
+    ASSERT_INT_EQUALS(AWS_ERROR_SHORT_BUFFER, aws_last_error());
+
+    Aws::Crt::Vector<uint8_t> zeros(16 * 1024 * 1024, 0);
+    Aws::Crt::ByteBuf bomb = Aws::Crt::ByteBufInit(allocator, 0);
+    ASSERT_TRUE(Aws::Crt::StreamCodec::CompressOneShot(
+        algorithm, aws_byte_cursor_from_array(zeros.data(), zeros.size()), bomb, -1, allocator));
+    ASSERT_TRUE(bomb.len < 64 * 1024);
+    Aws::Crt::ByteBuf defused = Aws::Crt::ByteBufInit(allocator, 0);
+    ASSERT_FALSE(Aws::Crt::StreamCodec::DecompressOneShot(
+        algorithm, aws_byte_cursor_from_buf(&bomb), defused, 64 * 1024, allocator));
+    ASSERT_INT_EQUALS(AWS_ERROR_SHORT_BUFFER, aws_last_error());
+    ASSERT_TRUE(defused.capacity <= 128 * 1024);
+    Aws::Crt::ByteBufDelete(bomb);
+    Aws::Crt::ByteBufDelete(defused);
+
+    Aws::Crt::ByteBufDelete(compressed);
+    Aws::Crt::ByteBufDelete(decompressed);
+    Aws::Crt::ByteBufDelete(oneShot);
+    Aws::Crt::ByteBufDelete(restored);
+    return AWS_OP_SUCCESS;
+}
+
+static int s_TestStreamCodecRoundTrip(struct aws_allocator *allocator, void *)
+{
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+
+        for (Aws::Crt::CompressionAlgorithm algorithm :
+             {Aws::Crt::CompressionAlgorithm::Deflate, Aws::Crt::CompressionAlgorithm::Zstd})
+        {
+            if (!Aws::Crt::StreamCodec::IsSupported(algorithm))
+            {
+                Aws::Crt::StreamCodec unsupported = Aws::Crt::StreamCodec::CreateCompressor(algorithm, -1, allocator);
+                ASSERT_FALSE(unsupported);
+                ASSERT_INT_EQUALS(AWS_ERROR_UNSUPPORTED_OPERATION, unsupported.LastError());
+                continue;
+            }
+
+            ASSERT_SUCCESS(s_RunStreamCodecRoundTrip(allocator, algorithm));
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(StreamCodecRoundTrip, s_TestStreamCodecRoundTrip)
@@ -0,0 +1,113 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Api.h>
+#include <aws/crt/auth/Credentials.h>
+#include <aws/crt/coro/Awaitables.h>
+#include <aws/crt/io/HostResolver.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <future>
+
+/* Built and registered with ENABLE_COROUTINE_TESTS, which compiles the tests as C++20 */
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+using namespace Aws::Crt;
+
+static const size_t s_iterationCount = 100000;
+
+static Coro::DetachedTask s_AwaitCredentialsRepeatedly(
+    const Auth::ICredentialsProvider &provider,
+    size_t iterations,
+    std::promise<size_t> &done)
+{
+    size_t successCount = 0;
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        Coro::CredentialsResult result = co_await Coro::GetCredentials(provider);
+        if (result.errorCode == AWS_ERROR_SUCCESS && result.credentials)
+        {
+            ++successCount;
+        }
+    }
+    done.set_value(successCount);
+}
+
+static Coro::DetachedTask s_ResolveOnLoop(
+    Io::HostResolver &resolver,
+    Io::EventLoop resumeOn,
+    Io::EventLoop expectedLoop,
+    std::promise<bool> &done)
+{
+    Coro::HostResolutionResult result = co_await Coro::ResolveHost(resolver, "localhost", resumeOn);
+    done.set_value(
+        result.errorCode == AWS_ERROR_SUCCESS && !result.addresses.empty() &&
+        (!expectedLoop || expectedLoop.IsCallersThread()));
+}
+
+/* Looks up the loop it runs on once, and comes back to it after each co_await */
+static Coro::DetachedTask s_ResolveTwiceOnCallersLoop(
+    Io::HostResolver &resolver,
+    const Io::EventLoopGroup &eventLoopGroup,
+    std::promise<bool> &done)
+{
+    Io::EventLoop callersLoop = eventLoopGroup.GetCallersLoop();
+    bool resumedOnCallersLoop = static_cast<bool>(callersLoop);
+    for (size_t i = 0; i < 2; ++i)
+    {
+        Coro::HostResolutionResult result = co_await Coro::ResolveHost(resolver, "localhost", callersLoop);
+        resumedOnCallersLoop = resumedOnCallersLoop && result.errorCode == AWS_ERROR_SUCCESS &&
+                               callersLoop.IsCallersThread();
+    }
+    done.set_value(resumedOnCallersLoop);
+}
+
+static int s_TestCoroutineAwaitables(struct aws_allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+
+        /* Completions arriving before the coroutine suspends continue it without growing the stack */
+        Auth::CredentialsProviderStaticConfig config;
+        config.AccessKeyId = aws_byte_cursor_from_c_str("AccessKey");
+        config.SecretAccessKey = aws_byte_cursor_from_c_str("Sekrit");
+        auto provider = Auth::CredentialsProvider::CreateCredentialsProviderStatic(config, allocator);
+        ASSERT_NOT_NULL(provider.get());
+
+        std::promise<size_t> credentialsDone;
+        s_AwaitCredentialsRepeatedly(*provider, s_iterationCount, credentialsDone);
+        ASSERT_UINT_EQUALS(s_iterationCount, credentialsDone.get_future().get());
+
+        /* The resolver completes on its own thread */
+        Io::EventLoopGroup resolverEventLoopGroup(1, allocator);
+        ASSERT_TRUE(resolverEventLoopGroup);
+        Io::DefaultHostResolver resolver(resolverEventLoopGroup, 8, 30, allocator);
+        ASSERT_TRUE(resolver);
+
+        /* An asynchronous completion resumes on the requested event loop */
+        Io::EventLoopGroup eventLoopGroup(1, allocator);
+        ASSERT_TRUE(eventLoopGroup);
+        std::promise<bool> explicitLoopDone;
+        s_ResolveOnLoop(resolver, eventLoopGroup.GetLoopAt(0), eventLoopGroup.GetLoopAt(0), explicitLoopDone);
+        ASSERT_TRUE(explicitLoopDone.get_future().get());
+
+        /* Without one, it resumes inline on whichever thread the resolver completes on */
+        std::promise<bool> inlineDone;
+        s_ResolveOnLoop(resolver, Io::EventLoop(), Io::EventLoop(), inlineDone);
+        ASSERT_TRUE(inlineDone.get_future().get());
+
+        /* A coroutine started on a loop looks it up once and comes back to it each time */
+        std::promise<bool> callersLoopDone;
+        ASSERT_TRUE(eventLoopGroup.GetLoopAt(0).Schedule(
+            [&resolver, &eventLoopGroup, &callersLoopDone](Io::TaskStatus)
+            { s_ResolveTwiceOnCallersLoop(resolver, eventLoopGroup, callersLoopDone); }));
+        ASSERT_TRUE(callersLoopDone.get_future().get());
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(CoroutineAwaitables, s_TestCoroutineAwaitables)
+
+#endif
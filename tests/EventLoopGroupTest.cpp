@@ -2,9 +2,15 @@
  * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
  * SPDX-License-Identifier: Apache-2.0.
  */
+#include <aws/common/system_info.h>
 #include <aws/crt/Api.h>
 #include <aws/testing/aws_test_harness.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <utility>
 
 static int s_TestEventLoopResourceSafety(struct aws_allocator *allocator, void *ctx)
@@ -30,3 +36,191 @@ static int s_TestEventLoopResourceSafety(struct aws_allocator *allocator, void *
 }
 
 AWS_TEST_CASE(EventLoopResourceSafety, s_TestEventLoopResourceSafety)
+
+static int s_TestEventLoopGroupSchedule(struct aws_allocator *allocator, void *ctx)
+{
+    (void)ctx;
+
+    {
+        Aws::Crt::ApiHandle handle;
+
+        Aws::Crt::Io::EventLoopGroup eventLoopGroup(2, allocator);
+        ASSERT_TRUE(eventLoopGroup);
+        ASSERT_UINT_EQUALS(2u, eventLoopGroup.GetLoopCount());
+        ASSERT_FALSE(eventLoopGroup.GetLoopAt(2));
+        ASSERT_FALSE(eventLoopGroup.GetCallersLoop());
+
+        /* round-robin selection visits every loop */
+        Aws::Crt::Io::EventLoop first = eventLoopGroup.GetNextLoop(Aws::Crt::Io::LoopSelection::RoundRobin);
+        Aws::Crt::Io::EventLoop second = eventLoopGroup.GetNextLoop(Aws::Crt::Io::LoopSelection::RoundRobin);
+        ASSERT_TRUE(first && second);
+        ASSERT_TRUE(first.GetUnderlyingHandle() != second.GetUnderlyingHandle());
+
+        const size_t taskCount = 64;
+        std::mutex lock;
+        std::condition_variable signal;
+        size_t tasksRun = 0;
+        size_t postedOnSameLoop = 0;
+
+        auto onTaskDone = [&]()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ++tasksRun;
+            signal.notify_one();
+        };
+
+        for (size_t i = 0; i < taskCount; ++i)
+        {
+            ASSERT_TRUE(eventLoopGroup.Schedule(
+                [&](Aws::Crt::Io::TaskStatus status)
+                {
+                    if (status != Aws::Crt::Io::TaskStatus::RunReady)
+                    {
+                        return;
+                    }
+
+                    /* a continuation posted from a loop thread must stay on that loop */
+                    Aws::Crt::Io::EventLoop callersLoop = eventLoopGroup.GetCallersLoop();
+                    eventLoopGroup.Post(
+                        [&, callersLoop](Aws::Crt::Io::TaskStatus)
+                        {
+                            if (callersLoop.IsCallersThread())
+                            {
+                                std::lock_guard<std::mutex> guard(lock);
+                                ++postedOnSameLoop;
+                            }
+                            onTaskDone();
+                        });
+                },
+                i % 2 == 0 ? Aws::Crt::Io::LoopSelection::RoundRobin : Aws::Crt::Io::LoopSelection::LeastLoaded));
+        }
+
+        auto scheduledAt = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point delayedRunAt;
+        ASSERT_TRUE(eventLoopGroup.ScheduleAfter(
+            [&](Aws::Crt::Io::TaskStatus)
+            {
+                delayedRunAt = std::chrono::steady_clock::now();
+                onTaskDone();
+            },
+            std::chrono::milliseconds(50)));
+
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            signal.wait(guard, [&]() { return tasksRun == taskCount + 1; });
+        }
+
+        ASSERT_UINT_EQUALS(taskCount, postedOnSameLoop);
+        ASSERT_TRUE(delayedRunAt - scheduledAt >= std::chrono::milliseconds(50));
+    }
+
+    return AWS_ERROR_SUCCESS;
+}
+
+AWS_TEST_CASE(EventLoopGroupSchedule, s_TestEventLoopGroupSchedule)
+
+static int s_TestEventLoopGroupStatistics(struct aws_allocator *allocator, void *ctx)
+{
+    (void)ctx;
+
+    {
+        Aws::Crt::ApiHandle handle;
+
+        Aws::Crt::Io::EventLoopGroup eventLoopGroup(2, allocator);
+        ASSERT_TRUE(eventLoopGroup);
+        ASSERT_TRUE(eventLoopGroup.EnableLatencyProbe(std::chrono::milliseconds(5)));
+
+        const size_t taskCount = 32;
+        std::mutex lock;
+        std::condition_variable signal;
+        size_t tasksRun = 0;
+
+        for (size_t i = 0; i < taskCount; ++i)
+        {
+            ASSERT_TRUE(eventLoopGroup.Schedule(
+                [&](Aws::Crt::Io::TaskStatus)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    ++tasksRun;
+                    signal.notify_one();
+                },
+                Aws::Crt::Io::LoopSelection::RoundRobin));
+        }
+
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            signal.wait(guard, [&]() { return tasksRun == taskCount; });
+        }
+
+        /* give the probe a few intervals on each loop */
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        Aws::Crt::Vector<Aws::Crt::Io::EventLoopStatistics> statistics = eventLoopGroup.GetStatistics();
+        ASSERT_UINT_EQUALS(2u, statistics.size());
+
+        uint64_t scheduled = 0;
+        uint64_t run = 0;
+        uint64_t latencySamples = 0;
+        for (const auto &loopStatistics : statistics)
+        {
+            scheduled += loopStatistics.tasksScheduled;
+            run += loopStatistics.tasksRun;
+            latencySamples += loopStatistics.taskLatency.count;
+            ASSERT_TRUE(loopStatistics.probeLatency.count > 0);
+            ASSERT_TRUE(loopStatistics.busyRatio >= 0.0 && loopStatistics.busyRatio <= 1.0);
+        }
+        ASSERT_UINT_EQUALS(taskCount, scheduled);
+        ASSERT_UINT_EQUALS(taskCount, run);
+        ASSERT_UINT_EQUALS(taskCount, latencySamples);
+
+        eventLoopGroup.DisableLatencyProbe();
+        eventLoopGroup.ResetStatistics();
+        ASSERT_UINT_EQUALS(0u, eventLoopGroup.GetLoopAt(0).GetStatistics().tasksRun);
+    }
+
+    return AWS_ERROR_SUCCESS;
+}
+
+AWS_TEST_CASE(EventLoopGroupStatistics, s_TestEventLoopGroupStatistics)
+
+static int s_TestEventLoopGroupPlacement(struct aws_allocator *allocator, void *ctx)
+{
+    (void)ctx;
+
+    {
+        Aws::Crt::ApiHandle handle;
+
+        Aws::Crt::Io::EventLoopGroup eventLoopGroup(
+            Aws::Crt::Io::EventLoopPlacement::SpreadAcrossCpuGroups, 0, allocator);
+        ASSERT_TRUE(eventLoopGroup);
+        ASSERT_TRUE(eventLoopGroup.GetLoopCount() > 0);
+
+        /* every loop is pinned to a core of a known CPU group */
+        uint16_t groupCount = aws_get_cpu_group_count();
+        for (size_t i = 0; i < eventLoopGroup.GetLoopCount(); ++i)
+        {
+            Aws::Crt::Io::EventLoop eventLoop = eventLoopGroup.GetLoopAt(i);
+            ASSERT_TRUE(eventLoop.GetCpuId() >= 0);
+            ASSERT_TRUE(eventLoop.GetCpuGroup() >= 0 && eventLoop.GetCpuGroup() < groupCount);
+        }
+
+        Aws::Crt::Io::EventLoop nearLoop = eventLoopGroup.GetLoopNearCaller();
+        ASSERT_TRUE(nearLoop);
+
+        std::promise<void> taskRun;
+        ASSERT_TRUE(nearLoop.Schedule([&](Aws::Crt::Io::TaskStatus) { taskRun.set_value(); }));
+        taskRun.get_future().wait();
+
+        /* an explicit thread count is honored even if it exceeds the core count */
+        Aws::Crt::Io::EventLoopGroup oversubscribed(
+            Aws::Crt::Io::EventLoopPlacement::SpreadAcrossCpuGroups,
+            static_cast<uint16_t>(eventLoopGroup.GetLoopCount() + 1),
+            allocator);
+        ASSERT_TRUE(oversubscribed);
+        ASSERT_UINT_EQUALS(eventLoopGroup.GetLoopCount() + 1, oversubscribed.GetLoopCount());
+    }
+
+    return AWS_ERROR_SUCCESS;
+}
+
+AWS_TEST_CASE(EventLoopGroupPlacement, s_TestEventLoopGroupPlacement)
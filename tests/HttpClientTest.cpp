@@ -347,6 +347,99 @@ static int s_TestHttpStreamUnActivated(struct aws_allocator *allocator, void *ct
 
 AWS_TEST_CASE(HttpStreamUnActivated, s_TestHttpStreamUnActivated)
 
+static int s_TestHttpConnectionSetupMetrics(struct aws_allocator *allocator, void *ctx)
+{
+    (void)ctx;
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+        Aws::Crt::Io::TlsContextOptions tlsCtxOptions = Aws::Crt::Io::TlsContextOptions::InitDefaultClient();
+        Aws::Crt::Io::TlsContext tlsContext(tlsCtxOptions, Aws::Crt::Io::TlsMode::CLIENT, allocator);
+        ASSERT_TRUE(tlsContext);
+
+        Aws::Crt::Io::TlsConnectionOptions tlsConnectionOptions = tlsContext.NewConnectionOptions();
+        ByteCursor hostName = ByteCursorFromCString("aws-crt-test-stuff.s3.amazonaws.com");
+        tlsConnectionOptions.SetServerName(hostName);
+        tlsConnectionOptions.SetAlpnList("http/1.1");
+
+        Aws::Crt::Io::SocketOptions socketOptions;
+        socketOptions.SetConnectTimeoutMs(3000);
+
+        Aws::Crt::Io::EventLoopGroup eventLoopGroup(0, allocator);
+        ASSERT_TRUE(eventLoopGroup);
+
+        Aws::Crt::Io::DefaultHostResolver defaultHostResolver(eventLoopGroup, 8, 30, allocator);
+        ASSERT_TRUE(defaultHostResolver);
+
+        Aws::Crt::Io::ClientBootstrap clientBootstrap(eventLoopGroup, defaultHostResolver, allocator);
+        ASSERT_TRUE(clientBootstrap);
+        clientBootstrap.EnableBlockingShutdown();
+
+        std::shared_ptr<Http::HttpClientConnection> connection(nullptr);
+        bool setupDone = false;
+        bool connectionShutdown = false;
+        size_t metricsReported = 0;
+        Aws::Crt::Io::ConnectionSetupMetrics setupMetrics;
+
+        std::condition_variable semaphore;
+        std::mutex semaphoreLock;
+
+        Http::HttpClientConnectionOptions httpClientConnectionOptions;
+        httpClientConnectionOptions.Bootstrap = &clientBootstrap;
+        httpClientConnectionOptions.OnConnectionSetupCallback =
+            [&](const std::shared_ptr<Http::HttpClientConnection> &newConnection, int)
+        {
+            std::lock_guard<std::mutex> lockGuard(semaphoreLock);
+            connection = newConnection;
+            setupDone = true;
+            semaphore.notify_one();
+        };
+        httpClientConnectionOptions.OnConnectionShutdownCallback = [&](Http::HttpClientConnection &, int)
+        {
+            std::lock_guard<std::mutex> lockGuard(semaphoreLock);
+            connectionShutdown = true;
+            semaphore.notify_one();
+        };
+        httpClientConnectionOptions.OnConnectionSetupMetricsCallback =
+            [&](const Aws::Crt::Io::ConnectionSetupMetrics &metrics)
+        {
+            std::lock_guard<std::mutex> lockGuard(semaphoreLock);
+            setupMetrics = metrics;
+            ++metricsReported;
+        };
+        httpClientConnectionOptions.SocketOptions = socketOptions;
+        httpClientConnectionOptions.TlsOptions = tlsConnectionOptions;
+        httpClientConnectionOptions.HostName = String((const char *)hostName.ptr, hostName.len);
+        httpClientConnectionOptions.Port = 443;
+
+        std::unique_lock<std::mutex> semaphoreULock(semaphoreLock);
+        ASSERT_TRUE(Http::HttpClientConnection::CreateConnection(httpClientConnectionOptions, allocator));
+        semaphore.wait(semaphoreULock, [&]() { return setupDone; });
+        ASSERT_TRUE(connection);
+
+        /* the handshake completes before the connection is set up */
+        ASSERT_UINT_EQUALS(1, metricsReported);
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, setupMetrics.tlsErrorCode);
+        ASSERT_TRUE(setupMetrics.attemptStartNs > 0);
+        ASSERT_TRUE(setupMetrics.tlsHandshakeEndNs >= setupMetrics.attemptStartNs);
+        if (setupMetrics.tlsHandshakeStartNs != 0)
+        {
+            ASSERT_TRUE(setupMetrics.ResolveAndConnectDuration().count() > 0);
+            ASSERT_TRUE(setupMetrics.TlsHandshakeDuration().count() > 0);
+        }
+        if (Aws::Crt::Io::TlsContextOptions::IsAlpnSupported())
+        {
+            ASSERT_TRUE(setupMetrics.negotiatedProtocol == "http/1.1");
+        }
+
+        connection->Close();
+        semaphore.wait(semaphoreULock, [&]() { return connectionShutdown; });
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(HttpConnectionSetupMetrics, s_TestHttpConnectionSetupMetrics)
+
 static int s_TestHttpCreateConnectionInvalidTlsConnectionOptions(struct aws_allocator *allocator, void *ctx)
 {
     (void)ctx;
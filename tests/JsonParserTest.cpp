@@ -196,3 +196,39 @@ static int s_JsonMoveTest(struct aws_allocator *allocator, void *ctx)
     return AWS_OP_SUCCESS;
 }
 AWS_TEST_CASE(JsonMoveTest, s_JsonMoveTest)
+
+static int s_JsonMergePatchTest(struct aws_allocator *allocator, void *ctx)
+{
+    (void)ctx;
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+
+        const Aws::Crt::String document =
+            "{\"light\":{\"color\":\"red\",\"level\":3},\"mode\":\"auto\",\"tags\":[1,2]}";
+        const Aws::Crt::String patch = "{\"light\":{\"level\":5,\"blink\":null},\"mode\":null,\"tags\":[3],"
+                                       "\"fan\":{\"speed\":2,\"timer\":null}}";
+
+        Aws::Crt::JsonObject target(Aws::Crt::ByteCursorFromString(document));
+        ASSERT_TRUE(target.WasParseSuccessful());
+        Aws::Crt::JsonObject patchObject(Aws::Crt::ByteCursorFromString(patch));
+        ASSERT_TRUE(patchObject.WasParseSuccessful());
+
+        // nulls remove their key, objects merge and everything else is replaced
+        target.MergePatch(patchObject.View());
+        ASSERT_STR_EQUALS(
+            "{\"light\":{\"color\":\"red\",\"level\":5},\"tags\":[3],\"fan\":{\"speed\":2}}",
+            target.View().WriteCompact().c_str());
+
+        // accumulating patches keeps their nulls
+        Aws::Crt::JsonObject accumulated;
+        accumulated.MergePatch(Aws::Crt::JsonObject("{\"a\":1,\"b\":{\"c\":1}}").View(), true);
+        accumulated.MergePatch(Aws::Crt::JsonObject("{\"a\":null,\"b\":{\"d\":2}}").View(), true);
+        ASSERT_STR_EQUALS("{\"b\":{\"c\":1,\"d\":2},\"a\":null}", accumulated.View().WriteCompact().c_str());
+
+        // a patch which is not an object replaces the target
+        accumulated.MergePatch(Aws::Crt::JsonObject("[1]").View());
+        ASSERT_TRUE(accumulated.View().IsListType());
+    }
+    return AWS_OP_SUCCESS;
+}
+AWS_TEST_CASE(JsonMergePatch, s_JsonMergePatchTest)
@@ -0,0 +1,49 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Api.h>
+#include <aws/crt/LatencyHistogram.h>
+#include <aws/testing/aws_test_harness.h>
+
+static int s_TestLatencyHistogramPercentiles(struct aws_allocator *allocator, void *)
+{
+    (void)allocator;
+
+    Aws::Crt::LatencyHistogram histogram;
+    ASSERT_UINT_EQUALS(0u, histogram.GetSnapshot().GetPercentileNanos(50.0));
+
+    ASSERT_UINT_EQUALS(0u, Aws::Crt::LatencyHistogram::GetBucketIndex(0));
+    ASSERT_UINT_EQUALS(0u, Aws::Crt::LatencyHistogram::GetBucketIndex(1));
+    ASSERT_UINT_EQUALS(1u, Aws::Crt::LatencyHistogram::GetBucketIndex(2));
+    ASSERT_UINT_EQUALS(10u, Aws::Crt::LatencyHistogram::GetBucketIndex(1024));
+    ASSERT_UINT_EQUALS(
+        Aws::Crt::LatencyHistogramSnapshot::BucketCount - 1, Aws::Crt::LatencyHistogram::GetBucketIndex(UINT64_MAX));
+
+    /* 1us .. 1000us */
+    for (uint64_t i = 1; i <= 1000; ++i)
+    {
+        histogram.Record(i * 1000);
+    }
+
+    Aws::Crt::LatencyHistogramSnapshot snapshot = histogram.GetSnapshot();
+    ASSERT_UINT_EQUALS(1000u, snapshot.count);
+    ASSERT_UINT_EQUALS(1000000u, snapshot.maxNanos);
+    ASSERT_TRUE(snapshot.GetMeanNanos() == 500500.0);
+
+    /* percentiles are bucket upper bounds, so at most 2x the exact value */
+    uint64_t p50 = snapshot.GetPercentileNanos(50.0);
+    ASSERT_TRUE(p50 >= 500000 && p50 <= 1000000);
+    ASSERT_UINT_EQUALS(1000000u, snapshot.GetPercentileNanos(100.0));
+
+    Aws::Crt::LatencyHistogramSnapshot merged = snapshot;
+    merged.Merge(snapshot);
+    ASSERT_UINT_EQUALS(2000u, merged.count);
+
+    histogram.Reset();
+    ASSERT_UINT_EQUALS(0u, histogram.GetSnapshot().count);
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(LatencyHistogramPercentiles, s_TestLatencyHistogramPercentiles)
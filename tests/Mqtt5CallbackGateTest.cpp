@@ -0,0 +1,113 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/private/Mqtt5CallbackGate.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace Aws::Crt;
+
+static int s_TestMqtt5CallbackGateShutdownStress(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+
+        const size_t threadCount = 8;
+        for (size_t round = 0; round < 20; ++round)
+        {
+            Mqtt5::Mqtt5CallbackGate gate;
+            std::atomic<bool> closeReturned(false);
+            std::atomic<bool> stop(false);
+            std::atomic<size_t> admitted(0);
+            std::atomic<size_t> admittedAfterClose(0);
+
+            Vector<std::thread> dispatchers;
+            for (size_t i = 0; i < threadCount; ++i)
+            {
+                dispatchers.push_back(std::thread(
+                    [&]()
+                    {
+                        while (!stop.load())
+                        {
+                            Mqtt5::Mqtt5CallbackGate::Scope scope(gate);
+                            if (!scope)
+                            {
+                                continue;
+                            }
+
+                            admitted.fetch_add(1);
+                            /* The work of a callback, which Close() must not return in the middle of */
+                            std::this_thread::yield();
+                            if (closeReturned.load())
+                            {
+                                admittedAfterClose.fetch_add(1);
+                            }
+                        }
+                    }));
+            }
+
+            while (admitted.load() < threadCount * 16)
+            {
+                std::this_thread::yield();
+            }
+            gate.Close();
+            closeReturned.store(true);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            stop.store(true);
+            for (std::thread &dispatcher : dispatchers)
+            {
+                dispatcher.join();
+            }
+
+            ASSERT_TRUE(admitted.load() > 0);
+            ASSERT_UINT_EQUALS(0, admittedAfterClose.load());
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5CallbackGateShutdownStress, s_TestMqtt5CallbackGateShutdownStress)
+
+static int s_TestMqtt5CallbackGateCloseFromCallback(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+
+        Mqtt5::Mqtt5CallbackGate gate;
+        Mqtt5::Mqtt5CallbackGate otherGate;
+        {
+            Mqtt5::Mqtt5CallbackGate::Scope outer(gate);
+            ASSERT_TRUE(outer);
+            {
+                /* A callback closing its own client, from a callback of another one */
+                Mqtt5::Mqtt5CallbackGate::Scope other(otherGate);
+                Mqtt5::Mqtt5CallbackGate::Scope inner(gate);
+                ASSERT_TRUE(other);
+                ASSERT_TRUE(inner);
+                gate.Close();
+            }
+
+            Mqtt5::Mqtt5CallbackGate::Scope afterClose(gate);
+            ASSERT_FALSE(afterClose);
+
+            Mqtt5::Mqtt5CallbackGate::Scope stillOpen(otherGate);
+            ASSERT_TRUE(stillOpen);
+        }
+
+        /* Closing twice is harmless */
+        gate.Close();
+        otherGate.Close();
+        Mqtt5::Mqtt5CallbackGate::Scope closed(otherGate);
+        ASSERT_FALSE(closed);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5CallbackGateCloseFromCallback, s_TestMqtt5CallbackGateCloseFromCallback)
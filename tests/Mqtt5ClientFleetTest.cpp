@@ -0,0 +1,145 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/Mqtt5ClientFleet.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <atomic>
+#include <future>
+
+using namespace Aws::Crt;
+
+static int s_TestMqtt5ClientFleetMemoryBudget(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+
+        Mqtt5::Mqtt5ClientOptions options(allocator);
+        options.WithHostName("127.0.0.1").WithPort(1883);
+
+        /* Creating a client already takes more than a byte, so every operation is over budget */
+        Mqtt5::Mqtt5ClientFleetOptions fleetOptions(allocator);
+        fleetOptions.WithClientCount(2).WithClientIdPrefix("budget-").WithMemoryBudgetPerClient(1);
+
+        auto fleet = Mqtt5::Mqtt5ClientFleet::NewMqtt5ClientFleet(options, fleetOptions, allocator);
+        ASSERT_NOT_NULL(fleet.get());
+        ASSERT_UINT_EQUALS(2, fleet->GetClientCount());
+        ASSERT_TRUE(fleet->GetClientMemoryUsage(0) > 1);
+        ASSERT_TRUE(fleet->GetClientMemoryUsage(1) > 1);
+
+        auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+            allocator,
+            "budget/topic",
+            ByteCursorFromCString("payload"),
+            Mqtt5::QOS::AWS_MQTT5_QOS_AT_MOST_ONCE,
+            allocator);
+        ASSERT_FALSE(fleet->Publish(0, publishPacket));
+        ASSERT_INT_EQUALS(AWS_ERROR_OOM, fleet->LastError());
+
+        /* Out of range client */
+        ASSERT_FALSE(fleet->Publish(2, publishPacket));
+        ASSERT_INT_EQUALS(AWS_ERROR_INVALID_ARGUMENT, fleet->LastError());
+
+        Mqtt5::Mqtt5ClientFleetOptions emptyFleetOptions(allocator);
+        emptyFleetOptions.WithClientCount(0);
+        ASSERT_NULL(Mqtt5::Mqtt5ClientFleet::NewMqtt5ClientFleet(options, emptyFleetOptions, allocator).get());
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5ClientFleetMemoryBudget, s_TestMqtt5ClientFleetMemoryBudget)
+
+static int s_TestMqtt5ClientFleetLoopbackRoundTrip(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        const size_t clientCount = 4;
+        std::atomic<size_t> connected(0);
+        std::atomic<size_t> stopped(0);
+        std::promise<void> allConnected;
+        std::promise<void> allStopped;
+        std::promise<size_t> receivedBy;
+
+        Mqtt5::Mqtt5ClientOptions options(allocator);
+        options.WithHostName("127.0.0.1")
+            .WithPort(broker.GetPort())
+            .WithBootstrap(ApiHandle::GetOrCreateStaticDefaultClientBootstrap());
+
+        Mqtt5::Mqtt5ClientFleetOptions fleetOptions(allocator);
+        fleetOptions.WithClientCount(clientCount)
+            .WithClientIdPrefix("fleet-")
+            .WithConnectionSuccessCallback(
+                [&](size_t, const Mqtt5::OnConnectionSuccessEventData &)
+                {
+                    if (++connected == clientCount)
+                    {
+                        allConnected.set_value();
+                    }
+                })
+            .WithStoppedCallback(
+                [&](size_t, const Mqtt5::OnStoppedEventData &)
+                {
+                    if (++stopped == clientCount)
+                    {
+                        allStopped.set_value();
+                    }
+                })
+            .WithPublishReceivedCallback([&receivedBy](size_t clientIndex, const Mqtt5::PublishReceivedEventData &)
+                                         { receivedBy.set_value(clientIndex); });
+
+        auto fleet = Mqtt5::Mqtt5ClientFleet::NewMqtt5ClientFleet(options, fleetOptions, allocator);
+        ASSERT_NOT_NULL(fleet.get());
+        ASSERT_TRUE(fleet->Start());
+        allConnected.get_future().get();
+
+        std::promise<int> subscribePromise;
+        auto subscribePacket = MakeShared<Mqtt5::SubscribePacket>(allocator, allocator);
+        subscribePacket->WithSubscription(
+            Mqtt5::Subscription("fleet/+/data", Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator));
+        ASSERT_TRUE(fleet->Subscribe(
+            1,
+            subscribePacket,
+            [&subscribePromise](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+            { subscribePromise.set_value(errorCode); }));
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subscribePromise.get_future().get());
+
+        std::promise<int> publishPromise;
+        auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+            allocator,
+            "fleet/3/data",
+            ByteCursorFromCString("hello fleet"),
+            Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+            allocator);
+        ASSERT_TRUE(fleet->Publish(
+            3,
+            publishPacket,
+            [&publishPromise](int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+            { publishPromise.set_value(errorCode); }));
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, publishPromise.get_future().get());
+        ASSERT_UINT_EQUALS(1, receivedBy.get_future().get());
+
+        ASSERT_TRUE(fleet->GetClientMemoryUsage(3) > 0);
+        ASSERT_UINT_EQUALS(0, fleet->GetOperationStatistics(3).incompleteOperationCount);
+
+        ASSERT_TRUE(fleet->Stop());
+        allStopped.get_future().get();
+        fleet = nullptr;
+
+        broker.Stop();
+        ASSERT_UINT_EQUALS(clientCount, broker.GetStatistics().connections);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5ClientFleetLoopbackRoundTrip, s_TestMqtt5ClientFleetLoopbackRoundTrip)
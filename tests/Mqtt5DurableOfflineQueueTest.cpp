@@ -0,0 +1,412 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/UUID.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <aws/common/file.h>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+using namespace Aws::Crt;
+
+/*
+ * A segment file path of its own for each test, removed when it goes out of scope
+ */
+class ScopedSegmentFile
+{
+  public:
+    ScopedSegmentFile() : m_path(String("mqtt5_durable_offline_queue_") + UUID().ToString() + ".segment") {}
+
+    ~ScopedSegmentFile() { remove(m_path.c_str()); }
+
+    const char *GetPath() const { return m_path.c_str(); }
+
+  private:
+    String m_path;
+};
+
+/*
+ * Subscribes to durable/+/data through the broker and collects the payloads it receives, in order
+ */
+class DurableQueueSubscriber
+{
+  public:
+    DurableQueueSubscriber(uint32_t port, size_t expected, Allocator *allocator) : m_expected(expected)
+    {
+        m_client = MqttLoopbackBroker::NewMqtt5Client(
+            "durable-subscriber",
+            port,
+            m_connected,
+            m_stopped,
+            [this](const Mqtt5::PublishReceivedEventData &eventData)
+            {
+                const ByteCursor &payload = eventData.publishPacket->getPayload();
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_payloads.push_back(String(reinterpret_cast<const char *>(payload.ptr), payload.len));
+                if (m_payloads.size() == m_expected)
+                {
+                    m_received.set_value();
+                }
+            },
+            allocator);
+
+        if (m_client && m_client->Start())
+        {
+            m_connected.get_future().get();
+
+            std::promise<int> subscribed;
+            auto subscribePacket = MakeShared<Mqtt5::SubscribePacket>(allocator, allocator);
+            subscribePacket->WithSubscription(
+                Mqtt5::Subscription("durable/+/data", Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator));
+            if (m_client->Subscribe(
+                    subscribePacket,
+                    [&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+                    { subscribed.set_value(errorCode); }))
+            {
+                m_subscribed = subscribed.get_future().get() == AWS_ERROR_SUCCESS;
+            }
+        }
+    }
+
+    ~DurableQueueSubscriber()
+    {
+        if (m_client && m_client->Stop())
+        {
+            m_stopped.get_future().get();
+        }
+    }
+
+    bool IsSubscribed() const { return m_subscribed; }
+
+    Vector<String> WaitForPayloads()
+    {
+        m_received.get_future().get();
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_payloads;
+    }
+
+  private:
+    size_t m_expected;
+    bool m_subscribed = false;
+    std::promise<void> m_connected;
+    std::promise<void> m_stopped;
+    std::promise<void> m_received;
+    std::mutex m_lock;
+    Vector<String> m_payloads;
+    std::shared_ptr<Mqtt5::Mqtt5Client> m_client;
+};
+
+static std::shared_ptr<Mqtt5::Mqtt5Client> s_NewDurablePublisher(
+    const ScopedSegmentFile &segmentFile,
+    uint32_t port,
+    std::promise<void> &connected,
+    std::promise<void> &stopped,
+    Allocator *allocator,
+    const Mqtt5::PublishRateLimitOptions *rateLimitOptions = nullptr)
+{
+    Mqtt5::DurableOfflineQueueOptions queueOptions;
+    queueOptions.m_segmentFilePath = segmentFile.GetPath();
+    queueOptions.m_memoryWatermarkBytes = 64;
+
+    return MqttLoopbackBroker::NewMqtt5Client(
+        "durable-publisher",
+        port,
+        connected,
+        stopped,
+        nullptr,
+        allocator,
+        [&queueOptions, rateLimitOptions](Mqtt5::Mqtt5ClientOptions &options)
+        {
+            options.WithDurableOfflineQueue(queueOptions);
+            if (rateLimitOptions != nullptr)
+            {
+                options.WithPublishRateLimit(*rateLimitOptions);
+            }
+        });
+}
+
+static bool s_PublishMessage(
+    Mqtt5::Mqtt5Client &client,
+    size_t index,
+    Mqtt5::OnPublishCompletionHandler onCompletion,
+    const char *topic = "durable/1/data")
+{
+    String payload = String("message-") + std::to_string(index).c_str();
+    auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+        ApiAllocator(),
+        topic,
+        ByteCursorFromCString(payload.c_str()),
+        Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+        ApiAllocator());
+    return client.Publish(publishPacket, std::move(onCompletion));
+}
+
+static int64_t s_SegmentFileLength(const ScopedSegmentFile &segmentFile)
+{
+    int64_t length = -1;
+    FILE *file = aws_fopen(segmentFile.GetPath(), "rb");
+    if (file != nullptr)
+    {
+        aws_file_get_length(file, &length);
+        fclose(file);
+    }
+    return length;
+}
+
+/* The committed offset in the header of the segment file */
+static uint64_t s_SegmentCommittedOffset(const ScopedSegmentFile &segmentFile)
+{
+    uint64_t committedOffset = 0;
+    FILE *file = aws_fopen(segmentFile.GetPath(), "rb");
+    if (file != nullptr)
+    {
+        if (aws_fseek(file, 8, SEEK_SET) != AWS_OP_SUCCESS ||
+            fread(&committedOffset, sizeof(committedOffset), 1, file) != 1)
+        {
+            committedOffset = 0;
+        }
+        fclose(file);
+    }
+    return committedOffset;
+}
+
+static int s_TestMqtt5DurableOfflineQueueSpillAndReplay(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+        ScopedSegmentFile segmentFile;
+
+        const size_t messageCount = 16;
+        DurableQueueSubscriber subscriber(broker.GetPort(), messageCount, allocator);
+        ASSERT_TRUE(subscriber.IsSubscribed());
+
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        auto publisher = s_NewDurablePublisher(segmentFile, broker.GetPort(), connected, stopped, allocator);
+        ASSERT_TRUE(publisher);
+
+        /* Not started yet: every publish goes to the segment file */
+        std::mutex completionLock;
+        Vector<size_t> completions;
+        std::promise<void> allCompleted;
+        for (size_t i = 0; i < messageCount; ++i)
+        {
+            ASSERT_TRUE(s_PublishMessage(
+                *publisher,
+                i,
+                [i, messageCount, &completionLock, &completions, &allCompleted](
+                    int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+                {
+                    std::lock_guard<std::mutex> lock(completionLock);
+                    completions.push_back(errorCode == AWS_ERROR_SUCCESS ? i : messageCount);
+                    if (completions.size() == messageCount)
+                    {
+                        allCompleted.set_value();
+                    }
+                }));
+        }
+        ASSERT_TRUE(s_SegmentFileLength(segmentFile) > 16);
+        ASSERT_UINT_EQUALS(0, publisher->GetMetrics().incompleteOperationCount);
+
+        /* The watermark only lets a few publishes at a time out of the file once connected */
+        ASSERT_TRUE(publisher->Start());
+        connected.get_future().get();
+        allCompleted.get_future().get();
+
+        Vector<String> payloads = subscriber.WaitForPayloads();
+        ASSERT_UINT_EQUALS(messageCount, payloads.size());
+        for (size_t i = 0; i < messageCount; ++i)
+        {
+            ASSERT_UINT_EQUALS(i, completions[i]);
+            ASSERT_TRUE(payloads[i] == String("message-") + std::to_string(i).c_str());
+        }
+
+        /* Truncated back to its header once everything completed */
+        ASSERT_INT_EQUALS(16, s_SegmentFileLength(segmentFile));
+
+        ASSERT_TRUE(publisher->Stop());
+        stopped.get_future().get();
+        publisher = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5DurableOfflineQueueSpillAndReplay, s_TestMqtt5DurableOfflineQueueSpillAndReplay)
+
+static int s_TestMqtt5DurableOfflineQueueRecovery(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+        ScopedSegmentFile segmentFile;
+
+        const size_t messageCount = 4;
+        {
+            /* Spills and goes away without ever connecting, as a process restarting while offline */
+            std::promise<void> connected;
+            std::promise<void> stopped;
+            auto publisher = s_NewDurablePublisher(segmentFile, broker.GetPort(), connected, stopped, allocator);
+            ASSERT_TRUE(publisher);
+            for (size_t i = 0; i < messageCount; ++i)
+            {
+                ASSERT_TRUE(s_PublishMessage(*publisher, i, nullptr));
+            }
+        }
+
+        DurableQueueSubscriber subscriber(broker.GetPort(), messageCount, allocator);
+        ASSERT_TRUE(subscriber.IsSubscribed());
+
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        auto publisher = s_NewDurablePublisher(segmentFile, broker.GetPort(), connected, stopped, allocator);
+        ASSERT_TRUE(publisher);
+        ASSERT_TRUE(publisher->Start());
+        connected.get_future().get();
+
+        Vector<String> payloads = subscriber.WaitForPayloads();
+        ASSERT_UINT_EQUALS(messageCount, payloads.size());
+        for (size_t i = 0; i < messageCount; ++i)
+        {
+            ASSERT_TRUE(payloads[i] == String("message-") + std::to_string(i).c_str());
+        }
+
+        ASSERT_TRUE(publisher->Stop());
+        stopped.get_future().get();
+        publisher = nullptr;
+
+        /* A file that is not a segment file is left alone */
+        FILE *file = aws_fopen(segmentFile.GetPath(), "wb");
+        ASSERT_NOT_NULL(file);
+        fputs("not a segment file, but long enough to have a header", file);
+        fclose(file);
+        std::promise<void> unusedConnected;
+        std::promise<void> unusedStopped;
+        ASSERT_NULL(
+            s_NewDurablePublisher(segmentFile, broker.GetPort(), unusedConnected, unusedStopped, allocator).get());
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5DurableOfflineQueueRecovery, s_TestMqtt5DurableOfflineQueueRecovery)
+
+static int s_TestMqtt5DurableOfflineQueueReplayFailure(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+        ScopedSegmentFile segmentFile;
+
+        std::atomic<size_t> completions(0);
+        {
+            std::promise<void> connected;
+            std::promise<void> stopped;
+            auto publisher = s_NewDurablePublisher(segmentFile, broker.GetPort(), connected, stopped, allocator);
+            ASSERT_TRUE(publisher);
+
+            /* Spilled without validation while offline, the native client refuses to publish to a wildcard */
+            auto onCompletion = [&completions](int, std::shared_ptr<Mqtt5::PublishResult>) { ++completions; };
+            ASSERT_TRUE(s_PublishMessage(*publisher, 0, onCompletion, "durable/#/data"));
+            ASSERT_TRUE(s_PublishMessage(*publisher, 1, onCompletion));
+            int64_t spilledLength = s_SegmentFileLength(segmentFile);
+            ASSERT_TRUE(spilledLength > 16);
+
+            /* The replay happens before the connection success callback, fails and stops there */
+            ASSERT_TRUE(publisher->Start());
+            connected.get_future().get();
+            ASSERT_UINT_EQUALS(0, completions.load());
+
+            ASSERT_TRUE(publisher->Stop());
+            stopped.get_future().get();
+            publisher = nullptr;
+
+            /* Both records are still there, uncommitted, for the next client */
+            ASSERT_INT_EQUALS(spilledLength, s_SegmentFileLength(segmentFile));
+            ASSERT_UINT_EQUALS(16, s_SegmentCommittedOffset(segmentFile));
+        }
+        ASSERT_UINT_EQUALS(0, completions.load());
+
+        /* A replay held back by the rate limiter, which fails once the limiter submits it, stays uncommitted too */
+        ScopedSegmentFile limitedSegmentFile;
+        Mqtt5::PublishRateLimitOptions rateLimitOptions;
+        rateLimitOptions.m_qos1.m_messagesPerSecond = 1;
+        {
+            std::promise<void> connected;
+            std::promise<void> stopped;
+            auto publisher = s_NewDurablePublisher(
+                limitedSegmentFile, broker.GetPort(), connected, stopped, allocator, &rateLimitOptions);
+            ASSERT_TRUE(publisher);
+
+            std::mutex resultLock;
+            Vector<int> results(3, AWS_ERROR_UNKNOWN);
+            std::promise<void> lastCompleted;
+            auto onCompletion = [&resultLock, &results, &lastCompleted](size_t index)
+            {
+                return [index, &resultLock, &results, &lastCompleted](
+                           int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+                {
+                    std::lock_guard<std::mutex> lock(resultLock);
+                    results[index] = errorCode;
+                    if (index == 2)
+                    {
+                        lastCompleted.set_value();
+                    }
+                };
+            };
+            ASSERT_TRUE(s_PublishMessage(*publisher, 0, onCompletion(0)));
+            ASSERT_TRUE(s_PublishMessage(*publisher, 1, onCompletion(1), "durable/#/data"));
+            ASSERT_TRUE(s_PublishMessage(*publisher, 2, onCompletion(2)));
+            int64_t spilledLength = s_SegmentFileLength(limitedSegmentFile);
+
+            /* The first replay takes the only token, the others wait a second each in the limiter */
+            ASSERT_TRUE(publisher->Start());
+            connected.get_future().get();
+            lastCompleted.get_future().get();
+            {
+                std::lock_guard<std::mutex> lock(resultLock);
+                ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, results[0]);
+                ASSERT_TRUE(results[1] != AWS_ERROR_SUCCESS);
+                ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, results[2]);
+            }
+
+            ASSERT_TRUE(publisher->Stop());
+            stopped.get_future().get();
+            publisher = nullptr;
+
+            /* Committed up to the failed record: header (16), record header (8), body header (4), topic, payload */
+            ASSERT_INT_EQUALS(spilledLength, s_SegmentFileLength(limitedSegmentFile));
+            ASSERT_UINT_EQUALS(
+                16 + 8 + 4 + strlen("durable/1/data") + strlen("message-0"),
+                s_SegmentCommittedOffset(limitedSegmentFile));
+        }
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5DurableOfflineQueueReplayFailure, s_TestMqtt5DurableOfflineQueueReplayFailure)
@@ -0,0 +1,272 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <functional>
+#include <future>
+
+using namespace Aws::Crt;
+
+/* Telemetry-like JSON, repetitive as real readings are */
+static String s_TelemetryJson(size_t readings)
+{
+    String json = "{\"deviceId\":\"sensor-0042\",\"readings\":[";
+    for (size_t i = 0; i < readings; ++i)
+    {
+        json += i > 0 ? "," : "";
+        json += "{\"ts\":17000000";
+        json += std::to_string(i).c_str();
+        json += ",\"temperature\":21.5,\"humidity\":40.2,\"status\":\"ok\"}";
+    }
+    json += "]}";
+    return json;
+}
+
+/* Adds payload compression to the options of a MqttLoopbackBroker client */
+static std::function<void(Mqtt5::Mqtt5ClientOptions &)> s_WithCompression(
+    const Mqtt5::PayloadCompressionOptions &compressionOptions)
+{
+    return [&compressionOptions](Mqtt5::Mqtt5ClientOptions &options)
+    { options.WithPayloadCompression(compressionOptions); };
+}
+
+static bool s_Subscribe(Mqtt5::Mqtt5Client &client, Allocator *allocator)
+{
+    std::promise<int> subscribed;
+    auto subscribePacket = MakeShared<Mqtt5::SubscribePacket>(allocator, allocator);
+    subscribePacket->WithSubscription(
+        Mqtt5::Subscription("telemetry/#", Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator));
+    return client.Subscribe(
+               subscribePacket,
+               [&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+               { subscribed.set_value(errorCode); }) &&
+           subscribed.get_future().get() == AWS_ERROR_SUCCESS;
+}
+
+static const Mqtt5::UserProperty *s_FindContentEncoding(const Mqtt5::PublishPacket &packet)
+{
+    for (const Mqtt5::UserProperty &property : packet.getUserProperties())
+    {
+        if (property.getName() == "content-encoding")
+        {
+            return &property;
+        }
+    }
+    return nullptr;
+}
+
+static int s_TestMqtt5PayloadCompressionRoundTrip(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        ASSERT_TRUE(StreamCodec::IsSupported(CompressionAlgorithm::Deflate));
+
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        /* Sees the publishes as they travel */
+        std::promise<void> observerConnected;
+        std::promise<void> observerStopped;
+        std::promise<std::shared_ptr<Mqtt5::PublishPacket>> observedLarge;
+        auto observer = MqttLoopbackBroker::NewMqtt5Client(
+            "compression-observer",
+            broker.GetPort(),
+            observerConnected,
+            observerStopped,
+            [&observedLarge](const Mqtt5::PublishReceivedEventData &eventData)
+            {
+                if (eventData.publishPacket->getTopic() == "telemetry/large")
+                {
+                    observedLarge.set_value(eventData.publishPacket);
+                }
+            },
+            allocator);
+        ASSERT_TRUE(observer);
+        ASSERT_TRUE(observer->Start());
+        observerConnected.get_future().get();
+        ASSERT_TRUE(s_Subscribe(*observer, allocator));
+
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        std::promise<std::shared_ptr<Mqtt5::PublishPacket>> receivedLarge;
+        std::promise<std::shared_ptr<Mqtt5::PublishPacket>> receivedSmall;
+        Mqtt5::PayloadCompressionOptions compressionOptions;
+        compressionOptions.m_thresholdBytes = 128;
+        auto client = MqttLoopbackBroker::NewMqtt5Client(
+            "compression-client",
+            broker.GetPort(),
+            connected,
+            stopped,
+            [&receivedLarge, &receivedSmall](const Mqtt5::PublishReceivedEventData &eventData)
+            {
+                auto &received = eventData.publishPacket->getTopic() == "telemetry/large" ? receivedLarge
+                                                                                           : receivedSmall;
+                received.set_value(eventData.publishPacket);
+            },
+            allocator,
+            s_WithCompression(compressionOptions));
+        ASSERT_TRUE(client);
+        ASSERT_TRUE(client->Start());
+        connected.get_future().get();
+        ASSERT_TRUE(s_Subscribe(*client, allocator));
+
+        String json = s_TelemetryJson(64);
+        String smallJson = s_TelemetryJson(1);
+        ASSERT_TRUE(smallJson.size() < 128);
+        const char *topics[] = {"telemetry/large", "telemetry/small"};
+        const String *payloads[] = {&json, &smallJson};
+        for (size_t i = 0; i < 2; ++i)
+        {
+            std::promise<int> published;
+            auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+                allocator,
+                topics[i],
+                ByteCursorFromString(*payloads[i]),
+                Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+                allocator);
+            publishPacket->WithPayloadFormatIndicator(Mqtt5::PayloadFormatIndicator::AWS_MQTT5_PFI_UTF8);
+            ASSERT_TRUE(client->Publish(
+                publishPacket,
+                [&published](int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+                { published.set_value(errorCode); }));
+            ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, published.get_future().get());
+        }
+
+        /* Compressed and marked on the way */
+        auto observed = observedLarge.get_future().get();
+        const Mqtt5::UserProperty *encoding = s_FindContentEncoding(*observed);
+        ASSERT_NOT_NULL(encoding);
+        ASSERT_TRUE(encoding->getValue() == "deflate");
+        ASSERT_TRUE(observed->getPayload().len < json.size() / 4);
+
+        /* Transparent to the compressing client */
+        auto large = receivedLarge.get_future().get();
+        ASSERT_NULL(s_FindContentEncoding(*large));
+        ASSERT_BIN_ARRAYS_EQUALS(json.data(), json.size(), large->getPayload().ptr, large->getPayload().len);
+
+        auto small = receivedSmall.get_future().get();
+        ASSERT_NULL(s_FindContentEncoding(*small));
+        ASSERT_BIN_ARRAYS_EQUALS(
+            smallJson.data(), smallJson.size(), small->getPayload().ptr, small->getPayload().len);
+
+        ASSERT_TRUE(client->GetMetrics().publishBytesSent < json.size());
+
+        ASSERT_TRUE(client->Stop());
+        stopped.get_future().get();
+        ASSERT_TRUE(observer->Stop());
+        observerStopped.get_future().get();
+        client = nullptr;
+        observer = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5PayloadCompressionRoundTrip, s_TestMqtt5PayloadCompressionRoundTrip)
+
+static int s_TestMqtt5PayloadCompressionDecompressedLimit(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        ASSERT_TRUE(StreamCodec::IsSupported(CompressionAlgorithm::Deflate));
+
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        /* Accepts nothing decompressing to more than 1 KiB */
+        std::promise<void> receiverConnected;
+        std::promise<void> receiverStopped;
+        std::promise<std::shared_ptr<Mqtt5::PublishPacket>> firstReceived;
+        bool receivedAny = false;
+        Mqtt5::PayloadCompressionOptions receiverCompressionOptions;
+        receiverCompressionOptions.m_maxDecompressedBytes = 1024;
+        auto receiver = MqttLoopbackBroker::NewMqtt5Client(
+            "compression-receiver",
+            broker.GetPort(),
+            receiverConnected,
+            receiverStopped,
+            [&firstReceived, &receivedAny](const Mqtt5::PublishReceivedEventData &eventData)
+            {
+                if (!receivedAny)
+                {
+                    receivedAny = true;
+                    firstReceived.set_value(eventData.publishPacket);
+                }
+            },
+            allocator,
+            s_WithCompression(receiverCompressionOptions));
+        ASSERT_TRUE(receiver);
+        ASSERT_TRUE(receiver->Start());
+        receiverConnected.get_future().get();
+        ASSERT_TRUE(s_Subscribe(*receiver, allocator));
+
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        Mqtt5::PayloadCompressionOptions compressionOptions;
+        compressionOptions.m_thresholdBytes = 128;
+        auto sender = MqttLoopbackBroker::NewMqtt5Client(
+            "compression-sender",
+            broker.GetPort(),
+            connected,
+            stopped,
+            [](const Mqtt5::PublishReceivedEventData &) {},
+            allocator,
+            s_WithCompression(compressionOptions));
+        ASSERT_TRUE(sender);
+        ASSERT_TRUE(sender->Start());
+        connected.get_future().get();
+
+        /* Small on the wire, too large once decompressed, then one within the limit */
+        String json = s_TelemetryJson(64);
+        String smallJson = s_TelemetryJson(1);
+        ASSERT_TRUE(json.size() > 1024);
+        const char *topics[] = {"telemetry/large", "telemetry/small"};
+        const String *payloads[] = {&json, &smallJson};
+        for (size_t i = 0; i < 2; ++i)
+        {
+            std::promise<int> published;
+            auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+                allocator,
+                topics[i],
+                ByteCursorFromString(*payloads[i]),
+                Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+                allocator);
+            ASSERT_TRUE(sender->Publish(
+                publishPacket,
+                [&published](int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+                { published.set_value(errorCode); }));
+            ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, published.get_future().get());
+        }
+
+        /* The broker forwards them in order, so the first delivered being the small one means the large was dropped */
+        auto received = firstReceived.get_future().get();
+        ASSERT_TRUE(received->getTopic() == "telemetry/small");
+        ASSERT_BIN_ARRAYS_EQUALS(
+            smallJson.data(), smallJson.size(), received->getPayload().ptr, received->getPayload().len);
+        ASSERT_UINT_EQUALS(2, receiver->GetMetrics().publishesReceivedQos1);
+
+        ASSERT_TRUE(sender->Stop());
+        stopped.get_future().get();
+        ASSERT_TRUE(receiver->Stop());
+        receiverStopped.get_future().get();
+        sender = nullptr;
+        receiver = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5PayloadCompressionDecompressedLimit, s_TestMqtt5PayloadCompressionDecompressedLimit)
@@ -0,0 +1,65 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/testing/aws_test_harness.h>
+
+using namespace Aws::Crt;
+
+static int s_TestMqtt5PublishPayloadOwnership(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+
+        /* A moved in buffer is sent as it is and freed with the packet */
+        ByteBuf frame;
+        ASSERT_SUCCESS(aws_byte_buf_init(&frame, allocator, 1024 * 1024));
+        aws_byte_buf_write_u8_n(&frame, 0x5a, frame.capacity);
+        const uint8_t *frameBytes = frame.buffer;
+        {
+            Mqtt5::PublishPacket packet(allocator);
+            packet.WithTopic("camera/frames").WithPayload(std::move(frame));
+            ASSERT_NULL(frame.buffer);
+            ASSERT_UINT_EQUALS(0, frame.len);
+
+            aws_mqtt5_packet_publish_view view;
+            ASSERT_TRUE(packet.initializeRawOptions(view));
+            ASSERT_PTR_EQUALS(frameBytes, view.payload.ptr);
+            ASSERT_UINT_EQUALS(1024 * 1024, view.payload.len);
+        }
+
+        /* A shared buffer is referenced until the packet lets go of it */
+        static const char chunk[] = "firmware-chunk-0001";
+        bool released = false;
+        std::shared_ptr<const void> owner(chunk, [&released](const void *) { released = true; });
+        {
+            Mqtt5::PublishPacket packet(allocator);
+            packet.WithTopic("firmware/chunks").WithPayload(ByteCursorFromCString(chunk), owner);
+            owner = nullptr;
+            ASSERT_FALSE(released);
+
+            aws_mqtt5_packet_publish_view view;
+            ASSERT_TRUE(packet.initializeRawOptions(view));
+            ASSERT_PTR_EQUALS(chunk, view.payload.ptr);
+
+            /* Copied from here on */
+            packet.WithPayload(ByteCursorFromCString("last"));
+            ASSERT_TRUE(released);
+            ASSERT_TRUE(packet.getPayload().ptr != (const uint8_t *)chunk);
+        }
+
+        released = false;
+        owner = std::shared_ptr<const void>(chunk, [&released](const void *) { released = true; });
+        {
+            Mqtt5::PublishPacket packet(allocator);
+            packet.WithPayload(ByteCursorFromCString(chunk), std::move(owner));
+        }
+        ASSERT_TRUE(released);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5PublishPayloadOwnership, s_TestMqtt5PublishPayloadOwnership)
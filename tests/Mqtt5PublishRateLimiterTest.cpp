@@ -0,0 +1,181 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <aws/common/clock.h>
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+
+using namespace Aws::Crt;
+
+static uint64_t s_Now()
+{
+    uint64_t now = 0;
+    aws_high_res_clock_get_ticks(&now);
+    return now;
+}
+
+static int s_TestMqtt5PublishRateLimit(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        /* One second worth of burst, then 20 publishes a second */
+        const size_t messagesPerSecond = 20;
+        Mqtt5::PublishRateLimitOptions rateLimitOptions;
+        rateLimitOptions.m_qos1.m_messagesPerSecond = messagesPerSecond;
+
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        auto client = MqttLoopbackBroker::NewMqtt5Client(
+            "rate-limited-publisher",
+            broker.GetPort(),
+            connected,
+            stopped,
+            nullptr,
+            allocator,
+            [&rateLimitOptions](Mqtt5::Mqtt5ClientOptions &options)
+            { options.WithPublishRateLimit(rateLimitOptions); });
+        ASSERT_TRUE(client);
+        ASSERT_TRUE(client->Start());
+        connected.get_future().get();
+
+        const size_t messageCount = messagesPerSecond * 2;
+        std::mutex completionLock;
+        Vector<size_t> completions;
+        std::promise<void> allCompleted;
+        uint64_t startNs = s_Now();
+        for (size_t i = 0; i < messageCount; ++i)
+        {
+            auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+                allocator,
+                "rate/limited/data",
+                ByteCursorFromCString("reading"),
+                Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+                allocator);
+            ASSERT_TRUE(client->Publish(
+                publishPacket,
+                [i, messageCount, &completionLock, &completions, &allCompleted](
+                    int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+                {
+                    std::lock_guard<std::mutex> lock(completionLock);
+                    completions.push_back(errorCode == AWS_ERROR_SUCCESS ? i : messageCount);
+                    if (completions.size() == messageCount)
+                    {
+                        allCompleted.set_value();
+                    }
+                }));
+        }
+        allCompleted.get_future().get();
+        uint64_t elapsedNs = s_Now() - startNs;
+
+        /* The second half waits for the bucket to refill, about a second, and keeps its order */
+        ASSERT_TRUE(elapsedNs >= AWS_TIMESTAMP_NANOS * 9 / 10);
+        for (size_t i = 0; i < messageCount; ++i)
+        {
+            ASSERT_UINT_EQUALS(i, completions[i]);
+        }
+
+        Mqtt5::Mqtt5ClientMetrics metrics = client->GetMetrics();
+        ASSERT_TRUE(metrics.publishesRateLimited >= messagesPerSecond / 2);
+        ASSERT_TRUE(metrics.publishesRateLimited < messageCount);
+        ASSERT_TRUE(metrics.rateLimitDelayNanos > 0);
+
+        /* Held back, not dropped */
+        ASSERT_UINT_EQUALS(messageCount, metrics.publishesSentQos1);
+
+        ASSERT_TRUE(client->Stop());
+        stopped.get_future().get();
+        client = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5PublishRateLimit, s_TestMqtt5PublishRateLimit)
+
+static int s_TestMqtt5PublishRateLimiterClose(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        /* One publish a second: the first goes out, the others wait for the bucket to refill */
+        Mqtt5::PublishRateLimitOptions rateLimitOptions;
+        rateLimitOptions.m_qos1.m_messagesPerSecond = 1;
+
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        auto client = MqttLoopbackBroker::NewMqtt5Client(
+            "rate-limited-closer",
+            broker.GetPort(),
+            connected,
+            stopped,
+            nullptr,
+            allocator,
+            [&rateLimitOptions](Mqtt5::Mqtt5ClientOptions &options)
+            { options.WithPublishRateLimit(rateLimitOptions); });
+        ASSERT_TRUE(client);
+        ASSERT_TRUE(client->Start());
+        connected.get_future().get();
+
+        const size_t publishCount = 4;
+        std::mutex completionLock;
+        Vector<size_t> completions;
+        std::promise<void> firstCompleted;
+        for (size_t i = 0; i < publishCount; ++i)
+        {
+            auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+                allocator,
+                "rate/limited/data",
+                ByteCursorFromCString("reading"),
+                Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+                allocator);
+            ASSERT_TRUE(client->Publish(
+                publishPacket,
+                [i, &completionLock, &completions, &firstCompleted](int, std::shared_ptr<Mqtt5::PublishResult>)
+                {
+                    std::lock_guard<std::mutex> lock(completionLock);
+                    completions.push_back(i);
+                    if (i == 0)
+                    {
+                        firstCompleted.set_value();
+                    }
+                }));
+        }
+        firstCompleted.get_future().get();
+        ASSERT_UINT_EQUALS(publishCount - 1, client->GetMetrics().publishesRateLimited);
+
+        /* Destroying the client drops the queued publishes, without a callback once its destructor runs */
+        client = nullptr;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        {
+            std::lock_guard<std::mutex> lock(completionLock);
+            ASSERT_UINT_EQUALS(1, completions.size());
+            ASSERT_UINT_EQUALS(0, completions[0]);
+        }
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5PublishRateLimiterClose, s_TestMqtt5PublishRateLimiterClose)
@@ -0,0 +1,158 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <mutex>
+
+using namespace Aws::Crt;
+
+static std::shared_ptr<const Mqtt5::PublishTemplate> s_NewTelemetryTemplate(Allocator *allocator)
+{
+    Vector<Mqtt5::UserProperty> tracingHeaders;
+    tracingHeaders.push_back(Mqtt5::UserProperty("traceparent", "00-4bf92f3577b34da6a3ce929d0e0e4736-01"));
+    auto list = Mqtt5::UserPropertyList::NewUserPropertyList(tracingHeaders, allocator);
+
+    Mqtt5::PublishPacket fields(
+        "telemetry/sensor-0042", ByteCursor(), Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator);
+    fields.WithContentType(ByteCursorFromCString("application/json"))
+        .WithPayloadFormatIndicator(Mqtt5::PayloadFormatIndicator::AWS_MQTT5_PFI_UTF8)
+        .WithUserPropertyList(list)
+        .WithUserProperty(Mqtt5::UserProperty("device", "sensor-0042"));
+    return Mqtt5::PublishTemplate::NewPublishTemplate(fields, allocator);
+}
+
+static int s_TestMqtt5PublishTemplateView(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+
+        auto publishTemplate = s_NewTelemetryTemplate(allocator);
+        ASSERT_NOT_NULL(publishTemplate.get());
+        ASSERT_TRUE(publishTemplate->getTopic() == "telemetry/sensor-0042");
+        ASSERT_INT_EQUALS(Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, publishTemplate->getQOS());
+
+        /* Every publish points at the same encoded fields, only the payload differs */
+        aws_mqtt5_packet_publish_view first;
+        aws_mqtt5_packet_publish_view second;
+        publishTemplate->initializeRawOptions(first, ByteCursorFromCString("{\"t\":21.5}"));
+        publishTemplate->initializeRawOptions(second, ByteCursorFromCString("{\"t\":21.7}"));
+        ASSERT_PTR_EQUALS(first.topic.ptr, second.topic.ptr);
+        ASSERT_PTR_EQUALS(first.user_properties, second.user_properties);
+        ASSERT_PTR_EQUALS(first.content_type, second.content_type);
+        ASSERT_FALSE(aws_byte_cursor_eq(&first.payload, &second.payload));
+
+        ASSERT_NOT_NULL(first.content_type);
+        ASSERT_CURSOR_VALUE_CSTRING_EQUALS(*first.content_type, "application/json");
+        ASSERT_NOT_NULL(first.payload_format);
+        ASSERT_INT_EQUALS(AWS_MQTT5_PFI_UTF8, *first.payload_format);
+
+        /* Shared properties first, then the ones of the packet */
+        ASSERT_UINT_EQUALS(2, first.user_property_count);
+        ASSERT_CURSOR_VALUE_CSTRING_EQUALS(first.user_properties[0].name, "traceparent");
+        ASSERT_CURSOR_VALUE_CSTRING_EQUALS(first.user_properties[1].value, "sensor-0042");
+
+        /* A packet with the content type sends it too */
+        Mqtt5::PublishPacket packet(
+            "telemetry/sensor-0042", ByteCursor(), Mqtt5::QOS::AWS_MQTT5_QOS_AT_MOST_ONCE, allocator);
+        packet.WithContentType(ByteCursorFromCString("text/plain"));
+        aws_mqtt5_packet_publish_view view;
+        ASSERT_TRUE(packet.initializeRawOptions(view));
+        ASSERT_NOT_NULL(view.content_type);
+        ASSERT_CURSOR_VALUE_CSTRING_EQUALS(*view.content_type, "text/plain");
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5PublishTemplateView, s_TestMqtt5PublishTemplateView)
+
+static int s_TestMqtt5PublishTemplateRoundTrip(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        const size_t messageCount = 8;
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        std::mutex receivedLock;
+        Vector<std::shared_ptr<Mqtt5::PublishPacket>> received;
+        std::promise<void> allReceived;
+        auto client = MqttLoopbackBroker::NewMqtt5Client(
+            "template-publisher",
+            broker.GetPort(),
+            connected,
+            stopped,
+            [&](const Mqtt5::PublishReceivedEventData &eventData)
+            {
+                std::lock_guard<std::mutex> lock(receivedLock);
+                received.push_back(eventData.publishPacket);
+                if (received.size() == messageCount)
+                {
+                    allReceived.set_value();
+                }
+            },
+            allocator);
+        ASSERT_TRUE(client);
+        ASSERT_TRUE(client->Start());
+        connected.get_future().get();
+
+        std::promise<int> subscribed;
+        auto subscribePacket = MakeShared<Mqtt5::SubscribePacket>(allocator, allocator);
+        subscribePacket->WithSubscription(
+            Mqtt5::Subscription("telemetry/#", Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator));
+        ASSERT_TRUE(client->Subscribe(
+            subscribePacket,
+            [&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>) { subscribed.set_value(errorCode); }));
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subscribed.get_future().get());
+
+        auto publishTemplate = s_NewTelemetryTemplate(allocator);
+        ASSERT_NOT_NULL(publishTemplate.get());
+
+        /* One buffer for every payload: it may be reused as soon as Publish() returns */
+        char payload[32];
+        for (size_t i = 0; i < messageCount; ++i)
+        {
+            int length = snprintf(payload, sizeof(payload), "{\"sequence\":%zu}", i);
+            ASSERT_TRUE(client->Publish(
+                publishTemplate, aws_byte_cursor_from_array(payload, static_cast<size_t>(length))));
+        }
+        allReceived.get_future().get();
+
+        for (size_t i = 0; i < messageCount; ++i)
+        {
+            const Mqtt5::PublishPacket &packet = *received[i];
+            ASSERT_TRUE(packet.getTopic() == "telemetry/sensor-0042");
+            ASSERT_TRUE(packet.getContentType().has_value());
+            ASSERT_CURSOR_VALUE_CSTRING_EQUALS(packet.getContentType().value(), "application/json");
+            ASSERT_UINT_EQUALS(2, packet.getUserProperties().size());
+            ASSERT_TRUE(packet.getUserProperties()[0].getName() == "traceparent");
+            ASSERT_TRUE(packet.getUserProperties()[1].getValue() == "sensor-0042");
+
+            snprintf(payload, sizeof(payload), "{\"sequence\":%zu}", i);
+            ASSERT_BIN_ARRAYS_EQUALS(payload, strlen(payload), packet.getPayload().ptr, packet.getPayload().len);
+        }
+
+        ASSERT_TRUE(client->Stop());
+        stopped.get_future().get();
+        client = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5PublishTemplateRoundTrip, s_TestMqtt5PublishTemplateRoundTrip)
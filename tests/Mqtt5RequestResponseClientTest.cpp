@@ -0,0 +1,199 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/crt/mqtt/Mqtt5RequestResponseClient.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
+using namespace Aws::Crt;
+
+struct RequestResponseOutcome
+{
+    int errorCode;
+    String payload;
+};
+
+static int s_TestMqtt5RequestResponseClient(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        /* Echoes every request on rpc/echo to its response topic, with its correlation data */
+        std::shared_ptr<Mqtt5::Mqtt5Client> responder;
+        std::promise<void> responderConnected;
+        std::promise<void> responderStopped;
+        responder = MqttLoopbackBroker::NewMqtt5Client(
+            "rpc-responder",
+            broker.GetPort(),
+            responderConnected,
+            responderStopped,
+            MqttLoopbackBroker::EchoResponder(responder, allocator),
+            allocator);
+        ASSERT_TRUE(responder);
+        ASSERT_TRUE(responder->Start());
+        responderConnected.get_future().get();
+        {
+            std::promise<int> subscribed;
+            auto subscribePacket = MakeShared<Mqtt5::SubscribePacket>(allocator, allocator);
+            subscribePacket->WithSubscription(
+                Mqtt5::Subscription("rpc/echo", Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator));
+            ASSERT_TRUE(responder->Subscribe(
+                subscribePacket,
+                [&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+                { subscribed.set_value(errorCode); }));
+            ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subscribed.get_future().get());
+        }
+
+        std::shared_ptr<Mqtt5::RequestResponseClient> requestResponse;
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        auto client = MqttLoopbackBroker::NewMqtt5Client(
+            "rpc-requester",
+            broker.GetPort(),
+            connected,
+            stopped,
+            [&requestResponse](const Mqtt5::PublishReceivedEventData &eventData)
+            { requestResponse->OnPublishReceived(eventData); },
+            allocator);
+        ASSERT_TRUE(client);
+
+        Mqtt5::RequestResponseClientOptions options(allocator);
+        options.WithResponseTopic("rpc/responses/rpc-requester")
+            .WithRequestTimeoutMs(300)
+            .WithTimeoutResolutionMs(50)
+            .WithMaxInFlightRequests(4);
+        requestResponse = Mqtt5::RequestResponseClient::NewRequestResponseClient(client, options, allocator);
+        ASSERT_NOT_NULL(requestResponse.get());
+        ASSERT_TRUE(client->Start());
+        connected.get_future().get();
+
+        std::promise<int> subscribed;
+        ASSERT_TRUE(requestResponse->Subscribe([&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+                                               { subscribed.set_value(errorCode); }));
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subscribed.get_future().get());
+
+        std::mutex outcomesLock;
+        std::condition_variable outcomesSignal;
+        Vector<RequestResponseOutcome> outcomes;
+        auto request = [&](const char *topic, const char *payload)
+        {
+            auto packet = MakeShared<Mqtt5::PublishPacket>(
+                allocator, topic, ByteCursorFromCString(payload), Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator);
+            return requestResponse->Request(
+                packet,
+                [&](int errorCode, std::shared_ptr<Mqtt5::PublishPacket> response)
+                {
+                    std::lock_guard<std::mutex> lock(outcomesLock);
+                    String responsePayload;
+                    if (response)
+                    {
+                        const ByteCursor &cursor = response->getPayload();
+                        responsePayload.assign((const char *)cursor.ptr, cursor.len);
+                    }
+                    outcomes.push_back({errorCode, responsePayload});
+                    outcomesSignal.notify_all();
+                });
+        };
+        auto waitForOutcomes = [&](size_t count)
+        {
+            std::unique_lock<std::mutex> lock(outcomesLock);
+            outcomesSignal.wait(lock, [&]() { return outcomes.size() >= count; });
+        };
+
+        /* Concurrent requests each get their own response */
+        ASSERT_TRUE(request("rpc/echo", "one"));
+        ASSERT_TRUE(request("rpc/echo", "two"));
+        ASSERT_TRUE(request("rpc/echo", "three"));
+        waitForOutcomes(3);
+        {
+            std::lock_guard<std::mutex> lock(outcomesLock);
+            size_t matched = 0;
+            for (const RequestResponseOutcome &outcome : outcomes)
+            {
+                ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, outcome.errorCode);
+                matched += outcome.payload == "one" || outcome.payload == "two" || outcome.payload == "three";
+            }
+            ASSERT_UINT_EQUALS(3, matched);
+        }
+        ASSERT_UINT_EQUALS(0, requestResponse->GetInFlightRequestCount());
+
+        /* Nobody answers rpc/nobody */
+        ASSERT_TRUE(request("rpc/nobody", "lost"));
+        waitForOutcomes(4);
+        {
+            std::lock_guard<std::mutex> lock(outcomesLock);
+            ASSERT_INT_EQUALS(AWS_ERROR_MQTT_TIMEOUT, outcomes[3].errorCode);
+            ASSERT_TRUE(outcomes[3].payload.empty());
+        }
+
+        /* Publishes on the response topic answering no request are counted, others left to the application */
+        Mqtt5::PublishReceivedEventData late;
+        late.publishPacket = MakeShared<Mqtt5::PublishPacket>(
+            allocator,
+            "rpc/responses/rpc-requester",
+            ByteCursorFromCString("late"),
+            Mqtt5::QOS::AWS_MQTT5_QOS_AT_MOST_ONCE,
+            allocator);
+        late.publishPacket->WithCorrelationData(ByteCursorFromCString("12345678"));
+        ASSERT_TRUE(requestResponse->OnPublishReceived(late));
+        Mqtt5::PublishReceivedEventData unrelated;
+        unrelated.publishPacket = MakeShared<Mqtt5::PublishPacket>(
+            allocator, "rpc/other", ByteCursorFromCString("{}"), Mqtt5::QOS::AWS_MQTT5_QOS_AT_MOST_ONCE, allocator);
+        ASSERT_FALSE(requestResponse->OnPublishReceived(unrelated));
+
+        /* Requests beyond the in-flight bound are refused, closing completes the outstanding ones */
+        for (int i = 0; i < 4; ++i)
+        {
+            ASSERT_TRUE(request("rpc/nobody", "pending"));
+        }
+        ASSERT_FALSE(request("rpc/nobody", "refused"));
+        ASSERT_INT_EQUALS(AWS_ERROR_MQTT_QUEUE_FULL, aws_last_error());
+        ASSERT_UINT_EQUALS(4, requestResponse->GetInFlightRequestCount());
+
+        requestResponse->Close();
+        waitForOutcomes(8);
+        {
+            std::lock_guard<std::mutex> lock(outcomesLock);
+            for (size_t i = 4; i < 8; ++i)
+            {
+                ASSERT_INT_EQUALS(AWS_ERROR_INVALID_STATE, outcomes[i].errorCode);
+            }
+        }
+        ASSERT_UINT_EQUALS(0, requestResponse->GetInFlightRequestCount());
+        ASSERT_FALSE(request("rpc/echo", "closed"));
+        ASSERT_INT_EQUALS(AWS_ERROR_INVALID_STATE, aws_last_error());
+
+        Mqtt5::RequestResponseClientMetrics metrics = requestResponse->GetMetrics();
+        ASSERT_UINT_EQUALS(8, metrics.requestsSent);
+        ASSERT_UINT_EQUALS(1, metrics.requestsRejected);
+        ASSERT_UINT_EQUALS(3, metrics.responsesMatched);
+        ASSERT_UINT_EQUALS(1, metrics.responsesUnmatched);
+        ASSERT_UINT_EQUALS(1, metrics.requestsTimedOut);
+
+        ASSERT_TRUE(client->Stop());
+        stopped.get_future().get();
+        ASSERT_TRUE(responder->Stop());
+        responderStopped.get_future().get();
+        requestResponse = nullptr;
+        client = nullptr;
+        responder = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5RequestResponseClient, s_TestMqtt5RequestResponseClient)
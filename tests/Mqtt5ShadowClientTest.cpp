@@ -0,0 +1,322 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/JsonObject.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/iot/Mqtt5ShadowClient.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
+using namespace Aws::Crt;
+
+static bool s_ServicePublish(Mqtt5::Mqtt5Client &service, const char *topic, const char *json, Allocator *allocator)
+{
+    std::promise<int> published;
+    auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+        allocator, topic, ByteCursorFromCString(json), Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator);
+    return service.Publish(
+               publishPacket,
+               [&published](int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+               { published.set_value(errorCode); }) &&
+           published.get_future().get() == AWS_ERROR_SUCCESS;
+}
+
+static int s_TestMqtt5ShadowClientDeltaAndCoalescing(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        /* Stands in for the shadow service */
+        std::mutex requestsLock;
+        std::condition_variable requestsSignal;
+        Vector<String> getRequests;
+        Vector<String> updateRequests;
+        std::promise<void> serviceConnected;
+        std::promise<void> serviceStopped;
+        auto service = MqttLoopbackBroker::NewMqtt5Client(
+            "shadow-service",
+            broker.GetPort(),
+            serviceConnected,
+            serviceStopped,
+            [&](const Mqtt5::PublishReceivedEventData &eventData)
+            {
+                const ByteCursor &payload = eventData.publishPacket->getPayload();
+                std::lock_guard<std::mutex> lock(requestsLock);
+                auto &requests =
+                    eventData.publishPacket->getTopic() == "$aws/things/thing-1/shadow/get" ? getRequests
+                                                                                           : updateRequests;
+                requests.push_back(String((const char *)payload.ptr, payload.len));
+                requestsSignal.notify_all();
+            },
+            allocator);
+        ASSERT_TRUE(service);
+        ASSERT_TRUE(service->Start());
+        serviceConnected.get_future().get();
+        {
+            std::promise<int> subscribed;
+            auto subscribePacket = MakeShared<Mqtt5::SubscribePacket>(allocator, allocator);
+            subscribePacket->WithSubscription(Mqtt5::Subscription(
+                "$aws/things/thing-1/shadow/get", Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator));
+            subscribePacket->WithSubscription(Mqtt5::Subscription(
+                "$aws/things/thing-1/shadow/update", Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator));
+            ASSERT_TRUE(service->Subscribe(
+                subscribePacket,
+                [&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+                { subscribed.set_value(errorCode); }));
+            ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subscribed.get_future().get());
+        }
+
+        std::mutex eventsLock;
+        std::condition_variable eventsSignal;
+        size_t documents = 0;
+        Vector<int64_t> deltaVersions;
+        Vector<int> rejectedCodes;
+        Vector<int> reportedPublishResults;
+        Aws::Iot::Mqtt5ShadowClientOptions shadowOptions(allocator);
+        shadowOptions.WithThingName("thing-1")
+            .WithReportedCoalescingDelayMs(200)
+            .WithDocumentCallback(
+                [&](const JsonView &, int64_t)
+                {
+                    std::lock_guard<std::mutex> lock(eventsLock);
+                    ++documents;
+                    eventsSignal.notify_all();
+                })
+            .WithDeltaCallback(
+                [&](const JsonView &, int64_t version)
+                {
+                    std::lock_guard<std::mutex> lock(eventsLock);
+                    deltaVersions.push_back(version);
+                    eventsSignal.notify_all();
+                })
+            .WithRejectedCallback(
+                [&](Aws::Iot::ShadowOperation operation, int code, const String &message)
+                {
+                    std::lock_guard<std::mutex> lock(eventsLock);
+                    rejectedCodes.push_back(
+                        operation == Aws::Iot::ShadowOperation::Update && message == "bad request" ? code : 0);
+                    eventsSignal.notify_all();
+                })
+            .WithReportedPublishedCallback(
+                [&](int errorCode)
+                {
+                    std::lock_guard<std::mutex> lock(eventsLock);
+                    reportedPublishResults.push_back(errorCode);
+                    eventsSignal.notify_all();
+                });
+        auto waitForEvents = [&](const std::function<bool()> &done)
+        {
+            std::unique_lock<std::mutex> lock(eventsLock);
+            eventsSignal.wait(lock, done);
+        };
+
+        std::shared_ptr<Aws::Iot::Mqtt5ShadowClient> shadow;
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        auto client = MqttLoopbackBroker::NewMqtt5Client(
+            "shadow-device",
+            broker.GetPort(),
+            connected,
+            stopped,
+            [&shadow](const Mqtt5::PublishReceivedEventData &eventData) { shadow->OnPublishReceived(eventData); },
+            allocator);
+        ASSERT_TRUE(client);
+        shadow = Aws::Iot::Mqtt5ShadowClient::NewMqtt5ShadowClient(client, shadowOptions, allocator);
+        ASSERT_NOT_NULL(shadow.get());
+        ASSERT_TRUE(client->Start());
+        connected.get_future().get();
+
+        std::promise<int> subscribed;
+        ASSERT_TRUE(shadow->Subscribe([&subscribed](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+                                      { subscribed.set_value(errorCode); }));
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subscribed.get_future().get());
+
+        /* The document replaces the local one */
+        ASSERT_TRUE(shadow->RequestDocument());
+        {
+            std::unique_lock<std::mutex> lock(requestsLock);
+            requestsSignal.wait(lock, [&]() { return getRequests.size() == 1; });
+            ASSERT_TRUE(getRequests[0] == "{}");
+        }
+        ASSERT_TRUE(s_ServicePublish(
+            *service,
+            "$aws/things/thing-1/shadow/get/accepted",
+            "{\"state\":{\"desired\":{\"color\":\"red\",\"level\":1},\"reported\":{\"color\":\"blue\"}},\"version\":3}",
+            allocator));
+        waitForEvents([&]() { return documents == 1; });
+        ASSERT_INT_EQUALS(3, shadow->GetVersion());
+        ASSERT_TRUE(shadow->GetDesired().View().GetString("color") == "red");
+        ASSERT_TRUE(shadow->GetReported().View().GetString("color") == "blue");
+
+        /* Deltas are merged into it, stale ones are dropped */
+        ASSERT_TRUE(s_ServicePublish(
+            *service,
+            "$aws/things/thing-1/shadow/update/delta",
+            "{\"state\":{\"level\":2,\"mode\":\"eco\"},\"version\":4}",
+            allocator));
+        ASSERT_TRUE(s_ServicePublish(
+            *service, "$aws/things/thing-1/shadow/update/delta", "{\"state\":{\"level\":9},\"version\":4}", allocator));
+        ASSERT_TRUE(s_ServicePublish(
+            *service,
+            "$aws/things/thing-1/shadow/update/delta",
+            "{\"state\":{\"mode\":null},\"version\":5}",
+            allocator));
+        waitForEvents([&]() { return deltaVersions.size() == 2; });
+        ASSERT_INT_EQUALS(4, deltaVersions[0]);
+        ASSERT_INT_EQUALS(5, deltaVersions[1]);
+        ASSERT_STR_EQUALS("{\"color\":\"red\",\"level\":2}", shadow->GetDesired().View().WriteCompact().c_str());
+        ASSERT_INT_EQUALS(5, shadow->GetVersion());
+
+        /* A burst of reported updates goes out as one update request */
+        for (int level = 0; level < 5; ++level)
+        {
+            ASSERT_TRUE(shadow->UpdateReported(JsonObject().WithInteger("level", level).View()));
+        }
+        ASSERT_TRUE(shadow->UpdateReported(JsonObject().WithString("color", "red").View()));
+        {
+            std::unique_lock<std::mutex> lock(requestsLock);
+            requestsSignal.wait(lock, [&]() { return updateRequests.size() == 1; });
+            ASSERT_STR_EQUALS("{\"state\":{\"reported\":{\"level\":4,\"color\":\"red\"}}}", updateRequests[0].c_str());
+        }
+        ASSERT_TRUE(shadow->FlushReported());
+
+        /* The reported document only takes the update once it has been published */
+        waitForEvents([&]() { return reportedPublishResults.size() == 1; });
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, reportedPublishResults[0]);
+        ASSERT_STR_EQUALS("{\"level\":4,\"color\":\"red\"}", shadow->GetReported().View().WriteCompact().c_str());
+
+        Aws::Iot::Mqtt5ShadowClientMetrics metrics = shadow->GetMetrics();
+        ASSERT_UINT_EQUALS(2, metrics.deltasApplied);
+        ASSERT_UINT_EQUALS(1, metrics.staleDeltasDropped);
+        ASSERT_UINT_EQUALS(6, metrics.reportedUpdates);
+        ASSERT_UINT_EQUALS(1, metrics.reportedPublishes);
+        ASSERT_UINT_EQUALS(0, metrics.reportedPublishFailures);
+
+        ASSERT_TRUE(s_ServicePublish(
+            *service,
+            "$aws/things/thing-1/shadow/update/rejected",
+            "{\"code\":400,\"message\":\"bad request\"}",
+            allocator));
+        waitForEvents([&]() { return rejectedCodes.size() == 1; });
+        ASSERT_INT_EQUALS(400, rejectedCodes[0]);
+
+        /* Publishes for other topics are left to the application */
+        Mqtt5::PublishReceivedEventData unrelated;
+        unrelated.publishPacket = MakeShared<Mqtt5::PublishPacket>(
+            allocator,
+            "$aws/things/thing-2/shadow/update/delta",
+            ByteCursorFromCString("{}"),
+            Mqtt5::QOS::AWS_MQTT5_QOS_AT_MOST_ONCE,
+            allocator);
+        ASSERT_FALSE(shadow->OnPublishReceived(unrelated));
+
+        shadow->Close();
+        ASSERT_FALSE(shadow->UpdateReported(JsonObject().WithInteger("level", 7).View()));
+
+        ASSERT_TRUE(client->Stop());
+        stopped.get_future().get();
+        ASSERT_TRUE(service->Stop());
+        serviceStopped.get_future().get();
+        shadow = nullptr;
+        client = nullptr;
+        service = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5ShadowClientDeltaAndCoalescing, s_TestMqtt5ShadowClientDeltaAndCoalescing)
+
+static int s_TestMqtt5ShadowClientReportedPublishFailure(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        /* Publishes submitted before the client connects fail rather than wait in its offline queue */
+        std::promise<void> connected;
+        std::promise<void> stopped;
+        auto client = MqttLoopbackBroker::NewMqtt5Client(
+            "shadow-device",
+            broker.GetPort(),
+            connected,
+            stopped,
+            nullptr,
+            allocator,
+            [](Mqtt5::Mqtt5ClientOptions &options)
+            {
+                options.WithOfflineQueueBehavior(
+                    Mqtt5::ClientOperationQueueBehaviorType::AWS_MQTT5_COQBT_FAIL_ALL_ON_DISCONNECT);
+            });
+        ASSERT_TRUE(client);
+
+        std::mutex resultsLock;
+        std::condition_variable resultsSignal;
+        Vector<int> results;
+        Aws::Iot::Mqtt5ShadowClientOptions shadowOptions(allocator);
+        shadowOptions.WithThingName("thing-1").WithReportedPublishedCallback(
+            [&](int errorCode)
+            {
+                std::lock_guard<std::mutex> lock(resultsLock);
+                results.push_back(errorCode);
+                resultsSignal.notify_all();
+            });
+        auto shadow = Aws::Iot::Mqtt5ShadowClient::NewMqtt5ShadowClient(client, shadowOptions, allocator);
+        ASSERT_NOT_NULL(shadow.get());
+        auto waitForResults = [&](size_t count)
+        {
+            std::unique_lock<std::mutex> lock(resultsLock);
+            resultsSignal.wait(lock, [&]() { return results.size() == count; });
+            return results[count - 1];
+        };
+
+        /* A failed update is not applied locally and stays pending, under the updates made after it */
+        ASSERT_TRUE(shadow->UpdateReported(JsonObject().WithInteger("level", 1).WithString("color", "red").View()));
+        ASSERT_TRUE(waitForResults(1) != AWS_ERROR_SUCCESS);
+        ASSERT_TRUE(shadow->UpdateReported(JsonObject().WithInteger("level", 2).View()));
+        ASSERT_TRUE(waitForResults(2) != AWS_ERROR_SUCCESS);
+        ASSERT_STR_EQUALS("{}", shadow->GetReported().View().WriteCompact().c_str());
+
+        Aws::Iot::Mqtt5ShadowClientMetrics metrics = shadow->GetMetrics();
+        ASSERT_UINT_EQUALS(0, metrics.reportedPublishes);
+        ASSERT_UINT_EQUALS(2, metrics.reportedPublishFailures);
+
+        /* Once connected, the pending state goes out in one update request */
+        ASSERT_TRUE(client->Start());
+        connected.get_future().get();
+        ASSERT_TRUE(shadow->FlushReported());
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, waitForResults(3));
+        ASSERT_STR_EQUALS("{\"level\":2,\"color\":\"red\"}", shadow->GetReported().View().WriteCompact().c_str());
+
+        metrics = shadow->GetMetrics();
+        ASSERT_UINT_EQUALS(1, metrics.reportedPublishes);
+        ASSERT_UINT_EQUALS(2, metrics.reportedPublishFailures);
+
+        shadow->Close();
+        ASSERT_TRUE(client->Stop());
+        stopped.get_future().get();
+        shadow = nullptr;
+        client = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5ShadowClientReportedPublishFailure, s_TestMqtt5ShadowClientReportedPublishFailure)
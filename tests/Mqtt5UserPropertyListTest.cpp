@@ -0,0 +1,79 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/testing/aws_test_harness.h>
+
+using namespace Aws::Crt;
+
+static bool s_PropertyEquals(const aws_mqtt5_user_property &property, const char *name, const char *value)
+{
+    ByteCursor nameCursor = ByteCursorFromCString(name);
+    ByteCursor valueCursor = ByteCursorFromCString(value);
+    return aws_byte_cursor_eq(&property.name, &nameCursor) && aws_byte_cursor_eq(&property.value, &valueCursor);
+}
+
+static int s_TestMqtt5UserPropertyListSharing(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+
+        Vector<Mqtt5::UserProperty> tracingHeaders;
+        tracingHeaders.push_back(Mqtt5::UserProperty("traceparent", "00-4bf92f3577b34da6a3ce929d0e0e4736-01"));
+        tracingHeaders.push_back(Mqtt5::UserProperty("tracestate", "vendor=value"));
+        tracingHeaders.push_back(Mqtt5::UserProperty("empty", ""));
+        auto list = Mqtt5::UserPropertyList::NewUserPropertyList(tracingHeaders, allocator);
+        ASSERT_NOT_NULL(list.get());
+        ASSERT_UINT_EQUALS(3, list->GetCount());
+
+        /* The list holds its own copy */
+        tracingHeaders.clear();
+        const aws_mqtt5_user_property *properties = list->GetNativeProperties();
+        ASSERT_TRUE(s_PropertyEquals(properties[0], "traceparent", "00-4bf92f3577b34da6a3ce929d0e0e4736-01"));
+        ASSERT_TRUE(s_PropertyEquals(properties[1], "tracestate", "vendor=value"));
+        ASSERT_TRUE(s_PropertyEquals(properties[2], "empty", ""));
+
+        /* Packets carrying only the list point at it as it is */
+        for (const char *topic : {"telemetry/1", "telemetry/2"})
+        {
+            Mqtt5::PublishPacket packet(
+                topic, ByteCursorFromCString("reading"), Mqtt5::QOS::AWS_MQTT5_QOS_AT_MOST_ONCE, allocator);
+            packet.WithUserPropertyList(list);
+
+            aws_mqtt5_packet_publish_view view;
+            ASSERT_TRUE(packet.initializeRawOptions(view));
+            ASSERT_PTR_EQUALS(properties, view.user_properties);
+            ASSERT_UINT_EQUALS(3, view.user_property_count);
+            ASSERT_TRUE(packet.getUserProperties().empty());
+        }
+
+        /* Properties of the packet itself come after the shared ones */
+        {
+            Mqtt5::PublishPacket packet(
+                "telemetry/3", ByteCursorFromCString("reading"), Mqtt5::QOS::AWS_MQTT5_QOS_AT_MOST_ONCE, allocator);
+            packet.WithUserPropertyList(list).WithUserProperty(Mqtt5::UserProperty("sequence", "42"));
+
+            aws_mqtt5_packet_publish_view view;
+            ASSERT_TRUE(packet.initializeRawOptions(view));
+            ASSERT_UINT_EQUALS(4, view.user_property_count);
+            ASSERT_TRUE(view.user_properties != properties);
+            ASSERT_TRUE(s_PropertyEquals(view.user_properties[1], "tracestate", "vendor=value"));
+            ASSERT_TRUE(s_PropertyEquals(view.user_properties[3], "sequence", "42"));
+
+            /* A received copy of it has them all as its own */
+            Mqtt5::PublishPacket received(view, allocator);
+            ASSERT_NULL(received.getUserPropertyList().get());
+            ASSERT_UINT_EQUALS(4, received.getUserProperties().size());
+        }
+
+        auto emptyList = Mqtt5::UserPropertyList::NewUserPropertyList(Vector<Mqtt5::UserProperty>(), allocator);
+        ASSERT_NOT_NULL(emptyList.get());
+        ASSERT_UINT_EQUALS(0, emptyList->GetCount());
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5UserPropertyListSharing, s_TestMqtt5UserPropertyListSharing)
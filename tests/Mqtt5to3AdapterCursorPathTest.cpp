@@ -0,0 +1,126 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/crt/mqtt/MqttConnection.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <future>
+#include <mutex>
+
+using namespace Aws::Crt;
+
+static int s_TestMqtt5to3AdapterCursorPath(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        auto connectPacket = MakeShared<Mqtt5::ConnectPacket>(allocator, allocator);
+        connectPacket->WithClientId("adapter-cursor-path");
+        Mqtt5::Mqtt5ClientOptions options(allocator);
+        options.WithHostName("127.0.0.1")
+            .WithPort(broker.GetPort())
+            .WithBootstrap(ApiHandle::GetOrCreateStaticDefaultClientBootstrap())
+            .WithConnectOptions(connectPacket);
+        auto mqtt5Client = Mqtt5::Mqtt5Client::NewMqtt5Client(options, allocator);
+        ASSERT_TRUE(mqtt5Client);
+        auto connection = Mqtt::MqttConnection::NewConnectionFromMqtt5Client(mqtt5Client);
+        ASSERT_TRUE(connection && *connection);
+
+        std::promise<bool> connected;
+        std::promise<void> disconnected;
+        connection->OnConnectionCompleted =
+            [&connected](Mqtt::MqttConnection &, int errorCode, Mqtt::ReturnCode returnCode, bool)
+        { connected.set_value(errorCode == AWS_ERROR_SUCCESS && returnCode == AWS_MQTT_CONNECT_ACCEPTED); };
+        connection->OnDisconnect = [&disconnected](Mqtt::MqttConnection &) { disconnected.set_value(); };
+        ASSERT_TRUE(connection->Connect("adapter-cursor-path", true));
+        ASSERT_TRUE(connected.get_future().get());
+
+        const size_t messageCount = 4;
+        std::mutex receivedLock;
+        Vector<String> receivedTopics;
+        Vector<String> receivedPayloads;
+        size_t receivedByAnyHandler = 0;
+        std::promise<void> allReceived;
+        auto checkAllReceived = [&]()
+        {
+            if (receivedTopics.size() == messageCount && receivedByAnyHandler == messageCount)
+            {
+                allReceived.set_value();
+            }
+        };
+        ASSERT_TRUE(connection->SetOnMessageCursorHandler(
+            [&](Mqtt::MqttConnection &, ByteCursor, ByteCursor, bool, Mqtt::QOS, bool)
+            {
+                std::lock_guard<std::mutex> lock(receivedLock);
+                ++receivedByAnyHandler;
+                checkAllReceived();
+            }));
+
+        std::promise<int> subscribed;
+        ASSERT_TRUE(
+            connection->SubscribeWithCursorHandler(
+                "adapter/cursor/#",
+                AWS_MQTT_QOS_AT_LEAST_ONCE,
+                [&](Mqtt::MqttConnection &, ByteCursor topic, ByteCursor payload, bool, Mqtt::QOS, bool)
+                {
+                    std::lock_guard<std::mutex> lock(receivedLock);
+                    receivedTopics.push_back(String((const char *)topic.ptr, topic.len));
+                    receivedPayloads.push_back(String((const char *)payload.ptr, payload.len));
+                    checkAllReceived();
+                },
+                [&subscribed](Mqtt::MqttConnection &, uint16_t, const String &, Mqtt::QOS, int errorCode)
+                { subscribed.set_value(errorCode); }) != 0);
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subscribed.get_future().get());
+
+        /* Fire and forget publishes take no completion, the last one reports its PUBACK */
+        const char *topic = "adapter/cursor/data";
+        for (size_t i = 0; i + 1 < messageCount; ++i)
+        {
+            String payload = String("reading-") + std::to_string(i).c_str();
+            ASSERT_TRUE(
+                connection->Publish(
+                    ByteCursorFromCString(topic), AWS_MQTT_QOS_AT_LEAST_ONCE, false, ByteCursorFromString(payload)) !=
+                0);
+        }
+        std::promise<int> published;
+        ASSERT_TRUE(
+            connection->Publish(
+                ByteCursorFromCString(topic),
+                AWS_MQTT_QOS_AT_LEAST_ONCE,
+                false,
+                ByteCursorFromCString("reading-3"),
+                [&published](Mqtt::MqttConnection &, uint16_t, int errorCode) { published.set_value(errorCode); }) !=
+            0);
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, published.get_future().get());
+        allReceived.get_future().get();
+
+        {
+            std::lock_guard<std::mutex> lock(receivedLock);
+            for (size_t i = 0; i < messageCount; ++i)
+            {
+                ASSERT_TRUE(receivedTopics[i] == topic);
+                ASSERT_TRUE(receivedPayloads[i] == String("reading-") + std::to_string(i).c_str());
+            }
+        }
+
+        ASSERT_TRUE(connection->Disconnect());
+        disconnected.get_future().get();
+        connection = nullptr;
+        mqtt5Client = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5to3AdapterCursorPath, s_TestMqtt5to3AdapterCursorPath)
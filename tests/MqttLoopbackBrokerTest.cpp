@@ -0,0 +1,205 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/Mqtt5Client.h>
+#include <aws/crt/mqtt/Mqtt5Packets.h>
+#include <aws/crt/mqtt/MqttClient.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <cstring>
+#include <future>
+
+using namespace Aws::Crt;
+
+static int s_TestMqttLoopbackBrokerTopicMatching(Aws::Crt::Allocator *, void *)
+{
+    struct
+    {
+        const char *filter;
+        const char *topic;
+        bool matches;
+    } cases[] = {
+        {"a/b", "a/b", true},
+        {"a/b", "a/c", false},
+        {"a", "a/b", false},
+        {"a/+", "a/b", true},
+        {"a/+", "a", false},
+        {"a/+", "a/", true},
+        {"+/+", "a/b/c", false},
+        {"a/+/c", "a//c", true},
+        {"a/#", "a", true},
+        {"a/#", "a/b/c", true},
+        {"#", "a/b", true},
+    };
+
+    for (const auto &testCase : cases)
+    {
+        ASSERT_TRUE(
+            testCase.matches == MqttLoopbackBroker::TopicMatches(
+                                    ByteCursorFromCString(testCase.filter), ByteCursorFromCString(testCase.topic)));
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(MqttLoopbackBrokerTopicMatching, s_TestMqttLoopbackBrokerTopicMatching)
+
+static int s_TestMqtt5LoopbackBrokerRoundTrip(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        std::promise<bool> connectionPromise;
+        std::promise<void> stoppedPromise;
+        std::promise<String> receivedPromise;
+
+        auto connectPacket = MakeShared<Mqtt5::ConnectPacket>(allocator, allocator);
+        connectPacket->WithClientId("loopback-mqtt5");
+
+        Mqtt5::Mqtt5ClientOptions mqtt5Options(allocator);
+        mqtt5Options.WithHostName("127.0.0.1")
+            .WithPort(broker.GetPort())
+            .WithBootstrap(ApiHandle::GetOrCreateStaticDefaultClientBootstrap())
+            .WithConnectOptions(connectPacket)
+            .WithClientConnectionSuccessCallback([&connectionPromise](const Mqtt5::OnConnectionSuccessEventData &)
+                                                 { connectionPromise.set_value(true); })
+            .WithClientConnectionFailureCallback([&connectionPromise](const Mqtt5::OnConnectionFailureEventData &)
+                                                 { connectionPromise.set_value(false); })
+            .WithClientStoppedCallback([&stoppedPromise](const Mqtt5::OnStoppedEventData &)
+                                       { stoppedPromise.set_value(); })
+            .WithPublishReceivedCallback(
+                [&receivedPromise](const Mqtt5::PublishReceivedEventData &eventData)
+                {
+                    const ByteCursor &payload = eventData.publishPacket->getPayload();
+                    receivedPromise.set_value(String(reinterpret_cast<const char *>(payload.ptr), payload.len));
+                });
+
+        std::shared_ptr<Mqtt5::Mqtt5Client> client = Mqtt5::Mqtt5Client::NewMqtt5Client(mqtt5Options, allocator);
+        ASSERT_TRUE(client);
+        ASSERT_TRUE(client->Start());
+        ASSERT_TRUE(connectionPromise.get_future().get());
+
+        std::promise<int> subscribePromise;
+        auto subscribePacket = MakeShared<Mqtt5::SubscribePacket>(allocator, allocator);
+        subscribePacket->WithSubscription(
+            Mqtt5::Subscription("loopback/+/data", Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE, allocator));
+        ASSERT_TRUE(client->Subscribe(
+            subscribePacket,
+            [&subscribePromise](int errorCode, std::shared_ptr<Mqtt5::SubAckPacket>)
+            { subscribePromise.set_value(errorCode); }));
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subscribePromise.get_future().get());
+
+        std::promise<int> publishPromise;
+        auto publishPacket = MakeShared<Mqtt5::PublishPacket>(
+            allocator,
+            "loopback/5/data",
+            ByteCursorFromCString("hello over loopback"),
+            Mqtt5::QOS::AWS_MQTT5_QOS_AT_LEAST_ONCE,
+            allocator);
+        ASSERT_TRUE(client->Publish(
+            publishPacket,
+            [&publishPromise](int errorCode, std::shared_ptr<Mqtt5::PublishResult>)
+            { publishPromise.set_value(errorCode); }));
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, publishPromise.get_future().get());
+        ASSERT_TRUE(receivedPromise.get_future().get() == "hello over loopback");
+
+        const size_t publishBytes = strlen("loopback/5/data") + strlen("hello over loopback");
+        Mqtt5::Mqtt5ClientMetrics metrics = client->GetMetrics();
+        ASSERT_UINT_EQUALS(0, metrics.publishesSentQos0);
+        ASSERT_UINT_EQUALS(1, metrics.publishesSentQos1);
+        ASSERT_UINT_EQUALS(1, metrics.publishesReceivedQos1);
+        ASSERT_UINT_EQUALS(publishBytes, metrics.publishBytesSent);
+        ASSERT_UINT_EQUALS(publishBytes, metrics.publishBytesReceived);
+        ASSERT_UINT_EQUALS(1, metrics.pubAckLatency.count);
+        ASSERT_UINT_EQUALS(1, metrics.connectionSuccesses);
+        ASSERT_UINT_EQUALS(0, metrics.reconnects);
+        ASSERT_UINT_EQUALS(0, metrics.incompleteOperationCount);
+        ASSERT_TRUE(metrics.incompleteOperationPeak >= 1);
+        ASSERT_UINT_EQUALS(0, client->GetMetrics().incompleteOperationPeak);
+
+        ASSERT_TRUE(client->Stop());
+        stoppedPromise.get_future().get();
+        client = nullptr;
+
+        broker.Stop();
+        MqttLoopbackBrokerStatistics statistics = broker.GetStatistics();
+        ASSERT_UINT_EQUALS(1, statistics.connections);
+        ASSERT_UINT_EQUALS(1, statistics.publishesReceived);
+        ASSERT_UINT_EQUALS(1, statistics.publishesDelivered);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt5LoopbackBrokerRoundTrip, s_TestMqtt5LoopbackBrokerRoundTrip)
+
+static int s_TestMqtt311LoopbackBrokerRoundTrip(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        Mqtt::MqttClient mqttClient(*ApiHandle::GetOrCreateStaticDefaultClientBootstrap(), allocator);
+        Io::SocketOptions socketOptions;
+        auto connection = mqttClient.NewConnection("127.0.0.1", broker.GetPort(), socketOptions);
+        ASSERT_TRUE(connection);
+
+        std::promise<bool> connectionPromise;
+        std::promise<void> disconnectPromise;
+        connection->OnConnectionCompleted =
+            [&connectionPromise](Mqtt::MqttConnection &, int errorCode, Mqtt::ReturnCode returnCode, bool)
+        { connectionPromise.set_value(errorCode == AWS_ERROR_SUCCESS && returnCode == AWS_MQTT_CONNECT_ACCEPTED); };
+        connection->OnDisconnect = [&disconnectPromise](Mqtt::MqttConnection &) { disconnectPromise.set_value(); };
+        ASSERT_TRUE(connection->Connect("loopback-mqtt311", true));
+        ASSERT_TRUE(connectionPromise.get_future().get());
+
+        std::promise<int> subscribePromise;
+        std::promise<String> receivedPromise;
+        ASSERT_TRUE(
+            connection->Subscribe(
+                "loopback/+/data",
+                AWS_MQTT_QOS_AT_LEAST_ONCE,
+                [&receivedPromise](
+                    Mqtt::MqttConnection &, const String &, const ByteBuf &payload, bool, Mqtt::QOS, bool)
+                { receivedPromise.set_value(String(reinterpret_cast<const char *>(payload.buffer), payload.len)); },
+                [&subscribePromise](Mqtt::MqttConnection &, uint16_t, const String &, Mqtt::QOS, int errorCode)
+                { subscribePromise.set_value(errorCode); }) != 0);
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subscribePromise.get_future().get());
+
+        std::promise<int> publishPromise;
+        ByteBuf payload = ByteBufFromCString("hello over loopback");
+        ASSERT_TRUE(
+            connection->Publish(
+                "loopback/311/data",
+                AWS_MQTT_QOS_AT_LEAST_ONCE,
+                false,
+                payload,
+                [&publishPromise](Mqtt::MqttConnection &, uint16_t, int errorCode)
+                { publishPromise.set_value(errorCode); }) != 0);
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, publishPromise.get_future().get());
+        ASSERT_TRUE(receivedPromise.get_future().get() == "hello over loopback");
+
+        ASSERT_TRUE(connection->Disconnect());
+        disconnectPromise.get_future().get();
+        connection = nullptr;
+
+        broker.Stop();
+        MqttLoopbackBrokerStatistics statistics = broker.GetStatistics();
+        ASSERT_UINT_EQUALS(1, statistics.connections);
+        ASSERT_UINT_EQUALS(1, statistics.publishesReceived);
+        ASSERT_UINT_EQUALS(1, statistics.publishesDelivered);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(Mqtt311LoopbackBrokerRoundTrip, s_TestMqtt311LoopbackBrokerRoundTrip)
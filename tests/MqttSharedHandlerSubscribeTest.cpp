@@ -0,0 +1,160 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+#include "MqttLoopbackBroker.h"
+
+#include <aws/crt/Api.h>
+#include <aws/crt/mqtt/MqttClient.h>
+#include <aws/crt/mqtt/MqttConnection.h>
+#include <aws/testing/aws_test_harness.h>
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
+using namespace Aws::Crt;
+
+struct SharedHandlerMessage
+{
+    uint32_t filterId;
+    String topic;
+    String payload;
+};
+
+static bool s_Publish(Mqtt::MqttConnection &connection, const String &topic, const char *payload)
+{
+    std::promise<int> published;
+    return connection.Publish(
+               ByteCursorFromString(topic),
+               AWS_MQTT_QOS_AT_LEAST_ONCE,
+               false,
+               ByteCursorFromCString(payload),
+               [&published](Mqtt::MqttConnection &, uint16_t, int errorCode) { published.set_value(errorCode); }) !=
+               0 &&
+           published.get_future().get() == AWS_ERROR_SUCCESS;
+}
+
+static int s_TestMqttSharedHandlerSubscribe(Aws::Crt::Allocator *allocator, void *)
+{
+    {
+        ApiHandle apiHandle(allocator);
+        Io::EventLoopGroup brokerEventLoopGroup(1, allocator);
+        MqttLoopbackBroker broker(brokerEventLoopGroup, allocator);
+        ASSERT_TRUE(broker.Start());
+
+        Io::SocketOptions socketOptions;
+        Mqtt::MqttClient client(*ApiHandle::GetOrCreateStaticDefaultClientBootstrap(), allocator);
+        ASSERT_TRUE(client);
+        auto connection = client.NewConnection("127.0.0.1", broker.GetPort(), socketOptions);
+        ASSERT_TRUE(connection && *connection);
+
+        std::promise<bool> connected;
+        std::promise<void> disconnected;
+        connection->OnConnectionCompleted =
+            [&connected](Mqtt::MqttConnection &, int errorCode, Mqtt::ReturnCode returnCode, bool)
+        { connected.set_value(errorCode == AWS_ERROR_SUCCESS && returnCode == AWS_MQTT_CONNECT_ACCEPTED); };
+        connection->OnDisconnect = [&disconnected](Mqtt::MqttConnection &) { disconnected.set_value(); };
+        ASSERT_TRUE(connection->Connect("shared-handler-subscriber", true));
+        ASSERT_TRUE(connected.get_future().get());
+
+        /* One filter per device shadow, and a wildcard one after them */
+        const uint32_t deviceCount = 256;
+        Vector<String> filterStorage;
+        for (uint32_t i = 0; i < deviceCount; ++i)
+        {
+            filterStorage.push_back(String("device/") + std::to_string(i).c_str() + "/shadow");
+        }
+        filterStorage.push_back("device/+/alerts");
+        Vector<const char *> filters;
+        for (const String &filter : filterStorage)
+        {
+            filters.push_back(filter.c_str());
+        }
+
+        std::mutex receivedLock;
+        std::condition_variable receivedSignal;
+        Vector<SharedHandlerMessage> received;
+        std::promise<std::pair<int, size_t>> subscribed;
+        ASSERT_TRUE(
+            connection->SubscribeWithSharedHandler(
+                filters,
+                AWS_MQTT_QOS_AT_LEAST_ONCE,
+                [&](Mqtt::MqttConnection &,
+                    uint32_t filterId,
+                    ByteCursor topic,
+                    ByteCursor payload,
+                    bool,
+                    Mqtt::QOS,
+                    bool)
+                {
+                    std::lock_guard<std::mutex> lock(receivedLock);
+                    received.push_back(
+                        {filterId,
+                         String((const char *)topic.ptr, topic.len),
+                         String((const char *)payload.ptr, payload.len)});
+                    receivedSignal.notify_all();
+                },
+                [&subscribed](Mqtt::MqttConnection &, uint16_t, const Vector<String> &topics, Mqtt::QOS, int errorCode)
+                { subscribed.set_value(std::make_pair(errorCode, topics.size())); }) != 0);
+        auto subAck = subscribed.get_future().get();
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, subAck.first);
+        ASSERT_UINT_EQUALS(filters.size(), subAck.second);
+
+        auto waitForMessages = [&](size_t count)
+        {
+            std::unique_lock<std::mutex> lock(receivedLock);
+            receivedSignal.wait(lock, [&]() { return received.size() >= count; });
+        };
+
+        ASSERT_TRUE(s_Publish(*connection, "device/7/shadow", "seven"));
+        waitForMessages(1);
+        ASSERT_TRUE(s_Publish(*connection, "device/128/shadow", "one-two-eight"));
+        waitForMessages(2);
+        ASSERT_TRUE(s_Publish(*connection, "device/42/alerts", "overheating"));
+        waitForMessages(3);
+
+        /* The other filters keep the shared handler once one of them is gone */
+        std::promise<int> unsubscribed;
+        ASSERT_TRUE(
+            connection->Unsubscribe(
+                "device/7/shadow",
+                [&unsubscribed](Mqtt::MqttConnection &, uint16_t, int errorCode)
+                { unsubscribed.set_value(errorCode); }) != 0);
+        ASSERT_INT_EQUALS(AWS_ERROR_SUCCESS, unsubscribed.get_future().get());
+        ASSERT_TRUE(s_Publish(*connection, "device/7/shadow", "ignored"));
+        ASSERT_TRUE(s_Publish(*connection, "device/255/shadow", "last"));
+        waitForMessages(4);
+
+        {
+            std::lock_guard<std::mutex> lock(receivedLock);
+            ASSERT_UINT_EQUALS(4, received.size());
+            ASSERT_UINT_EQUALS(7, received[0].filterId);
+            ASSERT_TRUE(received[0].topic == "device/7/shadow");
+            ASSERT_TRUE(received[0].payload == "seven");
+            ASSERT_UINT_EQUALS(128, received[1].filterId);
+            ASSERT_TRUE(received[1].payload == "one-two-eight");
+            ASSERT_UINT_EQUALS(deviceCount, received[2].filterId);
+            ASSERT_TRUE(received[2].topic == "device/42/alerts");
+            ASSERT_UINT_EQUALS(255, received[3].filterId);
+            ASSERT_TRUE(received[3].topic == "device/255/shadow");
+        }
+
+        /* Nothing subscribed is rejected up front */
+        ASSERT_UINT_EQUALS(
+            0,
+            connection->SubscribeWithSharedHandler(
+                Vector<const char *>(), AWS_MQTT_QOS_AT_LEAST_ONCE, nullptr, nullptr));
+        ASSERT_INT_EQUALS(AWS_ERROR_INVALID_ARGUMENT, aws_last_error());
+
+        ASSERT_TRUE(connection->Disconnect());
+        disconnected.get_future().get();
+        connection = nullptr;
+
+        broker.Stop();
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+AWS_TEST_CASE(MqttSharedHandlerSubscribe, s_TestMqttSharedHandlerSubscribe)
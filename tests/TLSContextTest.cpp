@@ -5,6 +5,7 @@
 #include <aws/crt/Api.h>
 
 #include <aws/testing/aws_test_harness.h>
+
 #include <utility>
 #if !BYO_CRYPTO
 static int s_TestTLSContextResourceSafety(Aws::Crt::Allocator *allocator, void *ctx)
@@ -51,4 +52,68 @@ static int s_TestTLSContextUninitializedNewConnectionOptions(Aws::Crt::Allocator
 }
 
 AWS_TEST_CASE(TLSContextUninitializedNewConnectionOptions, s_TestTLSContextUninitializedNewConnectionOptions)
+
+static int s_TestTLSContextCacheSharing(Aws::Crt::Allocator *allocator, void *ctx)
+{
+    (void)ctx;
+    {
+        Aws::Crt::ApiHandle apiHandle(allocator);
+        Aws::Crt::Io::TlsContextCache cache(allocator);
+
+        Aws::Crt::Io::TlsContextOptions options = Aws::Crt::Io::TlsContextOptions::InitDefaultClient();
+        options.SetAlpnList("h2;http/1.1");
+        options.SetVerifyPeer(true);
+
+        /* same inputs, set in a different order */
+        Aws::Crt::Io::TlsContextOptions sameOptions = Aws::Crt::Io::TlsContextOptions::InitDefaultClient();
+        sameOptions.SetVerifyPeer(true);
+        sameOptions.SetAlpnList("h2;http/1.1");
+
+        Aws::Crt::Io::TlsContextOptions otherAlpn = Aws::Crt::Io::TlsContextOptions::InitDefaultClient();
+        otherAlpn.SetAlpnList("x-amzn-mqtt-ca");
+        otherAlpn.SetVerifyPeer(true);
+
+        {
+            Aws::Crt::Io::TlsContext first = cache.GetOrCreate(options, Aws::Crt::Io::TlsMode::CLIENT);
+            Aws::Crt::Io::TlsContext second = cache.GetOrCreate(sameOptions, Aws::Crt::Io::TlsMode::CLIENT);
+            Aws::Crt::Io::TlsContext other = cache.GetOrCreate(otherAlpn, Aws::Crt::Io::TlsMode::CLIENT);
+            ASSERT_TRUE(first);
+            ASSERT_TRUE(second);
+            ASSERT_TRUE(other);
+            ASSERT_PTR_EQUALS(first.GetUnderlyingHandle(), second.GetUnderlyingHandle());
+            ASSERT_TRUE(first.GetUnderlyingHandle() != other.GetUnderlyingHandle());
+            ASSERT_UINT_EQUALS(2, cache.Size());
+
+            /* uncacheable or not, a context built directly is never handed out by the cache */
+            Aws::Crt::Io::TlsContext direct(options, Aws::Crt::Io::TlsMode::CLIENT, allocator);
+            ASSERT_TRUE(first.GetUnderlyingHandle() != direct.GetUnderlyingHandle());
+        }
+
+        /* the cache does not keep contexts alive */
+        ASSERT_UINT_EQUALS(0, cache.Size());
+        Aws::Crt::Io::TlsContext rebuilt = cache.GetOrCreate(options, Aws::Crt::Io::TlsMode::CLIENT);
+        ASSERT_TRUE(rebuilt);
+        ASSERT_UINT_EQUALS(1, cache.Size());
+
+        Aws::Crt::Io::TlsContextCacheStatistics statistics = cache.GetStatistics();
+        ASSERT_UINT_EQUALS(1, statistics.hits);
+        ASSERT_UINT_EQUALS(3, statistics.misses);
+        ASSERT_UINT_EQUALS(0, statistics.uncacheable);
+
+        /* many clients sharing one configuration share one context through the default cache */
+        const size_t contextCount = 50;
+        Aws::Crt::Vector<Aws::Crt::Io::TlsContext> contexts;
+        for (size_t i = 0; i < contextCount; ++i)
+        {
+            contexts.push_back(Aws::Crt::ApiHandle::GetOrCreateStaticDefaultTlsContextCache()->GetOrCreate(
+                options, Aws::Crt::Io::TlsMode::CLIENT));
+            ASSERT_PTR_EQUALS(contexts[0].GetUnderlyingHandle(), contexts[i].GetUnderlyingHandle());
+        }
+        ASSERT_UINT_EQUALS(1, Aws::Crt::ApiHandle::GetOrCreateStaticDefaultTlsContextCache()->Size());
+    }
+
+    return AWS_ERROR_SUCCESS;
+}
+
+AWS_TEST_CASE(TLSContextCacheSharing, s_TestTLSContextCacheSharing)
 #endif // !BYO_CRYPTO